@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <string.h>
+#include <tools/common/Check.h>
+#include <zero/Args.h>
+#include <zero/Types.h>
+#include <zero/game/net/security/Checksum.h>
+
+#include <vector>
+
+// Checks the sliced crc32 and vectorized map checksum against the scalar references and times both over real maps.
+
+using namespace zero;
+using namespace zero::tools;
+
+static void PrintUsage(const char* exe_name) {
+  printf(
+      "Usage: %s [OPTION] [MAP]...\n"
+      "Checks the optimized checksums against the scalar references and benchmarks them.\n"
+      "A random tile grid is used if no maps are given.\n"
+      "\n"
+      "--keys <count>\t\t\tmap checksum keys to compare for each map (default 100000)\n"
+      "--iterations <count>\t\tcalls to time for each benchmark (default 2000)\n"
+      "",
+      exe_name);
+}
+
+// Places tiles the same way as Map::LoadFromMemory. Large animated tiles aren't expanded since neither checksum looks
+// at them.
+static bool LoadTiles(const char* path, u8* tiles) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  std::vector<u8> data(size);
+
+  if (size < 4 || fread(data.data(), 1, size, f) != (size_t)size) {
+    fclose(f);
+    return false;
+  }
+
+  fclose(f);
+
+  size_t pos = 0;
+
+  if (data[0] == 'B' && data[1] == 'M') {
+    u32 bitmap_size;
+    memcpy(&bitmap_size, data.data() + 2, sizeof(bitmap_size));
+    pos = bitmap_size;
+  }
+
+  memset(tiles, 0, 1024 * 1024);
+
+  for (; pos + 4 <= (size_t)size; pos += 4) {
+    u32 tile;
+    memcpy(&tile, data.data() + pos, sizeof(tile));
+
+    u32 x = tile & 0xFFF;
+    u32 y = (tile >> 12) & 0xFFF;
+
+    if (x < 1024 && y < 1024) {
+      tiles[y * 1024 + x] = (u8)(tile >> 24);
+    }
+  }
+
+  return true;
+}
+
+static bool CheckKnownAnswers() {
+  const char* check = "123456789";
+  bool success = true;
+
+  // Standard crc32 check value.
+  if (crc32((const u8*)check, 9) != 0xCBF43926 || crc32_scalar((const u8*)check, 9) != 0xCBF43926) {
+    printf("crc32 check value mismatch: %08X %08X\n", crc32((const u8*)check, 9),
+           crc32_scalar((const u8*)check, 9));
+    success = false;
+  }
+
+  // Every length and alignment up to a few blocks to cover the sliced loop and the tail.
+  u8 buffer[1024 + 16];
+
+  for (size_t i = 0; i < sizeof(buffer); ++i) {
+    buffer[i] = (u8)NextRandom();
+  }
+
+  for (size_t offset = 0; offset < 8; ++offset) {
+    for (size_t size = 0; size <= 1024; ++size) {
+      if (crc32(buffer + offset, size) != crc32_scalar(buffer + offset, size)) {
+        printf("crc32 mismatch at offset %zu size %zu\n", offset, size);
+        success = false;
+      }
+
+      if (crc32_map(buffer + offset, size) != crc32_map_scalar(buffer + offset, size)) {
+        printf("crc32_map mismatch at offset %zu size %zu\n", offset, size);
+        success = false;
+      }
+    }
+  }
+
+  return success;
+}
+
+static bool CheckMap(const char* name, const u8* tiles, size_t key_count, size_t iterations) {
+  bool success = true;
+
+  for (size_t i = 0; i < key_count; ++i) {
+    // Cover small keys, every sampling offset and keys with the high bit set.
+    u32 key = i < 1024 ? (u32)i : NextRandom();
+
+    u32 expected = MapChecksumScalar(tiles, key);
+    u32 result = MapChecksum(tiles, key);
+
+    if (result != expected) {
+      printf("%s: map checksum mismatch for key %08X: %08X expected %08X\n", name, key, result, expected);
+      success = false;
+      break;
+    }
+  }
+
+  u32 expected_crc = crc32_map_scalar(tiles, 1024 * 1024);
+
+  if (crc32_map(tiles, 1024 * 1024) != expected_crc) {
+    printf("%s: crc32_map mismatch\n", name);
+    success = false;
+  }
+
+  if (crc32(tiles, 1024 * 1024) != crc32_scalar(tiles, 1024 * 1024)) {
+    printf("%s: crc32 mismatch\n", name);
+    success = false;
+  }
+
+  u64 checksum_scalar_us = Time(iterations, [&](size_t i) { Sink(MapChecksumScalar(tiles, (u32)i * 7919)); });
+  u64 checksum_us = Time(iterations, [&](size_t i) { Sink(MapChecksum(tiles, (u32)i * 7919)); });
+
+  size_t crc_iterations = iterations / 20 + 1;
+
+  u64 map_crc_scalar_us = Time(crc_iterations, [&](size_t) { Sink(crc32_map_scalar(tiles, 1024 * 1024)); });
+  u64 map_crc_us = Time(crc_iterations, [&](size_t) { Sink(crc32_map(tiles, 1024 * 1024)); });
+  u64 crc_scalar_us = Time(crc_iterations, [&](size_t) { Sink(crc32_scalar(tiles, 1024 * 1024)); });
+  u64 crc_us = Time(crc_iterations, [&](size_t) { Sink(crc32(tiles, 1024 * 1024)); });
+
+  size_t tile_count = 0;
+  for (size_t i = 0; i < 1024 * 1024; ++i) {
+    if (tiles[i]) ++tile_count;
+  }
+
+  printf("%s (%zu tiles)\n", name, tile_count);
+  PrintTiming("map checksum", checksum_us, "scalar", checksum_scalar_us, iterations);
+  PrintTiming("crc32_map", map_crc_us, "scalar", map_crc_scalar_us, crc_iterations);
+  PrintTiming("crc32 1 MiB", crc_us, "scalar", crc_scalar_us, crc_iterations);
+
+  return success;
+}
+
+int main(int argc, char* argv[]) {
+  ArgParser args(argc, argv);
+
+  if (args.HasParameter({"help", "h"})) {
+    PrintUsage(argv[0]);
+    return 0;
+  }
+
+  size_t key_count = GetCount(args, "keys", 100000);
+  size_t iterations = GetCount(args, "iterations", 2000);
+
+  bool success = Report("known answers", CheckKnownAnswers());
+
+  std::vector<u8> tiles(1024 * 1024);
+  size_t map_count = 0;
+
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+
+    // Every option takes a value, so skip both.
+    if (arg[0] == '-') {
+      ++i;
+      continue;
+    }
+
+    if (!LoadTiles(arg, tiles.data())) {
+      printf("Failed to load map %s\n", arg);
+      success = false;
+      continue;
+    }
+
+    success &= CheckMap(arg, tiles.data(), key_count, iterations);
+    ++map_count;
+  }
+
+  if (map_count == 0) {
+    // Sparse random walls with some safe tiles so every branch of both checksums is exercised.
+    for (size_t i = 0; i < tiles.size(); ++i) {
+      u32 r = NextRandom();
+      tiles[i] = (r % 8 == 0) ? (u8)(r >> 24) : 0;
+    }
+
+    success &= CheckMap("random", tiles.data(), key_count, iterations);
+  }
+
+  return success ? 0 : 1;
+}
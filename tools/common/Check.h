@@ -0,0 +1,92 @@
+#ifndef ZERO_TOOLS_CHECK_H_
+#define ZERO_TOOLS_CHECK_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <zero/Args.h>
+#include <zero/Types.h>
+#include <zero/game/Clock.h>
+
+namespace zero {
+namespace tools {
+
+// Shared pieces of the check tools. Each tool compares a replacement against the reference it replaced, reports every
+// check as "name: ok" or "name: FAILED", times both versions and exits with 1 if any check failed.
+
+constexpr u32 kDefaultSeed = 0x12345678;
+
+// xorshift32, so every run checks the same data.
+inline u32 g_random_state = kDefaultSeed;
+
+inline void SeedRandom(u32 seed) {
+  g_random_state = seed ? seed : kDefaultSeed;
+}
+
+inline u32 NextRandom() {
+  g_random_state ^= g_random_state << 13;
+  g_random_state ^= g_random_state >> 17;
+  g_random_state ^= g_random_state << 5;
+  return g_random_state;
+}
+
+// Timed results are added in here so the calls being timed aren't optimized out.
+inline volatile u32 g_sink;
+
+inline void Sink(u32 value) {
+  g_sink = g_sink + value;
+}
+
+inline void Sink(float value) {
+  g_sink = g_sink + (u32)(s32)value;
+}
+
+inline size_t GetCount(ArgParser& args, const char* name, size_t default_value) {
+  std::string_view value = args.GetValue(name);
+
+  return value.empty() ? default_value : (size_t)strtoull(value.data(), nullptr, 10);
+}
+
+inline float GetFloat(ArgParser& args, const char* name, float default_value) {
+  std::string_view value = args.GetValue(name);
+
+  return value.empty() ? default_value : strtof(value.data(), nullptr);
+}
+
+// Prints the result of a check and passes it through so results can be combined.
+inline bool Report(const char* name, bool success) {
+  printf("%s: %s\n", name, success ? "ok" : "FAILED");
+  return success;
+}
+
+// Calls func(i) for every iteration and returns the elapsed microseconds.
+template <typename Func>
+inline u64 Time(size_t iterations, Func&& func) {
+  u64 start = GetMicrosecondTick();
+
+  for (size_t i = 0; i < iterations; ++i) {
+    func(i);
+  }
+
+  return GetMicrosecondTick() - start;
+}
+
+inline double GetSpeedup(u64 reference_us, u64 us) {
+  return reference_us / (double)(us ? us : 1);
+}
+
+// Prints the time per call of a path next to the reference it's compared against.
+inline void PrintTiming(const char* label, u64 us, const char* reference_name, u64 reference_us, size_t calls) {
+  printf("  %-16s %9.3f us  %-9s %9.3f us  %5.1fx\n", label, us / (double)calls, reference_name,
+         reference_us / (double)calls, GetSpeedup(reference_us, us));
+}
+
+// Prints the throughput of a path next to the reference it's compared against.
+inline void PrintRate(const char* label, size_t bytes, u64 us, const char* reference_name, u64 reference_us) {
+  printf("  %-16s %9.1f MB/s  %-9s %9.1f MB/s  %5.1fx\n", label, bytes / (double)(us ? us : 1), reference_name,
+         bytes / (double)(reference_us ? reference_us : 1), GetSpeedup(reference_us, us));
+}
+
+}  // namespace tools
+}  // namespace zero
+
+#endif
@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <string.h>
+#include <tools/common/Check.h>
+#include <zero/Args.h>
+#include <zero/RegionRegistry.h>
+#include <zero/Types.h>
+#include <zero/game/Logger.h>
+#include <zero/game/Map.h>
+#include <zero/game/Memory.h>
+#include <zero/path/Node.h>
+#include <zero/path/NodeProcessor.h>
+
+#include <vector>
+
+// Checks the paged region registry and its replayed events, the blocked node layout and the offset node weight against
+// the flat versions they replaced.
+
+namespace zero {
+
+// The client objects expect these from the executable. Nothing here connects anywhere.
+const char* kSecurityServiceIp = "127.0.0.1";
+const char* kServerName = "layout";
+
+}  // namespace zero
+
+using namespace zero;
+using namespace zero::tools;
+
+// Ship radii in tiles to build the regions at. These cover a tiny ship, a normal one and one larger than most.
+constexpr float kRadii[] = {0.5f, 0.875f, 2.0f};
+
+static void PrintUsage(const char* exe_name) {
+  printf(
+      "Usage: %s [OPTION] [MAP]...\n"
+      "Checks the paged region registry and path node layout against the flat versions they replaced.\n"
+      "Two generated maps are used if no maps are given.\n"
+      "",
+      exe_name);
+}
+
+static void PushTile(std::vector<u8>& data, u32 x, u32 y, u32 id) {
+  u32 tile = x | (y << 12) | (id << 24);
+  u8* bytes = (u8*)&tile;
+
+  data.insert(data.end(), bytes, bytes + sizeof(tile));
+}
+
+static void PushRect(std::vector<u8>& data, std::vector<u8>& solid, u32 x, u32 y, u32 width, u32 height) {
+  for (u32 tile_y = y; tile_y < y + height && tile_y < 1024; ++tile_y) {
+    for (u32 tile_x = x; tile_x < x + width && tile_x < 1024; ++tile_x) {
+      if (solid[tile_y * 1024 + tile_x]) continue;
+
+      solid[tile_y * 1024 + tile_x] = 1;
+      PushTile(data, tile_x, tile_y, 1 + NextRandom() % 160);
+    }
+  }
+}
+
+// Random walls over the whole map, so most region pages have several regions in them.
+static std::vector<u8> GenerateScatteredMap() {
+  std::vector<u8> data;
+  std::vector<u8> solid(1024 * 1024);
+
+  for (size_t i = 0; i < 1500; ++i) {
+    u32 width = 1 + NextRandom() % 24;
+    u32 height = 1 + NextRandom() % 24;
+
+    PushRect(data, solid, NextRandom() % 1024, NextRandom() % 1024, width, height);
+  }
+
+  return data;
+}
+
+// Everything outside of the middle is solid, so most region pages are uniform.
+static std::vector<u8> GenerateEnclosedMap() {
+  std::vector<u8> data;
+  std::vector<u8> solid(1024 * 1024);
+
+  PushRect(data, solid, 0, 0, 1024, 256);
+  PushRect(data, solid, 0, 768, 1024, 256);
+  PushRect(data, solid, 0, 256, 256, 512);
+  PushRect(data, solid, 768, 256, 256, 512);
+
+  // Split the middle into rooms with a few gaps so some rooms are connected.
+  for (u32 i = 1; i < 4; ++i) {
+    PushRect(data, solid, 256, 256 + i * 128, 240, 2);
+    PushRect(data, solid, 256 + i * 128, 256, 2, 512);
+  }
+
+  return data;
+}
+
+// Counts the replayed region events and checks each one against the flat fill.
+struct RegionEventChecker : EventHandler<RegionBuildEvent>, EventHandler<RegionTileAddEvent> {
+  const RegionIndex* flat = nullptr;
+
+  size_t build_count = 0;
+  size_t tile_count = 0;
+  size_t mismatches = 0;
+
+  void HandleEvent(const RegionBuildEvent& event) override { ++build_count; }
+
+  void HandleEvent(const RegionTileAddEvent& event) override {
+    ++tile_count;
+
+    if (build_count == 0 || flat[(size_t)event.coord.y * 1024 + event.coord.x] != event.region_index) {
+      ++mismatches;
+    }
+  }
+};
+
+static bool CheckRegions(const Map& map, const char* map_name) {
+  bool success = true;
+
+  for (float radius : kRadii) {
+    RegionRegistry* registry = new RegionRegistry;
+
+    registry->CreateAll(map, radius);
+
+    // This is the fill that CreateAll did before the registry was paged.
+    std::vector<RegionIndex> flat(1024 * 1024, kUndefinedRegion);
+    RegionFiller filler(map, radius, flat.data());
+    RegionIndex region_count = 0;
+
+    for (u16 y = 0; y < 1024; ++y) {
+      for (u16 x = 0; x < 1024; ++x) {
+        if (map.CanOverlapTile(Vector2f(x, y), radius, 0xFFFF) && flat[(size_t)y * 1024 + x] == kUndefinedRegion) {
+          filler.Fill(region_count++, MapCoord(x, y));
+        }
+      }
+    }
+
+    size_t mismatches = 0;
+
+    for (u16 y = 0; y < 1024; ++y) {
+      for (u16 x = 0; x < 1024; ++x) {
+        RegionIndex paged = registry->GetRegionIndex(MapCoord(x, y));
+        RegionIndex expected = flat[(size_t)y * 1024 + x];
+
+        if (paged != expected) {
+          if (mismatches == 0) {
+            printf("%s radius %.3f: region %d at %u, %u, expected %d\n", map_name, radius, (int)paged, x, y,
+                   (int)expected);
+          }
+
+          ++mismatches;
+        }
+      }
+    }
+
+    // Every tile in a region should get exactly one event after the build event.
+    RegionEventChecker* checker = new RegionEventChecker;
+    checker->flat = flat.data();
+
+    registry->DispatchEvents();
+
+    size_t region_tile_count = 0;
+
+    for (RegionIndex region_index : flat) {
+      if (region_index != kUndefinedRegion) ++region_tile_count;
+    }
+
+    if (checker->build_count != 1 || checker->tile_count != region_tile_count || checker->mismatches > 0) {
+      printf("%s radius %.3f: %zu build events and %zu tile events with %zu wrong, expected 1 and %zu\n", map_name,
+             radius, checker->build_count, checker->tile_count, checker->mismatches, region_tile_count);
+      success = false;
+    }
+
+    delete checker;
+
+    MemoryFootprint footprint = registry->GetMemoryFootprint();
+
+    printf("  %s radius %.3f: %u regions, %zu KiB stored instead of %zu KiB\n", map_name, radius, region_count,
+           footprint.allocated / 1024, flat.size() * sizeof(RegionIndex) / 1024);
+
+    if (mismatches > 0) {
+      printf("%s radius %.3f: %zu tiles don't match the flat fill\n", map_name, radius, mismatches);
+      success = false;
+    }
+
+    delete registry;
+  }
+
+  return success;
+}
+
+static bool CheckNodeIndex() {
+  std::vector<u8> seen(path::kMaxNodes);
+
+  for (u16 y = 0; y < 1024; ++y) {
+    for (u16 x = 0; x < 1024; ++x) {
+      size_t index = path::NodeProcessor::GetIndex(x, y);
+
+      if (index >= path::kMaxNodes || seen[index]) {
+        printf("node index %zu for %u, %u is out of range or used twice\n", index, x, y);
+        return false;
+      }
+
+      seen[index] = 1;
+
+      path::NodePoint point = path::NodeProcessor::GetPoint(index);
+
+      if (point.x != x || point.y != y) {
+        printf("node index %zu for %u, %u maps back to %u, %u\n", index, x, y, point.x, point.y);
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+// Weights used to be stored directly as a fixed point byte where every 10 is 1.
+static float GetFlatWeight(float weight) {
+  u32 calc = (u32)(weight * 10.0f);
+  u8 stored = calc <= 255 ? (u8)calc : 255;
+
+  return stored / 10.0f;
+}
+
+static bool CheckNodeWeight() {
+  path::Node zeroed;
+  memset((void*)&zeroed, 0, sizeof(zeroed));
+
+  if (zeroed.GetWeight() != 1.0f || path::Node().GetWeight() != 1.0f) {
+    printf("default node weight is %f, expected 1\n", zeroed.GetWeight());
+    return false;
+  }
+
+  // Every stored value and the steps in between, past the top of the range.
+  for (u32 i = 0; i <= 4000; ++i) {
+    float weight = i / 100.0f;
+    path::Node node;
+
+    node.SetWeight(weight);
+
+    if (node.GetWeight() != GetFlatWeight(weight)) {
+      printf("node weight %f reads back as %f, expected %f\n", weight, node.GetWeight(), GetFlatWeight(weight));
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  ArgParser args(argc, argv);
+
+  if (args.HasParameter({"help", "h"})) {
+    PrintUsage(argv[0]);
+    return 0;
+  }
+
+  g_LogPrintLevel = LogLevel::Warning;
+
+  MemoryArena arena = ReserveArena("maps", Megabytes(64), HugePageMode::None);
+
+  if (!arena.base) {
+    printf("Failed to reserve memory.\n");
+    return 1;
+  }
+
+  bool region_success = true;
+  size_t map_count = 0;
+
+  printf("regions:\n");
+
+  for (int i = 1; i < argc; ++i) {
+    if (argv[i][0] == '-') continue;
+
+    Map* map = new Map();
+
+    arena.Reset();
+
+    if (!map->Load(arena, argv[i])) {
+      printf("Failed to load map %s\n", argv[i]);
+      region_success = false;
+    } else {
+      region_success &= CheckRegions(*map, argv[i]);
+    }
+
+    ++map_count;
+    delete map;
+  }
+
+  if (map_count == 0) {
+    const char* kNames[] = {"scattered", "enclosed"};
+    std::vector<u8> maps[] = {GenerateScatteredMap(), GenerateEnclosedMap()};
+
+    for (size_t i = 0; i < ZERO_ARRAY_SIZE(maps); ++i) {
+      Map* map = new Map();
+
+      arena.Reset();
+
+      if (!map->LoadFromMemory(arena, kNames[i], maps[i].data(), maps[i].size())) {
+        printf("Failed to load generated map %s\n", kNames[i]);
+        region_success = false;
+      } else {
+        region_success &= CheckRegions(*map, kNames[i]);
+      }
+
+      delete map;
+    }
+  }
+
+  bool success = Report("region registry", region_success);
+  success &= Report("node index", CheckNodeIndex());
+  success &= Report("node weight", CheckNodeWeight());
+
+  return success ? 0 : 1;
+}
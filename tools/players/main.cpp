@@ -0,0 +1,641 @@
+#include <stdio.h>
+#include <string.h>
+#include <tools/common/Check.h>
+#include <zero/Args.h>
+#include <zero/Types.h>
+#include <zero/game/Buffer.h>
+#include <zero/game/Player.h>
+#include <zero/game/PlayerGrid.h>
+#include <zero/game/PositionHistory.h>
+#include <zero/game/net/Packets.h>
+
+#include <algorithm>
+#include <vector>
+
+// Checks the player grid queries against a scan of every player, the position history ring and the batched position
+// decoder, then times full sweeps over the hot Player array against the combined layout Player had before
+// PlayerDetails was split out of it.
+
+using namespace zero;
+using namespace zero::tools;
+
+// The player struct before the hot/cold split, with names, scores and animation state inline.
+struct CombinedPlayer {
+  char name[32];
+  char squad[32];
+
+  s32 flag_points;
+  s32 kill_points;
+
+  PlayerId id;
+  u16 frequency;
+
+  Vector2f position;
+  Vector2f velocity;
+
+  Vector2f lerp_velocity;
+  float lerp_time;
+  float repel_time;
+
+  u16 wins;
+  u16 losses;
+
+  u16 bounty;
+  u16 s2c_latency;
+
+  u16 flag_timer;
+  WeaponData weapon;
+
+  u32 items;
+
+  float energy;
+  float orientation;
+
+  u8 ship;
+  u8 togglables;
+  u8 ping;
+  u8 has_crown;
+
+  u32 last_bounce_tick;
+
+  u16 attach_parent;
+  u16 flags;
+
+  AttachInfo* children;
+
+  u32 last_extra_timestamp;
+  u32 last_repel_timestamp;
+
+  u16 timestamp;
+
+  float enter_delay;
+
+  float warp_anim_t;
+  float explode_anim_t;
+  float bombflash_anim_t;
+
+  bool ball_carrier;
+};
+
+static void PrintUsage(const char* exe_name) {
+  printf(
+      "Usage: %s [OPTION]\n"
+      "Checks the player grid, position history and batched position decoding, then times them against the old\n"
+      "versions.\n"
+      "\n"
+      "--players <count>\t\tplayers in each array (default 1024)\n"
+      "--iterations <count>\t\tsweeps to time for each layout (default 20000)\n"
+      "--stride <count>\t\tarrays laid out back to back so the sweep doesn't stay in cache (default 64)\n"
+      "",
+      exe_name);
+}
+
+template <typename T>
+static void FillPlayers(T* players, size_t count) {
+  SeedRandom(kDefaultSeed);
+
+  for (size_t i = 0; i < count; ++i) {
+    T* player = players + i;
+
+    memset((void*)player, 0, sizeof(T));
+
+    player->id = (PlayerId)i;
+    player->frequency = (u16)(NextRandom() % 4);
+    player->ship = (u8)(NextRandom() % 9);
+    player->position = Vector2f((float)(NextRandom() % 1024), (float)(NextRandom() % 1024));
+    player->velocity = Vector2f((NextRandom() % 200) / 10.0f - 10.0f, (NextRandom() % 200) / 10.0f - 10.0f);
+    player->energy = (float)(NextRandom() % 2000);
+    player->enter_delay = (NextRandom() % 8 == 0) ? 1.0f : 0.0f;
+  }
+}
+
+// The fields the per-tick simulation and target selection touch for every player.
+template <typename T>
+static float Sweep(T* players, size_t count, const Vector2f& self_position, u16 self_frequency, float dt) {
+  float best_distance_sq = 1024.0f * 1024.0f;
+
+  for (size_t i = 0; i < count; ++i) {
+    T* player = players + i;
+
+    if (player->ship >= 8) continue;
+
+    if (player->enter_delay > 0.0f) {
+      player->enter_delay -= dt;
+      continue;
+    }
+
+    player->position += player->velocity * dt;
+
+    if (player->lerp_time > 0.0f) {
+      player->position += player->lerp_velocity * dt;
+      player->lerp_time -= dt;
+    }
+
+    if (player->frequency == self_frequency || player->energy <= 0.0f) continue;
+
+    float distance_sq = player->position.DistanceSq(self_position);
+
+    if (distance_sq < best_distance_sq) {
+      best_distance_sq = distance_sq;
+    }
+  }
+
+  return best_distance_sq;
+}
+
+template <typename T>
+static u64 TimeSweeps(std::vector<T>& storage, size_t players, size_t stride, size_t iterations, float* result) {
+  for (size_t i = 0; i < stride; ++i) {
+    FillPlayers(storage.data() + i * players, players);
+  }
+
+  float sink = 0.0f;
+  Vector2f self_position(512.0f, 512.0f);
+
+  u64 elapsed = Time(iterations, [&](size_t i) {
+    sink += Sweep(storage.data() + (i % stride) * players, players, self_position, 0, 1.0f / 100.0f);
+  });
+
+  *result = sink;
+  Sink(sink);
+
+  return elapsed;
+}
+
+template <typename T>
+static bool CheckPositions(const T* players, const Player* hot_players, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (players[i].position.x != hot_players[i].position.x || players[i].position.y != hot_players[i].position.y ||
+        players[i].enter_delay != hot_players[i].enter_delay) {
+      printf("player %zu state mismatch between layouts\n", i);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static PlayerQueryFilter GetRandomFilter() {
+  PlayerQueryFilter filter;
+
+  if (NextRandom() % 3 == 0) filter.frequency = (u16)(NextRandom() % 4);
+  if (NextRandom() % 3 == 0) filter.exclude_frequency = (u16)(NextRandom() % 4);
+  if (NextRandom() % 3 == 0) filter.ship_mask = (u8)NextRandom();
+  filter.alive_only = NextRandom() % 2 == 0;
+
+  return filter;
+}
+
+// The grid only holds players in a ship, so the scan has to skip spectators too.
+static bool IsGridMatch(const Player& player, const PlayerQueryFilter& filter) {
+  return player.ship < 8 && filter.Matches(player);
+}
+
+static void SortByAddress(Player** players, size_t count) {
+  std::sort(players, players + count);
+}
+
+// Compares every kind of grid query against a scan of every player, then moves, respawns and removes players so the
+// incremental relinking is checked too.
+static bool CheckPlayerGrid() {
+  constexpr size_t kPlayerCount = 600;
+  constexpr size_t kQueryCount = 2000;
+
+  std::vector<Player> players(PlayerGrid::kMaxPlayers);
+  PlayerGrid* grid = new PlayerGrid(players.data());
+
+  SeedRandom(kDefaultSeed);
+  FillPlayers(players.data(), kPlayerCount);
+
+  std::vector<Player*> result(PlayerGrid::kMaxPlayers);
+  std::vector<Player*> expected(PlayerGrid::kMaxPlayers);
+  std::vector<float> expected_distances;
+
+  bool success = true;
+
+  for (size_t round = 0; round < 4 && success; ++round) {
+    for (u16 i = 0; i < kPlayerCount; ++i) {
+      grid->Update(i);
+    }
+
+    for (size_t query = 0; query < kQueryCount; ++query) {
+      PlayerQueryFilter filter = GetRandomFilter();
+      // Centers reach past the edges of the map, where the cell coordinates are clamped.
+      Vector2f center((float)(NextRandom() % 1100) - 38.0f, (float)(NextRandom() % 1100) - 38.0f);
+      float radius = (float)(NextRandom() % 3000) / 10.0f;
+
+      size_t count = grid->QueryRadius(center, radius, filter, result.data(), result.size());
+      size_t expected_count = 0;
+
+      for (size_t i = 0; i < kPlayerCount; ++i) {
+        Player& player = players[i];
+
+        if (IsGridMatch(player, filter) && player.position.DistanceSq(center) <= radius * radius) {
+          expected[expected_count++] = &player;
+        }
+      }
+
+      SortByAddress(result.data(), count);
+      SortByAddress(expected.data(), expected_count);
+
+      if (count != expected_count || !std::equal(result.data(), result.data() + count, expected.data())) {
+        printf("grid radius query at (%f, %f) radius %f found %zu players, expected %zu\n", center.x, center.y, radius,
+               count, expected_count);
+        success = false;
+        break;
+      }
+
+      Vector2f min = center - Vector2f(radius, radius * 0.5f);
+      Vector2f max = center + Vector2f(radius * 0.5f, radius);
+
+      count = grid->QueryRect(min, max, filter, result.data(), result.size());
+      expected_count = 0;
+
+      for (size_t i = 0; i < kPlayerCount; ++i) {
+        Player& player = players[i];
+        Vector2f& position = player.position;
+
+        if (IsGridMatch(player, filter) && position.x >= min.x && position.x <= max.x && position.y >= min.y &&
+            position.y <= max.y) {
+          expected[expected_count++] = &player;
+        }
+      }
+
+      SortByAddress(result.data(), count);
+      SortByAddress(expected.data(), expected_count);
+
+      if (count != expected_count || !std::equal(result.data(), result.data() + count, expected.data())) {
+        printf("grid rect query found %zu players, expected %zu\n", count, expected_count);
+        success = false;
+        break;
+      }
+
+      // Small k covers the early ring exit and large k covers the search running out of players.
+      size_t k = NextRandom() % 2 == 0 ? 1 + NextRandom() % 16 : PlayerGrid::kMaxPlayers;
+      float max_distance = NextRandom() % 4 == 0 ? radius : 1024.0f * 1.5f;
+
+      count = grid->QueryNearest(center, k, filter, result.data(), result.size(), max_distance);
+
+      expected_distances.clear();
+
+      for (size_t i = 0; i < kPlayerCount; ++i) {
+        Player& player = players[i];
+        float distance_sq = player.position.DistanceSq(center);
+
+        if (IsGridMatch(player, filter) && distance_sq <= max_distance * max_distance) {
+          expected_distances.push_back(distance_sq);
+        }
+      }
+
+      std::sort(expected_distances.begin(), expected_distances.end());
+
+      expected_count = std::min(k, expected_distances.size());
+
+      // Players at the same distance can come back in any order, so the distances are compared instead.
+      bool nearest_match = count == expected_count;
+
+      for (size_t i = 0; i < count && nearest_match; ++i) {
+        nearest_match = IsGridMatch(*result[i], filter) &&
+                        result[i]->position.DistanceSq(center) == expected_distances[i];
+      }
+
+      if (!nearest_match) {
+        printf("grid nearest query at (%f, %f) k %zu found %zu players, expected %zu\n", center.x, center.y, k, count,
+               expected_count);
+        success = false;
+        break;
+      }
+    }
+
+    // Move everyone some distance, toggle a few into spectator mode and respawn others before the next round.
+    for (u16 i = 0; i < kPlayerCount; ++i) {
+      Player& player = players[i];
+
+      player.position += Vector2f((float)(NextRandom() % 64) - 32.0f, (float)(NextRandom() % 64) - 32.0f);
+      player.position.x = std::clamp(player.position.x, 0.0f, 1023.0f);
+      player.position.y = std::clamp(player.position.y, 0.0f, 1023.0f);
+
+      if (NextRandom() % 16 == 0) player.ship = (u8)(NextRandom() % 9);
+      if (NextRandom() % 16 == 0) player.enter_delay = player.enter_delay > 0.0f ? 0.0f : 1.0f;
+    }
+
+    // Players that leave are removed from the grid and stop being found.
+    for (u16 i = 0; i < kPlayerCount; i += 37) {
+      grid->Remove(i);
+      players[i].ship = 8;
+    }
+  }
+
+  delete grid;
+
+  return success;
+}
+
+// Pushes a player moving in a straight line across the tick wrap and checks every lookup lands on that line.
+static bool CheckPositionHistory() {
+  constexpr size_t kPushCount = PositionHistory::kCapacity + 5;
+  constexpr s32 kTickSpacing = 10;
+  // 1 tile every 10 ticks.
+  const Vector2f velocity(10.0f, -10.0f);
+  const Tick start_tick = MAKE_TICK(0x7FFFFFFF - 100);
+
+  auto expected_position = [&](s32 ticks_from_start) {
+    float t = ticks_from_start / 100.0f;
+    return Vector2f(velocity.x * t, 500.0f + velocity.y * t);
+  };
+
+  PositionHistory history;
+  history.Clear();
+
+  for (size_t i = 0; i < kPushCount; ++i) {
+    s32 offset = (s32)i * kTickSpacing;
+    history.Push(MAKE_TICK(start_tick + offset), expected_position(offset), velocity);
+  }
+
+  // Out of order samples are dropped.
+  history.Push(start_tick, Vector2f(0, 0), Vector2f(0, 0));
+
+  if (history.count != PositionHistory::kCapacity) {
+    printf("position history count %u expected %zu\n", history.count, PositionHistory::kCapacity);
+    return false;
+  }
+
+  for (size_t i = 0; i < history.count; ++i) {
+    s32 offset = (s32)(kPushCount - 1 - i) * kTickSpacing;
+
+    if (history.Get(i).tick != MAKE_TICK(start_tick + offset)) {
+      printf("position history sample %zu has tick %u expected %u\n", i, history.Get(i).tick,
+             MAKE_TICK(start_tick + offset));
+      return false;
+    }
+  }
+
+  // Covers backward extrapolation, interpolation between every pair and forward extrapolation.
+  s32 oldest_offset = (s32)(kPushCount - PositionHistory::kCapacity) * kTickSpacing;
+  s32 newest_offset = (s32)(kPushCount - 1) * kTickSpacing;
+
+  for (s32 offset = oldest_offset - 25; offset <= newest_offset + 25; ++offset) {
+    PositionSample state;
+
+    if (!history.GetStateAt(MAKE_TICK(start_tick + offset), &state)) {
+      printf("position history has no state at offset %d\n", offset);
+      return false;
+    }
+
+    Vector2f expected = expected_position(offset);
+
+    if (state.position.DistanceSq(expected) > 0.0001f || state.velocity.DistanceSq(velocity) > 0.0001f) {
+      printf("position history state at offset %d is (%f, %f) expected (%f, %f)\n", offset, state.position.x,
+             state.position.y, expected.x, expected.y);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Pushes a player accelerating at a constant rate across the tick wrap and checks the smoothed velocity and the
+// acceleration fit against it.
+static bool CheckPositionEstimators() {
+  constexpr size_t kPushCount = PositionHistory::kCapacity + 5;
+  constexpr s32 kTickSpacing = 10;
+  const Vector2f initial_velocity(-5.0f, 2.0f);
+  // Tiles per second squared.
+  const Vector2f acceleration(3.0f, -1.5f);
+  const Tick start_tick = MAKE_TICK(0x7FFFFFFF - 100);
+
+  auto expected_velocity = [&](s32 ticks_from_start) {
+    return initial_velocity + acceleration * (ticks_from_start / 100.0f);
+  };
+
+  PositionHistory history;
+  history.Clear();
+
+  Vector2f estimate;
+
+  if (history.GetAcceleration(&estimate) || history.GetSmoothedVelocity(4) != Vector2f(0, 0)) {
+    printf("position estimators returned a result for an empty history\n");
+    return false;
+  }
+
+  for (size_t i = 0; i < kPushCount; ++i) {
+    s32 offset = (s32)i * kTickSpacing;
+    history.Push(MAKE_TICK(start_tick + offset), Vector2f(512, 512), expected_velocity(offset));
+  }
+
+  s32 newest_offset = (s32)(kPushCount - 1) * kTickSpacing;
+
+  // The newest four samples average out to the velocity halfway between the first and the fourth.
+  Vector2f smoothed = history.GetSmoothedVelocity(4);
+  Vector2f expected = expected_velocity(newest_offset - kTickSpacing * 3 / 2);
+
+  if (smoothed.DistanceSq(expected) > 0.0001f) {
+    printf("smoothed velocity is (%f, %f) expected (%f, %f)\n", smoothed.x, smoothed.y, expected.x, expected.y);
+    return false;
+  }
+
+  // Samples older than max_ticks are left out, which leaves only the newest one here.
+  smoothed = history.GetSmoothedVelocity(4, kTickSpacing - 1);
+  expected = expected_velocity(newest_offset);
+
+  if (smoothed.DistanceSq(expected) > 0.0001f) {
+    printf("smoothed velocity within %d ticks is (%f, %f) expected (%f, %f)\n", kTickSpacing - 1, smoothed.x,
+           smoothed.y, expected.x, expected.y);
+    return false;
+  }
+
+  // The fit is exact for constant acceleration, both over the whole history and over the last few samples.
+  for (s32 max_ticks : {1000, kTickSpacing * 2}) {
+    if (!history.GetAcceleration(&estimate, max_ticks) || estimate.DistanceSq(acceleration) > 0.001f) {
+      printf("acceleration within %d ticks is (%f, %f) expected (%f, %f)\n", max_ticks, estimate.x, estimate.y,
+             acceleration.x, acceleration.y);
+      return false;
+    }
+  }
+
+  // A single sample isn't enough to estimate from.
+  if (history.GetAcceleration(&estimate, kTickSpacing - 1)) {
+    printf("acceleration was estimated from one sample\n");
+    return false;
+  }
+
+  return true;
+}
+
+// The batched position decode from before entries were read straight out of the packet.
+static size_t DecodeBatchedPositionsReference(u8* pkt, size_t size, bool large, BatchedPositionEntry* out) {
+  NetworkBuffer buffer(pkt, size, size);
+
+  buffer.ReadU8();  // Type
+
+  size_t entry_size = large ? 11 : 10;
+  size_t count = 0;
+
+  while (buffer.write - buffer.read >= (ptrdiff_t)entry_size) {
+    BatchedPositionEntry& entry = out[count++];
+
+    if (large) {
+      u16 pid_togglables = buffer.ReadU16();
+
+      entry.player_id = pid_togglables & 0x3FF;
+      entry.togglables = (u8)(pid_togglables >> 10);
+    } else {
+      entry.player_id = buffer.ReadU8();
+      entry.togglables = 0;
+    }
+
+    u16 packed = buffer.ReadU16();
+    entry.direction = (u8)(packed >> 10);
+    entry.timestamp = (packed & 0x3FF);
+
+    u32 packed_pos = buffer.ReadU32();
+    u32 x = packed_pos & 0x3FFF;
+    u32 y = (packed_pos >> 0x0E) & 0x3FFF;
+
+    u16 packed_velocity = buffer.ReadU16();
+    s16 vel_y = (packed_velocity << 0x12) >> 0x12;
+
+    s8 multiplier = buffer.ReadU8();
+
+    s32 vel_x = ((packed_velocity >> 0x0E) + (multiplier * 4)) * 0x10 + (packed_pos >> 0x1C);
+
+    entry.velocity = Vector2f(vel_x / 16.0f / 10.0f, vel_y / 16.0f / 10.0f);
+    entry.position = Vector2f(x / 16.0f, y / 16.0f);
+  }
+
+  return count;
+}
+
+static size_t DecodeBatchedPositions(const u8* pkt, size_t size, const BatchedPositionFormat& format,
+                                     BatchedPositionEntry* out) {
+  size_t entry_count = (size - 1) / format.entry_size;
+  const u8* entry = pkt + 1;
+
+  for (size_t i = 0; i < entry_count; ++i, entry += format.entry_size) {
+    BatchedPositionEntry::Decode(entry, format, out[i]);
+  }
+
+  return entry_count;
+}
+
+static bool IsSameEntry(const BatchedPositionEntry& a, const BatchedPositionEntry& b) {
+  return a.player_id == b.player_id && a.togglables == b.togglables && a.direction == b.direction &&
+         a.timestamp == b.timestamp && a.position.x == b.position.x && a.position.y == b.position.y &&
+         a.velocity.x == b.velocity.x && a.velocity.y == b.velocity.y;
+}
+
+// Decodes random batched packets of both formats with the old and new decoders, checks they match and times both.
+static bool CheckBatchedPositions(size_t iterations) {
+  constexpr size_t kPacketCount = 256;
+  constexpr size_t kMaxPacketSize = 512;
+  constexpr size_t kMaxEntries = kMaxPacketSize / 10;
+
+  std::vector<u8> packets(kPacketCount * kMaxPacketSize);
+  size_t sizes[kPacketCount];
+
+  BatchedPositionEntry expected[kMaxEntries];
+  BatchedPositionEntry result[kMaxEntries];
+
+  bool success = true;
+
+  for (int large = 0; large < 2; ++large) {
+    const BatchedPositionFormat& format = large ? kBatchedLargePositionFormat : kBatchedSmallPositionFormat;
+
+    for (size_t i = 0; i < kPacketCount; ++i) {
+      u8* pkt = packets.data() + i * kMaxPacketSize;
+
+      // Random sizes so trailing partial entries are covered.
+      sizes[i] = 1 + NextRandom() % (kMaxPacketSize - 1);
+
+      for (size_t j = 0; j < sizes[i]; ++j) {
+        pkt[j] = (u8)NextRandom();
+      }
+
+      size_t expected_count = DecodeBatchedPositionsReference(pkt, sizes[i], large, expected);
+      size_t count = DecodeBatchedPositions(pkt, sizes[i], format, result);
+
+      if (count != expected_count) {
+        printf("batched %s position entry count %zu expected %zu\n", large ? "large" : "small", count,
+               expected_count);
+        success = false;
+        continue;
+      }
+
+      for (size_t j = 0; j < count; ++j) {
+        if (!IsSameEntry(result[j], expected[j]) ||
+            BatchedPositionEntry::GetPlayerId(pkt + 1 + j * format.entry_size, format) != expected[j].player_id) {
+          printf("batched %s position entry %zu of packet %zu doesn't match\n", large ? "large" : "small", j, i);
+          success = false;
+          break;
+        }
+      }
+    }
+
+    size_t packet_iterations = iterations / 50 + 1;
+
+    u64 reference_us = Time(packet_iterations * kPacketCount, [&](size_t n) {
+      size_t i = n % kPacketCount;
+      size_t count = DecodeBatchedPositionsReference(packets.data() + i * kMaxPacketSize, sizes[i], large, expected);
+      if (count > 0) Sink(expected[count - 1].position.x);
+    });
+
+    u64 decode_us = Time(packet_iterations * kPacketCount, [&](size_t n) {
+      size_t i = n % kPacketCount;
+      size_t count = DecodeBatchedPositions(packets.data() + i * kMaxPacketSize, sizes[i], format, result);
+      if (count > 0) Sink(result[count - 1].position.x);
+    });
+
+    PrintTiming(large ? "batched large" : "batched small", decode_us, "old", reference_us,
+                packet_iterations * kPacketCount);
+  }
+
+  return success;
+}
+
+int main(int argc, char* argv[]) {
+  ArgParser args(argc, argv);
+
+  if (args.HasParameter({"help", "h"})) {
+    PrintUsage(argv[0]);
+    return 0;
+  }
+
+  size_t players = GetCount(args, "players", 1024);
+  size_t iterations = GetCount(args, "iterations", 20000);
+  size_t stride = GetCount(args, "stride", 64);
+
+  if (players == 0) players = 1;
+  if (stride == 0) stride = 1;
+
+  bool success = Report("player grid", CheckPlayerGrid());
+  success &= Report("position history", CheckPositionHistory());
+  success &= Report("position estimators", CheckPositionEstimators());
+  success &= Report("batched positions", CheckBatchedPositions(iterations));
+
+  std::vector<Player> hot(players * stride);
+  std::vector<CombinedPlayer> combined(players * stride);
+
+  float hot_result = 0.0f;
+  float combined_result = 0.0f;
+
+  u64 hot_us = TimeSweeps(hot, players, stride, iterations, &hot_result);
+  u64 combined_us = TimeSweeps(combined, players, stride, iterations, &combined_result);
+
+  bool sweep_success = hot_result == combined_result;
+
+  if (!sweep_success) {
+    printf("sweep result mismatch: %f expected %f\n", hot_result, combined_result);
+  }
+
+  for (size_t i = 0; i < stride; ++i) {
+    sweep_success &= CheckPositions(combined.data() + i * players, hot.data() + i * players, players);
+  }
+
+  success &= Report("player sweep", sweep_success);
+
+  printf("player sweep (%zu players, %zu arrays, hot %zu bytes, combined %zu bytes)\n", players, stride, sizeof(Player),
+         sizeof(CombinedPlayer));
+  PrintTiming("hot", hot_us, "combined", combined_us, iterations);
+
+  return success ? 0 : 1;
+}
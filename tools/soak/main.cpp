@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <string.h>
+#include <tools/common/Check.h>
+#include <zero/Args.h>
+#include <zero/Types.h>
+#include <zero/game/Clock.h>
+#include <zero/game/Logger.h>
+#include <zero/game/Memory.h>
+#include <zero/game/WorkQueue.h>
+#include <zero/game/net/Connection.h>
+#include <zero/game/net/LoopbackTransport.h>
+
+// Drives two connections against each other over a loopback link and checks that every reliable message arrives
+// exactly once and in order. A steady link that loses nothing runs first and must not resend anything.
+
+namespace zero {
+
+// The client objects expect these from the executable. The soak test never talks to a solver or downloads files.
+const char* kSecurityServiceIp = "127.0.0.1";
+const char* kServerName = "soak";
+
+}  // namespace zero
+
+using namespace zero;
+using namespace zero::tools;
+
+constexpr u32 kVieClientKey = 0x8A3C5E71;
+
+// Payloads are a chat type byte, the message number and filler that is derived from the number so corruption and
+// mixed up messages are both caught.
+constexpr size_t kMessageHeaderSize = 5;
+constexpr size_t kMaxFillerSize = 200;
+
+// New messages are only sent while fewer than this many are unacknowledged, which keeps the window from growing
+// without bound when the link is very lossy.
+constexpr u32 kMaxInFlight = 128;
+constexpr u32 kMessagesPerTick = 8;
+
+static void PrintUsage(const char* exe_name) {
+  printf(
+      "Usage: %s [OPTION]\n"
+      "Sends reliable messages both ways between two connections over a loopback link and checks delivery.\n"
+      "A link that loses nothing runs first and must not resend anything, then the lossy link set below.\n"
+      "\n"
+      "--messages <count>\t\treliable messages to send in each direction (default 20000)\n"
+      "--loss <chance>\t\t\tchance from 0 to 1 that a datagram is dropped (default 0.1)\n"
+      "--reorder <chance>\t\tchance from 0 to 1 that a datagram is delayed past later ones (default 0.1)\n"
+      "--duplicate <chance>\t\tchance from 0 to 1 that a datagram is delivered twice (default 0.05)\n"
+      "--latency <ms>\t\t\tone way delay (default 50)\n"
+      "--jitter <ms>\t\t\trandom extra delay up to this (default 20)\n"
+      "--seed <value>\t\t\tseed for the link conditions (default 1)\n"
+      "--ticks <count>\t\t\tgive up after this many ticks (default 200000)\n"
+      "",
+      exe_name);
+}
+
+static size_t GetFillerSize(u32 number) {
+  return (number * 37) % kMaxFillerSize;
+}
+
+static u8 GetFiller(u32 number, size_t index) {
+  return (u8)(number * 7 + index * 13);
+}
+
+struct SoakEndpoint {
+  const char* name = nullptr;
+
+  PacketDispatcher dispatcher;
+  Connection* connection = nullptr;
+
+  u32 next_send = 0;
+  u32 next_expected = 0;
+  // Set on the first message that is out of order, repeated or corrupted.
+  bool failed = false;
+
+  inline bool HasReceivedAll(u32 count) const { return next_expected >= count; }
+};
+
+static void OnChat(void* user, u8* pkt, size_t size) {
+  SoakEndpoint* endpoint = (SoakEndpoint*)user;
+
+  if (endpoint->failed) return;
+
+  if (size < kMessageHeaderSize) {
+    printf("%s: message of size %zu is too small\n", endpoint->name, size);
+    endpoint->failed = true;
+    return;
+  }
+
+  u32 number;
+  memcpy(&number, pkt + 1, sizeof(number));
+
+  if (number != endpoint->next_expected) {
+    printf("%s: received message %u, expected %u\n", endpoint->name, number, endpoint->next_expected);
+    endpoint->failed = true;
+    return;
+  }
+
+  size_t filler_size = GetFillerSize(number);
+
+  if (size != kMessageHeaderSize + filler_size) {
+    printf("%s: message %u has size %zu, expected %zu\n", endpoint->name, number, size,
+           kMessageHeaderSize + filler_size);
+    endpoint->failed = true;
+    return;
+  }
+
+  for (size_t i = 0; i < filler_size; ++i) {
+    if (pkt[kMessageHeaderSize + i] != GetFiller(number, i)) {
+      printf("%s: message %u is corrupted at byte %zu\n", endpoint->name, number, kMessageHeaderSize + i);
+      endpoint->failed = true;
+      return;
+    }
+  }
+
+  ++endpoint->next_expected;
+}
+
+static void SendMessages(SoakEndpoint& endpoint, u32 count) {
+  PacketSequencer& sequencer = endpoint.connection->packet_sequencer;
+
+  for (u32 i = 0; i < kMessagesPerTick && endpoint.next_send < count; ++i) {
+    if (sequencer.next_reliable_id - sequencer.reliable_sent.base >= kMaxInFlight) break;
+
+    u32 number = endpoint.next_send++;
+    size_t filler_size = GetFillerSize(number);
+    u8 message[kMessageHeaderSize + kMaxFillerSize];
+
+    message[0] = (u8)ProtocolS2C::Chat;
+    memcpy(message + 1, &number, sizeof(number));
+
+    for (size_t j = 0; j < filler_size; ++j) {
+      message[kMessageHeaderSize + j] = GetFiller(number, j);
+    }
+
+    sequencer.SendReliableMessage(*endpoint.connection, message, kMessageHeaderSize + filler_size);
+  }
+}
+
+static void SetupEndpoint(SoakEndpoint& endpoint, const char* name, MemoryArena& perm_arena, MemoryArena& temp_arena,
+                          WorkQueue& work_queue, Transport& transport) {
+  endpoint.name = name;
+  endpoint.dispatcher.Register(ProtocolS2C::Chat, OnChat, &endpoint);
+
+  endpoint.connection = memory_arena_construct_type(&perm_arena, Connection, perm_arena, temp_arena, work_queue,
+                                                    endpoint.dispatcher);
+
+  Connection& connection = *endpoint.connection;
+
+  // Both ends use the same VIE session key so the encryption path is part of the soak.
+  connection.encrypt_method = EncryptMethod::Subspace;
+  connection.vie_encrypt.client_key = kVieClientKey;
+  connection.vie_encrypt.Initialize(~kVieClientKey + 1);
+  connection.login_state = Connection::LoginState::Complete;
+  connection.Connect(transport);
+}
+
+static void PrintEndpoint(const SoakEndpoint& endpoint) {
+  const ReliableStatistics& stats = endpoint.connection->packet_sequencer.stats;
+
+  printf("  %-6s sent %llu  resends %llu  received %u  out of order %llu  duplicates %llu\n", endpoint.name,
+         (unsigned long long)stats.messages_sent, (unsigned long long)stats.resends, endpoint.next_expected,
+         (unsigned long long)stats.out_of_order, (unsigned long long)stats.duplicates);
+}
+
+static void PrintChannel(const char* name, const LoopbackChannelStatistics& stats) {
+  printf("  %-10s datagrams %llu  dropped %llu  reordered %llu  duplicated %llu  overflowed %llu\n", name,
+         (unsigned long long)stats.sent, (unsigned long long)stats.dropped, (unsigned long long)stats.reordered,
+         (unsigned long long)stats.duplicated, (unsigned long long)stats.overflowed);
+}
+
+struct SoakContext {
+  MemoryArena& perm_arena;
+  MemoryArena& temp_arena;
+  WorkQueue& work_queue;
+
+  u32 message_count;
+  u32 max_ticks;
+
+  Tick tick;
+};
+
+// Runs one link until every message arrives both ways. With allow_resends false any resend fails the run, which is
+// how a link that loses nothing must behave: a resend there means the timeout fired before an on-time ack was read.
+static bool RunSoak(SoakContext& ctx, const char* name, const LoopbackConditions& conditions, u64 seed,
+                    bool allow_resends) {
+  LoopbackLink* link = memory_arena_construct_type(&ctx.perm_arena, LoopbackLink, ctx.perm_arena, seed);
+  link->SetConditions(conditions);
+
+  SoakEndpoint* client = memory_arena_construct_type(&ctx.perm_arena, SoakEndpoint);
+  SoakEndpoint* server = memory_arena_construct_type(&ctx.perm_arena, SoakEndpoint);
+
+  SetupEndpoint(*client, "client", ctx.perm_arena, ctx.temp_arena, ctx.work_queue, link->client);
+  SetupEndpoint(*server, "server", ctx.perm_arena, ctx.temp_arena, ctx.work_queue, link->server);
+
+  u32 message_count = ctx.message_count;
+  Tick start_tick = ctx.tick;
+  bool closed = false;
+
+  while (!client->failed && !server->failed && TICK_DIFF(ctx.tick, start_tick) < (s32)ctx.max_ticks) {
+    if (client->HasReceivedAll(message_count) && server->HasReceivedAll(message_count)) break;
+
+    SetVirtualTick(++ctx.tick);
+
+    SendMessages(*client, message_count);
+    SendMessages(*server, message_count);
+
+    if (client->connection->Tick() != Connection::TickResult::Success ||
+        server->connection->Tick() != Connection::TickResult::Success) {
+      closed = true;
+      break;
+    }
+
+    ctx.temp_arena.Reset();
+  }
+
+  bool complete = client->HasReceivedAll(message_count) && server->HasReceivedAll(message_count);
+  bool success = complete && !client->failed && !server->failed;
+
+  printf("%s: %u messages each way, loss %.2f reorder %.2f duplicate %.2f, finished in %d ticks\n", name,
+         message_count, conditions.loss, conditions.reorder, conditions.duplicate, TICK_DIFF(ctx.tick, start_tick));
+  PrintEndpoint(*client);
+  PrintEndpoint(*server);
+  PrintChannel("to server", link->to_server.stats);
+  PrintChannel("to client", link->to_client.stats);
+
+  if (closed) {
+    printf("connection closed before every message arrived\n");
+  } else if (!complete && !client->failed && !server->failed) {
+    printf("gave up after %u ticks\n", ctx.max_ticks);
+  }
+
+  if (!allow_resends) {
+    u64 resends = client->connection->packet_sequencer.stats.resends;
+    resends += server->connection->packet_sequencer.stats.resends;
+
+    if (resends > 0) {
+      printf("%llu resends on a link that lost nothing\n", (unsigned long long)resends);
+      success = false;
+    }
+  }
+
+  return Report(name, success);
+}
+
+int main(int argc, char* argv[]) {
+  ArgParser args(argc, argv);
+
+  if (args.HasParameter({"help", "h"})) {
+    PrintUsage(argv[0]);
+    return 0;
+  }
+
+  // Unhandled packets and dropped datagrams are expected here, so only report real problems.
+  g_LogPrintLevel = LogLevel::Warning;
+
+  u64 seed = GetCount(args, "seed", 1);
+
+  LoopbackConditions conditions;
+  conditions.loss = GetFloat(args, "loss", 0.1f);
+  conditions.reorder = GetFloat(args, "reorder", 0.1f);
+  conditions.duplicate = GetFloat(args, "duplicate", 0.05f);
+  conditions.latency_us = (u32)GetCount(args, "latency", 50) * 1000;
+  conditions.jitter_us = (u32)GetCount(args, "jitter", 20) * 1000;
+
+  // The steady link has the same latency but never drops, delays or repeats anything.
+  LoopbackConditions steady_conditions;
+  steady_conditions.loss = 0.0f;
+  steady_conditions.reorder = 0.0f;
+  steady_conditions.duplicate = 0.0f;
+  steady_conditions.latency_us = conditions.latency_us;
+  steady_conditions.jitter_us = 0;
+
+  MemoryArena perm_arena = ReserveArena("perm", Megabytes(256), HugePageMode::None);
+  MemoryArena temp_arena = ReserveArena("temp", Megabytes(16), HugePageMode::None);
+  MemoryArena work_arena = ReserveArena("work", Megabytes(4), HugePageMode::None);
+
+  if (!perm_arena.base || !temp_arena.base || !work_arena.base) {
+    printf("Failed to reserve memory.\n");
+    return 1;
+  }
+
+  WorkQueue* work_queue = new WorkQueue(work_arena, 1);
+
+  // The virtual clock makes the run deterministic for a seed. It starts past zero so tick differences stay positive.
+  SoakContext ctx = {perm_arena, temp_arena, *work_queue};
+  ctx.message_count = (u32)GetCount(args, "messages", 20000);
+  ctx.max_ticks = (u32)GetCount(args, "ticks", 200000);
+  ctx.tick = 1000;
+  SetVirtualTick(ctx.tick);
+
+  bool success = RunSoak(ctx, "steady link", steady_conditions, seed, false);
+  success &= RunSoak(ctx, "soak", conditions, seed, true);
+
+  return success ? 0 : 1;
+}
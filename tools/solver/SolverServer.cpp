@@ -0,0 +1,281 @@
+#include "SolverServer.h"
+
+#ifdef _WIN32
+#include <WS2tcpip.h>
+#include <Windows.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define closesocket close
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <zero/game/Clock.h>
+#include <zero/game/Logger.h>
+
+#include <new>
+
+namespace zero {
+
+constexpr size_t kRequestSize = 5;
+constexpr size_t kKeystreamResponseSize = 85;
+constexpr size_t kChecksumResponseSize = 9;
+
+// Stands in for the real algorithms. Any well mixed function of the key works since nothing verifies the result.
+static u32 Mix(u32 x) {
+  x ^= x >> 16;
+  x *= 0x7FEB352D;
+  x ^= x >> 15;
+  x *= 0x846CA68B;
+  x ^= x >> 16;
+  return x;
+}
+
+bool SolverServer::Initialize() {
+#ifdef _WIN32
+  WSADATA wsa;
+  if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+#endif
+
+  listen_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+  if (listen_fd < 0) {
+    Log(LogLevel::Error, "Failed to create socket.");
+    return false;
+  }
+
+  int reuse = 1;
+  setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(config.port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  if (bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 64) != 0) {
+    Log(LogLevel::Error, "Failed to listen on port %d.", (int)config.port);
+    return false;
+  }
+
+  clients = memory_arena_push_type_count(&arena, SolverClient, kMaxClients);
+
+  if (!clients) {
+    Log(LogLevel::Error, "Failed to allocate solver state.");
+    return false;
+  }
+
+  for (size_t i = 0; i < kMaxClients; ++i) {
+    new (clients + i) SolverClient();
+  }
+
+  Log(LogLevel::Info, "Solver listening on port %d.", (int)config.port);
+
+  return true;
+}
+
+void SolverServer::Run() {
+  last_stats_us = GetMicrosecondTick();
+
+  while (true) {
+    fd_set read_set;
+    FD_ZERO(&read_set);
+    FD_SET(listen_fd, &read_set);
+
+    SocketType max_fd = listen_fd;
+    bool has_pending = false;
+
+    for (size_t i = 0; i < kMaxClients; ++i) {
+      SolverClient& client = clients[i];
+
+      if (client.fd == -1) continue;
+
+      FD_SET(client.fd, &read_set);
+
+      if (client.fd > max_fd) max_fd = client.fd;
+      if (client.pending_count > 0) has_pending = true;
+    }
+
+    // Delayed responses are checked every millisecond while any are waiting.
+    timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = has_pending ? 1000 : 100000;
+
+    int ready = select((int)max_fd + 1, &read_set, nullptr, nullptr, &timeout);
+    u64 now_us = GetMicrosecondTick();
+
+    if (ready > 0 && FD_ISSET(listen_fd, &read_set)) {
+      Accept();
+    }
+
+    for (size_t i = 0; i < kMaxClients; ++i) {
+      SolverClient& client = clients[i];
+
+      if (client.fd == -1) continue;
+
+      if (ready > 0 && FD_ISSET(client.fd, &read_set) && !Receive(client, now_us)) {
+        Disconnect(client);
+        continue;
+      }
+
+      if (!SendDue(client, now_us)) {
+        Disconnect(client);
+      }
+    }
+
+    if (now_us - last_stats_us >= (u64)(config.stats_interval * 1000000.0f)) {
+      PrintStatistics(now_us);
+    }
+  }
+}
+
+void SolverServer::Accept() {
+  SocketType fd = accept(listen_fd, nullptr, nullptr);
+
+  if (fd < 0) return;
+
+  SolverClient* client = nullptr;
+
+  for (size_t i = 0; i < kMaxClients; ++i) {
+    if (clients[i].fd == -1) {
+      client = clients + i;
+      break;
+    }
+  }
+
+  if (!client) {
+    closesocket(fd);
+    return;
+  }
+
+  int nodelay = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (const char*)&nodelay, sizeof(nodelay));
+
+  client->fd = fd;
+  client->recv_size = 0;
+  client->pending_start = 0;
+  client->pending_count = 0;
+
+  ++stats.connections;
+}
+
+bool SolverServer::Receive(SolverClient& client, u64 now_us) {
+  int bytes_received = recv(client.fd, (char*)client.recv_buffer + client.recv_size,
+                            (int)(sizeof(client.recv_buffer) - client.recv_size), 0);
+
+  if (bytes_received <= 0) return false;
+
+  client.recv_size += bytes_received;
+
+  size_t offset = 0;
+
+  for (; offset + kRequestSize <= client.recv_size; offset += kRequestSize) {
+    if (client.recv_buffer[offset] > 1) {
+      Log(LogLevel::Warning, "Received unknown request type %d.", (int)client.recv_buffer[offset]);
+      return false;
+    }
+
+    OnRequest(client, client.recv_buffer + offset, now_us);
+  }
+
+  client.recv_size -= offset;
+  memmove(client.recv_buffer, client.recv_buffer + offset, client.recv_size);
+
+  return true;
+}
+
+void SolverServer::OnRequest(SolverClient& client, const u8* request, u64 now_us) {
+  ++stats.requests;
+
+  if (config.drop > 0.0f && (float)rand() / (float)RAND_MAX < config.drop) {
+    ++stats.dropped;
+    return;
+  }
+
+  if (client.pending_count >= SolverClient::kPendingCapacity) {
+    ++stats.dropped;
+    return;
+  }
+
+  SolverResponse* response =
+      client.pending + (client.pending_start + client.pending_count++) % SolverClient::kPendingCapacity;
+
+  if (client.pending_count > stats.max_pipelined) {
+    stats.max_pipelined = client.pending_count;
+  }
+
+  u32 key;
+  memcpy(&key, request + 1, sizeof(key));
+
+  // Responses echo the type and key so the client can match them to requests.
+  response->due_us = now_us + config.delay_ms * 1000ULL;
+  response->data[0] = request[0];
+  memcpy(response->data + 1, &key, sizeof(key));
+
+  if (request[0] == 0) {
+    response->size = (u8)kKeystreamResponseSize;
+
+    for (u32 i = 0; i < 20; ++i) {
+      u32 value = Mix(key + i * 0x9E3779B9);
+      memcpy(response->data + 5 + i * sizeof(u32), &value, sizeof(value));
+    }
+  } else {
+    response->size = (u8)kChecksumResponseSize;
+
+    u32 checksum = Mix(key ^ 0x5EC0DE);
+    memcpy(response->data + 5, &checksum, sizeof(checksum));
+  }
+}
+
+bool SolverServer::SendDue(SolverClient& client, u64 now_us) {
+  while (client.pending_count > 0) {
+    SolverResponse* response = client.pending + client.pending_start;
+
+    if (response->due_us > now_us) break;
+
+    if (send(client.fd, (const char*)response->data, response->size, 0) != response->size) {
+      return false;
+    }
+
+    client.pending_start = (client.pending_start + 1) % SolverClient::kPendingCapacity;
+    --client.pending_count;
+
+    ++stats.responses;
+
+    if (config.one_shot) return false;
+  }
+
+  return true;
+}
+
+void SolverServer::Disconnect(SolverClient& client) {
+  closesocket(client.fd);
+
+  client.fd = -1;
+  client.recv_size = 0;
+  client.pending_count = 0;
+}
+
+void SolverServer::PrintStatistics(u64 now_us) {
+  float seconds = (now_us - last_stats_us) / 1000000.0f;
+
+  size_t connected_count = 0;
+
+  for (size_t i = 0; i < kMaxClients; ++i) {
+    if (clients[i].fd != -1) ++connected_count;
+  }
+
+  Log(LogLevel::Info,
+      "connections: %zu open, %llu new  requests: %.0f/s  responses: %.0f/s  dropped: %llu  max pipelined: %zu",
+      connected_count, (unsigned long long)stats.connections, stats.requests / seconds, stats.responses / seconds,
+      (unsigned long long)stats.dropped, stats.max_pipelined);
+
+  stats = {};
+  last_stats_us = now_us;
+}
+
+}  // namespace zero
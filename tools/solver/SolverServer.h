@@ -0,0 +1,86 @@
+#ifndef ZERO_TOOLS_SOLVERSERVER_H_
+#define ZERO_TOOLS_SOLVERSERVER_H_
+
+#include <zero/Types.h>
+#include <zero/game/Memory.h>
+#include <zero/game/net/Socket.h>
+
+namespace zero {
+
+// Stand-in security solver service for testing the bot's solver connection on localhost.
+// It speaks the same protocol as the real service, but the keystreams and checksums are made up, so it only works with
+// zones that don't verify them, like zero-zone.
+
+struct SolverConfig {
+  u16 port = 8085;
+
+  // Milliseconds to hold each response before sending it.
+  u32 delay_ms = 0;
+  // Chance from 0 to 1 that a request is never answered.
+  float drop = 0.0f;
+  // Close the connection after every response instead of keeping it open.
+  bool one_shot = false;
+
+  // Seconds between statistics output.
+  float stats_interval = 5.0f;
+};
+
+struct SolverResponse {
+  u64 due_us;
+  u8 size;
+  u8 data[85];
+};
+
+struct SolverClient {
+  SocketType fd = -1;
+
+  u8 recv_buffer[256];
+  size_t recv_size;
+
+  // Responses waiting for their delay to pass, in request order.
+  static constexpr size_t kPendingCapacity = 64;
+  SolverResponse pending[kPendingCapacity];
+  size_t pending_start;
+  size_t pending_count;
+};
+
+struct SolverStatistics {
+  u64 connections = 0;
+  u64 requests = 0;
+  u64 responses = 0;
+  u64 dropped = 0;
+  // Most requests waiting on one connection at the same time since the last report.
+  size_t max_pipelined = 0;
+};
+
+struct SolverServer {
+  static constexpr size_t kMaxClients = 256;
+
+  MemoryArena& arena;
+  SolverConfig config;
+
+  SocketType listen_fd = -1;
+  SolverClient* clients = nullptr;
+
+  SolverStatistics stats;
+  u64 last_stats_us = 0;
+
+  SolverServer(MemoryArena& arena, const SolverConfig& config) : arena(arena), config(config) {}
+
+  bool Initialize();
+  void Run();
+
+  void Accept();
+  // Returns false if the client disconnected.
+  bool Receive(SolverClient& client, u64 now_us);
+  bool SendDue(SolverClient& client, u64 now_us);
+
+  void OnRequest(SolverClient& client, const u8* request, u64 now_us);
+  void Disconnect(SolverClient& client);
+
+  void PrintStatistics(u64 now_us);
+};
+
+}  // namespace zero
+
+#endif
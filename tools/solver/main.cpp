@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <zero/Args.h>
+#include <zero/game/Logger.h>
+#include <zero/game/Memory.h>
+
+#include "SolverServer.h"
+
+static void PrintUsage(const char* exe_name) {
+  printf(
+      "Usage: %s [OPTION]\n"
+      "Stand-in security solver service for testing bots on localhost.\n"
+      "Keystreams and checksums are not real, so only use it with zones that don't verify them.\n"
+      "\n"
+      "--port <port>\t\t\tport to listen on (default 8085)\n"
+      "--delay <ms>\t\t\tmilliseconds to hold each response (default 0)\n"
+      "--drop <chance>\t\t\tchance from 0 to 1 that a request is never answered (default 0)\n"
+      "--one-shot\t\t\tclose the connection after every response\n"
+      "--stats <seconds>\t\tseconds between statistics output (default 5)\n"
+      "",
+      exe_name);
+}
+
+int main(int argc, char* argv[]) {
+  using namespace zero;
+
+  srand((unsigned int)time(NULL));
+
+  g_LogPrintLevel = LogLevel::Info;
+
+  ArgParser args(argc, argv);
+
+  if (args.HasParameter({"help", "h"})) {
+    PrintUsage(argv[0]);
+    return 0;
+  }
+
+  SolverConfig config;
+
+  std::string_view port = args.GetValue("port");
+  std::string_view delay = args.GetValue("delay");
+  std::string_view drop = args.GetValue("drop");
+  std::string_view stats_interval = args.GetValue("stats");
+
+  if (!port.empty()) config.port = (u16)strtol(port.data(), nullptr, 10);
+  if (!delay.empty()) config.delay_ms = (u32)strtol(delay.data(), nullptr, 10);
+  if (!drop.empty()) config.drop = strtof(drop.data(), nullptr);
+  if (!stats_interval.empty()) config.stats_interval = strtof(stats_interval.data(), nullptr);
+
+  config.one_shot = args.HasParameter("one-shot");
+
+  constexpr size_t kArenaSize = Megabytes(16);
+
+  u8* memory = (u8*)malloc(kArenaSize);
+  if (!memory) {
+    Log(LogLevel::Error, "Failed to allocate memory.");
+    return 1;
+  }
+
+  MemoryArena arena(memory, kArenaSize);
+  SolverServer* server = memory_arena_construct_type(&arena, SolverServer, arena, config);
+
+  if (!server->Initialize()) {
+    return 1;
+  }
+
+  server->Run();
+
+  return 0;
+}
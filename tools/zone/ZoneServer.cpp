@@ -0,0 +1,1105 @@
+#include "ZoneServer.h"
+
+#ifdef _WIN32
+#include <WS2tcpip.h>
+#include <Windows.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define closesocket close
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zero/game/Buffer.h>
+#include <zero/game/Logger.h>
+#include <zero/game/net/Protocol.h>
+#include <zero/game/net/security/Checksum.h>
+
+#include <chrono>
+#include <thread>
+
+namespace zero {
+
+constexpr s32 kClientTimeout = 1000;
+constexpr s32 kReliableResendDelay = 30;
+constexpr u16 kServerVersion = 134;
+constexpr u8 kSpectatorShip = 8;
+
+// Reliable header is 6 bytes, so this is the largest payload that fits in one datagram.
+constexpr size_t kMaxReliablePayload = kMaxPacketSize - 6;
+// Huge chunk header is 6 bytes inside of the reliable payload.
+constexpr size_t kMaxHugeChunkPayload = kMaxReliablePayload - 6;
+// Small chunk header is 2 bytes inside of the reliable payload.
+constexpr size_t kMaxSmallChunkPayload = kMaxReliablePayload - 2;
+
+constexpr size_t kPlayerEnteringSize = 64;
+
+static const char kEmptySquad[20] = {};
+
+static inline float RandomFloat(float min, float max) {
+  return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+static u32 Adler32(const u8* data, size_t size) {
+  u32 a = 1;
+  u32 b = 0;
+
+  for (size_t i = 0; i < size; ++i) {
+    a = (a + data[i]) % 65521;
+    b = (b + a) % 65521;
+  }
+
+  return (b << 16) | a;
+}
+
+// Wraps the data in a zlib stream made of stored blocks. The client only needs to be able to inflate it, so there's
+// no reason to pull in a compressor.
+static size_t WriteStoredZlib(u8* dest, const u8* data, size_t size) {
+  u8* out = dest;
+
+  *out++ = 0x78;
+  *out++ = 0x01;
+
+  size_t offset = 0;
+
+  do {
+    size_t block_size = size - offset;
+    if (block_size > 0xFFFF) block_size = 0xFFFF;
+
+    bool final = offset + block_size >= size;
+    u16 len = (u16)block_size;
+    u16 nlen = (u16)~len;
+
+    *out++ = final ? 0x01 : 0x00;
+    memcpy(out, &len, sizeof(len));
+    out += sizeof(len);
+    memcpy(out, &nlen, sizeof(nlen));
+    out += sizeof(nlen);
+    memcpy(out, data + offset, block_size);
+    out += block_size;
+
+    offset += block_size;
+  } while (offset < size);
+
+  u32 adler = Adler32(data, size);
+
+  *out++ = (u8)(adler >> 24);
+  *out++ = (u8)(adler >> 16);
+  *out++ = (u8)(adler >> 8);
+  *out++ = (u8)adler;
+
+  return (size_t)(out - dest);
+}
+
+static size_t GetStoredZlibSize(size_t size) {
+  size_t block_count = size / 0xFFFF + 1;
+
+  return 2 + block_count * 5 + size + 4;
+}
+
+static void WritePlayerEntering(NetworkBuffer& buffer, u8 ship, const char* name, u16 pid, u16 freq) {
+  buffer.WriteU8((u8)ProtocolS2C::PlayerEntering);
+  buffer.WriteU8(ship);
+  buffer.WriteU8(0);  // Audio
+  buffer.WriteString(name, 20);
+  buffer.WriteString(kEmptySquad, 20);
+  buffer.WriteU32(0);  // Kill points
+  buffer.WriteU32(0);  // Flag points
+  buffer.WriteU16(pid);
+  buffer.WriteU16(freq);
+  buffer.WriteU16(0);       // Wins
+  buffer.WriteU16(0);       // Losses
+  buffer.WriteU16(0xFFFF);  // Attach parent
+  buffer.WriteU16(0);       // Flags
+  buffer.WriteU8(0);        // Crown
+}
+
+bool ZoneServer::Initialize() {
+#ifdef _WIN32
+  WSADATA wsa;
+  if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+#endif
+
+  fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+  if (fd < 0) {
+    Log(LogLevel::Error, "Failed to create socket.");
+    return false;
+  }
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(config.port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+  if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+    Log(LogLevel::Error, "Failed to bind to port %d.", (int)config.port);
+    return false;
+  }
+
+#ifdef _WIN32
+  u_long mode = 1;
+  ioctlsocket(fd, FIONBIO, &mode);
+#else
+  int flags = fcntl(fd, F_GETFL, 0);
+  fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+#endif
+
+  clients = memory_arena_push_type_count(&arena, ZoneClient, kMaxClients);
+  synthetic_players = memory_arena_push_type_count(&arena, SyntheticPlayer, kMaxSyntheticPlayers);
+
+  if (!clients || !synthetic_players) {
+    Log(LogLevel::Error, "Failed to allocate zone state.");
+    return false;
+  }
+
+  memset((void*)clients, 0, sizeof(ZoneClient) * kMaxClients);
+
+  if (!LoadSettings() || !LoadMap()) return false;
+
+  CreateSyntheticPlayers();
+
+  Log(LogLevel::Info, "Zone listening on port %d with %zu synthetic players.", (int)config.port,
+      synthetic_player_count);
+
+  return true;
+}
+
+bool ZoneServer::LoadSettings() {
+  memset(&settings, 0, sizeof(settings));
+
+  if (config.settings_path) {
+    FILE* f = fopen(config.settings_path, "rb");
+
+    if (!f || fread(&settings, 1, sizeof(settings), f) != sizeof(settings)) {
+      Log(LogLevel::Error, "Failed to read arena settings from '%s'.", config.settings_path);
+      if (f) fclose(f);
+      return false;
+    }
+
+    fclose(f);
+  } else {
+    settings.ExactDamage = 1;
+
+    for (size_t i = 0; i < 8; ++i) {
+      ShipSettings& ship = settings.ShipSettings[i];
+
+      ship.Radius = 14;
+      ship.InitialEnergy = ship.MaximumEnergy = 1500;
+      ship.InitialRecharge = ship.MaximumRecharge = 400;
+      ship.InitialSpeed = ship.MaximumSpeed = 3000;
+      ship.InitialThrust = ship.MaximumThrust = 16;
+      ship.InitialRotation = ship.MaximumRotation = 300;
+      ship.AfterburnerEnergy = 1200;
+      ship.BulletFireEnergy = 20;
+      ship.MultiFireEnergy = 40;
+      ship.BombFireEnergy = 150;
+      ship.BulletSpeed = 2500;
+      ship.BombSpeed = 2000;
+      ship.BulletFireDelay = 25;
+      ship.MultiFireDelay = 25;
+      ship.BombFireDelay = 100;
+      ship.InitialGuns = 1;
+      ship.MaxGuns = 3;
+      ship.InitialBombs = 1;
+      ship.MaxBombs = 3;
+    }
+
+    settings.BulletDamageLevel = 200 * 1000;
+    settings.BulletDamageUpgrade = 100 * 1000;
+    settings.BombDamageLevel = 500 * 1000;
+    settings.BulletAliveTime = 550;
+    settings.BombAliveTime = 800;
+    settings.MaxFrequency = 10000;
+    settings.EnterDelay = 100;
+    settings.BounceFactor = 16;
+    settings.SendPositionDelay = 10;
+    settings.DoorMode = -1;
+    settings.AllowBombs = 1;
+    settings.AllowGuns = 1;
+
+    for (size_t i = 0; i < 4; ++i) {
+      settings.SpawnSettings[i].X = 512;
+      settings.SpawnSettings[i].Y = 512;
+      settings.SpawnSettings[i].Radius = 32;
+    }
+  }
+
+  settings.Type = (u8)ProtocolS2C::ArenaSettings;
+
+  return true;
+}
+
+bool ZoneServer::LoadMap() {
+  u8* map_data = nullptr;
+  size_t map_size = 0;
+
+  if (config.map_path) {
+    FILE* f = fopen(config.map_path, "rb");
+
+    if (!f) {
+      Log(LogLevel::Error, "Failed to open map '%s'.", config.map_path);
+      return false;
+    }
+
+    fseek(f, 0, SEEK_END);
+    map_size = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    map_data = arena.Allocate(map_size);
+
+    if (fread(map_data, 1, map_size, f) != map_size) {
+      Log(LogLevel::Error, "Failed to read map '%s'.", config.map_path);
+      fclose(f);
+      return false;
+    }
+
+    fclose(f);
+
+    const char* filename = config.map_path;
+    const char* separator = strrchr(filename, '/');
+
+    if (!separator) separator = strrchr(filename, '\\');
+    if (separator) filename = separator + 1;
+
+    strncpy(map_filename, filename, sizeof(map_filename) - 1);
+  } else {
+    // Generate a map with a solid border so the players stay inside.
+    constexpr size_t kBorderTiles = 1024 * 4 - 4;
+
+    map_size = kBorderTiles * sizeof(u32);
+    map_data = arena.Allocate(map_size);
+
+    u32* tiles = (u32*)map_data;
+    size_t tile_count = 0;
+
+    for (u32 i = 0; i < 1024; ++i) {
+      tiles[tile_count++] = i | (0 << 12) | (1 << 24);
+      tiles[tile_count++] = i | (1023 << 12) | (1 << 24);
+    }
+
+    for (u32 i = 1; i < 1023; ++i) {
+      tiles[tile_count++] = 0 | (i << 12) | (1 << 24);
+      tiles[tile_count++] = 1023 | (i << 12) | (1 << 24);
+    }
+
+    strcpy(map_filename, "zone.lvl");
+  }
+
+  map_checksum = crc32(map_data, map_size);
+
+  map_packet = arena.Allocate(17 + GetStoredZlibSize(map_size));
+
+  map_packet[0] = (u8)ProtocolS2C::CompressedMap;
+  memcpy(map_packet + 1, map_filename, 16);
+  map_packet_size = 17 + WriteStoredZlib(map_packet + 17, map_data, map_size);
+
+  Log(LogLevel::Info, "Serving map %s (%zu bytes, checksum %08X).", map_filename, map_size, map_checksum);
+
+  return true;
+}
+
+void ZoneServer::CreateSyntheticPlayers() {
+  synthetic_player_count = config.synthetic_player_count;
+
+  if (synthetic_player_count > kMaxSyntheticPlayers) {
+    synthetic_player_count = kMaxSyntheticPlayers;
+  }
+
+  // The small batch format only has one byte for the player id.
+  if (config.batch_positions && !config.large_batches && synthetic_player_count > 256) {
+    Log(LogLevel::Warning, "Using large position batches because there are more than 256 synthetic players.");
+    config.large_batches = true;
+  }
+
+  for (size_t i = 0; i < synthetic_player_count; ++i) {
+    SyntheticPlayer* player = synthetic_players + i;
+
+    *player = SyntheticPlayer{};
+
+    player->player_id = (u16)i;
+    player->frequency = (u16)(i % 2);
+    player->ship = (u8)(i % 8);
+    snprintf(player->name, sizeof(player->name), "synthetic%zu", i);
+
+    player->position = Vector2f(RandomFloat(448.0f, 576.0f), RandomFloat(448.0f, 576.0f));
+
+    float angle = RandomFloat(0.0f, 6.283185f);
+    float speed = RandomFloat(8.0f, 20.0f);
+    player->velocity = Vector2f(cosf(angle) * speed, sinf(angle) * speed);
+
+    // Spread the updates out so they don't all land on the same tick.
+    player->position_accumulator = RandomFloat(0.0f, 1.0f);
+    player->weapon_accumulator = RandomFloat(0.0f, 1.0f);
+  }
+}
+
+void ZoneServer::Run() {
+  constexpr s32 kTickDuration = 1;
+
+  Tick last_tick = GetCurrentTick();
+  u64 last_update_us = GetMicrosecondTick();
+
+  last_stats_tick = last_tick;
+
+  u8 data[kMaxPacketSize];
+
+  while (true) {
+    while (true) {
+      sockaddr_in addr = {};
+      socklen_t addr_size = sizeof(addr);
+
+      int bytes_recv = recvfrom(fd, (char*)data, sizeof(data), 0, (sockaddr*)&addr, &addr_size);
+      if (bytes_recv <= 0) break;
+
+      ++stats.packets_received;
+
+      ZoneAddress address = {addr.sin_addr.s_addr, addr.sin_port};
+      ZoneClient* client = GetClient(address);
+
+      if (!client) {
+        // Only encryption requests can create a new client.
+        if (bytes_recv < 8 || data[0] != 0x00 || data[1] != (u8)ProtocolCore::EncryptionRequest) continue;
+
+        for (size_t i = 0; i < kMaxClients; ++i) {
+          if (clients[i].state == ZoneClient::State::Free) {
+            client = clients + i;
+            break;
+          }
+        }
+
+        if (!client) continue;
+
+        memset((void*)client, 0, sizeof(ZoneClient));
+        client->state = ZoneClient::State::Connected;
+        client->address = address;
+        client->player_id = (u16)(synthetic_player_count + (client - clients));
+        client->ship = kSpectatorShip;
+        client->last_packet_tick = GetCurrentTick();
+      }
+
+      ++client->packets_received;
+      client->last_packet_tick = GetCurrentTick();
+
+      OnPacket(*client, data, (size_t)bytes_recv);
+    }
+
+    Tick tick = GetCurrentTick();
+    s32 tick_count = TICK_DIFF(tick, last_tick);
+
+    if (tick_count >= kTickDuration) {
+      u64 now_us = GetMicrosecondTick();
+      s64 gap_us = (s64)(now_us - last_update_us);
+
+      if (gap_us > stats.max_tick_gap_us) {
+        stats.max_tick_gap_us = gap_us;
+      }
+
+      last_update_us = now_us;
+      last_tick = tick;
+
+      Update(tick, tick_count / 100.0f);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+void ZoneServer::Update(Tick tick, float dt) {
+  ++stats.ticks;
+
+  for (size_t i = 0; i < synthetic_player_count; ++i) {
+    SyntheticPlayer* player = synthetic_players + i;
+
+    player->position += player->velocity * dt;
+
+    if (player->position.x < 448.0f || player->position.x > 576.0f) {
+      player->velocity.x = -player->velocity.x;
+    }
+
+    if (player->position.y < 448.0f || player->position.y > 576.0f) {
+      player->velocity.y = -player->velocity.y;
+    }
+  }
+
+  SendSyntheticPositions(dt);
+
+  for (size_t i = 0; i < kMaxClients; ++i) {
+    ZoneClient& client = clients[i];
+
+    if (client.state == ZoneClient::State::Free) continue;
+
+    if (TICK_DIFF(tick, client.last_packet_tick) >= kClientTimeout) {
+      Log(LogLevel::Info, "Client %s timed out.", client.name);
+      Disconnect(client);
+      continue;
+    }
+
+    if (config.security_interval > 0.0f && client.state == ZoneClient::State::Playing &&
+        TICK_DIFF(tick, client.security_tick) >= (s32)(config.security_interval * 100.0f)) {
+      SendSecurityCheck(client, tick);
+    }
+
+    FlushReliable(client, tick);
+  }
+
+  if (TICK_DIFF(tick, last_stats_tick) >= (s32)(config.stats_interval * 100.0f)) {
+    PrintStatistics(tick);
+  }
+}
+
+void ZoneServer::OnPacket(ZoneClient& client, u8* pkt, size_t size) {
+  if (size < 1) return;
+
+  if (pkt[0] == 0x00) {
+    if (size >= 2) {
+      OnCorePacket(client, pkt, size);
+    }
+  } else {
+    OnGamePacket(client, pkt, size);
+  }
+}
+
+void ZoneServer::OnCorePacket(ZoneClient& client, u8* pkt, size_t size) {
+  NetworkBuffer buffer(pkt, size, size);
+
+  buffer.ReadU8();
+  ProtocolCore type = (ProtocolCore)buffer.ReadU8();
+
+  switch (type) {
+    case ProtocolCore::EncryptionRequest: {
+      if (size < 8) break;
+
+      u32 key = buffer.ReadU32();
+      u16 version = buffer.ReadU16();
+
+      client.continuum = version == 0x11;
+
+#pragma pack(push, 1)
+      struct {
+        u8 core;
+        u8 type;
+        u32 key;
+      } response = {0x00, (u8)ProtocolCore::EncryptionResponse, key};
+#pragma pack(pop)
+
+      // Echoing the key back tells Subspace clients to not encrypt. Continuum clients never get the key expansion
+      // response, so they also stay unencrypted.
+      SendRaw(client, (u8*)&response, sizeof(response));
+    } break;
+    case ProtocolCore::ReliableMessage: {
+      OnReliableMessage(client, pkt, size);
+    } break;
+    case ProtocolCore::ReliableAck: {
+      if (size < 6) break;
+
+      OnReliableAck(client, buffer.ReadU32());
+    } break;
+    case ProtocolCore::SyncTimeRequest: {
+      if (size < 6) break;
+
+      u32 timestamp = buffer.ReadU32();
+
+#pragma pack(push, 1)
+      struct {
+        u8 core;
+        u8 type;
+        u32 received_timestamp;
+        u32 local_timestamp;
+      } sync_response = {0x00, (u8)ProtocolCore::SyncTimeResponse, timestamp, GetCurrentTick()};
+#pragma pack(pop)
+
+      SendRaw(client, (u8*)&sync_response, sizeof(sync_response));
+    } break;
+    case ProtocolCore::Disconnect: {
+      Log(LogLevel::Info, "Client %s disconnected.", client.name);
+      Disconnect(client);
+    } break;
+    case ProtocolCore::PacketCluster: {
+      while (buffer.read < buffer.write) {
+        u8 cluster_size = buffer.ReadU8();
+
+        if (buffer.read + cluster_size > buffer.write) break;
+
+        OnPacket(client, buffer.read, cluster_size);
+        buffer.read += cluster_size;
+      }
+    } break;
+    default: {
+    } break;
+  }
+}
+
+void ZoneServer::OnGamePacket(ZoneClient& client, u8* pkt, size_t size) {
+  NetworkBuffer buffer(pkt, size, size);
+
+  ProtocolC2S type = (ProtocolC2S)buffer.ReadU8();
+
+  switch (type) {
+    case ProtocolC2S::VIEPassword:
+    case ProtocolC2S::Password: {
+      if (size < 66) break;
+
+      buffer.ReadU8();
+      memcpy(client.name, buffer.ReadString(32), sizeof(client.name) - 1);
+      client.name[sizeof(client.name) - 1] = 0;
+
+      u8 response[36] = {};
+
+      response[0] = (u8)ProtocolS2C::PasswordResponse;
+      response[1] = 0x00;  // Ok
+      memcpy(response + 2, &kServerVersion, sizeof(kServerVersion));
+
+      client.state = ZoneClient::State::LoggedIn;
+
+      SendReliable(client, response, sizeof(response));
+
+      Log(LogLevel::Info, "Client %s logged in with player id %d.", client.name, (int)client.player_id);
+    } break;
+    case ProtocolC2S::ArenaLogin: {
+      if (size < 2 || client.state == ZoneClient::State::Connected) break;
+
+      client.ship = buffer.ReadU8();
+      if (client.ship > kSpectatorShip) client.ship = kSpectatorShip;
+
+      OnArenaLogin(client);
+    } break;
+    case ProtocolC2S::LeaveArena: {
+      if (client.state != ZoneClient::State::Playing) break;
+
+      u8 leaving[3] = {(u8)ProtocolS2C::PlayerLeaving};
+      memcpy(leaving + 1, &client.player_id, sizeof(client.player_id));
+
+      client.state = ZoneClient::State::LoggedIn;
+      BroadcastReliable(leaving, sizeof(leaving), &client);
+    } break;
+    case ProtocolC2S::Position: {
+      OnPosition(client, pkt, size);
+    } break;
+    case ProtocolC2S::Security: {
+      OnSecurityResponse(client, GetCurrentTick());
+    } break;
+    case ProtocolC2S::MapRequest: {
+      client.sending_map = true;
+      client.map_offset = 0;
+    } break;
+    case ProtocolC2S::SetShip:
+    case ProtocolC2S::FrequencyChange: {
+      if (client.state != ZoneClient::State::Playing) break;
+
+      if (type == ProtocolC2S::SetShip) {
+        if (size < 2) break;
+
+        client.ship = buffer.ReadU8();
+        if (client.ship > kSpectatorShip) client.ship = kSpectatorShip;
+      } else {
+        if (size < 3) break;
+
+        client.frequency = buffer.ReadU16();
+      }
+
+      u8 data[6];
+      NetworkBuffer change(data, sizeof(data));
+
+      change.WriteU8((u8)ProtocolS2C::TeamAndShipChange);
+      change.WriteU8(client.ship);
+      change.WriteU16(client.player_id);
+      change.WriteU16(client.frequency);
+
+      BroadcastReliable(data, sizeof(data), nullptr);
+    } break;
+    case ProtocolC2S::ChatMessage: {
+      // Bots find out which arena they are in from the arena list, then load their behaviors and pathfinder.
+      const char kArenaCommand[] = "?arena";
+
+      if (client.state != ZoneClient::State::Playing || size < 5 + sizeof(kArenaCommand)) break;
+      if (memcmp(pkt + 5, kArenaCommand, sizeof(kArenaCommand)) != 0) break;
+
+      u8 data[8];
+      NetworkBuffer list(data, sizeof(data));
+
+      // The current arena is marked with a negative player count.
+      list.WriteU8((u8)ProtocolS2C::ArenaDirectoryListing);
+      list.WriteString("0", 2);
+      list.WriteU16((u16)(-(s16)(synthetic_player_count + 1)));
+
+      SendReliable(client, data, list.GetSize());
+    } break;
+    default: {
+    } break;
+  }
+}
+
+void ZoneServer::OnArenaLogin(ZoneClient& client) {
+  u8 data[kMaxPacketSize];
+  NetworkBuffer buffer(data, sizeof(data));
+
+  client.frequency = (u16)(client.player_id % 2);
+
+  buffer.WriteU8((u8)ProtocolS2C::PlayerId);
+  buffer.WriteU16(client.player_id);
+  SendReliable(client, data, buffer.GetSize());
+
+  SendReliableChunked(client, (u8*)&settings, sizeof(settings));
+
+  // Send the player list packed together.
+  buffer.Reset();
+  WritePlayerEntering(buffer, client.ship, client.name, client.player_id, client.frequency);
+
+  for (size_t i = 0; i < synthetic_player_count; ++i) {
+    SyntheticPlayer* player = synthetic_players + i;
+
+    if (buffer.GetSize() + kPlayerEnteringSize > kMaxReliablePayload) {
+      SendReliable(client, data, buffer.GetSize());
+      buffer.Reset();
+    }
+
+    WritePlayerEntering(buffer, player->ship, player->name, player->player_id, player->frequency);
+  }
+
+  for (size_t i = 0; i < kMaxClients; ++i) {
+    ZoneClient* other = clients + i;
+
+    if (other == &client || other->state != ZoneClient::State::Playing) continue;
+
+    if (buffer.GetSize() + kPlayerEnteringSize > kMaxReliablePayload) {
+      SendReliable(client, data, buffer.GetSize());
+      buffer.Reset();
+    }
+
+    WritePlayerEntering(buffer, other->ship, other->name, other->player_id, other->frequency);
+  }
+
+  SendReliable(client, data, buffer.GetSize());
+
+  buffer.Reset();
+  buffer.WriteU8((u8)ProtocolS2C::MapInformation);
+  buffer.WriteString(map_filename, 16);
+  buffer.WriteU32(map_checksum);
+
+  if (client.continuum) {
+    buffer.WriteU32((u32)(map_packet_size - 17));
+  }
+
+  SendReliable(client, data, buffer.GetSize());
+
+  buffer.Reset();
+  buffer.WriteU8((u8)ProtocolS2C::JoinGame);
+  SendReliable(client, data, buffer.GetSize());
+
+  // Tell everyone else that this player entered.
+  buffer.Reset();
+  WritePlayerEntering(buffer, client.ship, client.name, client.player_id, client.frequency);
+  BroadcastReliable(data, buffer.GetSize(), &client);
+
+  client.state = ZoneClient::State::Playing;
+}
+
+void ZoneServer::OnPosition(ZoneClient& client, u8* pkt, size_t size) {
+  if (client.state != ZoneClient::State::Playing || client.ship == kSpectatorShip || size < 22) return;
+
+  NetworkBuffer buffer(pkt, size, size);
+
+  buffer.ReadU8();
+  u8 direction = buffer.ReadU8();
+  u32 timestamp = buffer.ReadU32();
+  u16 vel_x = buffer.ReadU16();
+  u16 y = buffer.ReadU16();
+  u8 checksum = buffer.ReadU8();
+  u8 togglables = buffer.ReadU8();
+  u16 x = buffer.ReadU16();
+  u16 vel_y = buffer.ReadU16();
+  u16 bounty = buffer.ReadU16();
+  u16 energy = buffer.ReadU16();
+  u16 weapon = buffer.ReadU16();
+
+  u8 data[32];
+  NetworkBuffer relay(data, sizeof(data));
+
+  relay.WriteU8((u8)ProtocolS2C::LargePosition);
+  relay.WriteU8(direction);
+  relay.WriteU16((u16)timestamp);
+  relay.WriteU16(x);
+  relay.WriteU16(vel_y);
+  relay.WriteU16(client.player_id);
+  relay.WriteU16(vel_x);
+  relay.WriteU8(checksum);
+  relay.WriteU8(togglables);
+  relay.WriteU8(0);  // Ping
+  relay.WriteU16(y);
+  relay.WriteU16(bounty);
+  relay.WriteU16(weapon);
+  relay.WriteU16(energy);
+
+  BroadcastRaw(data, relay.GetSize(), &client);
+}
+
+void ZoneServer::SendSyntheticPositions(float dt) {
+  u8 data[kMaxPacketSize];
+  NetworkBuffer buffer(data, sizeof(data));
+
+  u32 server_tick = GetCurrentTick();
+  u8 batch_type = config.large_batches ? (u8)ProtocolS2C::BatchedLargePosition : (u8)ProtocolS2C::BatchedSmallPosition;
+  size_t entry_size = config.large_batches ? 11 : 10;
+
+  buffer.WriteU8(batch_type);
+
+  for (size_t i = 0; i < synthetic_player_count; ++i) {
+    SyntheticPlayer* player = synthetic_players + i;
+
+    player->weapon_accumulator += config.weapon_rate * dt;
+
+    if (player->weapon_accumulator >= 1.0f) {
+      player->weapon_accumulator -= 1.0f;
+      SendSyntheticWeapon(*player);
+    }
+
+    player->position_accumulator += config.position_rate * dt;
+
+    if (player->position_accumulator < 1.0f) continue;
+
+    player->position_accumulator -= 1.0f;
+
+    u8 direction = (u8)(atan2f(player->velocity.x, -player->velocity.y) / 6.283185f * 40.0f + 40.0f) % 40;
+    u32 x = (u32)(player->position.x * 16.0f) & 0x3FFF;
+    u32 y = (u32)(player->position.y * 16.0f) & 0x3FFF;
+    s32 vel_x = (s32)(player->velocity.x * 16.0f * 10.0f);
+    s32 vel_y = (s32)(player->velocity.y * 16.0f * 10.0f);
+
+    if (!config.batch_positions) {
+      u8 small[16];
+      NetworkBuffer position(small, sizeof(small));
+
+      position.WriteU8((u8)ProtocolS2C::SmallPosition);
+      position.WriteU8(direction);
+      position.WriteU16((u16)server_tick);
+      position.WriteU16((u16)x);
+      position.WriteU8(0);  // Ping
+      position.WriteU8(0);  // Bounty
+      position.WriteU8((u8)player->player_id);
+      position.WriteU8(0);  // Togglables
+      position.WriteU16((u16)vel_y);
+      position.WriteU16((u16)y);
+      position.WriteU16((u16)vel_x);
+
+      BroadcastRaw(small, position.GetSize(), nullptr);
+      continue;
+    }
+
+    if (buffer.GetSize() + entry_size > kMaxPacketSize) {
+      BroadcastRaw(data, buffer.GetSize(), nullptr);
+      buffer.Reset();
+      buffer.WriteU8(batch_type);
+    }
+
+    // Inverse of the client's batched position decoding. The x velocity is split across the top bits of the velocity
+    // and position fields and a signed multiplier.
+    s32 vel_x_high = vel_x >> 4;
+
+    if (config.large_batches) {
+      buffer.WriteU16(player->player_id & 0x3FF);
+    } else {
+      buffer.WriteU8((u8)player->player_id);
+    }
+
+    buffer.WriteU16((u16)((server_tick & 0x3FF) | (direction << 10)));
+    buffer.WriteU32(x | (y << 14) | ((u32)(vel_x & 0x0F) << 28));
+    buffer.WriteU16((u16)((vel_y & 0x3FFF) | ((vel_x_high & 0x03) << 14)));
+    buffer.WriteU8((u8)(s8)(vel_x_high >> 2));
+  }
+
+  if (buffer.GetSize() > 1) {
+    BroadcastRaw(data, buffer.GetSize(), nullptr);
+  }
+}
+
+void ZoneServer::SendSyntheticWeapon(SyntheticPlayer& player) {
+  u8 data[32];
+  NetworkBuffer buffer(data, sizeof(data));
+
+  u8 direction = (u8)(atan2f(player.velocity.x, -player.velocity.y) / 6.283185f * 40.0f + 40.0f) % 40;
+  // Level 1 bullet
+  u16 weapon = 1;
+
+  buffer.WriteU8((u8)ProtocolS2C::LargePosition);
+  buffer.WriteU8(direction);
+  buffer.WriteU16((u16)GetCurrentTick());
+  buffer.WriteU16((u16)(player.position.x * 16.0f));
+  buffer.WriteU16((u16)(s16)(player.velocity.y * 16.0f * 10.0f));
+  buffer.WriteU16(player.player_id);
+  buffer.WriteU16((u16)(s16)(player.velocity.x * 16.0f * 10.0f));
+  buffer.WriteU8(0);  // Checksum
+  buffer.WriteU8(0);  // Togglables
+  buffer.WriteU8(0);  // Ping
+  buffer.WriteU16((u16)(player.position.y * 16.0f));
+  buffer.WriteU16(0);  // Bounty
+  buffer.WriteU16(weapon);
+
+  BroadcastRaw(data, buffer.GetSize(), nullptr);
+}
+
+void ZoneServer::SendSecurityCheck(ZoneClient& client, Tick tick) {
+  if (client.awaiting_security) {
+    Log(LogLevel::Warning, "Client %s did not respond to the last security check.", client.name);
+    ++stats.security_missed;
+  }
+
+  // Clients skip the checksums when the key is zero.
+  u32 checksum_key = (((u32)rand() << 16) ^ (u32)rand()) | 1;
+
+  if (config.security_key_count > 0) {
+    checksum_key = 0x5EC00001 + (u32)(rand() % config.security_key_count);
+  }
+
+  u8 data[17];
+  NetworkBuffer buffer(data, sizeof(data));
+
+  buffer.WriteU8((u8)ProtocolS2C::Security);
+  buffer.WriteU32((u32)rand());  // Prize seed
+  buffer.WriteU32((u32)rand());  // Door seed
+  buffer.WriteU32(tick);         // Timestamp
+  buffer.WriteU32(checksum_key);
+
+  SendReliable(client, data, buffer.GetSize());
+
+  client.security_tick = tick;
+  client.awaiting_security = true;
+  ++stats.security_sent;
+}
+
+void ZoneServer::OnSecurityResponse(ZoneClient& client, Tick tick) {
+  if (!client.awaiting_security) return;
+
+  s32 response_ticks = TICK_DIFF(tick, client.security_tick);
+
+  client.awaiting_security = false;
+
+  ++stats.security_responses;
+  stats.security_response_ticks += response_ticks;
+
+  if (response_ticks > stats.security_max_response_ticks) {
+    stats.security_max_response_ticks = response_ticks;
+  }
+}
+
+void ZoneServer::OnReliableMessage(ZoneClient& client, u8* pkt, size_t size) {
+  if (size < 6) return;
+
+  u32 id;
+  memcpy(&id, pkt + 2, sizeof(id));
+
+  s32 diff = (s32)(id - client.expected_reliable_id);
+
+  // Messages are only processed in order. Anything ahead of the expected id isn't acked so the client resends it.
+  if (diff > 0) return;
+
+  u8 ack[6] = {0x00, (u8)ProtocolCore::ReliableAck};
+  memcpy(ack + 2, &id, sizeof(id));
+  SendRaw(client, ack, sizeof(ack));
+
+  if (diff < 0) return;
+
+  ++client.expected_reliable_id;
+
+  OnPacket(client, pkt + 6, size - 6);
+}
+
+void ZoneServer::OnReliableAck(ZoneClient& client, u32 id) {
+  if ((s32)(id - client.reliable_base) < 0 || (s32)(id - client.next_reliable_id) >= 0) return;
+
+  client.reliable[id % ZoneClient::kReliableCapacity].acked = true;
+
+  while (client.reliable_base != client.next_reliable_id &&
+         client.reliable[client.reliable_base % ZoneClient::kReliableCapacity].acked) {
+    ++client.reliable_base;
+  }
+}
+
+void ZoneServer::SendRaw(ZoneClient& client, const u8* data, size_t size) {
+  sockaddr_in addr = {};
+
+  addr.sin_family = AF_INET;
+  addr.sin_port = client.address.port;
+  addr.sin_addr.s_addr = client.address.addr;
+
+  int bytes = sendto(fd, (const char*)data, (int)size, 0, (sockaddr*)&addr, sizeof(addr));
+
+  if (bytes > 0) {
+    ++client.packets_sent;
+    client.bytes_sent += bytes;
+    ++stats.packets_sent;
+    stats.bytes_sent += bytes;
+  }
+}
+
+void ZoneServer::SendReliable(ZoneClient& client, const u8* data, size_t size) {
+  if (size > kMaxReliablePayload) {
+    SendReliableChunked(client, data, size);
+    return;
+  }
+
+  if (client.next_reliable_id - client.reliable_base >= ZoneClient::kReliableCapacity) {
+    Log(LogLevel::Warning, "Reliable queue for %s is full. Dropping message.", client.name);
+    return;
+  }
+
+  u32 id = client.next_reliable_id++;
+  ZoneReliableMessage* message = client.reliable + (id % ZoneClient::kReliableCapacity);
+
+  message->id = id;
+  message->sent = false;
+  message->acked = false;
+  message->size = (u16)(size + 6);
+  message->data[0] = 0x00;
+  message->data[1] = (u8)ProtocolCore::ReliableMessage;
+  memcpy(message->data + 2, &id, sizeof(id));
+  memcpy(message->data + 6, data, size);
+}
+
+void ZoneServer::SendReliableChunked(ZoneClient& client, const u8* data, size_t size) {
+  u8 chunk[kMaxReliablePayload];
+  size_t offset = 0;
+  while (offset < size) {
+    size_t chunk_size = size - offset;
+    bool tail = chunk_size <= kMaxSmallChunkPayload;
+
+    if (!tail) chunk_size = kMaxSmallChunkPayload;
+
+    chunk[0] = 0x00;
+    chunk[1] = tail ? (u8)ProtocolCore::SmallChunkTail : (u8)ProtocolCore::SmallChunkBody;
+    memcpy(chunk + 2, data + offset, chunk_size);
+
+    SendReliable(client, chunk, chunk_size + 2);
+
+    offset += chunk_size;
+  }
+}
+
+void ZoneServer::FlushReliable(ZoneClient& client, Tick tick) {
+  // Stream the map in huge chunks while there's room in the window.
+  while (client.sending_map && client.next_reliable_id - client.reliable_base < ZoneClient::kReliableWindow) {
+    u8 chunk[kMaxReliablePayload];
+    size_t chunk_size = map_packet_size - client.map_offset;
+
+    if (chunk_size > kMaxHugeChunkPayload) chunk_size = kMaxHugeChunkPayload;
+
+    u32 total_size = (u32)map_packet_size;
+
+    chunk[0] = 0x00;
+    chunk[1] = (u8)ProtocolCore::HugeChunk;
+    memcpy(chunk + 2, &total_size, sizeof(total_size));
+    memcpy(chunk + 6, map_packet + client.map_offset, chunk_size);
+
+    SendReliable(client, chunk, chunk_size + 6);
+
+    client.map_offset += chunk_size;
+
+    if (client.map_offset >= map_packet_size) {
+      client.sending_map = false;
+    }
+  }
+
+  u32 end = client.next_reliable_id;
+
+  if (end - client.reliable_base > ZoneClient::kReliableWindow) {
+    end = client.reliable_base + ZoneClient::kReliableWindow;
+  }
+
+  for (u32 id = client.reliable_base; id != end; ++id) {
+    ZoneReliableMessage* message = client.reliable + (id % ZoneClient::kReliableCapacity);
+
+    if (message->acked) continue;
+
+    if (message->sent) {
+      if (TICK_DIFF(tick, message->send_tick) < kReliableResendDelay) continue;
+
+      ++stats.reliable_resends;
+    }
+
+    message->sent = true;
+    message->send_tick = tick;
+
+    SendRaw(client, message->data, message->size);
+  }
+}
+
+void ZoneServer::BroadcastRaw(const u8* data, size_t size, ZoneClient* except) {
+  for (size_t i = 0; i < kMaxClients; ++i) {
+    ZoneClient* client = clients + i;
+
+    if (client == except || client->state != ZoneClient::State::Playing) continue;
+
+    SendRaw(*client, data, size);
+  }
+}
+
+void ZoneServer::BroadcastReliable(const u8* data, size_t size, ZoneClient* except) {
+  for (size_t i = 0; i < kMaxClients; ++i) {
+    ZoneClient* client = clients + i;
+
+    if (client == except || client->state != ZoneClient::State::Playing) continue;
+
+    SendReliable(*client, data, size);
+  }
+}
+
+ZoneClient* ZoneServer::GetClient(const ZoneAddress& address) {
+  for (size_t i = 0; i < kMaxClients; ++i) {
+    if (clients[i].state != ZoneClient::State::Free && clients[i].address == address) {
+      return clients + i;
+    }
+  }
+
+  return nullptr;
+}
+
+void ZoneServer::Disconnect(ZoneClient& client) {
+  bool was_playing = client.state == ZoneClient::State::Playing;
+
+  client.state = ZoneClient::State::Free;
+
+  if (was_playing) {
+    u8 leaving[3] = {(u8)ProtocolS2C::PlayerLeaving};
+    memcpy(leaving + 1, &client.player_id, sizeof(client.player_id));
+
+    BroadcastReliable(leaving, sizeof(leaving), nullptr);
+  }
+}
+
+void ZoneServer::PrintStatistics(Tick tick) {
+  float seconds = TICK_DIFF(tick, last_stats_tick) / 100.0f;
+
+  size_t connected_count = 0;
+  size_t playing_count = 0;
+
+  for (size_t i = 0; i < kMaxClients; ++i) {
+    if (clients[i].state != ZoneClient::State::Free) ++connected_count;
+    if (clients[i].state == ZoneClient::State::Playing) ++playing_count;
+  }
+
+  Log(LogLevel::Info,
+      "clients: %zu (%zu playing)  in: %.0f pkt/s  out: %.0f pkt/s %.1f KiB/s  resends: %llu  ticks: %llu  max tick "
+      "gap: %.2fms",
+      connected_count, playing_count, stats.packets_received / seconds, stats.packets_sent / seconds,
+      stats.bytes_sent / seconds / 1024.0f, (unsigned long long)stats.reliable_resends,
+      (unsigned long long)stats.ticks, stats.max_tick_gap_us / 1000.0f);
+
+  if (config.security_interval > 0.0f) {
+    Log(LogLevel::Info, "security checks: %llu  responses: %llu  missed: %llu  mean response: %.0fms  max: %dms",
+        (unsigned long long)stats.security_sent, (unsigned long long)stats.security_responses,
+        (unsigned long long)stats.security_missed,
+        stats.security_responses > 0 ? stats.security_response_ticks * 10.0f / stats.security_responses : 0.0f,
+        stats.security_max_response_ticks * 10);
+  }
+
+  stats = {};
+  last_stats_tick = tick;
+}
+
+}  // namespace zero
@@ -0,0 +1,192 @@
+#ifndef ZERO_TOOLS_ZONESERVER_H_
+#define ZERO_TOOLS_ZONESERVER_H_
+
+#include <zero/Math.h>
+#include <zero/Types.h>
+#include <zero/game/ArenaSettings.h>
+#include <zero/game/Clock.h>
+#include <zero/game/Memory.h>
+#include <zero/game/net/Socket.h>
+
+namespace zero {
+
+// Stand-in zone server for load testing bots on localhost.
+// Connections are never encrypted: the Subspace key is echoed back and Continuum clients get a plain encryption
+// response, which both leave the client in plaintext mode.
+
+struct ZoneConfig {
+  u16 port = 5000;
+
+  // Map file to send to clients. A bordered empty map is generated if this is empty.
+  const char* map_path = nullptr;
+  // Raw arena settings packet to send to clients. Sensible defaults are used if this is empty.
+  const char* settings_path = nullptr;
+
+  size_t synthetic_player_count = 32;
+  // Position updates per second for each synthetic player.
+  float position_rate = 10.0f;
+  // Weapons fired per second for each synthetic player.
+  float weapon_rate = 1.0f;
+  // Send synthetic positions in the batched position packets instead of one packet per player.
+  bool batch_positions = true;
+  bool large_batches = false;
+
+  // Seconds between security checks sent to each playing client. Zero disables them.
+  // Continuum clients answer them with the security solver, so this exercises the solver under load.
+  float security_interval = 0.0f;
+  // Number of different checksum keys that security checks pick from. Zero uses a new random key for every check.
+  size_t security_key_count = 0;
+
+  // Seconds between statistics output.
+  float stats_interval = 5.0f;
+};
+
+struct ZoneAddress {
+  u32 addr;
+  u16 port;
+
+  inline bool operator==(const ZoneAddress& other) const { return addr == other.addr && port == other.port; }
+};
+
+struct ZoneReliableMessage {
+  u32 id;
+  Tick send_tick;
+  bool sent;
+  bool acked;
+  u16 size;
+  u8 data[kMaxPacketSize];
+};
+
+struct ZoneClient {
+  enum class State { Free, Connected, LoggedIn, Playing };
+
+  State state = State::Free;
+  ZoneAddress address;
+
+  u16 player_id;
+  u16 frequency;
+  u8 ship;
+  bool continuum;
+  char name[20];
+
+  Tick last_packet_tick;
+
+  u32 next_reliable_id;
+  u32 expected_reliable_id;
+
+  // Unacknowledged reliable messages. The window is kept small so the ring never overflows.
+  static constexpr size_t kReliableCapacity = 256;
+  static constexpr size_t kReliableWindow = 64;
+  ZoneReliableMessage reliable[kReliableCapacity];
+  u32 reliable_base;
+
+  // The map is streamed into the reliable window as space frees up instead of being queued all at once.
+  bool sending_map;
+  size_t map_offset;
+
+  Tick security_tick;
+  bool awaiting_security;
+
+  u64 packets_received;
+  u64 packets_sent;
+  u64 bytes_sent;
+};
+
+struct SyntheticPlayer {
+  u16 player_id;
+  u16 frequency;
+  u8 ship;
+  // Room for any numbered name so it never truncates. Only the first 20 bytes are sent.
+  char name[32];
+
+  Vector2f position;
+  Vector2f velocity;
+
+  float position_accumulator;
+  float weapon_accumulator;
+};
+
+struct ZoneStatistics {
+  u64 packets_received = 0;
+  u64 packets_sent = 0;
+  u64 bytes_sent = 0;
+  u64 reliable_resends = 0;
+  u64 ticks = 0;
+  u64 security_sent = 0;
+  u64 security_responses = 0;
+  // Security checks that weren't answered before the next one was due. A real zone would kick for these.
+  u64 security_missed = 0;
+  s64 security_response_ticks = 0;
+  s32 security_max_response_ticks = 0;
+  // Largest amount of time between two server ticks since the last report.
+  s64 max_tick_gap_us = 0;
+};
+
+struct ZoneServer {
+  static constexpr size_t kMaxClients = 256;
+  static constexpr size_t kMaxSyntheticPlayers = 512;
+
+  MemoryArena& arena;
+  ZoneConfig config;
+
+  SocketType fd = -1;
+
+  ZoneClient* clients = nullptr;
+  SyntheticPlayer* synthetic_players = nullptr;
+  size_t synthetic_player_count = 0;
+
+  ArenaSettings settings = {};
+
+  char map_filename[16] = {};
+  u32 map_checksum = 0;
+  // Complete compressed map packet, including the 0x2A header and filename.
+  u8* map_packet = nullptr;
+  size_t map_packet_size = 0;
+
+  ZoneStatistics stats;
+  Tick last_stats_tick = 0;
+
+  ZoneServer(MemoryArena& arena, const ZoneConfig& config) : arena(arena), config(config) {}
+
+  bool Initialize();
+  void Run();
+
+  void Update(Tick tick, float dt);
+
+  void OnPacket(ZoneClient& client, u8* pkt, size_t size);
+  void OnCorePacket(ZoneClient& client, u8* pkt, size_t size);
+  void OnGamePacket(ZoneClient& client, u8* pkt, size_t size);
+
+  void OnReliableMessage(ZoneClient& client, u8* pkt, size_t size);
+  void OnReliableAck(ZoneClient& client, u32 id);
+  void OnArenaLogin(ZoneClient& client);
+  void OnPosition(ZoneClient& client, u8* pkt, size_t size);
+  void OnSecurityResponse(ZoneClient& client, Tick tick);
+
+  void SendRaw(ZoneClient& client, const u8* data, size_t size);
+  void SendReliable(ZoneClient& client, const u8* data, size_t size);
+  // Splits payloads that don't fit in one reliable message into small chunks.
+  void SendReliableChunked(ZoneClient& client, const u8* data, size_t size);
+  void FlushReliable(ZoneClient& client, Tick tick);
+
+  void BroadcastRaw(const u8* data, size_t size, ZoneClient* except);
+  void BroadcastReliable(const u8* data, size_t size, ZoneClient* except);
+
+  void SendSyntheticPositions(float dt);
+  void SendSyntheticWeapon(SyntheticPlayer& player);
+  void SendSecurityCheck(ZoneClient& client, Tick tick);
+
+  ZoneClient* GetClient(const ZoneAddress& address);
+  void Disconnect(ZoneClient& client);
+
+  void PrintStatistics(Tick tick);
+
+ private:
+  bool LoadMap();
+  bool LoadSettings();
+  void CreateSyntheticPlayers();
+};
+
+}  // namespace zero
+
+#endif
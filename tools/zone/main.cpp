@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <zero/Args.h>
+#include <zero/game/Logger.h>
+#include <zero/game/Memory.h>
+
+#include "ZoneServer.h"
+
+static void PrintUsage(const char* exe_name) {
+  printf(
+      "Usage: %s [OPTION]\n"
+      "Stand-in zone server for load testing bots on localhost.\n"
+      "Bots should connect with the local server entry.\n"
+      "\n"
+      "--port <port>\t\t\tport to listen on (default 5000)\n"
+      "--map <path>\t\t\tmap file to send (default generated border map)\n"
+      "--settings <path>\t\traw arena settings packet to send\n"
+      "--players <count>\t\tnumber of synthetic players (default 32)\n"
+      "--position-rate <hz>\t\tposition updates per synthetic player per second (default 10)\n"
+      "--weapon-rate <hz>\t\tweapons fired per synthetic player per second (default 1)\n"
+      "--unbatched\t\t\tsend one position packet per synthetic player instead of batches\n"
+      "--large-batches\t\t\tuse the large batched position format\n"
+      "--security <seconds>\t\tseconds between security checks sent to each player (default 0, disabled)\n"
+      "--security-keys <count>\t\tnumber of checksum keys that security checks pick from (default 0, all random)\n"
+      "--stats <seconds>\t\tseconds between statistics output (default 5)\n"
+      "",
+      exe_name);
+}
+
+int main(int argc, char* argv[]) {
+  using namespace zero;
+
+  srand((unsigned int)time(NULL));
+
+  g_LogPrintLevel = LogLevel::Info;
+
+  ArgParser args(argc, argv);
+
+  if (args.HasParameter({"help", "h"})) {
+    PrintUsage(argv[0]);
+    return 0;
+  }
+
+  ZoneConfig config;
+
+  std::string_view port = args.GetValue("port");
+  std::string_view map_path = args.GetValue("map");
+  std::string_view settings_path = args.GetValue("settings");
+  std::string_view players = args.GetValue("players");
+  std::string_view position_rate = args.GetValue("position-rate");
+  std::string_view weapon_rate = args.GetValue("weapon-rate");
+  std::string_view security_interval = args.GetValue("security");
+  std::string_view security_key_count = args.GetValue("security-keys");
+  std::string_view stats_interval = args.GetValue("stats");
+
+  if (!port.empty()) config.port = (u16)strtol(port.data(), nullptr, 10);
+  if (!map_path.empty()) config.map_path = map_path.data();
+  if (!settings_path.empty()) config.settings_path = settings_path.data();
+  if (!players.empty()) config.synthetic_player_count = (size_t)strtol(players.data(), nullptr, 10);
+  if (!position_rate.empty()) config.position_rate = strtof(position_rate.data(), nullptr);
+  if (!weapon_rate.empty()) config.weapon_rate = strtof(weapon_rate.data(), nullptr);
+  if (!security_interval.empty()) config.security_interval = strtof(security_interval.data(), nullptr);
+  if (!security_key_count.empty()) config.security_key_count = (size_t)strtol(security_key_count.data(), nullptr, 10);
+  if (!stats_interval.empty()) config.stats_interval = strtof(stats_interval.data(), nullptr);
+
+  config.batch_positions = !args.HasParameter("unbatched");
+  config.large_batches = args.HasParameter("large-batches");
+
+  constexpr size_t kArenaSize = Megabytes(256);
+
+  u8* memory = (u8*)malloc(kArenaSize);
+  if (!memory) {
+    Log(LogLevel::Error, "Failed to allocate memory.");
+    return 1;
+  }
+
+  MemoryArena arena(memory, kArenaSize);
+  ZoneServer* server = memory_arena_construct_type(&arena, ZoneServer, arena, config);
+
+  if (!server->Initialize()) {
+    return 1;
+  }
+
+  server->Run();
+
+  return 0;
+}
@@ -7,7 +7,8 @@
 
 namespace zero {
 
-BotController::BotController(Game& game) : game(game), chat_queue(game.chat), energy_tracker(game.player_manager) {
+BotController::BotController(Game& game, MapDataCache& map_cache)
+    : game(game), map_cache(map_cache), chat_queue(game.chat), energy_tracker(game.player_manager) {
   this->input = nullptr;
 
   this->enable_dynamic_path = true;
@@ -21,6 +22,7 @@ void BotController::HandleEvent(const JoinGameEvent& event) {
 
   // Clear the pathfinder so it will rebuild on ship change.
   pathfinder = nullptr;
+  map_data = nullptr;
 
   this->enable_dynamic_path = true;
   this->door_solid_method = path::DoorSolidMethod::Dynamic;
@@ -76,21 +78,28 @@ void BotController::UpdatePathfinder(float radius) {
 
   Log(LogLevel::Info, "Creating new registry and pathfinder.");
 
-  auto processor = std::make_unique<path::NodeProcessor>(game);
-
-  region_registry = std::make_unique<RegionRegistry>();
-  region_registry->CreateAll(game.GetMap(), radius);
-
-  pathfinder = std::make_unique<path::Pathfinder>(std::move(processor), region_registry.get());
-
   path::Pathfinder::WeightConfig cfg = {};
 
   cfg.ship_radius = radius;
   cfg.wall_distance = 5;
   cfg.weight_type = path::Pathfinder::WeightType::Exponential;
 
-  pathfinder->CreateMapWeights(game.temp_arena, game.GetMap(), cfg);
+  map_data = map_cache.Get(game, cfg);
+
+  auto processor = std::make_unique<path::NodeProcessor>(game);
+
+  // The processor and registry share ownership of the map data so it stays alive as long as either is used.
+  processor->SetTiles(std::shared_ptr<const path::NodeTile[]>(map_data, map_data->tiles));
+  processor->dynamic_points = map_data->dynamic_points;
+
+  region_registry = std::shared_ptr<RegionRegistry>(map_data, &map_data->regions);
+
+  pathfinder = std::make_unique<path::Pathfinder>(std::move(processor), region_registry.get());
+  pathfinder->config = cfg;
   pathfinder->SetDoorSolidMethod(door_solid_method);
+
+  // The data might have been built by another bot, so the region events are sent from here instead of while building.
+  region_registry->DispatchEvents();
 }
 
 void BotController::RebuildRegionRegistry() {
@@ -103,9 +112,11 @@ void BotController::RebuildRegionRegistry() {
     game.connection.settings.ShipSettings[self->ship].GetRadius();
   }
 
-  region_registry = std::make_unique<RegionRegistry>();
+  region_registry = std::make_shared<RegionRegistry>();
   region_registry->CreateAll(game.GetMap(), radius);
   pathfinder->regions_ = region_registry.get();
+
+  region_registry->DispatchEvents();
 }
 
 void BotController::HandleEvent(const DoorToggleEvent& event) {
@@ -168,8 +179,6 @@ void BotController::Update(RenderContext& rc, InputState& input, behavior::Execu
   Event::Dispatch(UpdateEvent(*this, execute_ctx));
   energy_tracker.Update();
 
-  static behavior::TreePrinter tree_printer;
-
   if (behavior_tree && pathfinder) {
     bool should_print = g_Settings.debug_behavior_tree;
 
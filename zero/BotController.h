@@ -4,9 +4,11 @@
 #include <zero/ChatQueue.h>
 #include <zero/HeuristicEnergyTracker.h>
 #include <zero/InfluenceMap.h>
+#include <zero/MapDataCache.h>
 #include <zero/RenderContext.h>
 #include <zero/Steering.h>
 #include <zero/behavior/Behavior.h>
+#include <zero/behavior/BehaviorTree.h>
 #include <zero/game/Game.h>
 #include <zero/game/GameEvent.h>
 #include <zero/path/Pathfinder.h>
@@ -49,9 +51,13 @@ struct BotController : EventHandler<PlayerFreqAndShipChangeEvent>,
                        EventHandler<TeleportEvent>,
                        EventHandler<PlayerAttachEvent> {
   Game& game;
+  MapDataCache& map_cache;
 
   std::unique_ptr<path::Pathfinder> pathfinder;
-  std::unique_ptr<RegionRegistry> region_registry;
+  // Usually points into map_data, but it can be rebuilt for just this bot.
+  std::shared_ptr<RegionRegistry> region_registry;
+  // The map data that the pathfinder was created from. This is shared with other bots on the same map and ship radius.
+  std::shared_ptr<SharedMapData> map_data;
   std::string behavior_name;
   InputState* input;
   InputState last_input = {};
@@ -71,7 +77,9 @@ struct BotController : EventHandler<PlayerFreqAndShipChangeEvent>,
   std::string default_arena;
   std::unique_ptr<LockedShipState> locked_ships;
 
-  BotController(Game& game);
+  behavior::TreePrinter tree_printer;
+
+  BotController(Game& game, MapDataCache& map_cache);
 
   void Update(RenderContext& rc, InputState& input, behavior::ExecuteContext& execute_ctx);
 
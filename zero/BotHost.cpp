@@ -0,0 +1,187 @@
+#include "BotHost.h"
+
+#include <stdio.h>
+#include <zero/MapDataCache.h>
+#include <zero/game/Clock.h>
+#include <zero/game/Logger.h>
+#include <zero/game/Settings.h>
+#include <zero/game/WorkQueue.h>
+
+#include <chrono>
+#include <thread>
+
+namespace zero {
+
+// A tick is due at least this often, so no bot needs the thread to wait any longer.
+constexpr s64 kMaxWaitMicroseconds = 10000;
+
+BotHost::BotHost() : map_cache(std::make_shared<MapDataCache>()) {}
+
+BotHost::~BotHost() {}
+
+bool BotHost::Initialize(Config& config, const ArgParser& args, const char* name, const char* password,
+                         size_t bot_count) {
+  auto opt_threads = config.GetInt("Host", "Threads");
+  if (opt_threads && *opt_threads > 0) thread_count = *opt_threads;
+
+  auto opt_sleep_ms = config.GetInt("General", "SleepMs");
+  if (opt_sleep_ms && *opt_sleep_ms > 0) sleep_ms = *opt_sleep_ms;
+
+  if (thread_count > bot_count) thread_count = bot_count;
+
+  // The render window can only be driven by one bot on the main thread.
+  g_Settings.debug_window = false;
+
+  // Threads sleep between frames instead if the event loop is disabled or the platform doesn't have one.
+  auto opt_event_loop = config.GetInt("General", "EventLoop");
+  bool use_event_loop = !opt_event_loop || *opt_event_loop != 0;
+
+  for (size_t i = 0; i < thread_count; ++i) {
+    event_loops.push_back(std::make_unique<EventLoop>());
+
+    if (use_event_loop) {
+      event_loops.back()->Initialize();
+    }
+  }
+
+  bots.reserve(bot_count);
+
+  for (size_t i = 0; i < bot_count; ++i) {
+    auto bot = std::make_unique<ZeroBot>();
+
+    bot->hosted = true;
+    bot->map_cache = map_cache;
+    bot->config = std::make_unique<Config>(config);
+
+    char bot_name[32];
+    snprintf(bot_name, sizeof(bot_name), "%s%zu", name, i + 1);
+
+    if (!bot->Initialize(std::make_unique<ArgParser>(args), bot_name, password)) {
+      return false;
+    }
+
+    // Bots are given to threads in turn, so this is the loop of the thread that will step it.
+    EventLoop* event_loop = event_loops[i % thread_count].get();
+
+    if (event_loop->IsEnabled()) {
+      bot->work_queue->notify = [](void* user) { ((EventLoop*)user)->Wake(); };
+      bot->work_queue->notify_user = event_loop;
+    }
+
+    bots.push_back(std::move(bot));
+  }
+
+  Log(LogLevel::Info, "Hosting %zu bots on %zu threads.", bots.size(), thread_count);
+
+  return true;
+}
+
+void BotHost::Run(ServerInfo& server) {
+  // Start the clock before any of the threads can race to start it.
+  GetCurrentTick();
+
+  std::vector<std::thread> threads;
+
+  threads.reserve(thread_count);
+
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads.emplace_back(&BotHost::RunThread, this, i, std::ref(server));
+  }
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  LogMemoryUsage();
+}
+
+void BotHost::RunThread(size_t thread_index, ServerInfo& server) {
+  struct HostedBot {
+    ZeroBot* bot;
+    SocketType socket;
+    bool watched;
+  };
+
+  // The loop wakes the thread when any of its bots' sockets is readable, a worker finishes or the next tick is due.
+  EventLoop& event_loop = *event_loops[thread_index];
+  bool use_event_loop = event_loop.IsEnabled();
+
+  std::vector<HostedBot> active;
+
+  // Each thread always steps the same bots, so a bot's game state and events are only touched by one thread.
+  for (size_t i = thread_index; i < bots.size(); i += thread_count) {
+    ZeroBot* bot = bots[i].get();
+
+    if (!bot->JoinZone(server)) {
+      Log(LogLevel::Error, "Failed to join zone with '%s'.", bot->name);
+      continue;
+    }
+
+    bot->BeginRun();
+
+    SocketType socket = bot->game->connection.transport->GetSocket();
+
+    event_loop.AddSocket(socket);
+    active.push_back({bot, socket, true});
+  }
+
+  while (running && !active.empty()) {
+    s64 timeout_us = kMaxWaitMicroseconds;
+
+    for (size_t i = 0; i < active.size();) {
+      HostedBot& hosted = active[i];
+
+      if (!hosted.bot->RunFrame()) {
+        event_loop.RemoveSocket(hosted.socket);
+        hosted.bot->EndRun();
+
+        active[i] = active.back();
+        active.pop_back();
+        continue;
+      }
+
+      bool receiving = hosted.bot->game->connection.IsReceiving();
+
+      if (receiving != hosted.watched) {
+        event_loop.WatchSocket(hosted.socket, receiving);
+        hosted.watched = receiving;
+      }
+
+      s64 bot_timeout_us = hosted.bot->GetWaitTimeout();
+
+      if (bot_timeout_us < timeout_us) {
+        timeout_us = bot_timeout_us;
+      }
+
+      ++i;
+    }
+
+    if (use_event_loop) {
+      if (timeout_us > 0) {
+        event_loop.Wait(timeout_us);
+      }
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+    }
+  }
+
+  for (HostedBot& hosted : active) {
+    event_loop.RemoveSocket(hosted.socket);
+    hosted.bot->EndRun();
+  }
+}
+
+void BotHost::LogMemoryUsage() {
+  LogMemoryFootprint("host map data", map_cache->GetMemoryFootprint());
+
+  Log(LogLevel::Info, "Map data was built %zu times and shared %zu times.", map_cache->build_count.load(),
+      map_cache->share_count.load());
+
+  double resident_mib = GetProcessResidentSize() / (1024.0 * 1024.0);
+  double per_bot_mib = bots.empty() ? 0.0 : resident_mib / bots.size();
+
+  Log(LogLevel::Info, "Process resident: %.2f MiB for %zu bots (%.2f MiB per bot)", resident_mib, bots.size(),
+      per_bot_mib);
+}
+
+}  // namespace zero
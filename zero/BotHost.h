@@ -0,0 +1,47 @@
+#pragma once
+
+#include <zero/Args.h>
+#include <zero/Config.h>
+#include <zero/ZeroBot.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace zero {
+
+struct MapDataCache;
+
+// Runs many bots in one process from a single config. The bots are split between a fixed set of threads and each
+// thread steps its own bots in turn, so a bot is only ever updated from one thread. Between frames a thread blocks on
+// one event loop that watches all of its bots' sockets and work queues.
+// The map data that is derived from the map and ship radius is built once and shared between all of the bots.
+struct BotHost {
+  // One for each thread. Declared before the bots so their workers are stopped before the loops they wake go away.
+  std::vector<std::unique_ptr<EventLoop>> event_loops;
+  std::vector<std::unique_ptr<ZeroBot>> bots;
+  std::shared_ptr<MapDataCache> map_cache;
+
+  size_t thread_count = 2;
+  // Only used when the event loop isn't available.
+  int sleep_ms = 1;
+
+  std::atomic<bool> running = true;
+
+  BotHost();
+  ~BotHost();
+
+  // Each bot logs in with the name followed by its number, starting at 1.
+  bool Initialize(Config& config, const ArgParser& args, const char* name, const char* password, size_t bot_count);
+
+  // Blocks until every bot has disconnected or Stop is called.
+  void Run(ServerInfo& server);
+  void Stop() { running = false; }
+
+  void LogMemoryUsage();
+
+ private:
+  void RunThread(size_t thread_index, ServerInfo& server);
+};
+
+}  // namespace zero
@@ -169,7 +169,7 @@ void ChatQueue::Update() {
 
         Player* self = chat_controller.player_manager.GetSelf();
         if (self) {
-          memcpy(controller_entry->sender, self->name, 20);
+          memcpy(controller_entry->sender, chat_controller.player_manager.GetName(*self), 20);
         }
 
         continue;
@@ -221,7 +221,7 @@ void ChatQueue::Update() {
 
     Player* self = chat_controller.player_manager.GetSelf();
     if (self) {
-      memcpy(controller_entry->sender, self->name, 20);
+      memcpy(controller_entry->sender, chat_controller.player_manager.GetName(*self), 20);
     }
   }
 }
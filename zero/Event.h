@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <utility>
 #include <vector>
 
@@ -8,6 +9,85 @@ namespace zero {
 template <typename T>
 struct EventTypeDispatcher;
 
+struct EventDispatcherBase {
+  virtual ~EventDispatcherBase() {}
+};
+
+// Owns one dispatcher for each type of event. Each bot has its own context so bots that are hosted in the same process
+// only receive their own events.
+// Handlers register with the context that is current on their thread when they are constructed, and events are
+// dispatched to the context that is current when Dispatch is called.
+struct EventContext {
+  EventContext() {}
+  ~EventContext() {
+    for (EventDispatcherBase* dispatcher : dispatchers) {
+      delete dispatcher;
+    }
+  }
+
+  EventContext(const EventContext& other) = delete;
+  EventContext& operator=(const EventContext& other) = delete;
+
+  template <typename T>
+  EventTypeDispatcher<T>& GetDispatcher() {
+    size_t id = GetTypeId<T>();
+
+    if (id >= dispatchers.size()) {
+      dispatchers.resize(id + 1, nullptr);
+    }
+
+    if (!dispatchers[id]) {
+      dispatchers[id] = new EventTypeDispatcher<T>();
+    }
+
+    return *(EventTypeDispatcher<T>*)dispatchers[id];
+  }
+
+  // Returns the context that was made current on this thread, or the process context if none was.
+  static EventContext& GetCurrent() {
+    EventContext* current = GetCurrentPointer();
+
+    if (current) return *current;
+
+    static EventContext process_context;
+    return process_context;
+  }
+
+  // Returns the previous context so it can be restored.
+  static EventContext* SetCurrent(EventContext* context) {
+    EventContext* previous = GetCurrentPointer();
+    GetCurrentPointer() = context;
+    return previous;
+  }
+
+ private:
+  template <typename T>
+  static size_t GetTypeId() {
+    static const size_t id = next_type_id++;
+    return id;
+  }
+
+  static EventContext*& GetCurrentPointer() {
+    static thread_local EventContext* current = nullptr;
+    return current;
+  }
+
+  inline static std::atomic<size_t> next_type_id = 0;
+
+  std::vector<EventDispatcherBase*> dispatchers;
+};
+
+// Makes the context current on this thread until the scope ends.
+struct EventContextScope {
+  EventContext* previous;
+
+  EventContextScope(EventContext& context) : previous(EventContext::SetCurrent(&context)) {}
+  ~EventContextScope() { EventContext::SetCurrent(previous); }
+
+  EventContextScope(const EventContextScope& other) = delete;
+  EventContextScope& operator=(const EventContextScope& other) = delete;
+};
+
 struct Event {
   virtual ~Event() {}
 
@@ -23,27 +103,31 @@ struct Event {
 template <typename T>
 struct EventHandler {
  protected:
-  EventHandler() { EventTypeDispatcher<T>::Get().RegisterHandler(this); }
+  EventHandler() : dispatcher(&EventTypeDispatcher<T>::Get()) { dispatcher->RegisterHandler(this); }
 
  public:
-  virtual ~EventHandler() { EventTypeDispatcher<T>::Get().UnregisterHandler(this); }
+  // Unregisters from the dispatcher it registered with, even if a different context is current now.
+  virtual ~EventHandler() { dispatcher->UnregisterHandler(this); }
 
   virtual void HandleEvent(const T& event) = 0;
+
+ private:
+  EventTypeDispatcher<T>* dispatcher;
 };
 
 // This class stores the handlers for the given Event type T.
 template <typename T>
-struct EventTypeDispatcher {
+struct EventTypeDispatcher : EventDispatcherBase {
  private:
   std::vector<EventHandler<T>*> handlers;
 
-  virtual ~EventTypeDispatcher() {}
+  EventTypeDispatcher() {}
+
+  friend struct EventContext;
 
  public:
-  static EventTypeDispatcher& Get() {
-    static EventTypeDispatcher instance;
-    return instance;
-  }
+  // Returns the dispatcher from the current context.
+  static EventTypeDispatcher& Get() { return EventContext::GetCurrent().GetDispatcher<T>(); }
 
   void Dispatch(const T& event) {
     for (auto& handler : handlers) {
@@ -34,9 +34,8 @@ static inline float GetEstimatedRecharge(EnergyHeuristicType type, PlayerManager
   return (settings.InitialRecharge + settings.MaximumRecharge) / 2.0f;
 }
 
-HeuristicEnergyTracker::HeuristicEnergyTracker(PlayerManager& player_manager) : player_manager(player_manager) {
-  memset(player_energy, 0, sizeof(player_energy));
-}
+HeuristicEnergyTracker::HeuristicEnergyTracker(PlayerManager& player_manager)
+    : player_manager(player_manager), player_energy(player_manager.perm_arena, HeuristicEnergyData()) {}
 
 void HeuristicEnergyTracker::Update() {
   Tick current_tick = GetCurrentTick();
@@ -91,7 +90,7 @@ float HeuristicEnergyTracker::GetEnergy(Player& player) const {
     return 0.0f;
   }
 
-  return player_energy[player.id].energy;
+  return player_energy.Get(player.id).energy;
 }
 
 float HeuristicEnergyTracker::GetEnergyPercent(Player& player) const {
@@ -3,6 +3,7 @@
 #include <zero/Types.h>
 #include <zero/game/Clock.h>
 #include <zero/game/GameEvent.h>
+#include <zero/game/PagedIdTable.h>
 
 #include <vector>
 
@@ -14,8 +15,8 @@ struct PlayerManager;
 enum class EnergyHeuristicType { None, Initial, Maximum, Average };
 
 struct HeuristicEnergyData {
-  float energy;
-  u32 emp_ticks;
+  float energy = 0.0f;
+  u32 emp_ticks = 0;
 };
 
 // Attempts to track player energy by listening for events and applying recharge.
@@ -28,7 +29,7 @@ struct HeuristicEnergyTracker : EventHandler<WeaponFireEvent>,
   Tick last_tick_time = 0;
   EnergyHeuristicType estimate_type = EnergyHeuristicType::Maximum;
 
-  HeuristicEnergyData player_energy[65535];
+  PagedIdTable<HeuristicEnergyData> player_energy;
 
   HeuristicEnergyTracker(PlayerManager& player_manager);
 
@@ -36,6 +37,7 @@ struct HeuristicEnergyTracker : EventHandler<WeaponFireEvent>,
   float GetEnergyPercent(Player& player) const;
 
   void Update();
+  MemoryFootprint GetMemoryFootprint() const { return player_energy.GetMemoryFootprint(); }
 
   void HandleEvent(const WeaponFireEvent& event) override;
   void HandleEvent(const PlayerFreqAndShipChangeEvent& event) override;
@@ -1,38 +1,106 @@
 #pragma once
 
 #include <zero/Math.h>
+#include <zero/game/Memory.h>
 
 #include <algorithm>
 
 namespace zero {
 
+// Influence is only added around weapons, so the map is split into 64x64 tile pages that are allocated the first time
+// something is written to them. Missing pages read as zero.
 struct InfluenceMap {
-  InfluenceMap() {
-    tiles = new float[1024 * 1024];
-    Clear();
+  static constexpr size_t kPageShift = 6;
+  static constexpr size_t kPageSize = 1 << kPageShift;
+  static constexpr size_t kPagesPerRow = 1024 / kPageSize;
+  static constexpr size_t kPageCount = kPagesPerRow * kPagesPerRow;
+
+  InfluenceMap() {}
+
+  ~InfluenceMap() {
+    for (size_t i = 0; i < kPageCount; ++i) {
+      delete[] pages[i];
+    }
   }
 
-  float GetValue(u16 x, u16 y) { return tiles[y * 1024 + x]; }
+  InfluenceMap(const InfluenceMap& other) = delete;
+  InfluenceMap& operator=(const InfluenceMap& other) = delete;
 
-  float GetValue(Vector2f v) { return tiles[(u16)v.y * 1024 + (u16)v.x]; }
+  float GetValue(u16 x, u16 y) {
+    if (x >= 1024 || y >= 1024) return 0.0f;
 
-  void AddValue(u16 x, u16 y, float value) { tiles[y * 1024 + x] += value; }
+    float* page = pages[GetPageIndex(x, y)];
 
-  void SetValue(u16 x, u16 y, float value) { tiles[y * 1024 + x] = value; }
+    return page ? page[GetTileIndex(x, y)] : 0.0f;
+  }
+
+  float GetValue(Vector2f v) { return GetValue((u16)v.x, (u16)v.y); }
+
+  void AddValue(u16 x, u16 y, float value) {
+    float* tile = GetTile(x, y);
+    if (tile) *tile += value;
+  }
+
+  void SetValue(u16 x, u16 y, float value) {
+    float* tile = GetTile(x, y);
+    if (tile) *tile = value;
+  }
 
   void Clear() {
-    for (size_t i = 0; i < 1024 * 1024; ++i) {
-      tiles[i] = 0.0f;
+    for (size_t i = 0; i < kPageCount; ++i) {
+      if (!pages[i]) continue;
+
+      for (size_t j = 0; j < kPageSize * kPageSize; ++j) {
+        pages[i][j] = 0.0f;
+      }
     }
   }
 
   void Update(float dt) {
-    for (size_t i = 0; i < 1024 * 1024; ++i) {
-      tiles[i] = std::max(0.0f, tiles[i] - dt);
+    for (size_t i = 0; i < kPageCount; ++i) {
+      float* page = pages[i];
+
+      if (!page) continue;
+
+      for (size_t j = 0; j < kPageSize * kPageSize; ++j) {
+        page[j] = std::max(0.0f, page[j] - dt);
+      }
+    }
+  }
+
+  MemoryFootprint GetMemoryFootprint() const {
+    MemoryFootprint footprint;
+
+    for (size_t i = 0; i < kPageCount; ++i) {
+      footprint.Add(pages[i], sizeof(float) * kPageSize * kPageSize);
     }
+
+    return footprint;
+  }
+
+ private:
+  static inline size_t GetPageIndex(u16 x, u16 y) { return (y >> kPageShift) * kPagesPerRow + (x >> kPageShift); }
+  static inline size_t GetTileIndex(u16 x, u16 y) {
+    return (y & (kPageSize - 1)) * kPageSize + (x & (kPageSize - 1));
+  }
+
+  float* GetTile(u16 x, u16 y) {
+    if (x >= 1024 || y >= 1024) return nullptr;
+
+    float*& page = pages[GetPageIndex(x, y)];
+
+    if (!page) {
+      page = new float[kPageSize * kPageSize];
+
+      for (size_t i = 0; i < kPageSize * kPageSize; ++i) {
+        page[i] = 0.0f;
+      }
+    }
+
+    return page + GetTileIndex(x, y);
   }
 
-  float* tiles;
+  float* pages[kPageCount] = {};
 };
 
 }  // namespace zero
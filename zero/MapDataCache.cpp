@@ -0,0 +1,132 @@
+#include "MapDataCache.h"
+
+#include <stdlib.h>
+#include <zero/game/Game.h>
+#include <zero/game/Logger.h>
+
+namespace zero {
+
+SharedMapData::SharedMapData(u32 map_checksum, const path::Pathfinder::WeightConfig& weights)
+    : map_checksum(map_checksum), weights(weights) {
+  tiles = (path::NodeTile*)AllocateZeroedPages(sizeof(path::NodeTile) * path::kMaxNodes);
+
+  if (!tiles) {
+    Log(LogLevel::Error, "Failed to allocate %zu bytes for shared path tiles.",
+        sizeof(path::NodeTile) * path::kMaxNodes);
+    exit(1);
+  }
+}
+
+SharedMapData::~SharedMapData() {
+  FreeZeroedPages(tiles, sizeof(path::NodeTile) * path::kMaxNodes);
+}
+
+MemoryFootprint SharedMapData::GetMemoryFootprint() const {
+  MemoryFootprint footprint;
+
+  footprint.Add(tiles, sizeof(path::NodeTile) * path::kMaxNodes);
+  footprint.Add(dynamic_points.data(), dynamic_points.capacity() * sizeof(path::NodePoint));
+
+  MemoryFootprint region_footprint = regions.GetMemoryFootprint();
+
+  footprint.allocated += region_footprint.allocated;
+  footprint.resident += region_footprint.resident;
+
+  return footprint;
+}
+
+void SharedMapData::Build(Game& game) {
+  const Map& map = game.GetMap();
+
+  Log(LogLevel::Info, "Building map data for radius %.2f.", weights.ship_radius);
+
+  regions.CreateAll(map, weights.ship_radius);
+
+  // The weights are calculated into a full set of nodes and then written out to the tiles, so the nodes can be released
+  // once they're built.
+  path::Pathfinder builder(std::make_unique<path::NodeProcessor>(game), &regions);
+
+  builder.CreateMapWeights(game.temp_arena, map, weights);
+
+  path::NodeProcessor& processor = builder.GetProcessor();
+
+  processor.ExportTiles(tiles);
+  dynamic_points = std::move(processor.dynamic_points);
+
+  built = true;
+}
+
+static inline bool IsSameConfig(const path::Pathfinder::WeightConfig& a, const path::Pathfinder::WeightConfig& b) {
+  return a.ship_radius == b.ship_radius && a.weight_type == b.weight_type && a.wall_distance == b.wall_distance;
+}
+
+std::shared_ptr<SharedMapData> MapDataCache::Get(Game& game, const path::Pathfinder::WeightConfig& weights) {
+  u32 checksum = game.GetMap().loaded_checksum;
+  std::shared_ptr<SharedMapData> data;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (size_t i = 0; i < entries.size();) {
+      std::shared_ptr<SharedMapData> entry = entries[i].lock();
+
+      if (!entry) {
+        entries[i] = std::move(entries.back());
+        entries.pop_back();
+        continue;
+      }
+
+      if (checksum != 0 && entry->map_checksum == checksum && IsSameConfig(entry->weights, weights)) {
+        data = std::move(entry);
+        break;
+      }
+
+      ++i;
+    }
+
+    if (!data) {
+      data = std::make_shared<SharedMapData>(checksum, weights);
+
+      // A map that hasn't finished loading can't be identified, so its data is only used by the bot that built it.
+      if (checksum != 0) {
+        entries.push_back(data);
+      }
+    }
+  }
+
+  bool built_here = false;
+
+  std::call_once(data->build_flag, [&]() {
+    data->Build(game);
+    built_here = true;
+  });
+
+  if (built_here) {
+    ++build_count;
+  } else {
+    ++share_count;
+    Log(LogLevel::Info, "Using shared map data for radius %.2f.", weights.ship_radius);
+  }
+
+  return data;
+}
+
+MemoryFootprint MapDataCache::GetMemoryFootprint() {
+  MemoryFootprint footprint;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  for (auto& entry : entries) {
+    std::shared_ptr<SharedMapData> data = entry.lock();
+    if (!data || !data->built) continue;
+
+    MemoryFootprint data_footprint = data->GetMemoryFootprint();
+
+    footprint.allocated += data_footprint.allocated;
+    footprint.resident += data_footprint.resident;
+  }
+
+  return footprint;
+}
+
+}  // namespace zero
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <zero/RegionRegistry.h>
+#include <zero/game/Memory.h>
+#include <zero/path/Pathfinder.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace zero {
+
+struct Game;
+
+// Pathing data that only depends on the map and the weight config. It's never written to after it's built, so any
+// number of bots can read it at the same time.
+struct SharedMapData {
+  u32 map_checksum;
+  path::Pathfinder::WeightConfig weights;
+
+  // Indexed the same as the nodes in NodeProcessor.
+  path::NodeTile* tiles;
+  std::vector<path::NodePoint> dynamic_points;
+  RegionRegistry regions;
+
+  // Set once the data is built. Bots that find the data in the cache while it's still being built wait on this.
+  std::once_flag build_flag;
+  // Set at the end of Build, so the footprint can skip data that another thread is still writing.
+  std::atomic<bool> built = false;
+
+  SharedMapData(u32 map_checksum, const path::Pathfinder::WeightConfig& weights);
+  ~SharedMapData();
+
+  void Build(Game& game);
+
+  SharedMapData(const SharedMapData& other) = delete;
+  SharedMapData& operator=(const SharedMapData& other) = delete;
+
+  MemoryFootprint GetMemoryFootprint() const;
+};
+
+// Builds the shared map data and hands out references to it, so bots in the same process that are on the same map with
+// the same ship radius only build it once and keep one copy of it.
+// Only weak references are kept here, so the data is released when the last bot using it changes ship or map.
+// This is thread safe.
+struct MapDataCache {
+  std::shared_ptr<SharedMapData> Get(Game& game, const path::Pathfinder::WeightConfig& weights);
+
+  // Footprint of all of the data that is currently alive.
+  MemoryFootprint GetMemoryFootprint();
+
+  std::atomic<size_t> build_count = 0;
+  std::atomic<size_t> share_count = 0;
+
+ private:
+  // Only held while looking through the entries. Data is added before it's built so bots that join at the same time
+  // find it and wait for the first one instead of building it again, while bots using other data aren't blocked.
+  std::mutex mutex;
+  std::vector<std::weak_ptr<SharedMapData>> entries;
+};
+
+}  // namespace zero
@@ -1,3 +1,4 @@
+#include <string.h>
 #include <zero/RegionRegistry.h>
 #include <zero/game/Map.h>
 
@@ -26,8 +27,6 @@ void RegionFiller::FillEmpty(const MapCoord& coord) {
 
   coord_regions[coord.y * 1024 + coord.x] = region_index;
 
-  Event::Dispatch(RegionTileAddEvent(region_index, coord));
-
   stack.push_back(coord);
 
   while (!stack.empty()) {
@@ -65,7 +64,6 @@ void RegionFiller::TraverseEmpty(const Vector2f& from, MapCoord to) {
 
     if (map.CanTraverse(from, to_pos, radius, 0xFFFF)) {
       coord_regions[to_index] = region_index;
-      Event::Dispatch(RegionTileAddEvent(region_index, to));
       stack.push_back(to);
     }
   }
@@ -147,9 +145,9 @@ bool RegionFiller::IsEmptyBaseTile(const Vector2f& position) const {
 }
 
 void RegionRegistry::CreateAll(const Map& map, float radius) {
-  Event::Dispatch(RegionBuildEvent());
-
-  RegionFiller filler(map, radius, coord_regions_);
+  // The regions are filled out over the full map first and then compacted into pages.
+  std::vector<RegionIndex> coord_regions(1024 * 1024, kUndefinedRegion);
+  RegionFiller filler(map, radius, coord_regions.data());
 
   for (uint16_t y = 0; y < 1024; ++y) {
     for (uint16_t x = 0; x < 1024; ++x) {
@@ -158,7 +156,7 @@ void RegionRegistry::CreateAll(const Map& map, float radius) {
       if (map.CanOverlapTile(Vector2f(x, y), radius, 0xFFFF)) {
         // If the current coord is empty and hasn't been inserted into region
         // map then create a new region and flood fill it
-        if (!IsRegistered(coord)) {
+        if (coord_regions[(size_t)y * 1024 + x] == kUndefinedRegion) {
           RegionIndex region_index = CreateRegion();
 
           filler.Fill(region_index, coord);
@@ -166,16 +164,86 @@ void RegionRegistry::CreateAll(const Map& map, float radius) {
       }
     }
   }
+
+  Compact(coord_regions);
 }
 
-bool RegionRegistry::IsRegistered(MapCoord coord) const {
-  if (!IsValidPosition(coord)) return false;
-  return coord_regions_[coord.y * 1024 + coord.x] != -1;
+void RegionRegistry::Compact(const std::vector<RegionIndex>& coord_regions) {
+  size_t stored_count = 0;
+  bool uniform[kPagesPerRow * kPagesPerRow];
+
+  for (size_t page_y = 0; page_y < kPagesPerRow; ++page_y) {
+    for (size_t page_x = 0; page_x < kPagesPerRow; ++page_x) {
+      size_t page_index = page_y * kPagesPerRow + page_x;
+      const RegionIndex* start = coord_regions.data() + page_y * kPageSize * 1024 + page_x * kPageSize;
+      RegionIndex first = start[0];
+
+      uniform[page_index] = true;
+
+      for (size_t y = 0; y < kPageSize && uniform[page_index]; ++y) {
+        const RegionIndex* row = start + y * 1024;
+
+        for (size_t x = 0; x < kPageSize; ++x) {
+          if (row[x] != first) {
+            uniform[page_index] = false;
+            break;
+          }
+        }
+      }
+
+      pages_[page_index].uniform = first;
+      pages_[page_index].tiles = nullptr;
+
+      if (!uniform[page_index]) ++stored_count;
+    }
+  }
+
+  page_storage_.clear();
+  page_storage_.shrink_to_fit();
+  page_storage_.resize(stored_count * kPageSize * kPageSize);
+
+  RegionIndex* storage = page_storage_.data();
+
+  for (size_t page_y = 0; page_y < kPagesPerRow; ++page_y) {
+    for (size_t page_x = 0; page_x < kPagesPerRow; ++page_x) {
+      size_t page_index = page_y * kPagesPerRow + page_x;
+
+      if (uniform[page_index]) continue;
+
+      const RegionIndex* start = coord_regions.data() + page_y * kPageSize * 1024 + page_x * kPageSize;
+
+      for (size_t y = 0; y < kPageSize; ++y) {
+        memcpy(storage + y * kPageSize, start + y * 1024, kPageSize * sizeof(RegionIndex));
+      }
+
+      pages_[page_index].tiles = storage;
+      storage += kPageSize * kPageSize;
+    }
+  }
 }
 
-void RegionRegistry::Insert(MapCoord coord, RegionIndex index) {
-  if (!IsValidPosition(coord)) return;
-  coord_regions_[coord.y * 1024 + coord.x] = index;
+void RegionRegistry::DispatchEvents() const {
+  Event::Dispatch(RegionBuildEvent());
+
+  for (size_t page_y = 0; page_y < kPagesPerRow; ++page_y) {
+    for (size_t page_x = 0; page_x < kPagesPerRow; ++page_x) {
+      const RegionPage& page = pages_[page_y * kPagesPerRow + page_x];
+
+      if (!page.tiles && page.uniform == kUndefinedRegion) continue;
+
+      for (size_t y = 0; y < kPageSize; ++y) {
+        for (size_t x = 0; x < kPageSize; ++x) {
+          RegionIndex region_index = page.tiles ? page.tiles[y * kPageSize + x] : page.uniform;
+
+          if (region_index == kUndefinedRegion) continue;
+
+          MapCoord coord((u16)(page_x * kPageSize + x), (u16)(page_y * kPageSize + y));
+
+          Event::Dispatch(RegionTileAddEvent(region_index, coord));
+        }
+      }
+    }
+  }
 }
 
 RegionIndex RegionRegistry::CreateRegion() {
@@ -184,7 +252,7 @@ RegionIndex RegionRegistry::CreateRegion() {
 
 RegionIndex RegionRegistry::GetRegionIndex(MapCoord coord) const {
   if (!IsValidPosition(coord)) return kUndefinedRegion;
-  return coord_regions_[coord.y * 1024 + coord.x];
+  return Get(coord);
 }
 
 bool RegionRegistry::IsConnected(MapCoord a, MapCoord b) const {
@@ -192,12 +260,21 @@ bool RegionRegistry::IsConnected(MapCoord a, MapCoord b) const {
   if (!IsValidPosition(a)) return false;
   if (!IsValidPosition(b)) return false;
 
-  RegionIndex first = coord_regions_[a.y * 1024 + a.x];
+  RegionIndex first = Get(a);
   if (first == -1) return false;
 
-  RegionIndex second = coord_regions_[b.y * 1024 + b.x];
+  RegionIndex second = Get(b);
 
   return first == second;
 }
 
+MemoryFootprint RegionRegistry::GetMemoryFootprint() const {
+  MemoryFootprint footprint;
+
+  footprint.Add(this, sizeof(*this));
+  footprint.Add(page_storage_.data(), page_storage_.size() * sizeof(RegionIndex));
+
+  return footprint;
+}
+
 }  // namespace zero
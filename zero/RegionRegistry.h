@@ -4,12 +4,14 @@
 #include <zero/Hash.h>
 #include <zero/Math.h>
 #include <zero/game/Map.h>
+#include <zero/game/Memory.h>
 
 #include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace zero {
 
@@ -109,21 +111,48 @@ struct RegionFiller {
 
 class RegionRegistry {
  public:
-  RegionRegistry() : region_count_(0) { memset(coord_regions_, 0xFF, sizeof(coord_regions_)); }
+  RegionRegistry() : region_count_(0) {}
 
   bool IsConnected(MapCoord a, MapCoord b) const;
   void CreateAll(const Map& map, float radius);
 
+  // Sends a RegionBuildEvent and then a RegionTileAddEvent for every tile that is in a region to the current event
+  // context. Building doesn't send any events since the registry can be built by one bot and shared with others, so
+  // each bot calls this once it has its registry.
+  void DispatchEvents() const;
+
   RegionIndex GetRegionIndex(MapCoord coord) const;
 
+  MemoryFootprint GetMemoryFootprint() const;
+
  private:
-  bool IsRegistered(MapCoord coord) const;
-  void Insert(MapCoord coord, RegionIndex index);
+  // Regions are stored in 64x64 tile pages. A page where every tile is in the same region, or no region at all, only
+  // stores that one index. Open space and solid areas make up most of a map, so only pages along walls store tiles.
+  static constexpr size_t kPageShift = 6;
+  static constexpr size_t kPageSize = 1 << kPageShift;
+  static constexpr size_t kPagesPerRow = 1024 / kPageSize;
+
+  struct RegionPage {
+    RegionIndex uniform = kUndefinedRegion;
+    RegionIndex* tiles = nullptr;
+  };
+
+  inline RegionIndex Get(MapCoord coord) const {
+    const RegionPage& page = pages_[(coord.y >> kPageShift) * kPagesPerRow + (coord.x >> kPageShift)];
+
+    if (!page.tiles) return page.uniform;
+
+    return page.tiles[(coord.y & (kPageSize - 1)) * kPageSize + (coord.x & (kPageSize - 1))];
+  }
+
+  // Splits the full map of regions into pages, only storing the pages that aren't uniform.
+  void Compact(const std::vector<RegionIndex>& coord_regions);
 
   RegionIndex CreateRegion();
 
   RegionIndex region_count_;
 
-  RegionIndex coord_regions_[1024 * 1024];
+  RegionPage pages_[kPagesPerRow * kPagesPerRow];
+  std::vector<RegionIndex> page_storage_;
 };
 }  // namespace zero
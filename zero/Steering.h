@@ -11,6 +11,9 @@ struct Steering {
   float rotation = 0.0f;
   float rotation_threshold = 0.75f;
 
+  // Output for the player grid queries used to find nearby players to avoid.
+  Player* nearby_players[PlayerGrid::kMaxPlayers];
+
   void Reset() {
     force = Vector2f(0, 0);
     rotation = 0.0f;
@@ -190,19 +193,20 @@ struct Steering {
     Vector2f avoid_force;
     float count = 0.0f;
 
-    for (size_t i = 0; i < pm.player_count; ++i) {
-      Player* player = pm.players + i;
+    PlayerQueryFilter filter;
+    filter.frequency = self->frequency;
+
+    size_t nearby_count =
+        pm.grid.QueryRadius(self->position, dist, filter, nearby_players, ZERO_ARRAY_SIZE(nearby_players));
+
+    for (size_t i = 0; i < nearby_count; ++i) {
+      Player* player = nearby_players[i];
 
-      if (player->frequency != self->frequency) continue;
-      if (player->ship >= 8) continue;
       if (player->id == self->id) continue;
-      if (player->IsRespawning()) continue;
       if (player->position == Vector2f(0, 0)) continue;
       if (!game.player_manager.IsSynchronized(*player)) continue;
 
       float dist_sq = player->position.DistanceSq(self->position);
-      if (dist_sq > dist * dist) continue;
-
       float team_dist = sqrtf(dist_sq);
       float diff = dist - team_dist;
 
@@ -226,18 +230,20 @@ struct Steering {
     Vector2f avoid_force;
     float count = 0.0f;
 
-    for (size_t i = 0; i < pm.player_count; ++i) {
-      Player* player = pm.players + i;
+    PlayerQueryFilter filter;
+    filter.exclude_frequency = self->frequency;
+
+    size_t nearby_count =
+        pm.grid.QueryRadius(self->position, dist, filter, nearby_players, ZERO_ARRAY_SIZE(nearby_players));
+
+    for (size_t i = 0; i < nearby_count; ++i) {
+      Player* player = nearby_players[i];
 
-      if (player->frequency == self->frequency) continue;
       if (player->id == self->id) continue;
-      if (player->IsRespawning()) continue;
       if (player->position == Vector2f(0, 0)) continue;
       if (!game.player_manager.IsSynchronized(*player)) continue;
 
       float dist_sq = player->position.DistanceSq(self->position);
-      if (dist_sq > dist * dist) continue;
-
       float team_dist = sqrtf(dist_sq);
       float diff = dist - team_dist;
 
@@ -2,10 +2,13 @@
 
 #include <stdio.h>
 #include <zero/BotController.h>
+#include <zero/MapDataCache.h>
 #include <zero/game/Game.h>
 #include <zero/game/Logger.h>
 #include <zero/game/Settings.h>
 #include <zero/game/WorkQueue.h>
+#include <zero/game/net/NetworkStatistics.h>
+#include <zero/zones/ZoneController.h>
 
 #include <chrono>
 
@@ -32,66 +35,91 @@ namespace zero {
 
 GameSettings g_Settings;
 
-const char* kPlayerName = "ZeroBot";
-const char* kPlayerPassword = "none";
-
 MemoryArena* perm_global = nullptr;
 
 ZeroBot::ZeroBot() : perm_arena(nullptr, 0), trans_arena(nullptr, 0) {}
 
+// Defined here so the zone controllers can be destroyed with their complete type.
+ZeroBot::~ZeroBot() {}
+
 bool ZeroBot::Initialize(std::unique_ptr<ArgParser> args, const char* name, const char* password) {
+  EventContextScope scope(events);
+
   constexpr size_t kPermanentSize = Megabytes(64);
   constexpr size_t kTransientSize = Megabytes(32);
   constexpr size_t kWorkSize = Megabytes(4);
 
-#ifdef _WIN32
-  u8* perm_memory = (u8*)VirtualAlloc(NULL, kPermanentSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-  u8* trans_memory = (u8*)VirtualAlloc(NULL, kTransientSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-  u8* work_memory = (u8*)VirtualAlloc(NULL, kWorkSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-#else
-  u8* perm_memory = (u8*)malloc(kPermanentSize);
-  u8* trans_memory = (u8*)malloc(kTransientSize);
-  u8* work_memory = (u8*)malloc(kWorkSize);
-#endif
+  // Arenas only commit the pages they use, so the sizes above are limits rather than what each bot costs.
+  HugePageMode huge_pages = HugePageMode::Transparent;
 
-  if (!perm_memory || !trans_memory || !work_memory) {
+  auto opt_huge_pages = this->config->GetInt("General", "HugePages");
+  if (opt_huge_pages && *opt_huge_pages >= 0 && *opt_huge_pages <= 2) huge_pages = (HugePageMode)*opt_huge_pages;
+
+  perm_arena = ReserveArena("perm", kPermanentSize, huge_pages);
+  trans_arena = ReserveArena("trans", kTransientSize, huge_pages);
+  work_arena = ReserveArena("work", kWorkSize, HugePageMode::None);
+
+  if (!perm_arena.base || !trans_arena.base || !work_arena.base) {
     Log(LogLevel::Error, "Failed to allocate memory.");
     return false;
   }
 
-  perm_arena = MemoryArena(perm_memory, kPermanentSize);
-  trans_arena = MemoryArena(trans_memory, kTransientSize);
-  work_arena = MemoryArena(work_memory, kWorkSize);
+  size_t worker_count = 2;
+
+  auto opt_worker_threads = this->config->GetInt("General", "WorkerThreads");
+  if (opt_worker_threads && *opt_worker_threads > 0) worker_count = *opt_worker_threads;
 
-  work_queue = new WorkQueue(work_arena);
-  worker = new Worker(*work_queue);
-  worker->Launch();
+  work_queue = new WorkQueue(work_arena, worker_count);
+
+  if (!hosted && event_loop.Initialize()) {
+    work_queue->notify = [](void* user) { ((EventLoop*)user)->Wake(); };
+    work_queue->notify_user = &event_loop;
+  }
 
   perm_global = &perm_arena;
 
-  strcpy(this->name, name);
-  strcpy(this->password, password);
+  strncpy(this->name, name, sizeof(this->name) - 1);
+  strncpy(this->password, password, sizeof(this->password) - 1);
   this->args = std::move(args);
 
+  auto owner_str = this->config->GetString("General", "Owner");
+  if (owner_str) {
+    owner = *owner_str;
+  } else {
+    owner = "*unset*";
+  }
+
+  if (!map_cache) {
+    map_cache = std::make_shared<MapDataCache>();
+  }
+
+  // The controllers register their handlers with this bot's events.
+  for (ZoneControllerRegistration* registration = ZoneControllerRegistration::GetHead(); registration;
+       registration = registration->next) {
+    zone_controllers.push_back(registration->create());
+  }
+
   g_Settings.vsync = true;
 
   return true;
 }
 
-bool ZeroBot::JoinZone(ServerInfo& server) {
-  perm_arena.Reset();
+bool ZeroBot::CreateGame(ServerInfo& server) {
+  EventContextScope scope(events);
 
-  kPlayerName = name;
-  kPlayerPassword = password;
+  perm_arena.Reset();
 
   game = memory_arena_construct_type(&perm_arena, Game, perm_arena, trans_arena, *work_queue, SURFACE_WIDTH,
                                      SURFACE_HEIGHT);
-  bot_controller = memory_arena_construct_type(&perm_arena, BotController, *game);
+  game->connection.login_name = name;
+  game->connection.login_password = password;
+
+  bot_controller = memory_arena_construct_type(&perm_arena, BotController, *game, *map_cache);
 
   commands = memory_arena_construct_type(&perm_arena, CommandSystem, *this, this->game->dispatcher);
   commands->LoadSecurityLevels();
 
-  if (g_Settings.debug_window) {
+  if (g_Settings.debug_window && !hosted) {
     if (debug_renderer.Initialize(SURFACE_WIDTH, SURFACE_HEIGHT)) {
       game->render_enabled = true;
       debug_renderer.SetWindowUserPointer(this);
@@ -125,6 +153,20 @@ bool ZeroBot::JoinZone(ServerInfo& server) {
     bot_controller->default_arena = std::string(*default_arena);
   }
 
+  return true;
+}
+
+bool ZeroBot::JoinZone(ServerInfo& server) {
+  EventContextScope scope(events);
+
+  if (!CreateGame(server)) return false;
+
+  std::string_view capture_path = args->GetValue({"capture"});
+  if (!capture_path.empty() && capture.Open(capture_path.data())) {
+    Log(LogLevel::Info, "Capturing inbound packets to '%s'.", capture_path.data());
+    game->connection.capture = &capture;
+  }
+
   ConnectResult result = game->connection.Connect(server.ipaddr.data(), server.port);
 
   if (result != ConnectResult::Success) {
@@ -173,7 +215,6 @@ void ZeroBot::UpdateRelaxed(size_t update_count) {
       game->sprite_renderer.texture_push_buffer.Reset();
     }
 
-    game->player_manager.kdtree = nullptr;
     trans_arena.Reset();
   }
 }
@@ -208,77 +249,369 @@ void ZeroBot::Update(size_t update_count) {
       game->sprite_renderer.texture_push_buffer.Reset();
     }
 
-    game->player_manager.kdtree = nullptr;
     trans_arena.Reset();
   }
 }
 
 void ZeroBot::Run() {
-  // TODO: better timer
+  EventContextScope scope(events);
+
+  BeginRun();
+
+  while (RunFrame()) {
+    if (game->render_enabled) {
+      debug_renderer.Present();
+    }
+
+    if (run_state.use_event_loop) {
+      s64 timeout_us = GetWaitTimeout();
+
+      // A tick is already due or there are buffered datagrams, so run the next frame straight away.
+      if (timeout_us == 0) continue;
+
+      event_loop.SetSocketWatched(game->connection.IsReceiving());
+      event_loop.Wait(timeout_us);
+    } else if (!g_Settings.debug_window && run_state.sleep_ms > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(run_state.sleep_ms));
+    }
+  }
+
+  EndRun();
+}
+
+s64 ZeroBot::GetWaitTimeout() const {
   using ms_float = std::chrono::duration<float, std::milli>;
-  float frame_time = 0.0f;
+
+  Connection& connection = game->connection;
+
+  // Datagrams that were already read into the receive batch don't make the socket readable again.
+  if (connection.IsReceiving() && connection.HasBufferedDatagrams()) return 0;
+
+  auto now = std::chrono::high_resolution_clock::now();
+  float elapsed = std::chrono::duration_cast<ms_float>(now - run_state.frame_start).count();
+  s64 timeout_us = (s64)((kTickTime - run_state.dt_accumulator) * 1000000.0f - elapsed * 1000.0f);
+
+  return timeout_us > 0 ? timeout_us : 0;
+}
+
+void ZeroBot::BeginRun() {
+  EventContextScope scope(events);
 
   execute_ctx.bot = this;
 
-  int sleep_ms = 1;
+  run_state.frame_start = std::chrono::high_resolution_clock::now();
+  run_state.dt_accumulator = 0.0f;
 
   auto opt_sleep_ms = this->config->GetInt("General", "SleepMs");
-  if (opt_sleep_ms) sleep_ms = *opt_sleep_ms;
+  if (opt_sleep_ms) run_state.sleep_ms = *opt_sleep_ms;
 
-  float dt_accumulator = 0.0f;
+  auto opt_relaxed_controller_tick = this->config->GetInt("General", "RelaxedControllerTick");
+  if (opt_relaxed_controller_tick) run_state.relaxed_controller_tick = *opt_relaxed_controller_tick;
 
-  bool relaxed_controller_tick = false;
+  // The event loop blocks until a packet arrives or a tick is due instead of sleeping for SleepMs.
+  // The render window needs to be polled, so it always uses the sleep loop.
+  run_state.use_event_loop = event_loop.IsEnabled() && !game->render_enabled && !g_Settings.debug_window;
 
-  auto opt_relaxed_controller_tick = this->config->GetInt("General", "RelaxedControllerTick");
-  if (opt_relaxed_controller_tick) relaxed_controller_tick = *opt_relaxed_controller_tick;
+  auto opt_event_loop = this->config->GetInt("General", "EventLoop");
+  if (opt_event_loop && *opt_event_loop == 0) run_state.use_event_loop = false;
 
-  while (true) {
-    auto start = std::chrono::high_resolution_clock::now();
+  if (run_state.use_event_loop) {
+    event_loop.SetSocket(game->connection.transport->GetSocket());
+    Log(LogLevel::Debug, "Using event loop.");
+  }
 
-    dt_accumulator += frame_time / 1000.0f;
+  run_state.memory_stats_tick = GetCurrentTick();
 
-    Connection::TickResult tick_result = game->connection.Tick();
-    if (tick_result != Connection::TickResult::Success) {
-      break;
-    }
+  auto opt_memory_stats_interval = this->config->GetInt("General", "MemoryStatsInterval");
+  if (opt_memory_stats_interval) run_state.memory_stats_interval = *opt_memory_stats_interval * 100;
 
-    if (game->render_enabled && !debug_renderer.Begin()) {
-      game->Cleanup();
-      break;
-    }
+  auto opt_net_stats_interval = this->config->GetInt("General", "NetStatsInterval");
+  if (opt_net_stats_interval) run_state.net_stats_interval = *opt_net_stats_interval * 100;
 
-    size_t update_count = (size_t)(dt_accumulator / kTickTime);
+  // Packet timing is only turned on when the summary is being logged so it costs nothing otherwise.
+  if (run_state.net_stats_interval > 0) {
+    game->connection.net_stats.timing_enabled = true;
+    game->dispatcher.timing_enabled = true;
+    game->connection.net_stats.summary_tick = GetCurrentTick();
+  }
+}
+
+bool ZeroBot::RunFrame() {
+  using ms_float = std::chrono::duration<float, std::milli>;
+
+  EventContextScope scope(events);
 
-    if (update_count > 0) {
-      dt_accumulator -= (float)update_count * kTickTime;
+  // The time since the last frame started includes however long the caller waited between frames.
+  auto start = std::chrono::high_resolution_clock::now();
+  float frame_time = std::chrono::duration_cast<ms_float>(start - run_state.frame_start).count();
 
-      if (dt_accumulator < 0.0f) {
-        dt_accumulator = 0.0f;
-      }
+  run_state.frame_start = start;
+  run_state.dt_accumulator += frame_time / 1000.0f;
 
-      if (relaxed_controller_tick) {
-        this->UpdateRelaxed(update_count);
-      } else {
-        this->Update(update_count);
-      }
+  Connection::TickResult tick_result = game->connection.Tick();
+  if (tick_result != Connection::TickResult::Success) {
+    return false;
+  }
+
+  // Completions run before the update so anything they send goes out with this frame.
+  work_queue->ProcessCompleted();
+
+  if (game->render_enabled && !debug_renderer.Begin()) {
+    game->Cleanup();
+    return false;
+  }
+
+  size_t update_count = (size_t)(run_state.dt_accumulator / kTickTime);
+
+  if (update_count > 0) {
+    run_state.dt_accumulator -= (float)update_count * kTickTime;
+
+    if (run_state.dt_accumulator < 0.0f) {
+      run_state.dt_accumulator = 0.0f;
     }
 
-    if (game->render_enabled) {
-      debug_renderer.Present();
+    if (run_state.relaxed_controller_tick) {
+      this->UpdateRelaxed(update_count);
+    } else {
+      this->Update(update_count);
+    }
+  }
+
+  // Send everything that was generated during this frame together.
+  game->connection.FlushOutbound();
+
+  if (run_state.net_stats_interval > 0) {
+    Tick tick = GetCurrentTick();
+
+    if (TICK_DIFF(tick, (Tick)game->connection.net_stats.summary_tick) >= run_state.net_stats_interval) {
+      LogNetworkSummary(game->connection);
     }
+  }
+
+  if (run_state.memory_stats_interval > 0) {
+    Tick tick = GetCurrentTick();
 
-    if (!g_Settings.debug_window && sleep_ms > 0) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+    if (TICK_DIFF(tick, run_state.memory_stats_tick) >= run_state.memory_stats_interval) {
+      LogMemoryUsage();
+      run_state.memory_stats_tick = tick;
     }
+  }
+
+  sig_atomic_t dump_requests = g_NetworkStatisticsDumpRequests;
+
+  if (run_state.net_stats_dump_requests != dump_requests) {
+    run_state.net_stats_dump_requests = dump_requests;
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s-netstats.txt", name);
 
-    auto end = std::chrono::high_resolution_clock::now();
-    frame_time = std::chrono::duration_cast<ms_float>(end - start).count();
+    if (WriteNetworkStatistics(game->connection, path)) {
+      Log(LogLevel::Info, "Wrote network statistics to %s.", path);
+    }
   }
 
+  return true;
+}
+
+void ZeroBot::EndRun() {
+  EventContextScope scope(events);
+
   if (game && game->connection.connected) {
     game->connection.SendDisconnect();
     Log(LogLevel::Info, "Disconnected from server.");
   }
+
+  if (run_state.use_event_loop) {
+    event_loop.SetSocket(-1);
+  }
+
+  capture.Close();
+
+  LogMemoryUsage();
+}
+
+void ZeroBot::LogMemoryUsage() {
+  LogArenaUsage(perm_arena);
+  LogArenaUsage(trans_arena);
+  LogArenaUsage(work_arena);
+
+  if (game) {
+    LogArenaUsage(game->connection.map_arena);
+    LogArenaUsage(game->connection.send_arena);
+
+    LogMemoryFootprint("players", game->player_manager.GetMemoryFootprint());
+    LogMemoryFootprint("weapons", game->weapon_manager.GetMemoryFootprint());
+
+    MemoryFootprint animation;
+    animation.Add(&game->animation, sizeof(game->animation));
+    LogMemoryFootprint("animations", animation);
+
+    MemoryFootprint sprites;
+    sprites.Add(&game->sprite_renderer, sizeof(game->sprite_renderer));
+    LogMemoryFootprint("sprites", sprites);
+  }
+
+  if (bot_controller) {
+    if (bot_controller->pathfinder) {
+      LogMemoryFootprint("path nodes", bot_controller->pathfinder->GetProcessor().GetMemoryFootprint());
+    }
+
+    if (bot_controller->map_data) {
+      LogMemoryFootprint("shared map data", bot_controller->map_data->GetMemoryFootprint());
+    }
+
+    // Only the bot's own registry is logged here. The shared one is included in the shared map data.
+    if (bot_controller->region_registry &&
+        (!bot_controller->map_data || bot_controller->region_registry.get() != &bot_controller->map_data->regions)) {
+      LogMemoryFootprint("regions", bot_controller->region_registry->GetMemoryFootprint());
+    }
+
+    LogMemoryFootprint("influence map", bot_controller->influence_map.GetMemoryFootprint());
+    LogMemoryFootprint("energy tracker", bot_controller->energy_tracker.GetMemoryFootprint());
+  }
+
+  Log(LogLevel::Info, "Process resident: %.2f MiB", GetProcessResidentSize() / (1024.0 * 1024.0));
+}
+
+struct ReplayPhaseTiming {
+  const char* name;
+  double total_ms = 0.0;
+  double max_ms = 0.0;
+
+  ReplayPhaseTiming(const char* name) : name(name) {}
+
+  inline void Add(double ms) {
+    total_ms += ms;
+    if (ms > max_ms) max_ms = ms;
+  }
+};
+
+bool ZeroBot::Replay(ServerInfo& server, const char* capture_path) {
+  using clock = std::chrono::high_resolution_clock;
+  using ms_double = std::chrono::duration<double, std::milli>;
+
+  EventContextScope scope(events);
+
+  if (!CreateGame(server)) return false;
+
+  PacketCaptureReader reader;
+
+  if (!reader.Open(perm_arena, capture_path) || !reader.HasNext()) {
+    Log(LogLevel::Error, "Failed to replay capture '%s'.", capture_path);
+    return false;
+  }
+
+  Connection& connection = game->connection;
+
+  connection.offline = true;
+  connection.connected = true;
+  connection.encrypt_method = g_Settings.encrypt_method;
+
+  this->server_info = server;
+
+  Tick start_tick = reader.PeekTick();
+  Tick tick = start_tick;
+
+  SetVirtualTick(tick);
+
+  connection.connect_tick = tick;
+  connection.last_sync_tick = tick;
+  connection.last_packet_tick = tick;
+
+  execute_ctx.bot = this;
+
+  ReplayPhaseTiming network_timing("network");
+  ReplayPhaseTiming controller_timing("controller");
+  ReplayPhaseTiming update_timing("update");
+  ReplayPhaseTiming render_timing("render");
+
+  size_t packet_count = 0;
+  size_t tick_count = 0;
+
+  auto replay_start = clock::now();
+
+  while (reader.HasNext()) {
+    SetVirtualTick(tick);
+
+    auto network_start = clock::now();
+
+    connection.packet_sequencer.Tick(connection);
+
+    PacketCaptureRecord record;
+
+    while (reader.HasNext() && TICK_GTE(tick, reader.PeekTick())) {
+      reader.Next(&record);
+
+      connection.buffer.Reset();
+      connection.ProcessPacket(record.data, record.size);
+      connection.packet_sequencer.Tick(connection);
+
+      ++packet_count;
+    }
+
+    connection.buffer.Reset();
+
+    auto controller_start = clock::now();
+    network_timing.Add(ms_double(controller_start - network_start).count());
+
+    if (bot_controller && bot_controller->actuator.enabled) {
+      input.Clear();
+    } else {
+      input.ClearWeapons();
+    }
+
+    if (bot_controller && connection.login_state == Connection::LoginState::Complete) {
+      execute_ctx.dt = kTickTime;
+
+      RenderContext rc(&game->camera, &game->ui_camera, &game->sprite_renderer);
+
+      bot_controller->Update(rc, input, execute_ctx);
+    }
+
+    auto update_start = clock::now();
+    controller_timing.Add(ms_double(update_start - controller_start).count());
+
+    bool running = game->Update(input, kTickTime);
+
+    auto render_start = clock::now();
+    update_timing.Add(ms_double(render_start - update_start).count());
+
+    if (!running) {
+      game->Cleanup();
+      break;
+    }
+
+    game->Render(kTickTime);
+    connection.FlushOutbound();
+    trans_arena.Reset();
+
+    render_timing.Add(ms_double(clock::now() - render_start).count());
+
+    ++tick_count;
+    tick = MAKE_TICK(tick + 1);
+  }
+
+  double replay_ms = ms_double(clock::now() - replay_start).count();
+
+  DisableVirtualClock();
+
+  Log(LogLevel::Info, "Replayed %zu packets over %zu ticks (%d captured ticks) in %.2fms.", packet_count,
+      tick_count, TICK_DIFF(tick, start_tick), replay_ms);
+
+  ReplayPhaseTiming* timings[] = {&network_timing, &controller_timing, &update_timing, &render_timing};
+
+  for (ReplayPhaseTiming* timing : timings) {
+    double average_ms = tick_count > 0 ? timing->total_ms / tick_count : 0.0;
+
+    Log(LogLevel::Info, "  %-10s avg: %.4fms  max: %.4fms  total: %.2fms", timing->name, average_ms, timing->max_ms,
+        timing->total_ms);
+  }
+
+  Log(LogLevel::Info, "  %u packets would have been sent.", connection.packets_sent);
+
+  LogMemoryUsage();
+
+  return true;
 }
 
 }  // namespace zero
@@ -6,18 +6,25 @@
 #include <zero/Event.h>
 #include <zero/behavior/BehaviorTree.h>
 #include <zero/commands/CommandSystem.h>
+#include <zero/game/EventLoop.h>
 #include <zero/game/Game.h>
 #include <zero/game/InputState.h>
 #include <zero/game/Memory.h>
+#include <zero/game/net/PacketCapture.h>
 
+#include <signal.h>
+
+#include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace zero {
 
 struct BotController;
-struct Worker;
+struct MapDataCache;
 struct WorkQueue;
+struct ZoneController;
 
 enum class Zone {
   Local,
@@ -56,13 +63,16 @@ struct ServerInfo {
 };
 
 struct ZeroBot {
+  // Every handler that the bot creates registers with this, so it's declared first to be destroyed last.
+  EventContext events;
+
   MemoryArena perm_arena;
   MemoryArena trans_arena;
   MemoryArena work_arena;
   WorkQueue* work_queue;
-  Worker* worker;
   Game* game = nullptr;
   DebugRenderer debug_renderer;
+  EventLoop event_loop;
 
   std::unique_ptr<Config> config;
   std::unique_ptr<ArgParser> args;
@@ -79,13 +89,56 @@ struct ZeroBot {
   char password[256] = {0};
   std::string owner;
 
+  PacketCaptureWriter capture;
+
+  // Shared with the other bots in a host so they only build the map data once. Created by Initialize if not set.
+  std::shared_ptr<MapDataCache> map_cache;
+  std::vector<std::unique_ptr<ZoneController>> zone_controllers;
+
+  // Hosted bots are stepped by the host's threads, so they don't use the event loop or render window.
+  bool hosted = false;
+
+  // State kept between frames so the bot can be stepped by RunFrame instead of Run.
+  struct RunState {
+    std::chrono::high_resolution_clock::time_point frame_start;
+    float dt_accumulator = 0.0f;
+
+    int sleep_ms = 1;
+    bool relaxed_controller_tick = false;
+    bool use_event_loop = false;
+
+    s32 memory_stats_interval = 0;
+    Tick memory_stats_tick = 0;
+    s32 net_stats_interval = 0;
+
+    // The last value of g_NetworkStatisticsDumpRequests that was handled.
+    sig_atomic_t net_stats_dump_requests = 0;
+  } run_state;
+
   ZeroBot();
+  ~ZeroBot();
 
   bool Initialize(std::unique_ptr<ArgParser> args, const char* name, const char* password);
+  // Creates the game and bot controller without connecting.
+  bool CreateGame(ServerInfo& server);
   bool JoinZone(ServerInfo& server);
+  // Feeds a packet capture through the game with a virtual clock. No sockets or security solver are used.
+  bool Replay(ServerInfo& server, const char* capture_path);
 
+  // Runs until the connection closes.
   void Run();
 
+  // Run split up into parts so a host can step many bots from its own threads.
+  void BeginRun();
+  // Processes one frame without waiting. Returns false once the connection closes.
+  bool RunFrame();
+  void EndRun();
+
+  // Microseconds until the next tick is due, or zero if the next frame should run without waiting at all.
+  s64 GetWaitTimeout() const;
+
+  void LogMemoryUsage();
+
   void UpdateRelaxed(size_t update_count);
   void Update(size_t update_count);
 
@@ -6,7 +6,7 @@
 namespace zero {
 namespace behavior {
 
-TreePrinter* gDebugTreePrinter = nullptr;
+thread_local TreePrinter* gDebugTreePrinter = nullptr;
 
 void TreePrinter::Render(RenderContext& rc) {
   if (render_brackets) {
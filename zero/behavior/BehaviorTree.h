@@ -43,7 +43,8 @@ struct TreePrinter {
 
   void Render(RenderContext& rc);
 };
-extern TreePrinter* gDebugTreePrinter;
+// Set by the bot controller while its tree executes. Each thread can be running a different bot.
+extern thread_local TreePrinter* gDebugTreePrinter;
 
 enum class ExecuteResult { Success, Failure, Running };
 
@@ -9,8 +9,11 @@
 namespace zero {
 namespace behavior {
 
+// The target's acceleration bends the lead point along the path it's curving onto. The intercept time is still solved
+// for constant velocity, which is close enough over the short flight times where the acceleration matters.
 inline std::optional<Vector2f> CalculateShot(const Vector2f& pShooter, const Vector2f& pTarget,
-                                             const Vector2f& vShooter, const Vector2f& vTarget, float sProjectile) {
+                                             const Vector2f& vShooter, const Vector2f& vTarget, float sProjectile,
+                                             const Vector2f& aTarget = Vector2f(0, 0)) {
   Vector2f totarget = pTarget - pShooter;
   Vector2f v = vTarget - vShooter;
 
@@ -34,7 +37,7 @@ inline std::optional<Vector2f> CalculateShot(const Vector2f& pShooter, const Vec
     return std::nullopt;
   }
 
-  solution = pTarget + (v * t);
+  solution = pTarget + (v * t) + aTarget * (0.5f * t * t);
 
   return std::optional(solution);
 }
@@ -130,6 +133,33 @@ struct AimNode : public BehaviorNode {
   AimNode(WeaponType weapon_type, const char* target_player_key, const char* position_key)
       : weapon_type(weapon_type), target_player_key(target_player_key), position_key(position_key) {}
 
+  // Samples and ticks of received positions that the target's velocity is averaged over. This is short enough to follow
+  // real turns but keeps a single juke from swinging the lead point all the way over.
+  static constexpr size_t kSmoothingSamples = 4;
+  static constexpr s32 kSmoothingTicks = 25;
+  // Ticks of received positions the acceleration is fit over. Older history than this isn't used at all.
+  static constexpr s32 kAccelerationTicks = 50;
+
+  // Estimates the target's velocity and acceleration from the positions received for it. The change the simulation
+  // made since the newest position, such as a wall bounce, is kept on top of the smoothed velocity.
+  static void GetTargetMotion(Game& game, Player& target, Vector2f* velocity, Vector2f* acceleration) {
+    if (target.ship >= 8) return;
+
+    PositionHistory& history = game.player_manager.GetPositionHistory(target);
+
+    // Nothing recent was received, so the simulated velocity is all there is to go on.
+    if (history.count == 0 || TICK_DIFF(GetCurrentTick(), history.Get(0).tick) > kAccelerationTicks) return;
+
+    Vector2f smoothed_velocity = history.GetSmoothedVelocity(kSmoothingSamples, kSmoothingTicks);
+
+    *velocity = target.velocity - history.Get(0).velocity + smoothed_velocity;
+
+    if (!history.GetAcceleration(acceleration, kAccelerationTicks)) return;
+
+    // Fits over noisy turns can come out well past anything the ship can do, so limit it to full afterburner thrust.
+    acceleration->Truncate(game.connection.settings.ShipSettings[target.ship].MaximumThrust * (10.0f / 16.0f));
+  }
+
   ExecuteResult Execute(ExecuteContext& ctx) override {
     auto self = ctx.bot->game->player_manager.GetSelf();
     if (!self) return ExecuteResult::Failure;
@@ -143,18 +173,24 @@ struct AimNode : public BehaviorNode {
     float weapon_speed = GetWeaponSpeed(*ctx.bot->game, *self, weapon_type);
     Vector2f weapon_velocity = self->velocity + self->GetHeading() * weapon_speed;
 
+    Vector2f target_velocity = target->velocity;
+    Vector2f target_acceleration(0, 0);
+
+    GetTargetMotion(*ctx.bot->game, *target, &target_velocity, &target_acceleration);
+
     Vector2f direction = Normalize(target->position - self->position);
-    float away_amount = target->velocity.Dot(direction);
+    float away_amount = target_velocity.Dot(direction);
 
-    Vector2f target_velocity = target->velocity;
     // If the enemy is moving away too fast, ignore the away movement for this calculation.
     if (away_amount > weapon_speed) {
       // Remove the "away" velocity from the target so it's only moving side to side.
-      target_velocity = target->velocity - direction * away_amount;
+      target_velocity = target_velocity - direction * away_amount;
+      target_acceleration = target_acceleration - direction * target_acceleration.Dot(direction);
     }
 
     std::optional<Vector2f> calculated_shot =
-        CalculateShot(self->position, target->position, self->velocity, target_velocity, weapon_velocity.Length());
+        CalculateShot(self->position, target->position, self->velocity, target_velocity, weapon_velocity.Length(),
+                      target_acceleration);
 
     // Default to target's position if the calculated shot fails.
     Vector2f aimshot = target->position;
@@ -100,7 +100,7 @@ struct TurretCountQueryNode : behavior::BehaviorNode {
 
     if (!carrier || carrier->ship >= 8) return behavior::ExecuteResult::Failure;
 
-    AttachInfo* attach_info = carrier->children;
+    AttachInfo* attach_info = ctx.bot->game->player_manager.GetDetails(*carrier).children;
     while (attach_info) {
       ++count;
       attach_info = attach_info->next;
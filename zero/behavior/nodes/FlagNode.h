@@ -23,7 +23,7 @@ struct FlagCarryCountQueryNode : public BehaviorNode {
 
     if (!player) return ExecuteResult::Failure;
 
-    ctx.blackboard.Set<u16>(output_key, player->flags);
+    ctx.blackboard.Set<u16>(output_key, ctx.bot->game->player_manager.GetDetails(*player).flags);
 
     return ExecuteResult::Success;
   }
@@ -169,7 +169,9 @@ struct PowerballCarryQueryNode : public BehaviorNode {
 
     if (!player) return ExecuteResult::Failure;
 
-    return player->ball_carrier ? ExecuteResult::Success : ExecuteResult::Failure;
+    bool carrying = ctx.bot->game->player_manager.GetDetails(*player).ball_carrier;
+
+    return carrying ? ExecuteResult::Success : ExecuteResult::Failure;
   }
 
   const char* player_key = nullptr;
@@ -516,7 +516,7 @@ void CommandSystem::OnChatPacket(const u8* pkt, size_t size) {
     // Ignore self
     if (player->id == bot.game->player_manager.player_id) return;
 
-    sender_name = player->name;
+    sender_name = bot.game->player_manager.GetName(*player);
   }
 
   std::vector<std::string_view> tokens = Tokenize(msg, ';');
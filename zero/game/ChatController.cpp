@@ -133,11 +133,12 @@ Player* ChatController::GetBestPlayerNameMatch(char* name, size_t length) {
   // If they match up to the length and the name is exactly the same length as the check name then return that one.
   for (size_t i = 0; i < player_manager.player_count; ++i) {
     Player* p = player_manager.players + i;
+    char* p_name = player_manager.player_details[i].name;
 
     bool is_match = true;
 
-    for (size_t j = 0; j < ZERO_ARRAY_SIZE(p->name) && j < length; ++j) {
-      char p_curr = tolower(p->name[j]);
+    for (size_t j = 0; j < ZERO_ARRAY_SIZE(player_manager.player_details[i].name) && j < length; ++j) {
+      char p_curr = tolower(p_name[j]);
       char n_curr = tolower(name[j]);
 
       if (p_curr != n_curr) {
@@ -150,7 +151,7 @@ Player* ChatController::GetBestPlayerNameMatch(char* name, size_t length) {
       best_match = p;
 
       // If they match up until the length of the check name and they are the same length then it must be exact
-      if (strlen(p->name) == length) {
+      if (strlen(p_name) == length) {
         return p;
       }
     }
@@ -359,12 +360,12 @@ void ChatController::OnChatPacket(u8* packet, size_t size) {
 
   Player* player = player_manager.GetPlayerById(sender_id);
   if (player) {
-    memcpy(entry->sender, player->name, 20);
+    memcpy(entry->sender, player_manager.GetName(*player), 20);
 
     char prefix = GetChatTypePrefix(type);
 
     if (entry->type == ChatType::Private && player->id != player_manager.player_id) {
-      history.InsertRecent(player->name);
+      history.InsertRecent(player_manager.GetName(*player));
     }
 
     if (type == ChatType::RemotePrivate || type == ChatType::Arena || type == ChatType::RedWarning ||
@@ -420,7 +421,7 @@ void ChatController::AddMessage(ChatType type, const char* fmt, ...) {
   va_end(args);
 }
 
-void PrivateHistory::InsertRecent(char* name) {
+void PrivateHistory::InsertRecent(const char* name) {
   RecentSenderNode* node = recent;
   RecentSenderNode* alloc_node = nullptr;
 
@@ -45,7 +45,7 @@ struct PrivateHistory {
 
   RecentSenderNode nodes[5];
 
-  void InsertRecent(char* name);
+  void InsertRecent(const char* name);
   char* GetPrevious(char* current);
   void RemoveNode(RecentSenderNode* node);
 };
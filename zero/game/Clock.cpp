@@ -12,6 +12,9 @@ namespace zero {
 
 static Tick startup_tick;
 
+static bool virtual_clock_enabled;
+static Tick virtual_tick;
+
 Tick GetCurrentTickOs() {
 #ifdef _WIN32
   return (GetTickCount() / 10) & 0x7fffffff;
@@ -28,6 +31,10 @@ Tick GetCurrentTickOs() {
 }
 
 Tick GetCurrentTick() {
+  if (virtual_clock_enabled) {
+    return virtual_tick;
+  }
+
   if (startup_tick == 0) {
     startup_tick = GetCurrentTickOs();
   }
@@ -35,7 +42,24 @@ Tick GetCurrentTick() {
   return (GetCurrentTickOs() - startup_tick) & 0x7fffffff;
 }
 
+void SetVirtualTick(Tick tick) {
+  virtual_clock_enabled = true;
+  virtual_tick = MAKE_TICK(tick);
+}
+
+void DisableVirtualClock() {
+  virtual_clock_enabled = false;
+}
+
+bool IsVirtualClockEnabled() {
+  return virtual_clock_enabled;
+}
+
 u64 GetMicrosecondTick() {
+  if (virtual_clock_enabled) {
+    return (u64)virtual_tick * kTickDurationMicro;
+  }
+
   using micro = std::chrono::duration<u64, std::micro>;
 
   auto now = std::chrono::high_resolution_clock::now();
@@ -20,6 +20,11 @@ constexpr u16 kInvalidSmallTick = 0xFFFF;
 
 Tick GetCurrentTick();
 
+// Replaces the OS clock with a tick that is only advanced manually. This is used to replay captures deterministically.
+void SetVirtualTick(Tick tick);
+void DisableVirtualClock();
+bool IsVirtualClockEnabled();
+
 constexpr s64 kTickDurationMicro = 10000;
 
 u64 GetMicrosecondTick();
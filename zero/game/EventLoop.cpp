@@ -0,0 +1,199 @@
+#include "EventLoop.h"
+
+#include <zero/game/Logger.h>
+
+#if ZERO_EVENT_LOOP
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+namespace zero {
+
+#if ZERO_EVENT_LOOP
+
+enum { EventSource_Socket, EventSource_Timer, EventSource_Wake };
+
+EventLoop::~EventLoop() {
+  Close();
+}
+
+bool EventLoop::Initialize() {
+  if (IsEnabled()) return true;
+
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  if (epoll_fd == -1 || timer_fd == -1 || wake_fd == -1) {
+    Log(LogLevel::Warning, "Failed to create event loop descriptors.");
+    Close();
+    return false;
+  }
+
+  epoll_event event = {};
+
+  event.events = EPOLLIN;
+  event.data.u32 = EventSource_Timer;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &event);
+
+  event.events = EPOLLIN;
+  event.data.u32 = EventSource_Wake;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+
+  return true;
+}
+
+void EventLoop::Close() {
+  if (epoll_fd != -1) close(epoll_fd);
+  if (timer_fd != -1) close(timer_fd);
+  if (wake_fd != -1) close(wake_fd);
+
+  epoll_fd = timer_fd = wake_fd = -1;
+  socket_fd = -1;
+  socket_watched = false;
+}
+
+void EventLoop::SetSocket(SocketType fd) {
+  if (!IsEnabled()) return;
+
+  if (socket_fd != -1) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, socket_fd, nullptr);
+  }
+
+  socket_fd = fd;
+  socket_watched = false;
+
+  if (fd == -1) return;
+
+  epoll_event event = {};
+
+  event.events = EPOLLIN;
+  event.data.u32 = EventSource_Socket;
+
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0) {
+    socket_watched = true;
+  }
+}
+
+void EventLoop::SetSocketWatched(bool watched) {
+  if (!IsEnabled() || socket_fd == -1 || watched == socket_watched) return;
+
+  epoll_event event = {};
+
+  event.events = watched ? EPOLLIN : 0;
+  event.data.u32 = EventSource_Socket;
+
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, socket_fd, &event) == 0) {
+    socket_watched = watched;
+  }
+}
+
+void EventLoop::AddSocket(SocketType fd) {
+  if (!IsEnabled() || fd == -1) return;
+
+  epoll_event event = {};
+
+  event.events = EPOLLIN;
+  event.data.u32 = EventSource_Socket;
+
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+void EventLoop::RemoveSocket(SocketType fd) {
+  if (!IsEnabled() || fd == -1) return;
+
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void EventLoop::WatchSocket(SocketType fd, bool watched) {
+  if (!IsEnabled() || fd == -1) return;
+
+  epoll_event event = {};
+
+  event.events = watched ? EPOLLIN : 0;
+  event.data.u32 = EventSource_Socket;
+
+  epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+}
+
+void EventLoop::Wait(s64 timeout_us) {
+  if (!IsEnabled()) return;
+
+  int epoll_timeout = 0;
+
+  if (timeout_us > 0) {
+    itimerspec spec = {};
+
+    spec.it_value.tv_sec = timeout_us / 1000000;
+    spec.it_value.tv_nsec = (timeout_us % 1000000) * 1000;
+
+    timerfd_settime(timer_fd, 0, &spec, nullptr);
+    epoll_timeout = -1;
+  }
+
+  // Sockets are level triggered, so any that don't fit here are reported again by the next wait.
+  epoll_event events[16];
+  int count = epoll_wait(epoll_fd, events, ZERO_ARRAY_SIZE(events), epoll_timeout);
+
+  bool timer_fired = false;
+
+  for (int i = 0; i < count; ++i) {
+    u64 value;
+
+    switch (events[i].data.u32) {
+      case EventSource_Socket: {
+        ++socket_wakeups;
+      } break;
+      case EventSource_Timer: {
+        if (read(timer_fd, &value, sizeof(value)) > 0) {
+          timer_fired = true;
+          ++timer_wakeups;
+        }
+      } break;
+      case EventSource_Wake: {
+        if (read(wake_fd, &value, sizeof(value)) > 0) {
+          ++worker_wakeups;
+        }
+      } break;
+    }
+  }
+
+  // Disarm the timer if something else woke the loop so it doesn't fire during the next wait.
+  if (timeout_us > 0 && !timer_fired) {
+    itimerspec spec = {};
+    timerfd_settime(timer_fd, 0, &spec, nullptr);
+  }
+
+  if (count > 0) ++wakeups;
+}
+
+void EventLoop::Wake() {
+  if (wake_fd == -1) return;
+
+  u64 value = 1;
+  ssize_t result = write(wake_fd, &value, sizeof(value));
+  (void)result;
+}
+
+#else
+
+EventLoop::~EventLoop() {}
+
+bool EventLoop::Initialize() {
+  return false;
+}
+
+void EventLoop::Close() {}
+void EventLoop::SetSocket(SocketType fd) {}
+void EventLoop::SetSocketWatched(bool watched) {}
+void EventLoop::AddSocket(SocketType fd) {}
+void EventLoop::RemoveSocket(SocketType fd) {}
+void EventLoop::WatchSocket(SocketType fd, bool watched) {}
+void EventLoop::Wait(s64 timeout_us) {}
+void EventLoop::Wake() {}
+
+#endif
+
+}  // namespace zero
@@ -0,0 +1,61 @@
+#ifndef ZERO_EVENTLOOP_H_
+#define ZERO_EVENTLOOP_H_
+
+#include <zero/Types.h>
+#include <zero/game/net/Socket.h>
+
+namespace zero {
+
+// Linux can block on the socket, a tick timer and worker completions at the same time with epoll.
+#ifdef __linux__
+#define ZERO_EVENT_LOOP 1
+#else
+#define ZERO_EVENT_LOOP 0
+#endif
+
+// Blocks the main loop until a datagram arrives, the next tick is due, or a worker finishes some work.
+// The timer is a timerfd so tick deadlines have microsecond precision instead of the millisecond epoll timeout.
+struct EventLoop {
+  int epoll_fd = -1;
+  int timer_fd = -1;
+  // Written by worker threads to wake the main loop.
+  int wake_fd = -1;
+
+  SocketType socket_fd = -1;
+  bool socket_watched = false;
+
+  u64 wakeups = 0;
+  u64 socket_wakeups = 0;
+  u64 timer_wakeups = 0;
+  u64 worker_wakeups = 0;
+
+  ~EventLoop();
+
+  // Returns false if the platform doesn't support it, in which case the caller should fall back to sleeping.
+  bool Initialize();
+  void Close();
+
+  // Sets the socket that wakes the loop when readable. Replaces any previous socket.
+  void SetSocket(SocketType fd);
+  // Stops waking on the socket without removing it. Used while the connection refuses to read, such as during
+  // Continuum key expansion, so a readable socket doesn't spin the loop.
+  void SetSocketWatched(bool watched);
+
+  // Watches more sockets alongside the one from SetSocket so one loop can wait on many connections. The caller keeps
+  // track of which of these are watched.
+  void AddSocket(SocketType fd);
+  void RemoveSocket(SocketType fd);
+  void WatchSocket(SocketType fd, bool watched);
+
+  // Blocks for at most timeout_us microseconds. A timeout of zero only polls.
+  void Wait(s64 timeout_us);
+
+  // Thread safe.
+  void Wake();
+
+  inline bool IsEnabled() const { return epoll_fd != -1; }
+};
+
+}  // namespace zero
+
+#endif
@@ -159,23 +159,15 @@ static void OnPlayerFreqAndShipChangePkt(void* user, u8* pkt, size_t size) {
   game->RecreateRadar();
 }
 
-static void OnPlayerDeathPkt(void* user, u8* pkt, size_t size) {
-  NetworkBuffer buffer(pkt, size, size);
-
-  buffer.ReadU8();
-
-  s8 green_id = buffer.ReadU8();
-  u16 killer_id = buffer.ReadU16();
-  u16 killed_id = buffer.ReadU16();
-
+static void OnPlayerDeathPkt(void* user, const PlayerDeathPacket& packet) {
   Game* game = (Game*)user;
 
-  Player* killed = game->player_manager.GetPlayerById(killed_id);
-  Player* killer = game->player_manager.GetPlayerById(killer_id);
+  Player* killed = game->player_manager.GetPlayerById(packet.killed_id);
+  Player* killer = game->player_manager.GetPlayerById(packet.killer_id);
 
   // Only spawn greens if they are positive and the killed player has moved.
-  if (green_id > 0 && killer && killed && killed->velocity != Vector2f(0, 0)) {
-    game->SpawnDeathGreen(killed->position, (Prize)green_id);
+  if (packet.green_id > 0 && killer && killed && killed->velocity != Vector2f(0, 0)) {
+    game->SpawnDeathGreen(killed->position, (Prize)packet.green_id);
   }
 }
 
@@ -264,7 +256,7 @@ Game::Game(MemoryArena& perm_arena, MemoryArena& temp_arena, WorkQueue& work_que
   dispatcher.Register(ProtocolS2C::ArenaSettings, OnArenaSettingsPkt, this);
   dispatcher.Register(ProtocolS2C::TeamAndShipChange, OnPlayerFreqAndShipChangePkt, this);
   dispatcher.Register(ProtocolS2C::TurfFlagUpdate, OnTurfFlagUpdatePkt, this);
-  dispatcher.Register(ProtocolS2C::PlayerDeath, OnPlayerDeathPkt, this);
+  dispatcher.Subscribe<OnPlayerDeathPkt>(this);
   dispatcher.Register(ProtocolS2C::Security, OnSecurityRequestPkt, this);
   dispatcher.Register(ProtocolS2C::PlayerPrize, OnPlayerPrizePkt, this);
 
@@ -303,7 +295,10 @@ GameInitializeResult Game::Initialize(InputState& input) {
 bool Game::Update(const InputState& input, float dt) {
   Player* self = player_manager.GetSelf();
 
-  Graphics::colors.Update(dt);
+  // The colors are shared by every game in the process and only matter when rendering.
+  if (render_enabled) {
+    Graphics::colors.Update(dt);
+  }
 
   connection.map.UpdateDoors(connection.settings);
 
@@ -403,7 +398,7 @@ bool Game::Update(const InputState& input, float dt) {
         }
 
         u32 carry = connection.settings.CarryFlags;
-        bool can_carry = carry > 0 && (carry == 1 || player->flags < carry - 1);
+        bool can_carry = carry > 0 && (carry == 1 || player_manager.GetDetails(*player).flags < carry - 1);
 
 #if 0
         u32 view_tick = connection.login_tick + connection.settings.EnterGameFlaggingDelay;
@@ -429,15 +424,17 @@ bool Game::Update(const InputState& input, float dt) {
   if (self) {
     s32 tick_diff = TICK_DIFF(tick, last_tick);
 
-    if (self->flag_timer > 0 && tick_diff > 0) {
-      s32 new_timer = (s32)self->flag_timer - tick_diff;
+    PlayerDetails& self_details = player_manager.GetDetails(*self);
+
+    if (self_details.flag_timer > 0 && tick_diff > 0) {
+      s32 new_timer = (s32)self_details.flag_timer - tick_diff;
 
       if (new_timer <= 0) {
         connection.SendFlagDrop();
-        self->flag_timer = 0;
+        self_details.flag_timer = 0;
         Event::Dispatch(FlagTimeoutEvent());
       } else {
-        self->flag_timer = (u16)new_timer;
+        self_details.flag_timer = (u16)new_timer;
       }
     }
 
@@ -739,10 +736,12 @@ void Game::OnFlagClaim(u8* pkt, size_t size) {
   if (!(flags[id].flags & GameFlag_Turf) && connection.settings.CarryFlags > 0) {
     flags[id].flags &= ~GameFlag_Dropped;
 
-    player->flags++;
+    PlayerDetails& details = player_manager.GetDetails(*player);
+
+    details.flags++;
 
     if (player->id == self_id) {
-      player->flag_timer = connection.settings.FlagDropDelay;
+      details.flag_timer = connection.settings.FlagDropDelay;
     }
 
     Event::Dispatch(FlagPickupEvent(flags[id], *player));
@@ -778,7 +777,7 @@ void Game::OnFlagPosition(u8* pkt, size_t size) {
 void Game::OnFlagVictory(u8* pkt, size_t size) {
   auto self = player_manager.GetSelf();
   if (self) {
-    self->flags = 0;
+    player_manager.GetDetails(*self).flags = 0;
   }
 
   if (size < 3) return;
@@ -796,7 +795,7 @@ void Game::OnFlagDrop(u8* pkt, size_t size) {
   auto player = player_manager.GetPlayerById(pid);
   if (!player) return;
 
-  player->flags = 0;
+  player_manager.GetDetails(*player).flags = 0;
 }
 
 void Game::OnTurfFlagUpdate(u8* pkt, size_t size) {
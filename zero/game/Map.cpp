@@ -11,6 +11,7 @@
 #include <zero/game/Logger.h>
 #include <zero/game/PlayerManager.h>
 #include <zero/game/net/Connection.h>
+#include <zero/game/net/security/Checksum.h>
 
 namespace zero {
 
@@ -650,6 +651,10 @@ bool Map::LoadFromMemory(MemoryArena& arena, const char* filename, const u8* raw
   tiles = arena.Allocate(1024 * 1024);
   if (!tiles) return false;
 
+  solid_rows = memory_arena_push_type_count(&arena, u64, 1024 * 16);
+  solid_columns = memory_arena_push_type_count(&arena, u64, 1024 * 16);
+  if (!solid_rows || !solid_columns) return false;
+
   size_t pos = 0;
 
   if (data[0] == 'B' && data[1] == 'M') {
@@ -701,6 +706,18 @@ bool Map::LoadFromMemory(MemoryArena& arena, const char* filename, const u8* raw
     }
   }
 
+  memset(solid_rows, 0, sizeof(u64) * 1024 * 16);
+  memset(solid_columns, 0, sizeof(u64) * 1024 * 16);
+
+  for (u16 y = 0; y < 1024; ++y) {
+    for (u16 x = 0; x < 1024; ++x) {
+      if (zero::IsSolid(this->tiles[y * 1024 + x])) {
+        solid_rows[y * 16 + (x >> 6)] |= 1ULL << (x & 63);
+        solid_columns[x * 16 + (y >> 6)] |= 1ULL << (y & 63);
+      }
+    }
+  }
+
   return true;
 }
 
@@ -1139,6 +1156,7 @@ void Map::SeedDoors(u32 seed) {
 
     TileId previous_id = tiles[door->y * 1024 + door->x];
     tiles[door->y * 1024 + door->x] = id;
+    UpdateSolidBit(door->x, door->y);
 
     // If the tile just changed from open to closed then check for collisions
     if (self && self->ship < 8 && previous_id == kOpenDoorId && id != kOpenDoorId) {
@@ -1261,6 +1279,49 @@ void Map::SetTileId(u16 x, u16 y, TileId id) {
   if (x >= 1024 || y >= 1024) return;
 
   tiles[y * 1024 + x] = id;
+  UpdateSolidBit(x, y);
+}
+
+void Map::UpdateSolidBit(u16 x, u16 y) {
+  if (!solid_rows) return;
+
+  u64 row_bit = 1ULL << (x & 63);
+  u64 column_bit = 1ULL << (y & 63);
+
+  if (zero::IsSolid(tiles[y * 1024 + x])) {
+    solid_rows[y * 16 + (x >> 6)] |= row_bit;
+    solid_columns[x * 16 + (y >> 6)] |= column_bit;
+  } else {
+    solid_rows[y * 16 + (x >> 6)] &= ~row_bit;
+    solid_columns[x * 16 + (y >> 6)] &= ~column_bit;
+  }
+}
+
+bool Map::IsSpanPossiblySolid(u16 fixed, s32 start, s32 end, bool column) const {
+  if (start >= end) return false;
+  if (!solid_rows) return true;
+  if (fixed > 1023 || start < 0 || end > 1024) return true;
+
+  const u64* bits = (column ? solid_columns : solid_rows) + fixed * 16;
+
+  s32 last = end - 1;
+  size_t first_word = start >> 6;
+  size_t last_word = last >> 6;
+
+  u64 first_mask = ~0ULL << (start & 63);
+  u64 last_mask = ~0ULL >> (63 - (last & 63));
+
+  if (first_word == last_word) {
+    return (bits[first_word] & first_mask & last_mask) != 0;
+  }
+
+  if (bits[first_word] & first_mask) return true;
+
+  for (size_t i = first_word + 1; i < last_word; ++i) {
+    if (bits[i]) return true;
+  }
+
+  return (bits[last_word] & last_mask) != 0;
 }
 
 TileId Map::GetTileId(const Vector2f& position) const {
@@ -1319,26 +1380,7 @@ bool Map::IsSolidEmptyDoors(u16 x, u16 y, u32 frequency) const {
 }
 
 u32 Map::GetChecksum(u32 key) const {
-  constexpr u32 kTileStart = 1;
-  constexpr u32 kTileEnd = 160;
-
-  int basekey = key;
-
-  for (int y = basekey % 32; y < 1024; y += 32) {
-    for (int x = basekey % 31; x < 1024; x += 31) {
-      u8 tile = (u8)GetTileId(x, y);
-
-      if (tile == 250) {
-        tile = 0;
-      }
-
-      if ((tile >= kTileStart && tile <= kTileEnd) || tile == kTileIdSafe) {
-        key += basekey ^ tile;
-      }
-    }
-  }
-
-  return key;
+  return MapChecksum(tiles, key);
 }
 
 CastResult Map::Cast(const Vector2f& from, const Vector2f& direction, float max_distance, u32 frequency) const {
@@ -303,6 +303,11 @@ struct Map {
 
   bool IsSolid(const Vector2f& p, u32 frequency) const { return IsSolid((u16)p.x, (u16)p.y, frequency); }
 
+  // Tests the packed solidity bits for a span of tiles along one row or column.
+  // Returns false only if every tile in [start, end) is known to be empty for all frequencies.
+  // Tiles outside of the map are solid, so spans that leave the map always return true.
+  bool IsSpanPossiblySolid(u16 fixed, s32 start, s32 end, bool column) const;
+
   // Returns a possible rect that creates an occupiable area that contains the tested position.
   OccupyRect GetPossibleOccupyRect(const Vector2f& position, float radius, u32 frequency) const;
   OccupyRect GetClosestOccupyRect(Vector2f position, float radius, Vector2f point) const;
@@ -311,6 +316,12 @@ struct Map {
   // Rects must be initialized memory that can contain all possible occupy rects.
   size_t GetAllOccupiedRects(Vector2f position, float radius, u32 frequency, OccupiedRect* rects,
                              bool dynamic_doors = false) const;
+  // The most rects that GetAllOccupiedRects can write for a radius. One is found for each tile around the position
+  // that isn't in its row or column.
+  static inline size_t GetMaxOccupiedRects(float radius) {
+    size_t d = (u16)(radius * 2.0f);
+    return d < 1 ? 1 : 4 * d * d;
+  }
 
   bool CanTraverse(const Vector2f& start, const Vector2f& end, float radius, u32 frequency) const;
   bool CanOverlapTile(const Vector2f& position, float radius, u32 frequency) const;
@@ -352,6 +363,9 @@ struct Map {
 
   char filename[1024];
   u32 checksum = 0;
+  // Checksum of the map file that the tiles were loaded from. This is zero while a new map is downloading, since
+  // checksum already belongs to the new map and the tiles are still from the old one.
+  u32 loaded_checksum = 0;
   VieRNG door_rng;
   u32 last_seed_tick = 0;
   u32 compressed_size = 0;
@@ -359,6 +373,12 @@ struct Map {
   size_t data_size = 0;
   u8* tiles = nullptr;
 
+  // Packed solidity bits that are kept in sync with the tiles. Brick tiles are marked solid here even though they can be
+  // passed by their own team, so these are only used to quickly reject collision checks.
+  // solid_rows is indexed by [y][x / 64] and solid_columns is the transpose so spans along either axis are contiguous.
+  u64* solid_rows = nullptr;
+  u64* solid_columns = nullptr;
+
   size_t door_count = 0;
   Tile* doors = nullptr;
 
@@ -371,6 +391,7 @@ struct Map {
 
  private:
   size_t GetTileCount(Tile* tiles, size_t tile_count, TileId id_begin, TileId id_end);
+  void UpdateSolidBit(u16 x, u16 y);
 };
 
 }  // namespace zero
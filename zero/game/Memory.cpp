@@ -3,52 +3,470 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <zero/game/Logger.h>
 
 #ifdef _WIN32
 #include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 #define MONITOR_PERM_ALLOCATIONS 0
 
 namespace zero {
 
-MemoryArena::MemoryArena(u8* memory, size_t max_size) : base(memory), current(memory), max_size(max_size) {}
+// Pages are committed in chunks so growing an arena doesn't need a system call for every new page.
+constexpr size_t kCommitGranularity = Kilobytes(64);
+constexpr size_t kHugePageSize = Megabytes(2);
+
+static inline size_t AlignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static inline size_t AlignDown(size_t value, size_t alignment) {
+  return value & ~(alignment - 1);
+}
+
+MemoryArena::MemoryArena(u8* memory, size_t max_size)
+    : base(memory),
+      current(memory),
+      max_size(max_size),
+      commit_end(memory + max_size),
+      committed_size(0),
+      reserved_size(0),
+      huge_pages(HugePageMode::None),
+      shared_commit(nullptr),
+      child_count(0),
+      name(nullptr),
+      high_water(0),
+      overflow_count(0) {}
 
 u8* MemoryArena::Allocate(size_t size, size_t alignment) {
   assert(alignment > 0);
 
   size_t adj = alignment - 1;
   u8* result = (u8*)(((size_t)this->current + adj) & ~adj);
-  this->current = result + size;
+  u8* end = result + size;
+
+  if (end > this->commit_end) {
+    Grow(end, size);
+  }
+
+  this->current = end;
+
+  size_t used = (size_t)(end - this->base);
+  if (used > this->high_water) this->high_water = used;
 
 #if MONITOR_PERM_ALLOCATIONS
   if (this == perm_global) {
-    size_t allocated = (size_t)(this->current - this->base);
-
-    Log(LogLevel::Debug, "Allocating %zd with align %zd in perm arena. (allocated: %zd)", size, alignment, allocated);
+    Log(LogLevel::Debug, "Allocating %zd with align %zd in perm arena. (allocated: %zd)", size, alignment, used);
   }
 #endif
 
-  assert(this->current <= this->base + this->max_size);
-  if (this->current > this->base + this->max_size) {
-    Log(LogLevel::Error, "Memory arena ran out of space: %zu", size);
-    exit(1);
+  return result;
+}
+
+static bool CommitPages(u8* start, size_t size) {
+#ifdef _WIN32
+  return VirtualAlloc(start, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+  return mprotect(start, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+void MemoryArena::Grow(u8* end, size_t size) {
+  const char* arena_name = name ? name : "unnamed";
+  size_t used = (size_t)(current - base);
+  size_t requested = (size_t)(end - base);
+
+  if (requested > max_size) {
+    ++overflow_count;
+
+    // Only arenas with reserved space after the end can keep going.
+    if (requested > reserved_size) {
+      Log(LogLevel::Error,
+          "Memory arena '%s' ran out of space allocating %zu bytes. used: %zu  high water: %zu  size: %zu  "
+          "reserved: %zu",
+          arena_name, size, used, high_water, max_size, reserved_size);
+      assert(false);
+      exit(1);
+    }
+
+    if (overflow_count == 1) {
+      Log(LogLevel::Warning,
+          "Memory arena '%s' overflowed allocating %zu bytes. used: %zu  size: %zu. Continuing with reserved space, "
+          "but the arena size should be increased.",
+          arena_name, size, used, max_size);
+    }
   }
 
-  return result;
+  // The parent may have committed some or all of this child while growing past it.
+  if (shared_commit && shared_commit->commit_end > commit_end) {
+    commit_end = shared_commit->commit_end;
+
+    if (end <= commit_end) return;
+  }
+
+  u8* reserve_end = base + reserved_size;
+
+  // Commit in huge page sized chunks so transparent huge pages can back them. The explicit huge pages are committed
+  // when they are mapped, so only the normal pages in the overflow space get here.
+  size_t granularity = huge_pages == HugePageMode::Transparent ? kHugePageSize : kCommitGranularity;
+  u8* commit_start = (u8*)AlignDown((size_t)commit_end, granularity);
+  u8* new_commit_end = (u8*)AlignUp((size_t)end, granularity);
+
+  if (new_commit_end > reserve_end) new_commit_end = reserve_end;
+
+  // Everything before commit_end has to stay usable after a reset, so this also commits any child arenas in between.
+  // Whole chunks that a child already committed are skipped and stay counted by the child.
+  u8* cursor = commit_start;
+  size_t child_committed = 0;
+
+  for (size_t i = 0; i < child_count; ++i) {
+    ChildCommit& child = children[i];
+
+    u8* overlap_start = child.base > commit_end ? child.base : commit_end;
+    u8* overlap_end = child.commit_end < new_commit_end ? child.commit_end : new_commit_end;
+
+    if (overlap_end > overlap_start) {
+      child_committed += (size_t)(overlap_end - overlap_start);
+    }
+
+    u8* skip_start = (u8*)AlignUp((size_t)child.base, kCommitGranularity);
+    u8* skip_end = (u8*)AlignDown((size_t)overlap_end, kCommitGranularity);
+
+    if (skip_start < cursor) skip_start = cursor;
+
+    if (skip_end > skip_start) {
+      Commit(cursor, skip_start);
+      cursor = skip_end;
+    }
+
+    if (new_commit_end > child.commit_end) {
+      child.commit_end = new_commit_end < child.end ? new_commit_end : child.end;
+    }
+  }
+
+  Commit(cursor, new_commit_end);
+
+  committed_size += (size_t)(new_commit_end - commit_end) - child_committed;
+  commit_end = new_commit_end;
+
+  if (shared_commit) {
+    shared_commit->commit_end = commit_end < shared_commit->end ? commit_end : shared_commit->end;
+  }
+}
+
+void MemoryArena::Commit(u8* start, u8* end) {
+  if (end <= start) return;
+
+  if (!CommitPages(start, (size_t)(end - start))) {
+    Log(LogLevel::Error, "Memory arena '%s' failed to commit %zu bytes. used: %zu  committed: %zu",
+        name ? name : "unnamed", (size_t)(end - start), GetUsed(), GetCommitted());
+    exit(1);
+  }
 }
 
 MemoryArena MemoryArena::CreateArena(size_t size, size_t alignment) {
-  u8* base = Allocate(size, alignment);
-  assert(base);
-  return MemoryArena(base, size);
+  if (reserved_size == 0) {
+    u8* base = Allocate(size, alignment);
+    assert(base);
+    return MemoryArena(base, size);
+  }
+
+  // Child arenas of a reserved arena commit their own pages from the parent's reservation, so the space is only
+  // claimed here without committing it.
+  size_t adj = alignment - 1;
+  u8* child_base = (u8*)(((size_t)current + adj) & ~adj);
+  u8* end = child_base + size;
+
+  if (end > base + max_size) {
+    Grow(end, size);
+  }
+
+  // Children past the limit can't share their commit progress, so the parent commits and counts them up front.
+  if (child_count >= kMaxChildArenas && end > commit_end) {
+    Grow(end, size);
+  }
+
+  current = end;
+
+  size_t used = (size_t)(end - base);
+  if (used > high_water) high_water = used;
+
+  MemoryArena child(child_base, size);
+
+  child.reserved_size = size;
+  child.huge_pages = huge_pages;
+
+  if (end <= commit_end) {
+    // The parent already committed all of it, so it stays counted there.
+    child.commit_end = end;
+    return child;
+  }
+
+  ChildCommit* shared = children + child_count++;
+
+  shared->base = child_base;
+  shared->end = end;
+  shared->commit_end = child_base > commit_end ? child_base : commit_end;
+
+  child.commit_end = shared->commit_end;
+  child.shared_commit = shared;
+
+  return child;
 }
 
 void MemoryArena::Reset() {
   this->current = this->base;
 }
 
+#ifndef _WIN32
+static bool IsTransparentHugePageEnabled() {
+  FILE* f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+
+  if (!f) return false;
+
+  char mode[128] = {};
+  bool enabled = fgets(mode, sizeof(mode), f) && strstr(mode, "[never]") == nullptr;
+
+  fclose(f);
+
+  return enabled;
+}
+#endif
+
+#ifndef _WIN32
+// Reserves address space that starts on a huge page boundary.
+static u8* ReserveAddressSpace(size_t size) {
+  // Reserve an extra huge page so the start can be aligned.
+  size_t map_size = size + kHugePageSize;
+  void* result = mmap(NULL, map_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+  if (result == MAP_FAILED) return nullptr;
+
+  u8* start = (u8*)result;
+  u8* aligned = (u8*)AlignUp((size_t)start, kHugePageSize);
+  u8* end = start + map_size;
+
+  if (aligned > start) munmap(start, aligned - start);
+  if (end > aligned + size) munmap(aligned + size, end - (aligned + size));
+
+  return aligned;
+}
+
+#ifdef MAP_HUGETLB
+// Replaces the first size bytes of a reservation with huge pages from the pool. The pages are reserved for the mapping
+// when it's created, so this fails instead of faulting later if the pool runs out. The normal reservation is put back
+// on failure. Returns nullptr if that fails too, which only happens if something else was mapped into the gap.
+static u8* MapExplicitHugePages(u8* memory, size_t size, size_t reserved_size, bool* mapped) {
+  *mapped = false;
+
+  munmap(memory, size);
+
+  // The address is huge page aligned, so it's used as long as nothing else was mapped there first.
+  void* result = mmap(memory, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+  if (result == memory) {
+    *mapped = true;
+    return memory;
+  }
+
+  if (result != MAP_FAILED) munmap(result, size);
+
+  result = mmap(memory, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+  if (result == memory) return memory;
+
+  if (result != MAP_FAILED) munmap(result, size);
+  munmap(memory + size, reserved_size - size);
+
+  return ReserveAddressSpace(reserved_size);
+}
+#endif
+#endif
+
+MemoryArena ReserveArena(const char* name, size_t size, HugePageMode huge_pages) {
+  // Address space is cheap on 64 bit, so leave room to survive overflowing the arena.
+  size_t reserved_size = sizeof(void*) >= 8 ? size * 2 : size;
+  size_t committed_size = 0;
+  u8* memory = nullptr;
+
+#ifdef _WIN32
+  // Large pages need a user privilege that bots aren't run with, so only normal pages are used.
+  huge_pages = HugePageMode::None;
+  reserved_size = AlignUp(reserved_size, kCommitGranularity);
+  memory = (u8*)VirtualAlloc(NULL, reserved_size, MEM_RESERVE, PAGE_READWRITE);
+#else
+  reserved_size = AlignUp(reserved_size, kHugePageSize);
+  memory = ReserveAddressSpace(reserved_size);
+
+  if (memory && huge_pages == HugePageMode::Explicit) {
+    // Only the arena itself comes from the pool. The overflow space after it is committed in normal pages if it's ever
+    // needed, so a pool sized for the arenas is enough.
+    size_t huge_size = AlignUp(size, kHugePageSize);
+    bool mapped = false;
+
+#ifdef MAP_HUGETLB
+    memory = MapExplicitHugePages(memory, huge_size, reserved_size, &mapped);
+#endif
+
+    if (mapped) {
+      committed_size = huge_size;
+    } else {
+      Log(LogLevel::Warning, "Not enough explicit huge pages for arena '%s'. Using transparent huge pages.", name);
+      huge_pages = HugePageMode::Transparent;
+    }
+  }
+
+  if (memory && huge_pages == HugePageMode::Transparent) {
+#ifdef MADV_HUGEPAGE
+    if (!IsTransparentHugePageEnabled() || madvise(memory, reserved_size, MADV_HUGEPAGE) != 0) {
+      huge_pages = HugePageMode::None;
+    }
+#else
+    huge_pages = HugePageMode::None;
+#endif
+  }
+#endif
+
+  MemoryArena arena;
+
+  if (!memory) {
+    Log(LogLevel::Error, "Failed to reserve %zu bytes for arena '%s'.", reserved_size, name);
+    return arena;
+  }
+
+  arena = MemoryArena(memory, size);
+
+  arena.name = name;
+  arena.reserved_size = reserved_size;
+  arena.huge_pages = huge_pages;
+  // Explicit huge pages are committed when they are mapped.
+  arena.commit_end = memory + committed_size;
+  arena.committed_size = committed_size;
+
+  return arena;
+}
+
+static inline double ToMegabytes(size_t bytes) {
+  return bytes / (1024.0 * 1024.0);
+}
+
+void LogArenaUsage(const MemoryArena& arena) {
+  const char* kHugePageNames[] = {"", "  transparent huge pages", "  explicit huge pages"};
+
+  Log(LogLevel::Info, "Arena %-6s used: %7.2f MiB  high water: %7.2f MiB  committed: %7.2f MiB  size: %7.2f MiB%s%s",
+      arena.name ? arena.name : "unnamed", ToMegabytes(arena.GetUsed()), ToMegabytes(arena.high_water),
+      ToMegabytes(arena.GetCommitted()), ToMegabytes(arena.max_size), kHugePageNames[(size_t)arena.huge_pages],
+      arena.overflow_count > 0 ? "  OVERFLOWED" : "");
+
+  if (arena.overflow_count > 0) {
+    Log(LogLevel::Warning, "Arena %s overflowed %u times. Increase its size to at least %zu bytes.", arena.name,
+        arena.overflow_count, arena.high_water);
+  }
+}
+
+void MemoryFootprint::Add(const void* data, size_t size) {
+  if (!data) return;
+
+  allocated += size;
+  resident += GetResidentSize(data, size);
+}
+
+void LogMemoryFootprint(const char* name, const MemoryFootprint& footprint) {
+  Log(LogLevel::Info, "Footprint %-16s resident: %7.2f MiB  allocated: %7.2f MiB", name,
+      ToMegabytes(footprint.resident), ToMegabytes(footprint.allocated));
+}
+
+size_t GetResidentSize(const void* data, size_t size) {
+#ifdef _WIN32
+  return size;
+#else
+  static const size_t kPageSize = (size_t)sysconf(_SC_PAGESIZE);
+
+  if (size == 0) return 0;
+
+  u8* start = (u8*)((size_t)data & ~(kPageSize - 1));
+  u8* end = (u8*)AlignUp((size_t)data + size, kPageSize);
+
+  size_t resident = 0;
+  unsigned char pages[1024];
+
+  // Partial pages at either end count as a full page since that is what they cost.
+  while (start < end) {
+    size_t count = (size_t)(end - start) / kPageSize;
+
+    if (count > sizeof(pages)) count = sizeof(pages);
+
+    if (mincore(start, count * kPageSize, pages) != 0) return size;
+
+    for (size_t i = 0; i < count; ++i) {
+      if (pages[i] & 1) resident += kPageSize;
+    }
+
+    start += count * kPageSize;
+  }
+
+  return resident;
+#endif
+}
+
+size_t GetProcessResidentSize() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters = {};
+
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+
+  return counters.WorkingSetSize;
+#else
+  FILE* f = fopen("/proc/self/statm", "r");
+
+  if (!f) return 0;
+
+  size_t total_pages = 0;
+  size_t resident_pages = 0;
+
+  if (fscanf(f, "%zu %zu", &total_pages, &resident_pages) != 2) {
+    resident_pages = 0;
+  }
+
+  fclose(f);
+
+  return resident_pages * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+void* AllocateZeroedPages(size_t size) {
+#ifdef _WIN32
+  return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+  void* result = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+  if (result == MAP_FAILED) return nullptr;
+
+#ifdef MADV_NOHUGEPAGE
+  // A huge page would back 2 MiB the first time any entry in it is written, which defeats the point of these tables.
+  madvise(result, size, MADV_NOHUGEPAGE);
+#endif
+
+  return result;
+#endif
+}
+
+void FreeZeroedPages(void* data, size_t size) {
+  if (!data) return;
+
+#ifdef _WIN32
+  VirtualFree(data, 0, MEM_RELEASE);
+#else
+  munmap(data, size);
+#endif
+}
+
 u8* AllocateMirroredBuffer(size_t size) {
 #ifdef _WIN32
   SYSTEM_INFO sys_info = {0};
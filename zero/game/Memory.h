@@ -29,12 +29,58 @@ struct MemoryRevert {
   inline ~MemoryRevert();
 };
 
+enum class HugePageMode : u8 { None, Transparent, Explicit };
+
+// Commit progress of a child arena that was made from a reserved arena. It's shared by both so pages are only committed
+// and counted once, by whichever arena reached them first.
+struct ChildCommit {
+  u8* base;
+  u8* end;
+  u8* commit_end;
+};
+
+constexpr size_t kMaxChildArenas = 8;
+
 struct MemoryArena {
   u8* base;
   u8* current;
   size_t max_size;
 
-  MemoryArena() : base(nullptr), current(nullptr), max_size(0) {}
+  // Arenas made with ReserveArena only have address space reserved up front and commit pages as they grow. Everything
+  // before commit_end is usable. Child arenas commit their own pages until the parent grows past them. Other arenas are
+  // fully committed, so commit_end is the end of the arena.
+  u8* commit_end;
+  // Pages committed by this arena. Pages in a child's range are counted by the child if it committed them first.
+  size_t committed_size;
+  // Space reserved for arenas made with ReserveArena and zero for others. Top level arenas reserve extra space after
+  // max_size so they can keep running after an overflow.
+  size_t reserved_size;
+  HugePageMode huge_pages;
+
+  // Set on children of reserved arenas that still have uncommitted pages when they are created.
+  ChildCommit* shared_commit;
+  // Children point into this, so a reserved arena can't be moved once it has created one. Children past the limit are
+  // committed by the parent when they are created.
+  ChildCommit children[kMaxChildArenas];
+  size_t child_count;
+
+  const char* name;
+  size_t high_water;
+  u32 overflow_count;
+
+  MemoryArena()
+      : base(nullptr),
+        current(nullptr),
+        max_size(0),
+        commit_end(nullptr),
+        committed_size(0),
+        reserved_size(0),
+        huge_pages(HugePageMode::None),
+        shared_commit(nullptr),
+        child_count(0),
+        name(nullptr),
+        high_water(0),
+        overflow_count(0) {}
   MemoryArena(u8* memory, size_t max_size);
 
   u8* Allocate(size_t size, size_t alignment = 4);
@@ -46,8 +92,47 @@ struct MemoryArena {
   MemoryRevert GetReverter() { return MemoryRevert(*this, GetSnapshot()); }
 
   void Revert(ArenaSnapshot snapshot) { current = snapshot; }
+
+  inline size_t GetUsed() const { return (size_t)(current - base); }
+  inline size_t GetCommitted() const { return reserved_size > 0 ? committed_size : max_size; }
+  inline size_t GetRemaining() const { return GetUsed() < max_size ? max_size - GetUsed() : 0; }
+
+ private:
+  // Commits pages up to end, or reports the overflow if end is past the arena.
+  void Grow(u8* end, size_t size);
+  // Commits the pages in the range and exits if the system is out of memory.
+  void Commit(u8* start, u8* end);
 };
 
+// Reserves address space for an arena that commits pages as it is used. Top level arenas reserve extra space after
+// size so an overflow can be reported and survived instead of crashing. Transparent huge pages are requested for the
+// range if the system allows it. Explicit huge pages come from the system's preallocated pool for the arena itself and
+// fall back to transparent huge pages when the pool is too small. The overflow space is always normal pages.
+MemoryArena ReserveArena(const char* name, size_t size, HugePageMode huge_pages);
+
+void LogArenaUsage(const MemoryArena& arena);
+
+// Memory owned by one subsystem. Large tables are only partly touched depending on the map and player count, so
+// resident is how much of the allocation is actually backed by physical pages.
+struct MemoryFootprint {
+  size_t allocated = 0;
+  size_t resident = 0;
+
+  void Add(const void* data, size_t size);
+};
+
+void LogMemoryFootprint(const char* name, const MemoryFootprint& footprint);
+
+// Returns how many bytes of the range are backed by physical pages. Platforms that can't check count all of it.
+size_t GetResidentSize(const void* data, size_t size);
+// Returns the resident set size of the process or zero if it can't be read.
+size_t GetProcessResidentSize();
+
+// Allocates zeroed pages directly from the system. Pages aren't backed until they are first written, so a large table
+// only costs the parts of it that get used.
+void* AllocateZeroedPages(size_t size);
+void FreeZeroedPages(void* data, size_t size);
+
 #define memory_arena_push_type(arena, type) (type*)(arena)->Allocate(sizeof(type))
 #define memory_arena_construct_type(arena, type, ...) \
   (type*)(arena)->Allocate(sizeof(type));             \
@@ -0,0 +1,77 @@
+#ifndef ZERO_PAGEDIDTABLE_H_
+#define ZERO_PAGEDIDTABLE_H_
+
+#include <zero/Types.h>
+#include <zero/game/Memory.h>
+
+namespace zero {
+
+// Table with an entry for every 16 bit player id. Zones hand out ids starting from zero, so the entries are split into
+// pages that are only allocated from the arena once an id in them is written. Missing pages read as the default value.
+template <typename T, size_t kPageShift = 8>
+struct PagedIdTable {
+  static constexpr size_t kPageSize = (size_t)1 << kPageShift;
+  static constexpr size_t kPageCount = 65536 / kPageSize;
+
+  MemoryArena& arena;
+  T default_value;
+  T* pages[kPageCount];
+
+  PagedIdTable(MemoryArena& arena, const T& default_value) : arena(arena), default_value(default_value) {
+    for (size_t i = 0; i < kPageCount; ++i) {
+      pages[i] = nullptr;
+    }
+  }
+
+  inline T Get(u16 id) const {
+    const T* page = pages[id >> kPageShift];
+
+    return page ? page[id & (kPageSize - 1)] : default_value;
+  }
+
+  // Returns the entry for writing. Its page is allocated if this is the first id written in it.
+  inline T& operator[](u16 id) {
+    T* page = pages[id >> kPageShift];
+
+    if (!page) {
+      page = memory_arena_push_type_count(&arena, T, kPageSize);
+
+      for (size_t i = 0; i < kPageSize; ++i) {
+        page[i] = default_value;
+      }
+
+      pages[id >> kPageShift] = page;
+    }
+
+    return page[id & (kPageSize - 1)];
+  }
+
+  // Sets every entry back to the default value. Pages are kept since the same ids tend to be handed out again.
+  void Reset() {
+    for (size_t i = 0; i < kPageCount; ++i) {
+      T* page = pages[i];
+
+      if (!page) continue;
+
+      for (size_t j = 0; j < kPageSize; ++j) {
+        page[j] = default_value;
+      }
+    }
+  }
+
+  MemoryFootprint GetMemoryFootprint() const {
+    MemoryFootprint footprint;
+
+    footprint.Add(this, sizeof(*this));
+
+    for (size_t i = 0; i < kPageCount; ++i) {
+      footprint.Add(pages[i], sizeof(T) * kPageSize);
+    }
+
+    return footprint;
+  }
+};
+
+}  // namespace zero
+
+#endif
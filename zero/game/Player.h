@@ -60,31 +60,20 @@ struct AttachInfo {
   struct AttachInfo* next;
 };
 
-struct Player {
+// Data that is rarely touched while iterating the player list each tick.
+// This lives in a side table in PlayerManager that shares the index of the player list.
+struct PlayerDetails {
   char name[32];
   char squad[32];
 
   s32 flag_points;
   s32 kill_points;
 
-  PlayerId id;
-  u16 frequency;
-
-  Vector2f position;
-  Vector2f velocity;
-
-  Vector2f lerp_velocity;
-  float lerp_time;
-  float repel_time;
-
   u16 wins;
   u16 losses;
 
-  u16 bounty;
   u16 s2c_latency;
-
   u16 flag_timer;
-  WeaponData weapon;
 
   union {
     struct {
@@ -104,39 +93,55 @@ struct Player {
     };
   };
 
+  u16 flags;
+  u8 has_crown;
+  bool ball_carrier;
+
+  AttachInfo* children;
+
+  u32 last_extra_timestamp;
+  u32 last_repel_timestamp;
+
+  float warp_anim_t;
+  float explode_anim_t;
+  float bombflash_anim_t;
+};
+
+// Per-tick simulation data. This is kept small so sweeps over the player list stay in cache.
+struct Player {
+  PlayerId id;
+  u16 frequency;
+
+  Vector2f position;
+  Vector2f velocity;
+
+  Vector2f lerp_velocity;
+  float lerp_time;
+  float repel_time;
+
   float energy;
   float orientation;
 
+  u16 bounty;
+  WeaponData weapon;
+
   u8 ship;
   u8 togglables;
   u8 ping;
-  u8 has_crown;
-
-  u32 last_bounce_tick;
 
   u16 attach_parent;
-  u16 flags;
-
-  AttachInfo* children;
-
-  u32 last_extra_timestamp;
-  u32 last_repel_timestamp;
-
   // ppk timestamp exactly from packet
   u16 timestamp;
 
-  float enter_delay;
-
-  float warp_anim_t;
-  float explode_anim_t;
-  float bombflash_anim_t;
+  u32 last_bounce_tick;
 
-  bool ball_carrier;
+  float enter_delay;
 
   inline Vector2f GetHeading() const { return OrientationToHeading((u8)(orientation * 40.0f)); }
 
   inline bool IsRespawning() const { return ship != 8 && enter_delay > 0.0f; }
 };
+static_assert(sizeof(Player) <= 64, "Player should fit in a single cache line");
 
 }  // namespace zero
 
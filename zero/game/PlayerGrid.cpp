@@ -0,0 +1,199 @@
+#include "PlayerGrid.h"
+
+#include <string.h>
+
+namespace zero {
+
+PlayerGrid::PlayerGrid(Player* players) : players(players) {
+  Clear();
+}
+
+void PlayerGrid::Clear() {
+  memset(cell_heads, 0xFF, sizeof(cell_heads));
+  memset(player_cells, 0xFF, sizeof(player_cells));
+  memset(next, 0xFF, sizeof(next));
+  memset(prev, 0xFF, sizeof(prev));
+}
+
+void PlayerGrid::Update(u16 index) {
+  Player& player = players[index];
+
+  u16 cell = kInvalidIndex;
+
+  if (player.ship < 8) {
+    cell = GetCell(player.position);
+  }
+
+  if (cell == player_cells[index]) return;
+
+  Unlink(index);
+
+  if (cell != kInvalidIndex) {
+    Link(index, cell);
+  }
+}
+
+void PlayerGrid::Remove(u16 index) {
+  Unlink(index);
+}
+
+void PlayerGrid::Link(u16 index, u16 cell) {
+  u16 head = cell_heads[cell];
+
+  player_cells[index] = cell;
+  prev[index] = kInvalidIndex;
+  next[index] = head;
+
+  if (head != kInvalidIndex) {
+    prev[head] = index;
+  }
+
+  cell_heads[cell] = index;
+}
+
+void PlayerGrid::Unlink(u16 index) {
+  u16 cell = player_cells[index];
+
+  if (cell == kInvalidIndex) return;
+
+  if (prev[index] != kInvalidIndex) {
+    next[prev[index]] = next[index];
+  } else {
+    cell_heads[cell] = next[index];
+  }
+
+  if (next[index] != kInvalidIndex) {
+    prev[next[index]] = prev[index];
+  }
+
+  player_cells[index] = kInvalidIndex;
+  next[index] = kInvalidIndex;
+  prev[index] = kInvalidIndex;
+}
+
+size_t PlayerGrid::QueryRadius(const Vector2f& center, float radius, const PlayerQueryFilter& filter, Player** out,
+                               size_t capacity) const {
+  float radius_sq = radius * radius;
+  size_t count = 0;
+
+  s32 start_x = GetCellCoord(center.x - radius);
+  s32 start_y = GetCellCoord(center.y - radius);
+  s32 end_x = GetCellCoord(center.x + radius);
+  s32 end_y = GetCellCoord(center.y + radius);
+
+  for (s32 y = start_y; y <= end_y; ++y) {
+    for (s32 x = start_x; x <= end_x; ++x) {
+      u16 index = cell_heads[y * kCellsPerAxis + x];
+
+      while (index != kInvalidIndex) {
+        Player* player = players + index;
+
+        if (filter.Matches(*player) && player->position.DistanceSq(center) <= radius_sq) {
+          if (count >= capacity) return count;
+
+          out[count++] = player;
+        }
+
+        index = next[index];
+      }
+    }
+  }
+
+  return count;
+}
+
+size_t PlayerGrid::QueryRect(const Vector2f& min, const Vector2f& max, const PlayerQueryFilter& filter, Player** out,
+                             size_t capacity) const {
+  size_t count = 0;
+
+  s32 start_x = GetCellCoord(min.x);
+  s32 start_y = GetCellCoord(min.y);
+  s32 end_x = GetCellCoord(max.x);
+  s32 end_y = GetCellCoord(max.y);
+
+  for (s32 y = start_y; y <= end_y; ++y) {
+    for (s32 x = start_x; x <= end_x; ++x) {
+      u16 index = cell_heads[y * kCellsPerAxis + x];
+
+      while (index != kInvalidIndex) {
+        Player* player = players + index;
+        Vector2f& position = player->position;
+
+        if (position.x >= min.x && position.x <= max.x && position.y >= min.y && position.y <= max.y &&
+            filter.Matches(*player)) {
+          if (count >= capacity) return count;
+
+          out[count++] = player;
+        }
+
+        index = next[index];
+      }
+    }
+  }
+
+  return count;
+}
+
+size_t PlayerGrid::QueryNearest(const Vector2f& center, size_t k, const PlayerQueryFilter& filter, Player** out,
+                                size_t capacity, float max_distance) const {
+  float distances[kMaxPlayers];
+
+  if (k > capacity) k = capacity;
+  if (k > kMaxPlayers) k = kMaxPlayers;
+  if (k == 0) return 0;
+
+  float max_distance_sq = max_distance * max_distance;
+  size_t count = 0;
+
+  s32 center_x = GetCellCoord(center.x);
+  s32 center_y = GetCellCoord(center.y);
+
+  // Search outward in square rings of cells. Every cell in ring r is at least (r - 1) cells away from the center, so
+  // the search can stop once the worst kept distance is closer than that.
+  for (s32 ring = 0; ring < (s32)kCellsPerAxis; ++ring) {
+    float ring_distance = (float)((ring - 1) * (s32)kCellSize);
+
+    if (ring_distance > max_distance) break;
+    if (ring > 0 && count == k && distances[count - 1] <= ring_distance * ring_distance) break;
+
+    for (s32 y = center_y - ring; y <= center_y + ring; ++y) {
+      if (y < 0 || y >= (s32)kCellsPerAxis) continue;
+
+      bool edge_row = y == center_y - ring || y == center_y + ring;
+      // Only visit the outer edge of the ring since the inner cells were covered by previous rings.
+      s32 step = edge_row ? 1 : ring * 2;
+
+      for (s32 x = center_x - ring; x <= center_x + ring; x += step) {
+        if (x >= 0 && x < (s32)kCellsPerAxis) {
+          u16 index = cell_heads[y * kCellsPerAxis + x];
+
+          while (index != kInvalidIndex) {
+            Player* player = players + index;
+            float dist_sq = player->position.DistanceSq(center);
+
+            if (dist_sq <= max_distance_sq && (count < k || dist_sq < distances[count - 1]) &&
+                filter.Matches(*player)) {
+              // Insertion sort into the kept set, dropping the furthest player if it's full.
+              size_t insert = count < k ? count++ : count - 1;
+
+              while (insert > 0 && distances[insert - 1] > dist_sq) {
+                distances[insert] = distances[insert - 1];
+                out[insert] = out[insert - 1];
+                --insert;
+              }
+
+              distances[insert] = dist_sq;
+              out[insert] = player;
+            }
+
+            index = next[index];
+          }
+        }
+      }
+    }
+  }
+
+  return count;
+}
+
+}  // namespace zero
@@ -0,0 +1,88 @@
+#ifndef ZERO_PLAYER_GRID_H_
+#define ZERO_PLAYER_GRID_H_
+
+#include <zero/Math.h>
+#include <zero/Types.h>
+#include <zero/game/Player.h>
+
+namespace zero {
+
+constexpr u16 kAnyFrequency = 0xFFFF;
+
+struct PlayerQueryFilter {
+  // Only return players on this frequency. kAnyFrequency matches every frequency.
+  u16 frequency = kAnyFrequency;
+  // Skip players on this frequency. kAnyFrequency skips nothing.
+  u16 exclude_frequency = kAnyFrequency;
+  // One bit per ship. Spectators are never stored in the grid.
+  u8 ship_mask = 0xFF;
+  // Skip players that are dead and waiting to respawn.
+  bool alive_only = true;
+
+  inline bool Matches(const Player& player) const {
+    if (frequency != kAnyFrequency && player.frequency != frequency) return false;
+    if (exclude_frequency != kAnyFrequency && player.frequency == exclude_frequency) return false;
+    if (!(ship_mask & (1 << player.ship))) return false;
+    if (alive_only && player.enter_delay > 0.0f) return false;
+
+    return true;
+  }
+};
+
+// Persistent uniform grid over the map that links player indices into the cell they are in.
+// Players are only relinked when they move into a different cell, so it never needs to be rebuilt.
+// All queries write into caller provided buffers and return the number of players written.
+struct PlayerGrid {
+  static constexpr size_t kCellShift = 4;
+  static constexpr size_t kCellSize = 1 << kCellShift;
+  static constexpr size_t kCellsPerAxis = 1024 / kCellSize;
+  static constexpr size_t kCellCount = kCellsPerAxis * kCellsPerAxis;
+  static constexpr size_t kMaxPlayers = 1024;
+  static constexpr u16 kInvalidIndex = 0xFFFF;
+
+  Player* players;
+
+  u16 cell_heads[kCellCount];
+
+  // These are indexed by the player's index in the player manager's list.
+  u16 player_cells[kMaxPlayers];
+  u16 next[kMaxPlayers];
+  u16 prev[kMaxPlayers];
+
+  PlayerGrid(Player* players);
+
+  void Clear();
+
+  // Links, relinks, or unlinks the player at this index depending on its current ship and position.
+  void Update(u16 index);
+  void Remove(u16 index);
+
+  size_t QueryRadius(const Vector2f& center, float radius, const PlayerQueryFilter& filter, Player** out,
+                     size_t capacity) const;
+  size_t QueryRect(const Vector2f& min, const Vector2f& max, const PlayerQueryFilter& filter, Player** out,
+                   size_t capacity) const;
+  // Writes up to k players sorted by distance from center. Players beyond max_distance are ignored.
+  size_t QueryNearest(const Vector2f& center, size_t k, const PlayerQueryFilter& filter, Player** out, size_t capacity,
+                      float max_distance = 1024.0f * 1.5f) const;
+
+  inline static s32 GetCellCoord(float v) {
+    s32 coord = (s32)v >> kCellShift;
+
+    if (coord < 0) return 0;
+    if (coord >= (s32)kCellsPerAxis) return (s32)kCellsPerAxis - 1;
+
+    return coord;
+  }
+
+  inline static u16 GetCell(const Vector2f& position) {
+    return (u16)(GetCellCoord(position.y) * kCellsPerAxis + GetCellCoord(position.x));
+  }
+
+ private:
+  void Link(u16 index, u16 cell);
+  void Unlink(u16 index);
+};
+
+}  // namespace zero
+
+#endif
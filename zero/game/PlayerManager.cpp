@@ -8,7 +8,6 @@
 #include <zero/game/Clock.h>
 #include <zero/game/GameEvent.h>
 #include <zero/game/InputState.h>
-#include <zero/game/KDTree.h>
 #include <zero/game/Logger.h>
 #include <zero/game/Radar.h>
 #include <zero/game/ShipController.h>
@@ -54,16 +53,6 @@ static void OnPlayerFrequencyChangePkt(void* user, u8* pkt, size_t size) {
   manager->OnPlayerFrequencyChange(pkt, size);
 }
 
-static void OnLargePositionPkt(void* user, u8* pkt, size_t size) {
-  PlayerManager* manager = (PlayerManager*)user;
-  manager->OnLargePositionPacket(pkt, size);
-}
-
-static void OnSmallPositionPkt(void* user, u8* pkt, size_t size) {
-  PlayerManager* manager = (PlayerManager*)user;
-  manager->OnSmallPositionPacket(pkt, size);
-}
-
 static void OnBatchedSmallPositionPkt(void* user, u8* pkt, size_t size) {
   PlayerManager* manager = (PlayerManager*)user;
   manager->OnBatchedSmallPositionPacket(pkt, size);
@@ -74,11 +63,6 @@ static void OnBatchedLargePositionPkt(void* user, u8* pkt, size_t size) {
   manager->OnBatchedLargePositionPacket(pkt, size);
 }
 
-static void OnPlayerDeathPkt(void* user, u8* pkt, size_t size) {
-  PlayerManager* manager = (PlayerManager*)user;
-  manager->OnPlayerDeath(pkt, size);
-}
-
 static void OnFlagDropPkt(void* user, u8* pkt, size_t size) {
   PlayerManager* manager = (PlayerManager*)user;
   manager->OnFlagDrop(pkt, size);
@@ -129,7 +113,7 @@ static void OnSetCoordinatesPkt(void* user, u8* pkt, size_t size) {
   self->velocity.x = 0.0f;
   self->velocity.y = 0.0f;
   self->togglables |= Status_Flash;
-  self->warp_anim_t = 0.0f;
+  manager->GetDetails(*self).warp_anim_t = 0.0f;
 
   UnstuckSelf(*manager, *self);
   Event::Dispatch(TeleportEvent(*self));
@@ -176,18 +160,20 @@ inline bool IsPlayerVisible(Player& self, u32 self_freq, Player& player) {
 }
 
 PlayerManager::PlayerManager(MemoryArena& perm_arena, Connection& connection, PacketDispatcher& dispatcher)
-    : perm_arena(perm_arena), connection(connection) {
+    : perm_arena(perm_arena), connection(connection), player_lookup(perm_arena, kInvalidPlayerId), grid(players) {
+  // Position packets are decoded once by the dispatcher. Batched ones are read in place, so they take the raw packet.
+  dispatcher.Subscribe<&PlayerManager::OnLargePositionPacket>(this);
+  dispatcher.Subscribe<&PlayerManager::OnSmallPositionPacket>(this);
+  dispatcher.Register(ProtocolS2C::BatchedSmallPosition, OnBatchedSmallPositionPkt, this);
+  dispatcher.Register(ProtocolS2C::BatchedLargePosition, OnBatchedLargePositionPkt, this);
+
   dispatcher.Register(ProtocolS2C::PlayerId, OnPlayerIdPkt, this);
   dispatcher.Register(ProtocolS2C::PlayerEntering, OnPlayerEnterPkt, this);
   dispatcher.Register(ProtocolS2C::PlayerLeaving, OnPlayerLeavePkt, this);
   dispatcher.Register(ProtocolS2C::JoinGame, OnJoinGamePkt, this);
   dispatcher.Register(ProtocolS2C::TeamAndShipChange, OnPlayerFreqAndShipChangePkt, this);
   dispatcher.Register(ProtocolS2C::FrequencyChange, OnPlayerFrequencyChangePkt, this);
-  dispatcher.Register(ProtocolS2C::LargePosition, OnLargePositionPkt, this);
-  dispatcher.Register(ProtocolS2C::SmallPosition, OnSmallPositionPkt, this);
-  dispatcher.Register(ProtocolS2C::BatchedSmallPosition, OnBatchedSmallPositionPkt, this);
-  dispatcher.Register(ProtocolS2C::BatchedLargePosition, OnBatchedLargePositionPkt, this);
-  dispatcher.Register(ProtocolS2C::PlayerDeath, OnPlayerDeathPkt, this);
+  dispatcher.Subscribe<&PlayerManager::OnPlayerDeath>(this);
   dispatcher.Register(ProtocolS2C::DropFlag, OnFlagDropPkt, this);
   dispatcher.Register(ProtocolS2C::SetCoordinates, OnSetCoordinatesPkt, this);
   dispatcher.Register(ProtocolS2C::CreateTurret, OnCreateTurretLinkPkt, this);
@@ -197,7 +183,20 @@ PlayerManager::PlayerManager(MemoryArena& perm_arena, Connection& connection, Pa
   dispatcher.Register(ProtocolS2C::KothGameReset, zero::OnKothGameReset, this);
   dispatcher.Register(ProtocolS2C::AddKothTime, zero::OnKothAddTime, this);
 
-  memset(player_lookup, 0xFF, sizeof(player_lookup));
+  memset(name_index, 0xFF, sizeof(name_index));
+}
+
+MemoryFootprint PlayerManager::GetMemoryFootprint() const {
+  MemoryFootprint footprint;
+
+  // The lookup pages are allocated separately from the manager.
+  footprint.Add(this, sizeof(*this));
+
+  for (size_t i = 0; i < player_lookup.kPageCount; ++i) {
+    footprint.Add(player_lookup.pages[i], sizeof(u16) * player_lookup.kPageSize);
+  }
+
+  return footprint;
 }
 
 void PlayerManager::Update(float dt) {
@@ -222,21 +221,26 @@ void PlayerManager::Update(float dt) {
     }
   }
 
+  SimulatePlayers(dt);
+
   for (size_t i = 0; i < this->player_count; ++i) {
     Player* player = this->players + i;
 
-    if (player->ship >= 8) continue;
+    if (player->ship >= 8) {
+      grid.Update((u16)i);
+      continue;
+    }
 
-    SimulatePlayer(*player, dt, false);
+    PlayerDetails& details = player_details[i];
 
-    player->explode_anim_t += dt;
-    player->warp_anim_t += dt;
-    player->bombflash_anim_t += dt;
+    details.explode_anim_t += dt;
+    details.warp_anim_t += dt;
+    details.bombflash_anim_t += dt;
 
     if (player->enter_delay > 0.0f) {
       player->enter_delay -= dt;
 
-      if (connection.settings.EnterDelay > 0 && player->explode_anim_t >= kAnimDurationShipExplode) {
+      if (connection.settings.EnterDelay > 0 && details.explode_anim_t >= kAnimDurationShipExplode) {
         if (player != self) {
           player->position = Vector2f(0, 0);
           player->lerp_time = 0.0f;
@@ -248,12 +252,14 @@ void PlayerManager::Update(float dt) {
       if (player == self && player->enter_delay <= 0.0f) {
         if (connection.settings.EnterDelay > 0) {
           Spawn();
-          player->warp_anim_t = 0.0f;
+          details.warp_anim_t = 0.0f;
         } else {
           player->energy = 1;
         }
       }
     }
+
+    grid.Update((u16)i);
   }
 
   s32 position_delay = 100;
@@ -298,8 +304,10 @@ void PlayerManager::Render(Camera& camera, SpriteRenderer& renderer) {
     if (player->position == Vector2f(0, 0)) continue;
     if (player->attach_parent != kInvalidPlayerId) continue;
 
-    if (explode_animation.IsAnimating(player->explode_anim_t)) {
-      SpriteRenderable& renderable = explode_animation.GetFrame(player->explode_anim_t);
+    PlayerDetails& details = player_details[i];
+
+    if (explode_animation.IsAnimating(details.explode_anim_t)) {
+      SpriteRenderable& renderable = explode_animation.GetFrame(details.explode_anim_t);
       Vector2f position = player->position - renderable.dimensions * (0.5f / 16.0f);
 
       renderer.Draw(camera, renderable, position, Layer::AfterShips);
@@ -313,7 +321,7 @@ void PlayerManager::Render(Camera& camera, SpriteRenderer& renderer) {
         renderer.Draw(camera, Graphics::ship_sprites[index], position, Layer::Ships);
       }
 
-      AttachInfo* info = player->children;
+      AttachInfo* info = details.children;
 
       while (info) {
         Player* child = GetPlayerById(info->player_id);
@@ -330,15 +338,15 @@ void PlayerManager::Render(Camera& camera, SpriteRenderer& renderer) {
         info = info->next;
       }
 
-      if (warp_animation.IsAnimating(player->warp_anim_t)) {
-        SpriteRenderable& renderable = warp_animation.GetFrame(player->warp_anim_t);
+      if (warp_animation.IsAnimating(details.warp_anim_t)) {
+        SpriteRenderable& renderable = warp_animation.GetFrame(details.warp_anim_t);
         Vector2f position = player->position - renderable.dimensions * (0.5f / 16.0f);
 
         renderer.Draw(camera, renderable, position, Layer::AfterShips);
       }
 
-      if (bombflash_animation.IsAnimating(player->bombflash_anim_t)) {
-        SpriteRenderable& renderable = bombflash_animation.GetFrame(player->bombflash_anim_t);
+      if (bombflash_animation.IsAnimating(details.bombflash_anim_t)) {
+        SpriteRenderable& renderable = bombflash_animation.GetFrame(details.bombflash_anim_t);
         Vector2f heading = OrientationToHeading((u8)(player->orientation * 40.0f));
         ShipSettings& ship_settings = connection.settings.ShipSettings[player->ship];
 
@@ -347,7 +355,7 @@ void PlayerManager::Render(Camera& camera, SpriteRenderer& renderer) {
 
         renderer.Draw(camera, renderable, position, Layer::Weapons);
       }
-    } else if (player == self && player->enter_delay > 0 && !explode_animation.IsAnimating(player->explode_anim_t)) {
+    } else if (player == self && player->enter_delay > 0 && !explode_animation.IsAnimating(details.explode_anim_t)) {
       char output[256];
       sprintf(output, "%.1f", player->enter_delay);
       renderer.PushText(camera, output, TextColor::DarkRed, camera.position, Layer::TopMost, TextAlignment::Center);
@@ -374,7 +382,7 @@ void PlayerManager::Render(Camera& camera, SpriteRenderer& renderer) {
       }
     }
 
-    AttachInfo* info = player->children;
+    AttachInfo* info = player_details[i].children;
 
     while (info) {
       position += Vector2f(0, 12.0f / 16.0f);
@@ -418,27 +426,28 @@ void PlayerManager::RenderPlayerName(Camera& camera, SpriteRenderer& renderer, P
 
     char display[80];
 
-    bool display_ball = player.ball_carrier && !is_decoy;
+    PlayerDetails& details = GetDetails(player);
+    bool display_ball = details.ball_carrier && !is_decoy;
 
-    if (player.flags > 0) {
-      sprintf(display, "%s(%d:%d)[%d] %s", player.name, player.bounty, player.flags, player.ping * 10,
+    if (details.flags > 0) {
+      sprintf(display, "%s(%d:%d)[%d] %s", details.name, player.bounty, details.flags, player.ping * 10,
               display_ball ? "(Ball)" : "");
     } else {
-      sprintf(display, "%s(%d)[%d] %s", player.name, player.bounty, player.ping * 10, display_ball ? "(Ball)" : "");
+      sprintf(display, "%s(%d)[%d] %s", details.name, player.bounty, player.ping * 10, display_ball ? "(Ball)" : "");
     }
 
     TextColor color = TextColor::Blue;
 
     if (player.frequency == self_freq) {
       color = TextColor::Yellow;
-    } else if (player.flags > 0 || (player.ball_carrier && !is_decoy)) {
+    } else if (details.flags > 0 || (details.ball_carrier && !is_decoy)) {
       color = TextColor::DarkRed;
     }
 
     Vector2f current_position = position.PixelRounded() + offset;
 
     if (!is_decoy) {
-      if (player.ball_carrier && player.id == player_id &&
+      if (details.ball_carrier && player.id == player_id &&
           connection.settings.ShipSettings[player.ship].SoccerBallThrowTimer > 0) {
         char ball_time_output[16];
 
@@ -458,7 +467,7 @@ void PlayerManager::RenderPlayerName(Camera& camera, SpriteRenderer& renderer, P
         renderer.PushText(camera, energy_output, energy_color, current_position, Layer::Ships);
 
         current_position.y += (12.0f / 16.0f);
-      } else if (player.id != player_id && TICK_DIFF(tick, player.last_extra_timestamp) < kExtraDataTimeout) {
+      } else if (player.id != player_id && TICK_DIFF(tick, details.last_extra_timestamp) < kExtraDataTimeout) {
         char energy_output[16];
         sprintf(energy_output, "%d", (u32)player.energy);
         Vector2f energy_p = position.PixelRounded() + Vector2f(-0.5f, offset.y);
@@ -579,9 +588,10 @@ void PlayerManager::SendPositionPacket() {
   if (connection.extra_position_info || connection.settings.ExtraPositionData) {
     buffer.WriteU16(energy);
     buffer.WriteU16(connection.ping / 10);
-    u16 timer = player->flag_timer / 100;
+    u16 flag_timer = GetDetails(*player).flag_timer;
+    u16 timer = flag_timer / 100;
 
-    if (player->flag_timer == 0) {
+    if (flag_timer == 0) {
       timer = this->remaining_crown_ticks / 100;
     }
 
@@ -621,7 +631,7 @@ Player* PlayerManager::GetSelf() {
 }
 
 Player* PlayerManager::GetPlayerById(u16 id, size_t* index) {
-  u16 player_index = player_lookup[id];
+  u16 player_index = player_lookup.Get(id);
 
   if (player_index < kInvalidPlayerId) {
     if (index) {
@@ -634,29 +644,110 @@ Player* PlayerManager::GetPlayerById(u16 id, size_t* index) {
   return nullptr;
 }
 
+static inline char ToLower(char c) {
+  if (c >= 'A' && c <= 'Z') return c - 'A' + 'a';
+  return c;
+}
+
+static inline u32 HashNameLower(const char* name) {
+  u32 hash = 0;
+
+  for (const char* c = name; *c; ++c) {
+    hash += (u8)ToLower(*c);
+    hash += (hash << 10);
+    hash ^= (hash >> 6);
+  }
+
+  hash += (hash << 3);
+  hash ^= (hash >> 11);
+  hash += (hash << 15);
+
+  return hash;
+}
+
+static inline bool NameEquals(const char* a, const char* b) {
+  for (; *a && *b; ++a, ++b) {
+    if (ToLower(*a) != ToLower(*b)) return false;
+  }
+
+  return *a == *b;
+}
+
 Player* PlayerManager::GetPlayerByName(const char* name) {
-  for (size_t i = 0; i < player_count; ++i) {
-    Player* player = players + i;
+  constexpr size_t kMask = kNameIndexSize - 1;
+
+  for (size_t slot = HashNameLower(name) & kMask;; slot = (slot + 1) & kMask) {
+    u16 index = name_index[slot];
 
-    if (strcmp(player->name, name) == 0) {
-      return player;
+    if (index == kInvalidPlayerId) break;
+
+    if (NameEquals(player_details[index].name, name)) {
+      return players + index;
     }
   }
 
   return nullptr;
 }
 
+void PlayerManager::InsertNameIndex(u16 index) {
+  constexpr size_t kMask = kNameIndexSize - 1;
+
+  size_t slot = HashNameLower(player_details[index].name) & kMask;
+
+  while (name_index[slot] != kInvalidPlayerId) {
+    slot = (slot + 1) & kMask;
+  }
+
+  name_index[slot] = index;
+}
+
+u16* PlayerManager::FindNameIndexSlot(u16 index) {
+  constexpr size_t kMask = kNameIndexSize - 1;
+
+  for (size_t slot = HashNameLower(player_details[index].name) & kMask;; slot = (slot + 1) & kMask) {
+    if (name_index[slot] == index) return name_index + slot;
+    if (name_index[slot] == kInvalidPlayerId) break;
+  }
+
+  return nullptr;
+}
+
+void PlayerManager::RemoveNameIndex(u16 index) {
+  constexpr size_t kMask = kNameIndexSize - 1;
+
+  u16* found = FindNameIndexSlot(index);
+  if (!found) return;
+
+  size_t empty = (size_t)(found - name_index);
+
+  // Shift later entries of the probe chain back into the hole so lookups never stop early.
+  for (size_t slot = (empty + 1) & kMask; name_index[slot] != kInvalidPlayerId; slot = (slot + 1) & kMask) {
+    size_t home = HashNameLower(player_details[name_index[slot]].name) & kMask;
+
+    // Only move the entry if its home slot is not cyclically within (empty, slot].
+    bool movable = empty <= slot ? (home <= empty || home > slot) : (home <= empty && home > slot);
+
+    if (movable) {
+      name_index[empty] = name_index[slot];
+      empty = slot;
+    }
+  }
+
+  name_index[empty] = kInvalidPlayerId;
+}
+
 void PlayerManager::OnPlayerIdChange(u8* pkt, size_t size) {
   player_id = *(u16*)(pkt + 1);
   Log(LogLevel::Debug, "Player id: %d", player_id);
 
   this->player_count = 0;
   this->received_initial_list = false;
-  this->kdtree = nullptr;
   this->crown_dt = 0.0f;
   this->remaining_crown_ticks = 0;
 
-  memset(player_lookup, 0xFF, sizeof(player_lookup));
+  player_lookup.Reset();
+  memset(name_index, 0xFF, sizeof(name_index));
+  grid.Clear();
 }
 
 void PlayerManager::OnPlayerEnter(u8* pkt, size_t size) {
@@ -681,32 +772,37 @@ void PlayerManager::OnPlayerEnter(u8* pkt, size_t size) {
   assert(player_index < ZERO_ARRAY_SIZE(players));
 
   Player* player = players + player_index;
+  PlayerDetails* details = player_details + player_index;
 
   memset((void*)player, 0, sizeof(Player));
+  memset((void*)details, 0, sizeof(PlayerDetails));
+  position_history[player_index].Clear();
 
   player->ship = ship;
 
-  memcpy(player->name, name, 20);
-  player->name[20] = 0;
-  memcpy(player->squad, squad, 20);
-  player->squad[20] = 0;
+  memcpy(details->name, name, 20);
+  details->name[20] = 0;
+  memcpy(details->squad, squad, 20);
+  details->squad[20] = 0;
 
-  player->kill_points = buffer.ReadU32();
-  player->flag_points = buffer.ReadU32();
+  details->kill_points = buffer.ReadU32();
+  details->flag_points = buffer.ReadU32();
   player->id = buffer.ReadU16();
   player->frequency = buffer.ReadU16();
-  player->wins = buffer.ReadU16();
-  player->losses = buffer.ReadU16();
+  details->wins = buffer.ReadU16();
+  details->losses = buffer.ReadU16();
   player->attach_parent = buffer.ReadU16();
-  player->flags = buffer.ReadU16();
-  player->has_crown = buffer.ReadU8();
+  details->flags = buffer.ReadU16();
+  details->has_crown = buffer.ReadU8();
   player->timestamp = kInvalidSmallTick;
 
-  player->warp_anim_t = kAnimDurationShipWarp;
-  player->explode_anim_t = kAnimDurationShipExplode;
-  player->bombflash_anim_t = kAnimDurationBombFlash;
+  details->warp_anim_t = kAnimDurationShipWarp;
+  details->explode_anim_t = kAnimDurationShipExplode;
+  details->bombflash_anim_t = kAnimDurationBombFlash;
 
   player_lookup[player->id] = (u16)player_index;
+  grid.Update((u16)player_index);
+  InsertNameIndex((u16)player_index);
 
   Log(LogLevel::Info, "%s [%d] entered arena", name, player->id);
 
@@ -719,7 +815,7 @@ void PlayerManager::OnPlayerEnter(u8* pkt, size_t size) {
   }
 
   if (chat_controller && received_initial_list) {
-    chat_controller->AddMessage(ChatType::Arena, "%s entered arena", player->name);
+    chat_controller->AddMessage(ChatType::Arena, "%s entered arena", details->name);
   }
 
   Event::Dispatch(PlayerEnterEvent(*player));
@@ -743,13 +839,13 @@ void PlayerManager::RemovePlayer(Player* player) {
 
   weapon_manager->ClearWeapons(*player);
 
-  Log(LogLevel::Info, "%s left arena", player->name);
+  Log(LogLevel::Info, "%s left arena", GetName(*player));
 
   DetachPlayer(*player);
   DetachAllChildren(*player);
 
   if (chat_controller) {
-    chat_controller->AddMessage(ChatType::Arena, "%s left arena", player->name);
+    chat_controller->AddMessage(ChatType::Arena, "%s left arena", GetName(*player));
   }
 
   Event::Dispatch(PlayerLeaveEvent(*player));
@@ -757,44 +853,63 @@ void PlayerManager::RemovePlayer(Player* player) {
   // Swap the last player in the list's lookup to point to their new index
   assert(index < 1024);
 
-  player_lookup[players[player_count - 1].id] = (u16)index;
+  size_t last_index = player_count - 1;
+
+  player_lookup[players[last_index].id] = (u16)index;
   player_lookup[player->id] = kInvalidPlayerId;
 
-  players[index] = players[--player_count];
-}
+  grid.Remove((u16)index);
+  grid.Remove((u16)last_index);
 
-void PlayerManager::OnPlayerDeath(u8* pkt, size_t size) {
-  NetworkBuffer buffer(pkt, size, size);
+  RemoveNameIndex((u16)index);
 
-  buffer.ReadU8();
+  if (index != last_index) {
+    u16* slot = FindNameIndexSlot((u16)last_index);
 
-  u8 green_id = buffer.ReadU8();
-  u16 killer_id = buffer.ReadU16();
-  u16 killed_id = buffer.ReadU16();
-  u16 bounty = buffer.ReadU16();
-  u16 flag_transfer = buffer.ReadU16();
+    if (slot) {
+      *slot = (u16)index;
+    }
+  }
+
+  players[index] = players[last_index];
+  player_details[index] = player_details[last_index];
+  position_history[index] = position_history[last_index];
+  --player_count;
+
+  if (index != last_index) {
+    grid.Update((u16)index);
+  }
+}
+
+void PlayerManager::OnPlayerDeath(const PlayerDeathPacket& packet) {
+  u16 bounty = packet.bounty;
+  u16 flag_transfer = packet.flag_transfer;
 
-  Player* killed = GetPlayerById(killed_id);
-  Player* killer = GetPlayerById(killer_id);
+  Player* killed = GetPlayerById(packet.killed_id);
+  Player* killer = GetPlayerById(packet.killer_id);
 
   if (killed) {
     // Hide the player until they send a new position packet
+    PlayerDetails& killed_details = GetDetails(*killed);
+
     killed->enter_delay = (connection.settings.EnterDelay / 100.0f) + kAnimDurationShipExplode;
-    killed->explode_anim_t = 0.0f;
-    killed->flags = 0;
-    killed->flag_timer = 0;
-    killed->ball_carrier = false;
     killed->energy = 0;
+    killed_details.explode_anim_t = 0.0f;
+    killed_details.flags = 0;
+    killed_details.flag_timer = 0;
+    killed_details.ball_carrier = false;
 
     DetachPlayer(*killed);
     DetachAllChildren(*killed);
   }
 
   if (killer && killer != killed) {
-    killer->flags += flag_transfer;
+    PlayerDetails& killer_details = GetDetails(*killer);
+
+    killer_details.flags += flag_transfer;
 
     if (flag_transfer > 0) {
-      killer->flag_timer = connection.settings.FlagDropDelay;
+      killer_details.flag_timer = connection.settings.FlagDropDelay;
     }
 
     if (killer->id == player_id && killed && killed->bounty > 0) {
@@ -807,10 +922,10 @@ void PlayerManager::OnPlayerDeath(u8* pkt, size_t size) {
   }
 }
 
-static inline u32 HashName(Player& player) {
+static inline u32 HashName(const char* name) {
   u32 hash = 0;
 
-  const char* c = player.name;
+  const char* c = name;
 
   for (; *c; ++c) {
     hash += *c;
@@ -844,7 +959,7 @@ void PlayerManager::Spawn(bool reset) {
 
   // Create a hash based on our name so we can offset the random seed.
   // This is to stop many bots ran at the same time from generating the same positions.
-  u32 hash = HashName(*self);
+  u32 hash = HashName(GetName(*self));
   u32 rand_seed = rand() + hash;
 
   if (spawn_count == 0) {
@@ -943,8 +1058,8 @@ void PlayerManager::Spawn(bool reset) {
   }
 
   self->togglables |= Status_Flash;
-  self->warp_anim_t = 0.0f;
   self->velocity = Vector2f(0, 0);
+  GetDetails(*self).warp_anim_t = 0.0f;
 
   Event::Dispatch(SpawnEvent(*self));
 }
@@ -969,12 +1084,15 @@ void PlayerManager::OnPlayerFrequencyChange(u8* pkt, size_t size) {
     player->velocity = Vector2f(0, 0);
 
     player->lerp_time = 0.0f;
-    player->warp_anim_t = 0.0f;
     player->enter_delay = 0.0f;
-    player->flags = 0;
-    player->ball_carrier = false;
     player->energy = 0;
 
+    PlayerDetails& details = GetDetails(*player);
+
+    details.warp_anim_t = 0.0f;
+    details.flags = 0;
+    details.ball_carrier = false;
+
     weapon_manager->ClearWeapons(*player);
 
     Event::Dispatch(PlayerFreqAndShipChangeEvent(*player, old_freq, frequency, player->ship, player->ship));
@@ -1007,13 +1125,18 @@ void PlayerManager::OnPlayerFreqAndShipChange(u8* pkt, size_t size) {
     player->frequency = freq;
     player->velocity = Vector2f(0, 0);
 
+    grid.Update((u16)(player - players));
+
     player->lerp_time = 0.0f;
-    player->warp_anim_t = 0.0f;
     player->enter_delay = 0.0f;
-    player->flags = 0;
-    player->ball_carrier = false;
     player->energy = 0;
 
+    PlayerDetails& details = GetDetails(*player);
+
+    details.warp_anim_t = 0.0f;
+    details.flags = 0;
+    details.ball_carrier = false;
+
     weapon_manager->ClearWeapons(*player);
 
     if (player->id == player_id) {
@@ -1048,18 +1171,10 @@ bool IsNewerPositionPacket(Player* player, u16 timestamp) {
   return abs(timestamp - player->timestamp) > 999;
 }
 
-void PlayerManager::OnLargePositionPacket(u8* pkt, size_t size) {
-  NetworkBuffer buffer(pkt, size, size);
-
-  buffer.ReadU8();
-
-  u8 direction = buffer.ReadU8();
-  u16 timestamp = buffer.ReadU16();
-  u16 x = buffer.ReadU16();
-  s16 vel_y_s16 = (s16)buffer.ReadU16();
-  u16 pid = buffer.ReadU16();
+void PlayerManager::OnLargePositionPacket(const LargePositionPacket& packet) {
+  u16 timestamp = packet.timestamp;
 
-  Player* player = GetPlayerById(pid);
+  Player* player = GetPlayerById(packet.player_id);
 
   // Put packet timestamp into local time
   u32 server_timestamp = (connection.GetServerTick() & 0x7FFF0000) | timestamp;
@@ -1071,46 +1186,43 @@ void PlayerManager::OnLargePositionPacket(u8* pkt, size_t size) {
   }
 
   if (IsNewerPositionPacket(player, timestamp)) {
-    player->orientation = direction / 40.0f;
-    float vel_y = vel_y_s16 / 16.0f / 10.0f;
-    float vel_x = (s16)buffer.ReadU16() / 16.0f / 10.0f;
+    player->orientation = packet.direction / 40.0f;
 
-    Vector2f velocity(vel_x, vel_y);
+    Vector2f velocity(packet.vel_x / 16.0f / 10.0f, packet.vel_y / 16.0f / 10.0f);
 
-    u8 checksum = buffer.ReadU8();
-    player->togglables = buffer.ReadU8();
-    player->ping = buffer.ReadU8();
-    u16 y = buffer.ReadU16();
-    player->bounty = buffer.ReadU16();
+    player->togglables = packet.togglables;
+    player->ping = packet.ping;
+    player->bounty = packet.bounty;
+
+    PlayerDetails& details = GetDetails(*player);
 
     if (player->togglables & Status_Flash) {
-      player->warp_anim_t = 0.0f;
+      details.warp_anim_t = 0.0f;
     }
 
-    u16 weapon = buffer.ReadU16();
-    memcpy(&player->weapon, &weapon, sizeof(weapon));
+    memcpy(&player->weapon, &packet.weapon, sizeof(packet.weapon));
 
-    if (weapon != 0) {
+    if (packet.weapon != 0) {
       ++connection.weapons_received;
     }
 
     // Don't force set own energy/latency
     if (player->id != player_id) {
-      if (size >= 23) {
-        player->last_extra_timestamp = GetCurrentTick();
-        player->energy = (float)buffer.ReadU16();
+      if (packet.HasEnergy()) {
+        details.last_extra_timestamp = GetCurrentTick();
+        player->energy = (float)packet.energy;
       }
 
-      if (size >= 25) {
-        player->s2c_latency = buffer.ReadU16();
+      if (packet.HasLatency()) {
+        details.s2c_latency = packet.s2c_latency;
       }
 
-      if (size >= 27) {
-        player->flag_timer = buffer.ReadU16();
+      if (packet.HasFlagTimer()) {
+        details.flag_timer = packet.flag_timer;
       }
 
-      if (size >= 31) {
-        player->items = buffer.ReadU32();
+      if (packet.HasItems()) {
+        details.items = packet.items;
       }
     }
 
@@ -1119,24 +1231,15 @@ void PlayerManager::OnLargePositionPacket(u8* pkt, size_t size) {
     player->timestamp = timestamp;
     player->ping += timestamp_diff;
 
-    Vector2f pkt_position(x / 16.0f, y / 16.0f);
+    Vector2f pkt_position(packet.x / 16.0f, packet.y / 16.0f);
     OnPositionPacket(*player, pkt_position, velocity, player->ping);
   }
 }
 
-void PlayerManager::OnSmallPositionPacket(u8* pkt, size_t size) {
-  NetworkBuffer buffer(pkt, size, size);
+void PlayerManager::OnSmallPositionPacket(const SmallPositionPacket& packet) {
+  u16 timestamp = packet.timestamp;
 
-  buffer.ReadU8();
-
-  u8 direction = buffer.ReadU8();
-  u16 timestamp = buffer.ReadU16();
-  u16 x = buffer.ReadU16();
-  u8 ping = buffer.ReadU8();
-  u8 bounty = buffer.ReadU8();
-  u16 pid = buffer.ReadU8();
-
-  Player* player = GetPlayerById(pid);
+  Player* player = GetPlayerById(packet.player_id);
 
   // Put packet timestamp into local time
   u32 server_timestamp = (connection.GetServerTick() & 0x7FFF0000) | timestamp;
@@ -1149,37 +1252,36 @@ void PlayerManager::OnSmallPositionPacket(u8* pkt, size_t size) {
 
   // Only perform update if the packet is newer than the previous one.
   if (IsNewerPositionPacket(player, timestamp)) {
-    player->orientation = direction / 40.0f;
-    player->ping = ping;
-    player->bounty = bounty;
-    player->togglables = buffer.ReadU8();
-    float vel_y = (s16)buffer.ReadU16() / 16.0f / 10.0f;
-    u16 y = buffer.ReadU16();
-    float vel_x = (s16)buffer.ReadU16() / 16.0f / 10.0f;
+    player->orientation = packet.direction / 40.0f;
+    player->ping = packet.ping;
+    player->bounty = packet.bounty;
+    player->togglables = packet.togglables;
 
-    Vector2f velocity(vel_x, vel_y);
+    Vector2f velocity(packet.vel_x / 16.0f / 10.0f, packet.vel_y / 16.0f / 10.0f);
+
+    PlayerDetails& details = GetDetails(*player);
 
     if (player->togglables & Status_Flash) {
-      player->warp_anim_t = 0.0f;
+      details.warp_anim_t = 0.0f;
     }
 
     // Don't force set own energy/latency
     if (player->id != player_id) {
-      if (size >= 18) {
-        player->last_extra_timestamp = GetCurrentTick();
-        player->energy = (float)buffer.ReadU16();
+      if (packet.HasEnergy()) {
+        details.last_extra_timestamp = GetCurrentTick();
+        player->energy = (float)packet.energy;
       }
 
-      if (size >= 20) {
-        player->s2c_latency = buffer.ReadU16();
+      if (packet.HasLatency()) {
+        details.s2c_latency = packet.s2c_latency;
       }
 
-      if (size >= 22) {
-        player->flag_timer = buffer.ReadU16();
+      if (packet.HasFlagTimer()) {
+        details.flag_timer = packet.flag_timer;
       }
 
-      if (size >= 26) {
-        player->items = buffer.ReadU32();
+      if (packet.HasItems()) {
+        details.items = packet.items;
       }
     }
 
@@ -1188,115 +1290,62 @@ void PlayerManager::OnSmallPositionPacket(u8* pkt, size_t size) {
     player->timestamp = timestamp;
     player->ping += timestamp_diff;
 
-    Vector2f pkt_position(x / 16.0f, y / 16.0f);
+    Vector2f pkt_position(packet.x / 16.0f, packet.y / 16.0f);
     OnPositionPacket(*player, pkt_position, velocity, player->ping);
   }
 }
 
 void PlayerManager::OnBatchedLargePositionPacket(u8* pkt, size_t size) {
-  NetworkBuffer buffer(pkt, size, size);
-
-  buffer.ReadU8();  // Type
-
-  u32 server_tick = (GetCurrentTick() + connection.time_diff);
-
-  while (buffer.write - buffer.read >= 11) {
-    u16 pid_togglables = buffer.ReadU16();
-
-    u16 player_id = pid_togglables & 0x3FF;
-    u8 togglables = (u8)(pid_togglables >> 10);
-
-    u16 packed = buffer.ReadU16();
-    u16 direction = (packed >> 10);
-    u16 timestamp = (packed & 0x3FF);
-
-    u32 packed_pos = buffer.ReadU32();
-    u32 x = packed_pos & 0x3FFF;
-    u32 y = (packed_pos >> 0x0E) & 0x3FFF;
-
-    u16 packed_velocity = buffer.ReadU16();
-    s16 vel_y = (packed_velocity << 0x12) >> 0x12;
-
-    s8 multiplier = buffer.ReadU8();
-
-    s32 vel_x = ((packed_velocity >> 0x0E) + (multiplier * 4)) * 0x10 + (packed_pos >> 0x1C);
-
-    Vector2f velocity(vel_x / 16.0f / 10.0f, vel_y / 16.0f / 10.0f);
-    Vector2f position(x / 16.0f, y / 16.0f);
-
-    // Put packet timestamp into local time
-    u32 server_timestamp = (connection.GetServerTick() & 0x7FFFFC00) | timestamp;
-    u32 local_timestamp = server_timestamp - connection.time_diff;
-    timestamp = server_timestamp & 0xFFFF;
-
-    // Throw away bad timestamps so the player doesn't get desynchronized.
-    if (TICK_DIFF(local_timestamp, GetCurrentTick()) >= 300) {
-      continue;
-    }
-
-    Player* player = GetPlayerById(player_id);
-
-    if (player && IsNewerPositionPacket(player, timestamp)) {
-      s32 timestamp_diff = GetTimestampDiff(connection, server_timestamp);
-
-      player->timestamp = timestamp;
-      player->orientation = direction / 40.0f;
-      // Store the new togglables, but keep the top 2 bits since they aren't sent in this.
-      player->togglables = togglables | (player->togglables & 0xC0);
-
-      OnPositionPacket(*player, position, velocity, timestamp_diff);
-    }
-  }
+  OnBatchedPositionPacket(pkt, size, kBatchedLargePositionFormat);
 }
 
 void PlayerManager::OnBatchedSmallPositionPacket(u8* pkt, size_t size) {
-  NetworkBuffer buffer(pkt, size, size);
-
-  buffer.ReadU8();  // Type
-
-  u32 server_tick = (GetCurrentTick() + connection.time_diff);
-
-  while (buffer.write - buffer.read >= 10) {
-    u8 player_id = buffer.ReadU8();
-
-    u16 packed = buffer.ReadU16();
-    u16 direction = (packed >> 10);
-    s16 timestamp = (packed & 0x3FF);
+  OnBatchedPositionPacket(pkt, size, kBatchedSmallPositionFormat);
+}
 
-    u32 packed_pos = buffer.ReadU32();
-    u32 x = packed_pos & 0x3FFF;
-    u32 y = (packed_pos >> 0x0E) & 0x3FFF;
+void PlayerManager::OnBatchedPositionPacket(u8* pkt, size_t size, const BatchedPositionFormat& format) {
+  if (size < 1) return;
 
-    u16 packed_velocity = buffer.ReadU16();
-    s16 vel_y = (packed_velocity << 0x12) >> 0x12;
+  // Validate the bounds once so the entries can be decoded directly out of the packet. Trailing partial entries are
+  // ignored.
+  size_t entry_count = (size - 1) / format.entry_size;
+  const u8* entry = pkt + 1;
 
-    s8 multiplier = buffer.ReadU8();
+  u32 current_tick = GetCurrentTick();
+  u32 server_tick_base = connection.GetServerTick() & 0x7FFFFC00;
 
-    s32 vel_x = ((packed_velocity >> 0x0E) + (multiplier * 4)) * 0x10 + (packed_pos >> 0x1C);
+  for (size_t i = 0; i < entry_count; ++i, entry += format.entry_size) {
+    u16 player_index = player_lookup.Get(BatchedPositionEntry::GetPlayerId(entry, format));
+    if (player_index >= kInvalidPlayerId) continue;
 
-    Vector2f velocity(vel_x / 16.0f / 10.0f, vel_y / 16.0f / 10.0f);
-    Vector2f position(x / 16.0f, y / 16.0f);
+    BatchedPositionEntry position;
+    BatchedPositionEntry::Decode(entry, format, position);
 
     // Put packet timestamp into local time
-    u32 server_timestamp = (connection.GetServerTick() & 0x7FFFFC00) | timestamp;
+    u32 server_timestamp = server_tick_base | position.timestamp;
     u32 local_timestamp = server_timestamp - connection.time_diff;
-    timestamp = server_timestamp & 0xFFFF;
+    u16 timestamp = server_timestamp & 0xFFFF;
 
     // Throw away bad timestamps so the player doesn't get desynchronized.
-    if (TICK_DIFF(local_timestamp, GetCurrentTick()) >= 300) {
+    if (TICK_DIFF(local_timestamp, current_tick) >= 300) {
       continue;
     }
 
-    Player* player = GetPlayerById(player_id);
+    Player* player = players + player_index;
 
-    if (player && IsNewerPositionPacket(player, timestamp)) {
-      s32 timestamp_diff = GetTimestampDiff(connection, server_timestamp);
+    if (!IsNewerPositionPacket(player, timestamp)) continue;
 
-      player->timestamp = timestamp;
-      player->orientation = direction / 40.0f;
+    s32 timestamp_diff = GetTimestampDiff(connection, server_timestamp);
+
+    player->timestamp = timestamp;
+    player->orientation = position.direction / 40.0f;
 
-      OnPositionPacket(*player, position, velocity, timestamp_diff);
+    if (format.id_size == 2) {
+      // Store the new togglables, but keep the top 2 bits since they aren't sent in this.
+      player->togglables = position.togglables | (player->togglables & 0xC0);
     }
+
+    OnPositionPacket(*player, position.position, position.velocity, timestamp_diff);
   }
 }
 
@@ -1310,6 +1359,9 @@ void PlayerManager::OnPositionPacket(Player& player, const Vector2f& position, c
     return;
   }
 
+  // The packet state was true sim_ticks ago, so store it at that time for prediction.
+  GetPositionHistory(player).Push(MAKE_TICK(GetCurrentTick() - sim_ticks), position, velocity);
+
   // Hard set the new position so we can simulate from it to catch up to where the player would be now after ping ticks
   player.position = position;
   player.velocity = velocity;
@@ -1352,6 +1404,8 @@ void PlayerManager::OnPositionPacket(Player& player, const Vector2f& position, c
     UnstuckSelf(*this, player);
     Event::Dispatch(TeleportEvent(player));
   }
+
+  grid.Update((u16)(&player - players));
 }
 
 void PlayerManager::OnFlagDrop(u8* pkt, size_t size) {
@@ -1360,8 +1414,10 @@ void PlayerManager::OnFlagDrop(u8* pkt, size_t size) {
   Player* player = GetPlayerById(player_id);
 
   if (player) {
-    player->flags = 0;
-    player->flag_timer = 0;
+    PlayerDetails& details = GetDetails(*player);
+
+    details.flags = 0;
+    details.flag_timer = 0;
   }
 }
 
@@ -1379,7 +1435,7 @@ AttachRequestResponse PlayerManager::AttachSelf(Player* destination) {
     return AttachRequestResponse::DetatchFromParent;
   }
 
-  if (self->children) {
+  if (GetDetails(*self).children) {
     connection.SendAttachDrop();
     return AttachRequestResponse::DetatchChildren;
   }
@@ -1445,10 +1501,12 @@ void PlayerManager::AttachPlayer(Player& requester, Player& destination) {
   AttachInfo* info = attach_free;
   attach_free = attach_free->next;
 
+  PlayerDetails& destination_details = GetDetails(destination);
+
   info->player_id = requester.id;
-  info->next = destination.children;
+  info->next = destination_details.children;
 
-  destination.children = info;
+  destination_details.children = info;
 }
 
 void PlayerManager::OnCreateTurretLink(u8* pkt, size_t size) {
@@ -1527,7 +1585,8 @@ void PlayerManager::DetachPlayer(Player& player) {
     }
 
     if (parent) {
-      AttachInfo* current = parent->children;
+      PlayerDetails& parent_details = GetDetails(*parent);
+      AttachInfo* current = parent_details.children;
       AttachInfo* prev = nullptr;
 
       while (current) {
@@ -1536,7 +1595,7 @@ void PlayerManager::DetachPlayer(Player& player) {
           if (prev) {
             prev->next = current->next;
           } else {
-            parent->children = current->next;
+            parent_details.children = current->next;
           }
 
           current->player_id = kInvalidPlayerId;
@@ -1560,7 +1619,8 @@ void PlayerManager::DetachPlayer(Player& player) {
 }
 
 void PlayerManager::DetachAllChildren(Player& player) {
-  AttachInfo* current = player.children;
+  PlayerDetails& details = GetDetails(player);
+  AttachInfo* current = details.children;
 
   while (current) {
     AttachInfo* remove = current;
@@ -1585,11 +1645,11 @@ void PlayerManager::DetachAllChildren(Player& player) {
     attach_free = remove;
   }
 
-  player.children = nullptr;
+  details.children = nullptr;
 }
 
 size_t PlayerManager::GetTurretCount(Player& player) {
-  AttachInfo* info = player.children;
+  AttachInfo* info = GetDetails(player).children;
   size_t count = 0;
 
   while (info) {
@@ -1600,9 +1660,47 @@ size_t PlayerManager::GetTurretCount(Player& player) {
   return count;
 }
 
+// Checks if a ship that just moved delta along the axis is now overlapping a wall on the leading edge.
+static bool IsAxisColliding(const Map& map, const Vector2f& position, float delta, float radius, int axis,
+                            u32 frequency) {
+  int axis_flip = axis == 0 ? 1 : 0;
+
+  u16 check = (u16)(position.values[axis] + radius);
+
+  if (delta < 0) {
+    check = (u16)floorf(position.values[axis] - radius);
+  }
+
+  if (check > 1023) return true;
+
+  s16 start = (s16)(position.values[axis_flip] - radius - 1);
+  s16 end = (s16)(position.values[axis_flip] + radius + 1);
+
+  // Most ships are nowhere near a wall, so reject the whole span with the packed solidity bits first.
+  if (!map.IsSpanPossiblySolid(check, start, end, axis == 0)) return false;
+
+  Vector2f collider_min = position.PixelRounded() - Vector2f(radius, radius);
+  Vector2f collider_max = position.PixelRounded() + Vector2f(radius, radius);
+
+  for (s16 other = start; other < end; ++other) {
+    if (axis == 0 && map.IsSolid(check, other, frequency)) {
+      if (BoxBoxIntersect(collider_min, collider_max, Vector2f((float)check, (float)other),
+                          Vector2f((float)check + 1, (float)other + 1))) {
+        return true;
+      }
+    } else if (axis == 1 && map.IsSolid(other, check, frequency)) {
+      if (BoxBoxIntersect(collider_min, collider_max, Vector2f((float)other, (float)check),
+                          Vector2f((float)other + 1, (float)check + 1))) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
 bool PlayerManager::SimulateAxis(Player& player, float dt, int axis, bool extrapolating) {
   float bounce_factor = 16.0f / connection.settings.BounceFactor;
-  Map& map = connection.map;
 
   int axis_flip = axis == 0 ? 1 : 0;
   float radius = connection.settings.ShipSettings[player.ship].GetRadius();
@@ -1621,34 +1719,7 @@ bool PlayerManager::SimulateAxis(Player& player, float dt, int axis, bool extrap
     delta += player.lerp_velocity.values[axis] * timestep;
   }
 
-  u16 check = (u16)(player.position.values[axis] + radius);
-
-  if (delta < 0) {
-    check = (u16)floorf(player.position.values[axis] - radius);
-  }
-
-  s16 start = (s16)(player.position.values[axis_flip] - radius - 1);
-  s16 end = (s16)(player.position.values[axis_flip] + radius + 1);
-
-  Vector2f collider_min = player.position.PixelRounded() - Vector2f(radius, radius);
-  Vector2f collider_max = player.position.PixelRounded() + Vector2f(radius, radius);
-
-  bool collided = check < 0 || check > 1023;
-  for (s16 other = start; other < end && !collided; ++other) {
-    if (axis == 0 && map.IsSolid(check, other, player.frequency)) {
-      if (BoxBoxIntersect(collider_min, collider_max, Vector2f((float)check, (float)other),
-                          Vector2f((float)check + 1, (float)other + 1))) {
-        collided = true;
-        break;
-      }
-    } else if (axis == 1 && map.IsSolid(other, check, player.frequency)) {
-      if (BoxBoxIntersect(collider_min, collider_max, Vector2f((float)other, (float)check),
-                          Vector2f((float)other + 1, (float)check + 1))) {
-        collided = true;
-        break;
-      }
-    }
-  }
+  bool collided = IsAxisColliding(connection.map, player.position, delta, radius, axis, player.frequency);
 
   if (collided) {
     u32 tick = GetCurrentTick();
@@ -1709,6 +1780,137 @@ void PlayerManager::SimulatePlayer(Player& player, float dt, bool extrapolating)
   player.lerp_time -= dt;
 }
 
+// Number of players that SimulatePlayers advances together.
+constexpr size_t kSimulationLanes = 8;
+
+// Structure of arrays for a group of players so the integration step can run across every lane at once.
+struct SimulationLanes {
+  size_t count;
+
+  Player* players[kSimulationLanes];
+
+  float position[2][kSimulationLanes];
+  float velocity[2][kSimulationLanes];
+  float lerp_velocity[2][kSimulationLanes];
+
+  float lerp_timestep[kSimulationLanes];
+  float radius[kSimulationLanes];
+  float bounce_factor[kSimulationLanes];
+  u16 frequency[kSimulationLanes];
+
+  bool lerping[kSimulationLanes];
+  bool bounced[kSimulationLanes];
+};
+
+static void SimulateLaneAxis(SimulationLanes& lanes, const Map& map, float dt, int axis) {
+  int axis_flip = axis == 0 ? 1 : 0;
+
+  float previous[kSimulationLanes];
+  float delta[kSimulationLanes];
+
+  // This matches the operation order of SimulateAxis so the results are identical, but it's branch free across the
+  // lanes so it can be vectorized. Unused lanes are zeroed so they can be computed with the rest.
+  for (size_t i = 0; i < kSimulationLanes; ++i) {
+    float step = lanes.velocity[axis][i] * dt;
+    float lerp_step = lanes.lerp_velocity[axis][i] * lanes.lerp_timestep[i];
+    float position = lanes.position[axis][i] + step;
+
+    previous[i] = lanes.position[axis][i];
+    lanes.position[axis][i] = lanes.lerping[i] ? position + lerp_step : position;
+    delta[i] = lanes.lerping[i] ? step + lerp_step : step;
+  }
+
+  for (size_t i = 0; i < lanes.count; ++i) {
+    Vector2f position(lanes.position[0][i], lanes.position[1][i]);
+
+    if (IsAxisColliding(map, position, delta[i], lanes.radius[i], axis, lanes.frequency[i])) {
+      float bounce_factor = lanes.bounce_factor[i];
+
+      lanes.position[axis][i] = previous[i];
+
+      lanes.velocity[axis][i] *= -bounce_factor;
+      lanes.velocity[axis_flip][i] *= bounce_factor;
+
+      lanes.lerp_velocity[axis][i] *= -bounce_factor;
+      lanes.lerp_velocity[axis_flip][i] *= bounce_factor;
+
+      lanes.bounced[i] = true;
+    }
+  }
+}
+
+void PlayerManager::SimulateLanes(SimulationLanes& lanes, float dt, u32 tick) {
+  SimulateLaneAxis(lanes, connection.map, dt, 0);
+  SimulateLaneAxis(lanes, connection.map, dt, 1);
+
+  for (size_t i = 0; i < lanes.count; ++i) {
+    Player& player = *lanes.players[i];
+
+    player.position = Vector2f(lanes.position[0][i], lanes.position[1][i]);
+    player.velocity = Vector2f(lanes.velocity[0][i], lanes.velocity[1][i]);
+    player.lerp_velocity = Vector2f(lanes.lerp_velocity[0][i], lanes.lerp_velocity[1][i]);
+
+    if (lanes.bounced[i]) {
+      player.last_bounce_tick = tick;
+    }
+
+    player.lerp_time -= dt;
+  }
+
+  memset(&lanes, 0, sizeof(lanes));
+}
+
+void PlayerManager::SimulatePlayers(float dt) {
+  u32 tick = GetCurrentTick();
+  float bounce_factor = 16.0f / connection.settings.BounceFactor;
+
+  SimulationLanes lanes;
+  memset(&lanes, 0, sizeof(lanes));
+
+  for (size_t i = 0; i < player_count; ++i) {
+    Player& player = players[i];
+
+    if (player.ship >= 8) continue;
+
+    // Self can trigger wormholes during simulation, so it always goes through the scalar path.
+    if (player.id == player_id) {
+      SimulatePlayer(player, dt, false);
+      continue;
+    }
+
+    if (!IsSynchronized(player, tick)) {
+      player.velocity = Vector2f(0, 0);
+      player.lerp_time = 0.0f;
+      continue;
+    }
+
+    size_t lane = lanes.count++;
+
+    lanes.players[lane] = &player;
+    lanes.position[0][lane] = player.position.x;
+    lanes.position[1][lane] = player.position.y;
+    lanes.velocity[0][lane] = player.velocity.x;
+    lanes.velocity[1][lane] = player.velocity.y;
+    lanes.lerp_velocity[0][lane] = player.lerp_velocity.x;
+    lanes.lerp_velocity[1][lane] = player.lerp_velocity.y;
+    lanes.lerping[lane] = player.lerp_time > 0.0f;
+    lanes.lerp_timestep[lane] = player.lerp_time < dt ? player.lerp_time : dt;
+    lanes.radius[lane] = connection.settings.ShipSettings[player.ship].GetRadius();
+    lanes.frequency[lane] = player.frequency;
+
+    // Don't perform a bunch of wall slowdowns so the player doesn't get very slow against walls.
+    lanes.bounce_factor[lane] = TICK_DIFF(tick, player.last_bounce_tick) < 1 ? 1.0f : bounce_factor;
+
+    if (lanes.count == kSimulationLanes) {
+      SimulateLanes(lanes, dt, tick);
+    }
+  }
+
+  if (lanes.count > 0) {
+    SimulateLanes(lanes, dt, tick);
+  }
+}
+
 bool PlayerManager::IsAntiwarped(Player& self, bool notify) {
   float antiwarp_tiles = connection.settings.AntiWarpPixels / 16.0f;
   float antiwarp_range_sq = antiwarp_tiles * antiwarp_tiles;
@@ -1754,9 +1956,7 @@ void PlayerManager::OnKothGameReset(u8* pkt, size_t size) {
 
   if (pid == kInvalidPlayerId) {
     for (size_t i = 0; i < player_count; ++i) {
-      Player* player = players + i;
-
-      player->has_crown = adding;
+      player_details[i].has_crown = adding;
     }
 
     this->remaining_crown_ticks = timer;
@@ -1765,7 +1965,7 @@ void PlayerManager::OnKothGameReset(u8* pkt, size_t size) {
     Player* player = GetPlayerById(pid);
 
     if (player) {
-      player->has_crown = adding;
+      GetDetails(*player).has_crown = adding;
 
       if (player->id == player_id) {
         this->remaining_crown_ticks = timer;
@@ -2,8 +2,12 @@
 #define ZERO_PLAYER_MANAGER_H_
 
 #include <zero/Types.h>
+#include <zero/game/PagedIdTable.h>
 #include <zero/game/Player.h>
+#include <zero/game/PlayerGrid.h>
+#include <zero/game/PositionHistory.h>
 #include <zero/game/net/Connection.h>
+#include <zero/game/net/Packets.h>
 #include <zero/game/render/Animation.h>
 #include <zero/game/render/Graphics.h>
 
@@ -15,6 +19,7 @@ struct InputState;
 struct PacketDispatcher;
 struct Radar;
 struct ShipController;
+struct SimulationLanes;
 struct Soccer;
 struct SpriteRenderer;
 struct WeaponManager;
@@ -47,8 +52,6 @@ struct PlayerManager {
   Soccer* soccer = nullptr;
   Radar* radar = nullptr;
 
-  struct KDNode* kdtree = nullptr;
-
   u16 player_id = 0;
   bool requesting_attach = false;
 
@@ -72,9 +75,20 @@ struct PlayerManager {
 
   size_t player_count = 0;
   Player players[1024];
+  // Cold player data. This shares the index of the players list.
+  PlayerDetails player_details[1024];
+  // Recently received position packets. This shares the index of the players list.
+  PositionHistory position_history[1024];
 
   // Indirection table to look up player by id quickly
-  u16 player_lookup[65536];
+  PagedIdTable<u16> player_lookup;
+
+  // Spatial index of the players list. This is kept up to date as players move.
+  PlayerGrid grid;
+
+  // Open addressed table of player indices keyed by case-insensitive name. Must be a power of 2.
+  static constexpr size_t kNameIndexSize = 2048;
+  u16 name_index[kNameIndexSize];
 
   PlayerManager(MemoryArena& perm_arena, Connection& connection, PacketDispatcher& dispatcher);
 
@@ -103,26 +117,40 @@ struct PlayerManager {
   Player* GetPlayerById(u16 id, size_t* index = nullptr);
   Player* GetPlayerByName(const char* name);
 
-  inline u16 GetPlayerIndex(u16 id) { return player_lookup[id]; }
+  inline u16 GetPlayerIndex(u16 id) { return player_lookup.Get(id); }
+
+  MemoryFootprint GetMemoryFootprint() const;
+
+  inline PlayerDetails& GetDetails(const Player& player) { return player_details[&player - players]; }
+  inline const char* GetName(const Player& player) { return GetDetails(player).name; }
+  inline PositionHistory& GetPositionHistory(const Player& player) { return position_history[&player - players]; }
 
   void RemovePlayer(Player* player);
 
+  void InsertNameIndex(u16 index);
+  void RemoveNameIndex(u16 index);
+  u16* FindNameIndexSlot(u16 index);
+
   void PushDamage(PlayerId shooter_id, WeaponData weapon_data, int energy, int damage);
 
   void SendPositionPacket();
   void SimulatePlayer(Player& player, float dt, bool extrapolating);
   bool SimulateAxis(Player& player, float dt, int axis, bool extrapolating);
+  // Simulates every player in the list for one step. Remote players are advanced in batches of lanes.
+  void SimulatePlayers(float dt);
+  void SimulateLanes(SimulationLanes& lanes, float dt, u32 tick);
 
   void OnPlayerIdChange(u8* pkt, size_t size);
   void OnPlayerEnter(u8* pkt, size_t size);
   void OnPlayerLeave(u8* pkt, size_t size);
-  void OnPlayerDeath(u8* pkt, size_t size);
+  void OnPlayerDeath(const PlayerDeathPacket& packet);
   void OnPlayerFreqAndShipChange(u8* pkt, size_t size);
   void OnPlayerFrequencyChange(u8* pkt, size_t size);
-  void OnLargePositionPacket(u8* pkt, size_t size);
+  void OnLargePositionPacket(const LargePositionPacket& packet);
   void OnBatchedLargePositionPacket(u8* pkt, size_t size);
-  void OnSmallPositionPacket(u8* pkt, size_t size);
+  void OnSmallPositionPacket(const SmallPositionPacket& packet);
   void OnBatchedSmallPositionPacket(u8* pkt, size_t size);
+  void OnBatchedPositionPacket(u8* pkt, size_t size, const BatchedPositionFormat& format);
   void OnFlagDrop(u8* pkt, size_t size);
   void OnCreateTurretLink(u8* pkt, size_t size);
   void OnDestroyTurretLink(u8* pkt, size_t size);
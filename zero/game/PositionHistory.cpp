@@ -0,0 +1,120 @@
+#include "PositionHistory.h"
+
+namespace zero {
+
+constexpr float kTicksPerSecond = 100.0f;
+
+void PositionHistory::Push(Tick tick, const Vector2f& position, const Vector2f& velocity) {
+  // Drop out of order samples so lookups can assume the history is sorted.
+  if (count > 0 && TICK_GT(Get(0).tick, tick)) return;
+
+  PositionSample& sample = samples[head];
+
+  sample.tick = tick;
+  sample.position = position;
+  sample.velocity = velocity;
+
+  head = (head + 1) & (kCapacity - 1);
+
+  if (count < kCapacity) {
+    ++count;
+  }
+}
+
+Vector2f PositionHistory::GetSmoothedVelocity(size_t sample_count, s32 max_ticks) const {
+  if (count == 0) return Vector2f(0, 0);
+  if (sample_count > count) sample_count = count;
+  if (sample_count == 0) sample_count = 1;
+
+  Tick newest = Get(0).tick;
+  Vector2f total(0, 0);
+  size_t used = 0;
+
+  for (size_t i = 0; i < sample_count; ++i) {
+    const PositionSample& sample = Get(i);
+
+    if (TICK_DIFF(newest, sample.tick) > max_ticks) break;
+
+    total += sample.velocity;
+    ++used;
+  }
+
+  return total * (1.0f / used);
+}
+
+bool PositionHistory::GetAcceleration(Vector2f* acceleration, s32 max_ticks) const {
+  if (count < 2) return false;
+
+  Tick newest = Get(0).tick;
+
+  // Fit velocity = a * t + b with time relative to the newest sample to keep the sums small.
+  float sum_t = 0.0f;
+  float sum_tt = 0.0f;
+  Vector2f sum_v(0, 0);
+  Vector2f sum_tv(0, 0);
+  size_t used = 0;
+
+  for (size_t i = 0; i < count; ++i) {
+    const PositionSample& sample = Get(i);
+    s32 diff = TICK_DIFF(newest, sample.tick);
+
+    if (diff > max_ticks) break;
+
+    float t = -diff / kTicksPerSecond;
+
+    sum_t += t;
+    sum_tt += t * t;
+    sum_v += sample.velocity;
+    sum_tv += sample.velocity * t;
+    ++used;
+  }
+
+  float denominator = used * sum_tt - sum_t * sum_t;
+
+  if (used < 2 || denominator <= 0.0f) return false;
+
+  *acceleration = (sum_tv * (float)used - sum_v * sum_t) * (1.0f / denominator);
+  return true;
+}
+
+bool PositionHistory::GetStateAt(Tick tick, PositionSample* out) const {
+  if (count == 0) return false;
+
+  const PositionSample* newer = &Get(0);
+
+  // Extrapolate forward from the newest sample.
+  if (TICK_GTE(tick, newer->tick)) {
+    float t = TICK_DIFF(tick, newer->tick) / kTicksPerSecond;
+
+    out->tick = tick;
+    out->position = newer->position + newer->velocity * t;
+    out->velocity = newer->velocity;
+    return true;
+  }
+
+  for (size_t i = 1; i < count; ++i) {
+    const PositionSample* older = &Get(i);
+
+    if (TICK_GTE(tick, older->tick)) {
+      s32 span = TICK_DIFF(newer->tick, older->tick);
+      float t = span > 0 ? TICK_DIFF(tick, older->tick) / (float)span : 0.0f;
+
+      out->tick = tick;
+      out->position = older->position + (newer->position - older->position) * t;
+      out->velocity = older->velocity + (newer->velocity - older->velocity) * t;
+      return true;
+    }
+
+    newer = older;
+  }
+
+  // Older than anything stored, so extrapolate backward from the oldest sample.
+  float t = TICK_DIFF(tick, newer->tick) / kTicksPerSecond;
+
+  out->tick = tick;
+  out->position = newer->position + newer->velocity * t;
+  out->velocity = newer->velocity;
+  return true;
+}
+
+}  // namespace zero
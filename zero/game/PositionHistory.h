@@ -0,0 +1,55 @@
+#ifndef ZERO_POSITION_HISTORY_H_
+#define ZERO_POSITION_HISTORY_H_
+
+#include <zero/Math.h>
+#include <zero/Types.h>
+#include <zero/game/Clock.h>
+
+namespace zero {
+
+struct PositionSample {
+  // Local tick that this state was true for on the sender's client.
+  Tick tick;
+  Vector2f position;
+  Vector2f velocity;
+};
+
+// Fixed size ring buffer of the most recent position packets received for one player.
+// Samples are pushed in increasing tick order, so index 0 is always the newest one.
+struct PositionHistory {
+  static constexpr size_t kCapacity = 16;
+
+  PositionSample samples[kCapacity];
+  u8 head;
+  u8 count;
+
+  inline void Clear() {
+    head = 0;
+    count = 0;
+  }
+
+  void Push(Tick tick, const Vector2f& position, const Vector2f& velocity);
+
+  // Index 0 is the newest sample. Index must be less than count.
+  inline const PositionSample& Get(size_t index) const {
+    return samples[(head + kCapacity - 1 - index) & (kCapacity - 1)];
+  }
+
+  // Averages the velocity of the newest samples that are within max_ticks of the newest one.
+  Vector2f GetSmoothedVelocity(size_t sample_count, s32 max_ticks = 100) const;
+
+  // Least squares slope of velocity over the samples within max_ticks of the newest one. Units are tiles per second
+  // squared. Returns false if there isn't enough history to estimate it.
+  bool GetAcceleration(Vector2f* acceleration, s32 max_ticks = 100) const;
+
+  // Reconstructs the player's position and velocity at the requested tick from the received samples.
+  // Ticks between samples are interpolated and ticks outside of the history are extrapolated from the nearest sample.
+  bool GetStateAt(Tick tick, PositionSample* out) const;
+};
+
+static_assert((PositionHistory::kCapacity & (PositionHistory::kCapacity - 1)) == 0,
+              "Position history capacity must be a power of 2");
+
+}  // namespace zero
+
+#endif
@@ -141,8 +141,10 @@ void Radar::RenderPlayer(Camera& ui_camera, SpriteRenderer& renderer, Player& se
   bool visible =
       !(player.togglables & Status_Stealth) || self.togglables & Status_XRadar || player.frequency == ctx.team_freq;
 
-  if (!visible && player.children != nullptr) {
-    AttachInfo* info = player.children;
+  AttachInfo* children = player_manager.GetDetails(player).children;
+
+  if (!visible && children != nullptr) {
+    AttachInfo* info = children;
 
     // Loop through attached children and find any that don't have stealth
     while (info && !visible) {
@@ -187,6 +189,7 @@ IndicatorRenderable Radar::GetIndicator(Player& self, Player& player) {
   IndicatorRenderable renderable;
 
   bool is_me = player.id == ctx.spec_id || (player.id == self.id && self.ship != 8);
+  PlayerDetails& details = player_manager.GetDetails(player);
 
   ColorType color = ColorType::RadarEnemy;
 
@@ -197,7 +200,7 @@ IndicatorRenderable Radar::GetIndicator(Player& self, Player& player) {
       color = ColorType::RadarEnemyTarget;
     }
 
-    if ((player.flags > 0 && player_manager.connection.settings.FlaggerOnRadar) || player.ball_carrier) {
+    if ((details.flags > 0 && player_manager.connection.settings.FlaggerOnRadar) || details.ball_carrier) {
       color = ColorType::RadarEnemyFlag;
     }
   }
@@ -207,7 +210,7 @@ IndicatorRenderable Radar::GetIndicator(Player& self, Player& player) {
   }
 
   renderable.color = color;
-  renderable.dim = (player.flags > 0 || player.ball_carrier) ? Vector2f(3, 3) : Vector2f(2, 2);
+  renderable.dim = (details.flags > 0 || details.ball_carrier) ? Vector2f(3, 3) : Vector2f(2, 2);
 
   return renderable;
 }
@@ -131,7 +131,7 @@ void ShipController::Update(const InputState& input, float dt) {
   if (self->attach_parent == kInvalidPlayerId) {
     u32 thrust = afterburners ? ship_settings.MaximumThrust : ship.thrust;
 
-    if (self->children) {
+    if (player_manager.GetDetails(*self).children) {
       thrust -= ship_settings.TurretThrustPenalty;
 
       if ((s32)thrust < 0) {
@@ -147,7 +147,7 @@ void ShipController::Update(const InputState& input, float dt) {
       thrust = connection.settings.RocketThrust;
     }
 
-    if (self->flags > 0 || (self->ball_carrier && connection.settings.UseFlagger)) {
+    if (IsFlagger(*self)) {
       s64 new_thrust = (s64)thrust + (s64)connection.settings.FlaggerThrustAdjustment;
 
       if (new_thrust < 0) {
@@ -227,7 +227,7 @@ void ShipController::Update(const InputState& input, float dt) {
     speed = ship_speed;
   }
 
-  if (self->children) {
+  if (player_manager.GetDetails(*self).children) {
     speed -= ship_settings.TurretSpeedPenalty;
   }
 
@@ -241,7 +241,7 @@ void ShipController::Update(const InputState& input, float dt) {
     self->repel_time -= dt;
   }
 
-  if (self->flags > 0 || (self->ball_carrier && connection.settings.UseFlagger)) {
+  if (IsFlagger(*self)) {
     s64 new_speed = (s64)speed + (s64)connection.settings.FlaggerSpeedAdjustment;
 
     if (new_speed < 0) {
@@ -314,6 +314,12 @@ void ShipController::Update(const InputState& input, float dt) {
   }
 }
 
+bool ShipController::IsFlagger(Player& self) {
+  PlayerDetails& details = player_manager.GetDetails(self);
+
+  return details.flags > 0 || (details.ball_carrier && player_manager.connection.settings.UseFlagger);
+}
+
 void ShipController::HandleStatusEnergy(Player& self, u32 status, u32 cost, float dt) {
   if (self.togglables & status) {
     float update_cost = (cost / 10.0f) * dt;
@@ -499,7 +505,7 @@ void ShipController::FireWeapons(Player& self, const InputState& input, float dt
   bool can_fastshoot = !afterburners || !ship_settings.DisableFastShooting;
 
   u32 bomb_fire_delay = ship_settings.BombFireDelay;
-  if (self.flags > 0 || (self.ball_carrier && connection.settings.UseFlagger)) {
+  if (IsFlagger(self)) {
     if (connection.settings.FlaggerBombFireDelay > 0) {
       bomb_fire_delay += connection.settings.FlaggerBombFireDelay;
     }
@@ -637,7 +643,7 @@ void ShipController::FireWeapons(Player& self, const InputState& input, float dt
           Vector2f from = self.position;
 
           self.togglables |= Status_Flash;
-          self.warp_anim_t = 0.0f;
+          player_manager.GetDetails(self).warp_anim_t = 0.0f;
           self.position = ship.portal_location;
 
           ship.next_bomb_tick = tick + kRepelDelayTicks;
@@ -653,7 +659,7 @@ void ShipController::FireWeapons(Player& self, const InputState& input, float dt
               Vector2f from = self.position;
 
               self.togglables |= Status_Flash;
-              self.warp_anim_t = 0.0f;
+              player_manager.GetDetails(self).warp_anim_t = 0.0f;
               self.energy = 1.0f;
               self.velocity = Vector2f(0, 0);
 
@@ -687,7 +693,7 @@ void ShipController::FireWeapons(Player& self, const InputState& input, float dt
         self.weapon.level = ship.guns - 1;
 
         if (connection.settings.FlaggerGunUpgrade) {
-          if (self.flags > 0 || (self.ball_carrier && connection.settings.UseFlagger)) {
+          if (IsFlagger(self)) {
             self.weapon.level++;
           }
         }
@@ -709,7 +715,7 @@ void ShipController::FireWeapons(Player& self, const InputState& input, float dt
           energy_cost = (float)(ship_settings.BulletFireEnergy * (self.weapon.level + 1));
         }
 
-        if (self.flags > 0 || (self.ball_carrier && connection.settings.UseFlagger)) {
+        if (IsFlagger(self)) {
           energy_cost = energy_cost * (connection.settings.FlaggerFireCostPercent / 1000.0f);
         }
 
@@ -735,7 +741,7 @@ void ShipController::FireWeapons(Player& self, const InputState& input, float dt
         self.weapon.alternate = 1;
 
         if (connection.settings.FlaggerBombUpgrade) {
-          if (self.flags > 0 || (self.ball_carrier && connection.settings.UseFlagger)) {
+          if (IsFlagger(self)) {
             self.weapon.level++;
           }
         }
@@ -749,7 +755,7 @@ void ShipController::FireWeapons(Player& self, const InputState& input, float dt
         energy_cost =
             (float)(ship_settings.LandmineFireEnergy + ship_settings.LandmineFireEnergyUpgrade * self.weapon.level);
 
-        if (self.flags > 0 || (self.ball_carrier && connection.settings.UseFlagger)) {
+        if (IsFlagger(self)) {
           energy_cost = energy_cost * (connection.settings.FlaggerFireCostPercent / 1000.0f);
         }
 
@@ -776,7 +782,7 @@ void ShipController::FireWeapons(Player& self, const InputState& input, float dt
         self.weapon.type = (ship.capability & ShipCapability_Proximity) ? WeaponType::ProximityBomb : WeaponType::Bomb;
 
         if (connection.settings.FlaggerBombUpgrade) {
-          if (self.flags > 0 || (self.ball_carrier && connection.settings.UseFlagger)) {
+          if (IsFlagger(self)) {
             self.weapon.level++;
           }
         }
@@ -789,7 +795,7 @@ void ShipController::FireWeapons(Player& self, const InputState& input, float dt
 
         energy_cost = (float)(ship_settings.BombFireEnergy + ship_settings.BombFireEnergyUpgrade * self.weapon.level);
 
-        if (self.flags > 0 || (self.ball_carrier && connection.settings.UseFlagger)) {
+        if (IsFlagger(self)) {
           energy_cost = energy_cost * (connection.settings.FlaggerFireCostPercent / 1000.0f);
         }
 
@@ -960,11 +966,13 @@ void ShipController::RenderIndicators(Camera& ui_camera, SpriteRenderer& rendere
     RenderTimedIndicator(ui_camera, renderer, &shield_animation, kShieldIndicatorY, percent, TextColor::Yellow, true);
   }
 
-  if (self->flag_timer > 0) {
+  u16 flag_timer = player_manager.GetDetails(*self).flag_timer;
+
+  if (flag_timer > 0) {
     constexpr float kFlagIndicatorY = 117;
 
     flag_animation.sprite = &Graphics::anim_flag_indicator;
-    float time = self->flag_timer / 100.0f;
+    float time = flag_timer / 100.0f;
     RenderTimedIndicator(ui_camera, renderer, &flag_animation, kFlagIndicatorY, time, TextColor::DarkRed);
   }
 
@@ -1834,7 +1842,7 @@ void ShipController::ResetShip() {
   ship.next_bomb_tick = ship.next_bullet_tick = ship.next_repel_tick = last_tick;
   ship.rocket_end_tick = ship.shutdown_end_tick = ship.fake_antiwarp_end_tick = last_tick;
 
-  self->flag_timer = 0;
+  player_manager.GetDetails(*self).flag_timer = 0;
   self->togglables = 0;
   self->bounty = 0;
   self->repel_time = 0.0f;
@@ -2059,7 +2067,7 @@ void ShipController::OnWeaponHit(Weapon& weapon) {
   TileId tile_id = connection.map.GetTileId((u16)self->position.x, (u16)self->position.y);
 
   if (tile_id == kTileIdSafe) {
-    if (self->flags > 0) {
+    if (player_manager.GetDetails(*self).flags > 0) {
       connection.SendFlagDrop();
     }
     return;
@@ -2078,7 +2086,7 @@ void ShipController::OnWeaponHit(Weapon& weapon) {
     damage = (s32)sqrt(r);
   }
 
-  if (self->flags > 0 || (self->ball_carrier && connection.settings.UseFlagger)) {
+  if (IsFlagger(*self)) {
     damage = (int)(damage * (connection.settings.FlaggerDamagePercent / 1000.0f));
   }
 
@@ -2109,7 +2117,7 @@ void ShipController::OnWeaponHit(Weapon& weapon) {
       connection.SendDeath(weapon.player_id, self->bounty);
 
       self->enter_delay = (connection.settings.EnterDelay / 100.0f) + kAnimDurationShipExplode;
-      self->explode_anim_t = 0.0f;
+      player_manager.GetDetails(*self).explode_anim_t = 0.0f;
       self->energy = 0;
       died = true;
     }
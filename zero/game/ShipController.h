@@ -158,6 +158,8 @@ struct ShipController {
   void AddBulletDelay(u32 tick_amount);
 
   void HandleStatusEnergy(Player& self, u32 status, u32 cost, float dt);
+  // Flag carriers, and ball carriers when UseFlagger is set, get the flagger adjustments.
+  bool IsFlagger(Player& self);
 
   void Render(Camera& ui_camera, Camera& camera, SpriteRenderer& renderer);
   void RenderEnergyDisplay(Camera& ui_camera, SpriteRenderer& renderer);
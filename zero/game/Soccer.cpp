@@ -368,7 +368,7 @@ void Soccer::OnPowerballPosition(u8* pkt, size_t size) {
       auto self = player_manager.GetSelf();
 
       if (self) {
-        self->ball_carrier = false;
+        player_manager.GetDetails(*self).ball_carrier = false;
       }
     }
 
@@ -391,7 +391,7 @@ void Soccer::OnPowerballPosition(u8* pkt, size_t size) {
       carrier = player_manager.GetPlayerById(owner_id);
 
       if (carrier) {
-        carrier->ball_carrier = false;
+        player_manager.GetDetails(*carrier).ball_carrier = false;
         ball->frequency = carrier->frequency;
 
         ship = carrier->ship;
@@ -439,7 +439,7 @@ void Soccer::OnPowerballPosition(u8* pkt, size_t size) {
 
       if (ball->state != BallState::Carried && carrier && carrier->ship != 8) {
         ball->state = BallState::Carried;
-        carrier->ball_carrier = true;
+        player_manager.GetDetails(*carrier).ball_carrier = true;
 
         if (carrier->id == player_manager.player_id) {
           ShipSettings& ship_settings = connection.settings.ShipSettings[carrier->ship];
@@ -458,7 +458,7 @@ void Soccer::OnPowerballPosition(u8* pkt, size_t size) {
         Player* carrier = player_manager.GetPlayerById(owner_id);
 
         if (carrier) {
-          carrier->ball_carrier = false;
+          player_manager.GetDetails(*carrier).ball_carrier = false;
         }
 
         if (ball->carrier_id == carry_id) {
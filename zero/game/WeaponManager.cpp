@@ -2,12 +2,12 @@
 
 #include <assert.h>
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include <zero/game/Buffer.h>
 #include <zero/game/Camera.h>
 #include <zero/game/Clock.h>
 #include <zero/game/GameEvent.h>
-#include <zero/game/KDTree.h>
 #include <zero/game/Logger.h>
 #include <zero/game/Memory.h>
 #include <zero/game/PlayerManager.h>
@@ -21,16 +21,31 @@
 
 namespace zero {
 
-static void OnLargePositionPkt(void* user, u8* pkt, size_t size) {
-  WeaponManager* manager = (WeaponManager*)user;
-
-  manager->OnWeaponPacket(pkt, size);
-}
-
 WeaponManager::WeaponManager(MemoryArena& temp_arena, Connection& connection, PlayerManager& player_manager,
                              PacketDispatcher& dispatcher, AnimationSystem& animation)
     : temp_arena(temp_arena), connection(connection), player_manager(player_manager), animation(animation) {
-  dispatcher.Register(ProtocolS2C::LargePosition, OnLargePositionPkt, this);
+  // Weapons arrive in large position packets, so this shares the decoded packet with the player manager.
+  dispatcher.Subscribe<&WeaponManager::OnWeaponPacket>(this);
+
+  weapons = (Weapon*)AllocateZeroedPages(sizeof(Weapon) * kMaxWeapons);
+
+  if (!weapons) {
+    Log(LogLevel::Error, "Failed to allocate %zu bytes for weapons.", sizeof(Weapon) * kMaxWeapons);
+    exit(1);
+  }
+}
+
+WeaponManager::~WeaponManager() {
+  FreeZeroedPages(weapons, sizeof(Weapon) * kMaxWeapons);
+}
+
+MemoryFootprint WeaponManager::GetMemoryFootprint() const {
+  MemoryFootprint footprint;
+
+  footprint.Add(this, sizeof(*this));
+  footprint.Add(weapons, sizeof(Weapon) * kMaxWeapons);
+
+  return footprint;
 }
 
 void WeaponManager::Update(float dt) {
@@ -238,34 +253,21 @@ WeaponSimulateResult WeaponManager::Simulate(Weapon& weapon, u32 current_tick) {
   // Combine ship radius with weapon radius to find max collision lookup distance.
   max_distance += weapon_radius;
 
-  if (player_manager.kdtree == nullptr) {
-    player_manager.kdtree = BuildPartition(temp_arena, player_manager);
-  }
-
-  KDCollection players = {};
-  KDNode* node = nullptr;
-
   Vector2f weapon_position = weapon.GetPosition();
 
-  if (player_manager.kdtree) {
-    // Range search is L2 distance, so max distance should be multiplied by sqrt(2) to handle box corner cases.
-    constexpr float sqrt2 = 1.5f;
-    // Add some buffer room for rounding errors
-    max_distance += 1.0f;
+  // Add some buffer room for rounding errors
+  max_distance += 1.0f;
 
-    node = player_manager.kdtree->RangeSearch(weapon_position, max_distance * sqrt2);
-  }
+  PlayerQueryFilter filter;
+  filter.exclude_frequency = weapon.frequency;
 
-  if (node) {
-    players = node->Collect(temp_arena);
-  }
+  Vector2f search_extent(max_distance, max_distance);
+  size_t player_count = player_manager.grid.QueryRect(weapon_position - search_extent, weapon_position + search_extent,
+                                                      filter, query_players, ZERO_ARRAY_SIZE(query_players));
 
-  for (size_t i = 0; i < players.count; ++i) {
-    Player* player = players.players[i];
+  for (size_t i = 0; i < player_count; ++i) {
+    Player* player = query_players[i];
 
-    if (player->ship == 8) continue;
-    if (player->frequency == weapon.frequency) continue;
-    if (player->enter_delay > 0) continue;
     if (!player_manager.IsSynchronized(*player, current_tick)) continue;
 
     float radius = connection.settings.ShipSettings[player->ship].GetRadius();
@@ -377,7 +379,7 @@ WeaponSimulateResult WeaponManager::SimulateRepel(Weapon& weapon) {
 
     if (PointInsideBox(rect_min, rect_max, player.position)) {
       if (connection.map.GetTileId(player.position) != kTileIdSafe) {
-        player.last_repel_timestamp = GetCurrentTick();
+        player_manager.GetDetails(player).last_repel_timestamp = GetCurrentTick();
 
         if (player.id == player_manager.player_id) {
           Vector2f direction = Normalize(player.position - weapon.GetPosition());
@@ -694,33 +696,25 @@ u32 WeaponManager::CalculateRngSeed(u32 x, u32 y, u32 vel_x, u32 vel_y, u16 shra
   return shrap_count + weapon_level + x1000 + y1000 + x_vel + y_vel + frequency;
 }
 
-void WeaponManager::OnWeaponPacket(u8* pkt, size_t size) {
-  NetworkBuffer buffer(pkt, size, size);
-
-  buffer.ReadU8();
-
-  u8 direction = buffer.ReadU8();
-  u16 timestamp = buffer.ReadU16();
-  u16 x = buffer.ReadU16();
-  s16 vel_y = (s16)buffer.ReadU16();
-  u16 pid = buffer.ReadU16();
-  s16 vel_x = (s16)buffer.ReadU16();
-  u8 checksum = buffer.ReadU8();
-  buffer.ReadU8();  // Togglables
-  u8 ping = buffer.ReadU8();
-  u16 y = buffer.ReadU16();
-  buffer.ReadU16();  // Bounty
-  u16 weapon_data = buffer.ReadU16();
+void WeaponManager::OnWeaponPacket(const LargePositionPacket& packet) {
+  u16 weapon_data = packet.weapon;
 
   if (weapon_data == 0) return;
 
+  u16 x = packet.x;
+  u16 y = packet.y;
+  s16 vel_x = packet.vel_x;
+  s16 vel_y = packet.vel_y;
+  u16 timestamp = packet.timestamp;
+  u8 ping = packet.ping;
+
   // Player sends out position packet with their timestamp, it takes ping ticks to reach server, server re-timestamps it
   // and sends it to us.
   u32 server_timestamp = ((connection.GetServerTick() & 0x7FFF0000) | timestamp);
   s32 my_ping = (connection.ping + 9) / 10;
   u32 local_timestamp = MAKE_TICK(server_timestamp - connection.time_diff - ping - my_ping);
 
-  Player* player = player_manager.GetPlayerById(pid);
+  Player* player = player_manager.GetPlayerById(packet.player_id);
   if (!player) return;
 
   Vector2f position(x / 16.0f, y / 16.0f);
@@ -951,7 +945,7 @@ WeaponSimulateResult WeaponManager::GenerateWeapon(u16 player_id, WeaponData wea
   if (player->id == player_manager.player_id &&
       (type == WeaponType::Bomb || type == WeaponType::ProximityBomb || type == WeaponType::Thor) &&
       !weapon->data.alternate) {
-    player->bombflash_anim_t = 0.0f;
+    player_manager.GetDetails(*player).bombflash_anim_t = 0.0f;
   }
 
   return result;
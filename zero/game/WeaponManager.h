@@ -2,7 +2,9 @@
 #define ZERO_WEAPONMANAGER_H_
 
 #include <zero/Types.h>
+#include <zero/game/Memory.h>
 #include <zero/game/Player.h>
+#include <zero/game/net/Packets.h>
 #include <zero/game/render/Animation.h>
 
 namespace zero {
@@ -103,13 +105,21 @@ struct WeaponManager {
   u32 next_link_id = 0;
 
   size_t weapon_count = 0;
-  Weapon weapons[kMaxWeapons];
+  // Allocated from zeroed pages so only the pages that have held a weapon are backed by memory.
+  Weapon* weapons;
 
   size_t link_removal_count = 0;
   WeaponLinkRemoval link_removals[2048];
 
+  // Scratch output for player grid queries during weapon collision.
+  Player* query_players[1024];
+
   WeaponManager(MemoryArena& temp_arena, Connection& connection, PlayerManager& player_manager,
                 PacketDispatcher& dispatcher, AnimationSystem& animation);
+  ~WeaponManager();
+
+  WeaponManager(const WeaponManager& other) = delete;
+  WeaponManager& operator=(const WeaponManager& other) = delete;
 
   void Initialize(ShipController* ship_controller, Radar* radar) {
     this->ship_controller = ship_controller;
@@ -122,10 +132,12 @@ struct WeaponManager {
 
   int GetWeaponTotalAliveTime(WeaponType type, bool alternate);
 
+  MemoryFootprint GetMemoryFootprint() const;
+
   bool FireWeapons(Player& player, WeaponData weapon, u32 pos_x, u32 pos_y, s32 vel_x, s32 vel_y, u32 timestamp);
   void ClearWeapons(Player& player);
 
-  void OnWeaponPacket(u8* pkt, size_t size);
+  void OnWeaponPacket(const LargePositionPacket& packet);
 
   void GetMineCounts(Player& player, const Vector2f& check, size_t* player_count, size_t* team_count,
                      bool* has_check_mine);
@@ -1,88 +1,338 @@
 #include "WorkQueue.h"
 
+#include <zero/game/Clock.h>
+
+#include <new>
+
 namespace zero {
 
-WorkQueue::WorkQueue(MemoryArena& arena) : arena(arena), queue_size(0), queue(nullptr), free(nullptr) {}
+WorkQueue::WorkQueue(MemoryArena& arena, size_t worker_count) : arena(arena), completed_count(0) {
+  if (worker_count < 1) worker_count = 1;
+  if (worker_count > kMaxWorkerCount) worker_count = kMaxWorkerCount;
+
+  this->worker_count = worker_count;
+}
 
-void WorkQueue::Submit(WorkDefinition definition, void* user) {
+WorkQueue::~WorkQueue() {
   {
     std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
 
-    Work* work = free;
+  convar.notify_all();
 
-    if (!work) {
-      work = free = memory_arena_push_type(&arena, Work);
-      work->next = nullptr;
-    }
+  for (size_t i = 0; i < running_worker_count; ++i) {
+    workers[i].join();
+  }
+}
 
-    free = free->next;
+WorkHandle WorkQueue::Submit(WorkDefinition definition, void* user, WorkPriority priority) {
+  WorkHandle handle;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Work* work = AllocateWorkLocked();
 
     work->definition = definition;
     work->user = user;
-    work->next = queue;
-    work->valid = true;
+    work->priority = priority;
+    work->submit_us = GetMicrosecondTick();
+
+    if (!definition.run) {
+      ++posted;
+      PushCompletedLocked(work);
+    } else {
+      size_t index = (size_t)priority;
+      WorkQueueStatistics& priority_stats = stats[index];
+
+      ++priority_stats.submitted;
+
+      work->state = WorkState::Queued;
+
+      if (queue_tails[index]) {
+        queue_tails[index]->next = work;
+      } else {
+        queues[index] = work;
+      }
 
-    queue = work;
-    ++queue_size;
+      queue_tails[index] = work;
+      ++queue_size;
+
+      if (++priority_stats.depth > priority_stats.max_depth) {
+        priority_stats.max_depth = priority_stats.depth;
+      }
+
+      // Workers are started the first time they are needed so bots that never submit work don't pay for the threads.
+      if (running_worker_count == 0) {
+        for (size_t i = 0; i < worker_count; ++i) {
+          workers[i] = std::thread(&WorkQueue::Run, this);
+        }
+
+        running_worker_count = worker_count;
+      }
+    }
+
+    handle.work = work;
+    handle.generation = work->generation;
+  }
+
+  if (definition.run) {
+    convar.notify_one();
+  } else if (notify) {
+    notify(notify_user);
   }
 
-  convar.notify_one();
+  return handle;
+}
+
+WorkHandle WorkQueue::Post(WorkComplete complete, void* user) {
+  WorkDefinition definition = {nullptr, complete};
+
+  return Submit(definition, user, WorkPriority::Critical);
+}
+
+bool WorkQueue::Cancel(WorkHandle handle) {
+  if (!handle.work) return false;
+
+  bool completed_now = false;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Work* work = handle.work;
+
+    if (work->generation != handle.generation || work->state == WorkState::Free) return false;
+
+    completed_now = CancelLocked(work);
+  }
+
+  // Queued work is completed here instead of on a worker, so wake the main thread like a worker would.
+  if (completed_now && notify) {
+    notify(notify_user);
+  }
+
+  return true;
 }
 
 void WorkQueue::Clear() {
-  std::lock_guard<std::mutex> lock(mutex);
+  bool completed_now = false;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (size_t i = 0; i < kPriorityCount; ++i) {
+      while (queues[i]) {
+        completed_now |= CancelLocked(queues[i]);
+      }
+    }
+
+    for (Work* work = running; work; work = work->next) {
+      CancelLocked(work);
+    }
+
+    for (Work* work = completed; work; work = work->next) {
+      CancelLocked(work);
+    }
+  }
+
+  if (completed_now && notify) {
+    notify(notify_user);
+  }
+}
+
+size_t WorkQueue::ProcessCompleted() {
+  if (completed_count.load(std::memory_order_acquire) == 0) return 0;
+
+  Work* work = nullptr;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    work = completed;
+    completed = completed_tail = nullptr;
+    completed_count.store(0, std::memory_order_relaxed);
+  }
+
+  size_t count = 0;
 
-  // Push everything to freelist
-  Work* work = queue;
   while (work) {
-    Work* current = work;
-    work = work->next;
-    work->valid = false;
+    Work* next = work->next;
+    u64 wait_us = GetMicrosecondTick() - work->complete_us;
 
-    current->next = free;
-    free = current;
+    if (work->definition.complete) {
+      work->definition.complete(work);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (work->definition.run) {
+      ++stats[(size_t)work->priority].completed;
+    }
+
+    ++completions;
+    completion_wait_total_us += wait_us;
+
+    if (wait_us > completion_wait_max_us) {
+      completion_wait_max_us = wait_us;
+    }
+
+    work->state = WorkState::Free;
+    ++work->generation;
+    work->next = free;
+    free = work;
+
+    work = next;
+    ++count;
+  }
+
+  return count;
+}
+
+Work* WorkQueue::AllocateWorkLocked() {
+  Work* work = free;
+
+  if (work) {
+    free = work->next;
+  } else {
+    work = memory_arena_push_type(&arena, Work);
+    new (work) Work();
+    work->generation = 0;
+  }
+
+  work->cancelled = false;
+  work->next = nullptr;
+
+  return work;
+}
+
+void WorkQueue::PushCompletedLocked(Work* work) {
+  work->state = WorkState::Completed;
+  work->complete_us = GetMicrosecondTick();
+  work->next = nullptr;
+
+  if (completed_tail) {
+    completed_tail->next = work;
+  } else {
+    completed = work;
+  }
+
+  completed_tail = work;
+
+  completed_count.fetch_add(1, std::memory_order_release);
+}
+
+bool WorkQueue::CancelLocked(Work* work) {
+  if (work->cancelled) return false;
+
+  work->cancelled = true;
+
+  if (work->definition.run) {
+    ++stats[(size_t)work->priority].cancelled;
+  }
+
+  if (work->state != WorkState::Queued) return false;
+
+  // Queued work never reaches a worker, so it is unlinked and sent straight to the completion list.
+  size_t index = (size_t)work->priority;
+  Work* prev = nullptr;
+
+  for (Work* current = queues[index]; current; prev = current, current = current->next) {
+    if (current != work) continue;
+
+    if (prev) {
+      prev->next = work->next;
+    } else {
+      queues[index] = work->next;
+    }
+
+    if (queue_tails[index] == work) {
+      queue_tails[index] = prev;
+    }
+
+    break;
   }
 
-  queue = nullptr;
-  queue_size = 0;
+  --queue_size;
+  --stats[index].depth;
+
+  PushCompletedLocked(work);
+
+  return true;
 }
 
-void Worker::Run() {
+void WorkQueue::Run() {
+  std::unique_lock<std::mutex> lock(mutex);
+
   while (true) {
+    convar.wait(lock, [this] { return stopping || queue_size > 0; });
+
+    if (stopping) break;
+
     Work* work = nullptr;
 
-    {
-      std::unique_lock<std::mutex> lock(queue.mutex);
+    for (size_t i = 0; i < kPriorityCount; ++i) {
+      if (queues[i]) {
+        work = queues[i];
+        queues[i] = work->next;
+
+        if (!queues[i]) {
+          queue_tails[i] = nullptr;
+        }
+
+        break;
+      }
+    }
+
+    WorkQueueStatistics& priority_stats = stats[(size_t)work->priority];
+
+    --queue_size;
+    --priority_stats.depth;
 
-      queue.convar.wait(lock, [this] { return this->queue.queue_size > 0; });
+    u64 start_us = GetMicrosecondTick();
+    u64 wait_us = start_us - work->submit_us;
 
-      work = queue.queue;
-      if (!work) continue;
+    ++priority_stats.started;
+    priority_stats.wait_total_us += wait_us;
 
-      // Pop work off queue
-      queue.queue = work->next;
-      --queue.queue_size;
+    if (wait_us > priority_stats.wait_max_us) {
+      priority_stats.wait_max_us = wait_us;
     }
 
+    work->state = WorkState::Running;
+    work->next = running;
+    running = work;
+
+    lock.unlock();
+
     work->definition.run(work);
 
-    if (work->valid) {
-      work->definition.complete(work);
+    u64 end_us = GetMicrosecondTick();
+
+    lock.lock();
+
+    priority_stats.run_total_us += end_us - start_us;
+
+    Work* prev = nullptr;
+
+    for (Work* current = running; current != work; current = current->next) {
+      prev = current;
     }
 
-    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (prev) {
+      prev->next = work->next;
+    } else {
+      running = work->next;
+    }
 
-    // Push work to free list
-    work->next = queue.free;
-    work->valid = false;
-    queue.free = work;
-  }
-}
+    PushCompletedLocked(work);
 
-void Worker::Launch() {
-  thread = std::thread(&Worker::Run, this);
+    if (notify) {
+      lock.unlock();
+      notify(notify_user);
+      lock.lock();
+    }
+  }
 }
 
-Worker::Worker(WorkQueue& queue) : queue(queue) {}
-
 }  // namespace zero
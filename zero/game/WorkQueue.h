@@ -13,45 +13,136 @@ namespace zero {
 
 typedef void (*WorkRun)(struct Work* work);
 typedef void (*WorkComplete)(struct Work* work);
+typedef void (*WorkNotify)(void* user);
+
+// Workers always take from the highest priority that has work queued. Work within a priority runs in submit order.
+enum class WorkPriority : u8 {
+  // Work that something is waiting on to respond to the server, such as security.
+  Critical,
+  Normal,
+  // Precomputation that can finish whenever there's time.
+  Background,
+
+  Count
+};
+
+enum class WorkState : u8 { Free, Queued, Running, Completed };
 
 struct WorkDefinition {
+  // Called on a worker thread. Can be null for work that only needs its completion run on the main thread.
   WorkRun run;
+  // Called on the main thread from ProcessCompleted. This is always called once for submitted work, even if it was
+  // cancelled, so it can release anything owned by the work. Check cancelled before using any results.
   WorkComplete complete;
 };
 
 struct Work {
   WorkDefinition definition;
   void* user;
-  bool valid;
+  WorkPriority priority;
+  WorkState state;
+
+  // Set when the work is cancelled. Long running work can check this to stop early.
+  std::atomic<bool> cancelled;
+
+  // Incremented each time the work is freed so stale handles can't cancel reused work.
+  u32 generation;
+
+  u64 submit_us;
+  u64 complete_us;
 
   Work* next;
 };
 
+struct WorkHandle {
+  Work* work = nullptr;
+  u32 generation = 0;
+};
+
+struct WorkQueueStatistics {
+  u64 submitted = 0;
+  u64 started = 0;
+  u64 completed = 0;
+  u64 cancelled = 0;
+
+  // Time spent waiting in the queue before a worker started running the work.
+  u64 wait_total_us = 0;
+  u64 wait_max_us = 0;
+  u64 run_total_us = 0;
+
+  u32 depth = 0;
+  u32 max_depth = 0;
+};
+
+// Fixed pool of worker threads that run submitted work by priority.
+// Completion callbacks are queued up and run on the main thread by ProcessCompleted, so they can touch game state
+// without any locking. Workers are only launched when the first work that needs them is submitted.
 struct WorkQueue {
+  static constexpr size_t kMaxWorkerCount = 16;
+  static constexpr size_t kPriorityCount = (size_t)WorkPriority::Count;
+
   MemoryArena& arena;
-  std::atomic<int> queue_size;
-  Work* queue;
 
-  Work* free;
+  std::mutex mutex;
+  std::condition_variable convar;
 
-  WorkQueue(MemoryArena& arena);
+  Work* queues[kPriorityCount] = {};
+  Work* queue_tails[kPriorityCount] = {};
+  size_t queue_size = 0;
 
-  void Submit(WorkDefinition definition, void* user);
-  void Clear();
+  // Work that a worker is running, so it can be flagged when the queue is cleared.
+  Work* running = nullptr;
 
-  std::condition_variable convar;
-  std::mutex mutex;
-};
+  // Work that finished running and is waiting for the main thread to call its completion.
+  Work* completed = nullptr;
+  Work* completed_tail = nullptr;
+  std::atomic<u32> completed_count;
+
+  Work* free = nullptr;
+
+  size_t worker_count;
+  size_t running_worker_count = 0;
+  std::thread workers[kMaxWorkerCount];
+  bool stopping = false;
 
-struct Worker {
-  WorkQueue& queue;
-  std::thread thread;
+  // Only counts work that runs on a worker. Posted completions are counted separately.
+  WorkQueueStatistics stats[kPriorityCount];
+  u64 posted = 0;
 
-  Worker(WorkQueue& queue);
+  // Time between work finishing, or being posted, and its completion being run on the main thread.
+  u64 completions = 0;
+  u64 completion_wait_total_us = 0;
+  u64 completion_wait_max_us = 0;
 
-  void Launch();
+  // Called after work completes so a blocked main loop can wake up to run the completion.
+  // Must be set before any work is submitted.
+  WorkNotify notify = nullptr;
+  void* notify_user = nullptr;
+
+  WorkQueue(MemoryArena& arena, size_t worker_count);
+  ~WorkQueue();
+
+  WorkHandle Submit(WorkDefinition definition, void* user, WorkPriority priority = WorkPriority::Normal);
+
+  // Queues a completion to run on the main thread without running anything on a worker. This lets other threads hand
+  // results back to the main thread.
+  WorkHandle Post(WorkComplete complete, void* user);
+
+  // Work that hasn't started is skipped and work that is running is flagged so it can stop early. The completion is
+  // still called in both cases. Returns false if the handle is stale because the completion already ran.
+  bool Cancel(WorkHandle handle);
+  // Cancels everything that is queued, running or waiting for completion.
+  void Clear();
+
+  // Runs the completions for any finished work. Must be called from the main thread.
+  size_t ProcessCompleted();
 
  private:
+  Work* AllocateWorkLocked();
+  void PushCompletedLocked(Work* work);
+  // Returns true if the work was queued and moved straight to the completion list.
+  bool CancelLocked(Work* work);
+
   void Run();
 };
 
@@ -4,14 +4,7 @@
 #include <WS2tcpip.h>
 #include <Windows.h>
 #else
-#include <arpa/inet.h>
-#include <fcntl.h>
-#include <netinet/in.h>
-#include <netinet/ip.h>
-#include <sys/socket.h>
-#include <unistd.h>
-#define WSAEWOULDBLOCK EWOULDBLOCK
-#define closesocket close
+#include <errno.h>
 #endif
 
 #include <assert.h>
@@ -46,9 +39,6 @@ enum {
                              ClientFeature_Lvz | ClientFeature_Redirect),
 };
 
-extern const char* kPlayerName;
-extern const char* kPlayerPassword;
-
 extern const char* kSecurityServiceIp;
 const u16 kSecurityServicePort = 8085;
 
@@ -99,27 +89,28 @@ Connection::Connection(MemoryArena& perm_arena, MemoryArena& temp_arena, WorkQue
     : perm_arena(perm_arena),
       temp_arena(temp_arena),
       dispatcher(dispatcher),
-      remote_addr(),
-      security_solver(work_queue, kSecurityServiceIp, kSecurityServicePort),
+      security_solver(perm_arena, work_queue, kSecurityServiceIp, kSecurityServicePort),
       requester(perm_arena, temp_arena, *this, dispatcher),
       packet_sequencer(perm_arena, temp_arena),
       buffer(perm_arena, kMaxPacketSize),
       last_sync_tick(GetCurrentTick()) {
   map_arena = perm_arena.CreateArena(Megabytes(16));
   send_arena = perm_arena.CreateArena(Megabytes(2));
+  map_arena.name = "map";
+  send_arena.name = "send";
 }
 
 Connection::TickResult Connection::Tick() {
   constexpr s32 kSyncDelay = 500;
   constexpr s32 kTimeout = 3000;
 
-  sockaddr_in addr = {};
-  addr.sin_family = remote_addr.family;
-  addr.sin_port = remote_addr.port;
-  addr.sin_addr.s_addr = remote_addr.addr;
-
   zero::Tick current_tick = GetCurrentTick();
 
+  socket_stats.tick_recv_calls = (u32)(socket_stats.recv_calls - socket_stats.tick_start_recv_calls);
+  socket_stats.tick_send_calls = (u32)(socket_stats.send_calls - socket_stats.tick_start_send_calls);
+  socket_stats.tick_start_recv_calls = socket_stats.recv_calls;
+  socket_stats.tick_start_send_calls = socket_stats.send_calls;
+
   constexpr u32 kConnectTimeout = 500;
   if (login_state == Connection::LoginState::EncryptionRequested &&
       TICK_DIFF(current_tick, connect_tick) >= kConnectTimeout) {
@@ -173,21 +164,20 @@ Connection::TickResult Connection::Tick() {
     // reset.
     buffer.Reset();
 
-    socklen_t socklen = sizeof(addr);
-    int bytes_recv = recvfrom(fd, (char*)buffer.read, kMaxPacketSize, 0, (sockaddr*)&addr, &socklen);
+    u8* pkt = (u8*)buffer.data;
+    int bytes_recv = ReceiveDatagram(&pkt);
 
     if (bytes_recv == 0) {
       this->connected = false;
       return TickResult::ConnectionClosed;
+    } else if (bytes_recv == kTransportWouldBlock) {
+      // Send anything that was generated while processing, such as acks and resends, in as few datagrams as
+      // possible.
+      FlushOutbound();
+      return TickResult::Success;
     } else if (bytes_recv < 0) {
-      int err = GetLastError();
-
-      if (err == WSAEWOULDBLOCK) {
-        return TickResult::Success;
-      }
-
       if (login_state != LoginState::Quit) {
-        Log(LogLevel::Error, "Unexpected socket error: %d", err);
+        Log(LogLevel::Error, "Unexpected socket error: %d", GetLastError());
         bool in_game = login_state == LoginState::Complete;
 
         this->Disconnect();
@@ -203,8 +193,8 @@ Connection::TickResult Connection::Tick() {
       ++packets_received;
       buffer.write += bytes_recv;
 
-      u8* pkt = (u8*)buffer.data;
       size_t size = bytes_recv;
+      u64 decrypt_start_us = net_stats.timing_enabled ? GetStatisticsMicroseconds() : 0;
 
       if (encrypt_method == EncryptMethod::Continuum && (encrypt.key1 != 0 || encrypt.key2 != 0)) {
         size = encrypt.Decrypt(pkt, size);
@@ -212,6 +202,10 @@ Connection::TickResult Connection::Tick() {
         size = vie_encrypt.Decrypt(pkt, size);
       }
 
+      if (net_stats.timing_enabled && size > 0) {
+        net_stats.GetInbound(pkt, size)->crypt_us += GetStatisticsMicroseconds() - decrypt_start_us;
+      }
+
 #ifdef PACKET_SHEDDING  // packet shedding for testing sequencer
       srand(GetCurrentTick());
 
@@ -220,6 +214,10 @@ Connection::TickResult Connection::Tick() {
       if (1) {
 #endif
         if (size > 0) {
+          if (capture) {
+            capture->Write(GetCurrentTick(), pkt, size);
+          }
+
           ProcessPacket(pkt, size);
         }
 
@@ -235,6 +233,23 @@ Connection::TickResult Connection::Tick() {
   return TickResult::Success;
 }
 
+int Connection::ReceiveDatagram(u8** pkt) {
+  if (batch_socket_io) {
+    if (recv_batch.read >= recv_batch.count) {
+      int count = transport->ReceiveBatch(recv_batch);
+
+      if (count <= 0) return count;
+    }
+
+    size_t index = recv_batch.read++;
+
+    *pkt = recv_batch.data[index];
+    return (int)recv_batch.sizes[index];
+  }
+
+  return transport->Receive(*pkt, kMaxPacketSize);
+}
+
 void Connection::SendPassword(bool registration) {
   u8 data[kMaxPacketSize];
   NetworkBuffer buffer(data, kMaxPacketSize);
@@ -253,8 +268,8 @@ void Connection::SendPassword(bool registration) {
   u32 machine_id = platform.GetMachineId();
   u16 timezone = (u16)platform.GetTimeZoneBias();
 
-  strcpy(name, kPlayerName);
-  strcpy(password, kPlayerPassword);
+  strncpy(name, login_name, sizeof(name) - 1);
+  strncpy(password, login_password, sizeof(password) - 1);
 
   buffer.WriteU8(packet_type);                 // Continuum password packet
   buffer.WriteU8(registration ? 0x01 : 0x00);  // New user
@@ -281,13 +296,10 @@ void Connection::SendPassword(bool registration) {
   buffer.WriteU32(0x00);
   buffer.WriteU32(0x00);
 
-  u32 remote_ip = (u32)remote_addr.addr;
+  u32 remote_ip = transport ? transport->GetRemoteAddress() : 0;
   buffer.WriteU32(remote_ip);
 
-  struct sockaddr_in addr;
-  socklen_t addr_size = sizeof(addr);
-  getsockname(fd, (sockaddr*)&addr, &addr_size);
-  u16 port = htons(addr.sin_port);
+  u16 port = transport ? transport->GetLocalPort() : 0;
   buffer.WriteU32(port);
   buffer.WriteU32(0x00);
 
@@ -307,6 +319,8 @@ void Connection::SendPassword(bool registration) {
 void Connection::ProcessPacket(u8* pkt, size_t size) {
   NetworkBuffer buffer(pkt, size, size);
 
+  net_stats.RecordInbound(pkt, size);
+
   u8 type_byte = buffer.ReadU8();
 
   last_packet_tick = GetCurrentTick();
@@ -370,6 +384,8 @@ void Connection::ProcessPacket(u8* pkt, size_t size) {
         s32 current_tick = GetCurrentTick();
         s32 rtt = current_tick - sent_timestamp;
 
+        packet_sequencer.rtt.AddSample((float)rtt);
+
         s32 current_ping = (u32)((rtt / 2.0f) * 10.0f);
         s32 current_time_diff = ((rtt * 3) / 5) + server_timestamp - current_tick;
 
@@ -452,10 +468,17 @@ void Connection::ProcessPacket(u8* pkt, size_t size) {
 
         encrypt.key1 = key1;
         encrypt.key2 = key2;
-        encrypt.state = ContinuumEncrypt::State::Expanding;
         encrypt.key_send_tick = GetCurrentTick();
         encrypt.resend_count = 0;
 
+        if (offline) {
+          // Captured packets are already decrypted, so there's nothing to expand.
+          encrypt.state = ContinuumEncrypt::State::Initialized;
+          break;
+        }
+
+        encrypt.state = ContinuumEncrypt::State::Expanding;
+
         security_solver.ExpandKey(key2, [this](u32* table) {
           if (table) {
             Log(LogLevel::Debug, "Successfully expanded continuum encryption keys.");
@@ -469,6 +492,8 @@ void Connection::ProcessPacket(u8* pkt, size_t size) {
       case ProtocolCore::ContinuumKeyExpansionRequest: {
         u32 seed = buffer.ReadU32();
 
+        if (offline) break;
+
         security_solver.ExpandKey(seed, [seed, this](u32* table) {
           if (table) {
             u8 data[kMaxPacketSize];
@@ -599,6 +624,7 @@ void Connection::ProcessPacket(u8* pkt, size_t size) {
         short old_door_mode = this->settings.DoorMode;
 
         this->settings = *settings;
+        this->settings_crc = crc32((u8*)settings, sizeof(ArenaSettings));
 
         if (settings->DoorMode >= 0) {
           // Force update
@@ -754,6 +780,7 @@ void Connection::SendArenaLogin(u8 ship, u16 audio, u16 xres, u16 yres, u16 aren
   packet_sequencer.SendReliableMessage(*this, write.read, write.GetSize());
   login_state = LoginState::ArenaLogin;
   map.checksum = 0;
+  map.loaded_checksum = 0;
   memset(&security, 0, sizeof(security));
 }
 
@@ -766,6 +793,7 @@ void Connection::OnDownloadComplete(struct FileRequest* request, u8* data) {
     return;
   }
 
+  map.loaded_checksum = map.checksum;
   map.door_rng.Seed(security.door_seed);
   map.last_seed_tick = security.timestamp - time_diff;
 
@@ -800,35 +828,44 @@ void Connection::SendSyncTimeRequestPacket(bool reliable) {
 }
 
 void Connection::SendSecurityPacket() {
+  // The local checksums only depend on the key, so they are computed here instead of in the solver callback. That
+  // keeps the checksum cache on the main thread.
+  u32 settings_checksum = checksum_cache.GetSettingsChecksum(settings, settings_crc, security.checksum_key);
+  u32 map_checksum = checksum_cache.GetMapChecksum(map, security.checksum_key);
+
   if (encrypt_method != EncryptMethod::Continuum) {
-    u32 settings_checksum = SettingsChecksum(security.checksum_key, settings);
-    u32 map_checksum = map.GetChecksum(security.checksum_key);
     u32 exe_checksum = VieChecksum(security.checksum_key);
 
     Log(LogLevel::Debug, "Sending security packet with checksum seed %08X", security.checksum_key);
-    SendSecurity(settings_checksum, exe_checksum, map_checksum);
+    SendSecurity(settings_checksum, exe_checksum, map_checksum, 0);
+    return;
+  }
+
+  u32 map_crc = checksum_cache.GetMapCrc(map);
+
+  if (offline) {
+    // The exe checksum requires the network solver, so only compute the local checksums when replaying.
+    SendSecurity(settings_checksum, 0, map_checksum, map_crc);
   } else {
     u32 request_key = security.checksum_key;
 
-    security_solver.GetChecksum(security.checksum_key, [this, request_key](u32* checksum) {
-      // The checksum key can be different from the requested key if the player changes arena, so just discard this.
-      if (request_key != security.checksum_key) return;
+    security_solver.GetChecksum(
+        security.checksum_key, [this, request_key, settings_checksum, map_checksum, map_crc](u32* checksum) {
+          // The checksum key can be different from the requested key if the player changes arena, so just discard this.
+          if (request_key != security.checksum_key) return;
 
-      if (checksum) {
-        u32 settings_checksum = SettingsChecksum(security.checksum_key, settings);
-        u32 map_checksum = map.GetChecksum(security.checksum_key);
+          if (checksum) {
+            Log(LogLevel::Debug, "Sending security packet with checksum seed %08X", request_key);
 
-        Log(LogLevel::Debug, "Sending security packet with checksum seed %08X", request_key);
-
-        SendSecurity(settings_checksum, *checksum, map_checksum);
-      } else {
-        Log(LogLevel::Error, "Failed to load checksum from network solver.");
-      }
-    });
+            SendSecurity(settings_checksum, *checksum, map_checksum, map_crc);
+          } else {
+            Log(LogLevel::Error, "Failed to load checksum from network solver.");
+          }
+        });
   }
 }
 
-void Connection::SendSecurity(u32 settings_checksum, u32 exe_checksum, u32 map_checksum) {
+void Connection::SendSecurity(u32 settings_checksum, u32 exe_checksum, u32 map_checksum, u32 map_crc) {
   u8 data[kMaxPacketSize];
   NetworkBuffer buffer(data, kMaxPacketSize);
 
@@ -852,10 +889,7 @@ void Connection::SendSecurity(u32 settings_checksum, u32 exe_checksum, u32 map_c
 
   if (encrypt_method == EncryptMethod::Continuum) {
     buffer.WriteU16(0);  // Timer drift
-
-    u32 map_crc32 = crc32_map(map.tiles, 1024 * 1024);
-
-    buffer.WriteU32(map_crc32);
+    buffer.WriteU32(map_crc);
   }
 
   packet_sequencer.SendReliableMessage(*this, buffer.data, buffer.GetSize());
@@ -1068,19 +1102,20 @@ void Connection::SendCrownExpire() {
 }
 
 ConnectResult Connection::Connect(const char* ip, u16 port) {
-  inet_pton(AF_INET, ip, &this->remote_addr.addr);
+  UdpTransport* udp = memory_arena_construct_type(&perm_arena, UdpTransport);
+  ConnectResult result = udp->Open(ip, port);
 
-  this->remote_addr.port = htons(port);
-  this->remote_addr.family = AF_INET;
-
-  this->fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-
-  if (this->fd < 0) {
-    return ConnectResult::ErrorSocket;
+  if (result != ConnectResult::Success) {
+    return result;
   }
 
+  return Connect(*udp);
+}
+
+ConnectResult Connection::Connect(Transport& transport) {
+  this->transport = &transport;
+  this->transport->stats = &socket_stats;
   this->connected = true;
-  this->SetBlocking(false);
 
   this->connect_tick = GetCurrentTick();
   this->last_packet_tick = GetCurrentTick();
@@ -1140,38 +1175,137 @@ size_t Connection::Send(u8* data, size_t size) {
 
   std::lock_guard<std::mutex> lock(send_mutex);
 
+  net_stats.RecordOutbound(data, size);
+
+  // Clusters are only understood once the encryption handshake is complete. Don't nest the ack clusters either.
+  bool encrypted = (encrypt_method == EncryptMethod::Continuum && encrypt.IsInitialized()) ||
+                   (encrypt_method == EncryptMethod::Subspace && vie_encrypt.session_key != 0);
+  bool is_cluster = size >= 2 && data[0] == 0x00 && data[1] == 0x0E;
+
+  if (cluster_outbound && encrypted && !is_cluster && size <= OutboundCluster::kMaxClusteredSize) {
+    if (!outbound_cluster.CanFit(size)) {
+      FlushOutboundLocked();
+    }
+
+    outbound_cluster.Push(data, size);
+    return size;
+  }
+
+  // Keep the packets in order by sending anything that was queued before this.
+  SubmitClusterLocked();
+
+  return SendEncrypted(data, size);
+}
+
+void Connection::FlushOutbound() {
+  std::lock_guard<std::mutex> lock(send_mutex);
+
+  FlushOutboundLocked();
+}
+
+void Connection::FlushOutboundLocked() {
+  SubmitClusterLocked();
+  FlushSendBatchLocked();
+}
+
+void Connection::SubmitClusterLocked() {
+  if (outbound_cluster.count == 0) return;
+
+  if (outbound_cluster.count == 1) {
+    // Send a lone packet directly instead of wrapping it in a cluster.
+    u8* packet = outbound_cluster.data + OutboundCluster::kHeaderSize;
+    SendEncrypted(packet + 1, packet[0]);
+  } else {
+    outbound_cluster.data[0] = 0x00;
+    outbound_cluster.data[1] = 0x0E;
+
+    packets_clustered += (u32)outbound_cluster.count;
+    SendEncrypted(outbound_cluster.data, outbound_cluster.size);
+  }
+
+  outbound_cluster.Clear();
+}
+
+size_t Connection::SendEncrypted(u8* data, size_t size) {
   send_arena.Reset();
 
+  u8* batch_dest = nullptr;
+
+  if (batch_socket_io) {
+    if (send_batch.count >= DatagramBatch::kCapacity) {
+      FlushSendBatchLocked();
+    }
+
+    // Write the datagram directly into the batch so it can be sent with the rest when the connection is flushed.
+    batch_dest = send_batch.data[send_batch.count];
+  }
+
+  PacketTypeStatistics* type_stats = net_stats.timing_enabled ? net_stats.GetOutbound(data, size) : nullptr;
+  u64 encrypt_start_us = type_stats ? GetStatisticsMicroseconds() : 0;
+
   if (encrypt_method == EncryptMethod::Continuum && (encrypt.key1 || encrypt.key2)) {
     // Allocate enough space for both the crc and possibly the crc escape
-    u8* dest = send_arena.Allocate(size + 2);
+    u8* dest = batch_dest ? batch_dest : send_arena.Allocate(size + 2);
     size = encrypt.Encrypt(data, dest, size);
     data = dest;
   } else if (encrypt_method == EncryptMethod::Subspace) {
-    u8* dest = send_arena.Allocate(size);
+    u8* dest = batch_dest ? batch_dest : send_arena.Allocate(size);
     size = vie_encrypt.Encrypt(data, dest, size);
     data = dest;
+  } else if (batch_dest) {
+    memcpy(batch_dest, data, size);
+  }
+
+  if (type_stats) {
+    type_stats->crypt_us += GetStatisticsMicroseconds() - encrypt_start_us;
+  }
+
+  if (batch_dest) {
+    send_batch.sizes[send_batch.count++] = size;
+    return size;
   }
 
   return SendRaw(data, size);
 }
 
-size_t Connection::SendRaw(u8* data, size_t size) {
-  sockaddr_in addr = {};
+void Connection::FlushSendBatchLocked() {
+  if (send_batch.count == 0) return;
+
+  if (offline) {
+    packets_sent += (u32)send_batch.count;
+    socket_stats.datagrams_sent += send_batch.count;
+    send_batch.Clear();
+    return;
+  }
+
+  size_t count = send_batch.count;
 
-  addr.sin_family = remote_addr.family;
-  addr.sin_port = remote_addr.port;
-  addr.sin_addr.s_addr = remote_addr.addr;
+  if (!transport->SendBatch(send_batch)) {
+    send_batch.Clear();
+    Disconnect();
+    return;
+  }
+
+  packets_sent += (u32)count;
+
+  send_batch.Clear();
+}
+
+size_t Connection::SendRaw(u8* data, size_t size) {
+  if (offline) {
+    ++packets_sent;
+    ++socket_stats.datagrams_sent;
+    return size;
+  }
 
-  int bytes = sendto(this->fd, (const char*)data, (int)size, 0, (sockaddr*)&addr, sizeof(addr));
   ++packets_sent;
 
-  if (bytes <= 0) {
+  if (!transport->Send(data, size)) {
     Disconnect();
     return 0;
   }
 
-  return bytes;
+  return size;
 }
 
 void Connection::SendDisconnect() {
@@ -1183,6 +1317,7 @@ void Connection::SendDisconnect() {
 #pragma pack(pop)
 
   Send((u8*)&disconnect, sizeof(u16));
+  FlushOutbound();
 }
 
 void Connection::SendEncryptionRequest(EncryptMethod method) {
@@ -1255,38 +1390,14 @@ void Connection::SendFrequencyChange(u16 freq) {
 }
 
 void Connection::Disconnect() {
+  outbound_cluster.Clear();
+  send_batch.Clear();
+  recv_batch.Clear();
   login_state = LoginState::Quit;
-  closesocket(this->fd);
+  if (transport) {
+    transport->Close();
+  }
   this->connected = false;
 }
 
-void Connection::SetBlocking(bool blocking) {
-  unsigned long mode = blocking ? 0 : 1;
-
-#ifdef _WIN32
-  ioctlsocket(this->fd, FIONBIO, &mode);
-#else
-  int flags = fcntl(this->fd, F_GETFL, 0);
-
-  flags = blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
-
-  fcntl(this->fd, F_SETFL, flags);
-#endif
-}
-
-#ifdef _WIN32
-struct NetworkInitializer {
-  NetworkInitializer() {
-    WSADATA wsa;
-
-    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
-      Log(LogLevel::Error, "Error WSAStartup: %d", WSAGetLastError());
-      exit(1);
-    }
-  }
-};
-
-NetworkInitializer _net_init;
-#endif
-
 }  // namespace zero
@@ -10,26 +10,22 @@
 #include <zero/game/Memory.h>
 #include <zero/game/Player.h>
 #include <zero/game/Settings.h>
+#include <zero/game/net/NetworkStatistics.h>
+#include <zero/game/net/PacketCapture.h>
 #include <zero/game/net/PacketDispatcher.h>
 #include <zero/game/net/PacketSequencer.h>
 #include <zero/game/net/Socket.h>
+#include <zero/game/net/UdpTransport.h>
 #include <zero/game/net/security/Crypt.h>
+#include <zero/game/net/security/SecurityCache.h>
 #include <zero/game/net/security/SecuritySolver.h>
 
+#include <string.h>
+
 #include <mutex>
 
 namespace zero {
 
-enum class ConnectResult { Success, ErrorSocket, ErrorAddrInfo, ErrorConnect };
-
-struct RemoteAddress {
-  long addr;
-  u16 port;
-  u16 family;
-
-  RemoteAddress() : addr(0), port(0), family(0) {}
-};
-
 struct Security {
   u32 prize_seed = 0;
   u32 door_seed = 0;
@@ -49,6 +45,31 @@ struct PingStatistics {
   s32 ping_current;
 };
 
+// Small outbound packets are appended to a 0x00 0x0E cluster so they go out in one datagram when flushed.
+struct OutboundCluster {
+  // Each packet in a cluster is prefixed with a one byte length.
+  static constexpr size_t kMaxClusteredSize = 255;
+  static constexpr size_t kHeaderSize = 2;
+
+  u8 data[kMaxPacketSize];
+  size_t size = kHeaderSize;
+  size_t count = 0;
+
+  inline bool CanFit(size_t packet_size) const { return size + 1 + packet_size <= kMaxPacketSize; }
+
+  inline void Push(u8* packet, size_t packet_size) {
+    data[size++] = (u8)packet_size;
+    memcpy(data + size, packet, packet_size);
+    size += packet_size;
+    ++count;
+  }
+
+  inline void Clear() {
+    size = kHeaderSize;
+    count = 0;
+  }
+};
+
 struct Connection {
   enum class TickResult { Success, ConnectionClosed, ConnectionError };
   enum class LoginState {
@@ -71,10 +92,11 @@ struct Connection {
   MemoryArena send_arena;
   PacketDispatcher& dispatcher;
 
-  SocketType fd = -1;
-  RemoteAddress remote_addr;
+  Transport* transport = nullptr;
   bool connected = false;
   SecuritySolver security_solver;
+  // Kept across reconnects so rejoining the same map and settings doesn't recompute anything.
+  SecurityChecksumCache checksum_cache;
   EncryptMethod encrypt_method = EncryptMethod::Continuum;
   ContinuumEncrypt encrypt;
   VieEncrypt vie_encrypt;
@@ -82,18 +104,40 @@ struct Connection {
   PacketSequencer packet_sequencer;
   NetworkBuffer buffer;
   std::mutex send_mutex;
+  OutboundCluster outbound_cluster;
+  // Coalesce small packets into clusters that are sent when the connection is flushed.
+  bool cluster_outbound = true;
+  // Receive and send datagrams in batches, which use recvmmsg and sendmmsg with the UDP transport when they are
+  // available. Outbound datagrams are held until the connection is flushed.
+  bool batch_socket_io = ZERO_BATCHED_SOCKET_IO;
+  DatagramBatch recv_batch;
+  DatagramBatch send_batch;
+  SocketStatistics socket_stats;
+  NetworkStatistics net_stats = {};
+  // Every decrypted inbound packet is written here when set.
+  PacketCaptureWriter* capture = nullptr;
+  // Offline connections are driven by a capture replay. Nothing is sent and the security solver is never used.
+  bool offline = false;
   bool joined_arena = false;
 
+  // Sent in the password packet. Owned by whatever created the connection.
+  const char* login_name = "ZeroBot";
+  const char* login_password = "none";
+
   Vector2f view_dim;
 
   Map map;
   Security security;
   ArenaSettings settings = {};
+  // Identifies the current settings in the checksum cache.
+  u32 settings_crc = 0;
 
   u32 connect_tick = 0;
   u32 login_tick = 0;
   u32 packets_sent = 0;
   u32 packets_received = 0;
+  // Number of packets that were sent inside of a cluster instead of their own datagram.
+  u32 packets_clustered = 0;
   u32 weapons_received = 0;
   // GetCurrentTick() + time_diff = Server tick
   s32 time_diff = 0;
@@ -113,9 +157,11 @@ struct Connection {
 
   Connection(MemoryArena& perm_arena, MemoryArena& temp_arena, WorkQueue& work_queue, PacketDispatcher& dispatcher);
 
+  // Opens a UDP transport to the server.
   ConnectResult Connect(const char* ip, u16 port);
+  // Uses an existing transport, such as one end of a loopback link. The transport must outlive the connection.
+  ConnectResult Connect(Transport& transport);
   void Disconnect();
-  void SetBlocking(bool blocking);
 
   size_t Send(u8* data, size_t size);
   size_t Send(NetworkBuffer& buffer);
@@ -123,10 +169,30 @@ struct Connection {
   // This will not encrypt the data.
   size_t SendRaw(u8* data, size_t size);
 
+  // Sends any packets that are waiting in the outbound cluster.
+  void FlushOutbound();
+  // These must be called while holding the send mutex.
+  void FlushOutboundLocked();
+  void SubmitClusterLocked();
+  size_t SendEncrypted(u8* data, size_t size);
+  void FlushSendBatchLocked();
+
+  // Returns the size of the next received datagram and points pkt at it. Returns -1 on socket error.
+  int ReceiveDatagram(u8** pkt);
+
   u32 GetServerTick() { return (GetCurrentTick() + time_diff) & 0x7FFFFFFF; }
 
   TickResult Tick();
 
+  // Datagrams are left in the socket while waiting for the Continuum key expansion to finish.
+  inline bool IsReceiving() const {
+    return !(encrypt_method == EncryptMethod::Continuum && encrypt.IsExpanding());
+  }
+
+  // Datagrams that a batched read already took out of the socket. The socket doesn't become readable for these, so
+  // anything waiting on it needs to check here first.
+  inline bool HasBufferedDatagrams() const { return recv_batch.read < recv_batch.count; }
+
   void ProcessPacket(u8* pkt, size_t size);
 
   void OnDownloadComplete(struct FileRequest* request, u8* data);
@@ -135,7 +201,8 @@ struct Connection {
 
   void SendDisconnect();
   void SendEncryptionRequest(EncryptMethod method);
-  void SendSecurity(u32 settings_checksum, u32 exe_checksum, u32 map_checksum);
+  // The map crc is only sent by Continuum clients.
+  void SendSecurity(u32 settings_checksum, u32 exe_checksum, u32 map_checksum, u32 map_crc);
   void SendSpectateRequest(u16 pid);
   void SendShipRequest(u8 ship);
   void SendDeath(u16 killer, u16 bounty);
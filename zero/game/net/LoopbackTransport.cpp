@@ -0,0 +1,139 @@
+#include "LoopbackTransport.h"
+
+#include <string.h>
+#include <zero/game/Clock.h>
+
+namespace zero {
+
+void LoopbackChannel::Initialize(MemoryArena& arena, u64 seed) {
+  datagrams = memory_arena_push_type_count(&arena, LoopbackDatagram, kCapacity);
+  count = 0;
+  next_sequence = 0;
+  // Xorshift can't start from zero.
+  random_state = seed ? seed : 0x9E3779B97F4A7C15ULL;
+}
+
+float LoopbackChannel::NextRandom() {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 7;
+  random_state ^= random_state << 17;
+
+  return (random_state >> 40) / (float)(1 << 24);
+}
+
+void LoopbackChannel::Push(const u8* data, size_t size) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  ++stats.sent;
+
+  if (conditions.loss > 0.0f && NextRandom() < conditions.loss) {
+    ++stats.dropped;
+    return;
+  }
+
+  Enqueue(data, size);
+
+  if (conditions.duplicate > 0.0f && NextRandom() < conditions.duplicate) {
+    ++stats.duplicated;
+    Enqueue(data, size);
+  }
+}
+
+void LoopbackChannel::Enqueue(const u8* data, size_t size) {
+  if (count >= kCapacity || size > DatagramBatch::kDatagramSize) {
+    ++stats.overflowed;
+    return;
+  }
+
+  u64 delay = conditions.latency_us;
+
+  if (conditions.jitter_us > 0) {
+    delay += (u64)(NextRandom() * conditions.jitter_us);
+  }
+
+  if (conditions.reorder > 0.0f && NextRandom() < conditions.reorder) {
+    delay += conditions.reorder_delay_us;
+    ++stats.reordered;
+  }
+
+  LoopbackDatagram* datagram = datagrams + count++;
+
+  datagram->deliver_us = GetMicrosecondTick() + delay;
+  datagram->sequence = next_sequence++;
+  datagram->size = (u16)size;
+  memcpy(datagram->data, data, size);
+}
+
+int LoopbackChannel::Pop(u8* dest, size_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  u64 now = GetMicrosecondTick();
+  LoopbackDatagram* next = nullptr;
+
+  for (size_t i = 0; i < count; ++i) {
+    LoopbackDatagram* datagram = datagrams + i;
+
+    if (datagram->deliver_us > now) continue;
+
+    if (!next || datagram->deliver_us < next->deliver_us ||
+        (datagram->deliver_us == next->deliver_us && datagram->sequence < next->sequence)) {
+      next = datagram;
+    }
+  }
+
+  if (!next) return kTransportWouldBlock;
+
+  int size = next->size < capacity ? next->size : (int)capacity;
+  memcpy(dest, next->data, size);
+
+  // Order doesn't matter in the array, so fill the hole with the last datagram.
+  *next = datagrams[--count];
+  ++stats.delivered;
+
+  return size;
+}
+
+int LoopbackTransport::Receive(u8* data, size_t capacity) {
+  if (closed) return kTransportError;
+
+  int size = inbound->Pop(data, capacity);
+  ++stats->recv_calls;
+
+  if (size > 0) {
+    ++stats->datagrams_received;
+  }
+
+  return size;
+}
+
+bool LoopbackTransport::Send(const u8* data, size_t size) {
+  if (closed) return false;
+
+  outbound->Push(data, size);
+  ++stats->send_calls;
+  ++stats->datagrams_sent;
+
+  return true;
+}
+
+void LoopbackTransport::Close() {
+  closed = true;
+}
+
+LoopbackLink::LoopbackLink(MemoryArena& arena, u64 seed) {
+  to_server.Initialize(arena, seed);
+  to_client.Initialize(arena, seed * 31 + 1);
+
+  client.inbound = &to_client;
+  client.outbound = &to_server;
+
+  server.inbound = &to_server;
+  server.outbound = &to_client;
+}
+
+void LoopbackLink::SetConditions(const LoopbackConditions& conditions) {
+  to_server.conditions = conditions;
+  to_client.conditions = conditions;
+}
+
+}  // namespace zero
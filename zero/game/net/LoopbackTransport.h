@@ -0,0 +1,99 @@
+#ifndef ZERO_NET_LOOPBACKTRANSPORT_H_
+#define ZERO_NET_LOOPBACKTRANSPORT_H_
+
+#include <zero/game/Memory.h>
+#include <zero/game/net/Transport.h>
+
+#include <mutex>
+
+namespace zero {
+
+// Network conditions applied to every datagram that goes through a loopback channel.
+struct LoopbackConditions {
+  // One way delay in microseconds.
+  u32 latency_us = 0;
+  // Random extra delay between zero and this many microseconds.
+  u32 jitter_us = 0;
+  // Chance from 0 to 1 that a datagram is dropped.
+  float loss = 0.0f;
+  // Chance from 0 to 1 that a datagram is held back by reorder_delay_us so later datagrams overtake it.
+  float reorder = 0.0f;
+  u32 reorder_delay_us = 20000;
+  // Chance from 0 to 1 that a delivered datagram arrives a second time. The copy gets its own delay.
+  float duplicate = 0.0f;
+};
+
+struct LoopbackDatagram {
+  u64 deliver_us;
+  u64 sequence;
+  u16 size;
+  u8 data[DatagramBatch::kDatagramSize];
+};
+
+struct LoopbackChannelStatistics {
+  u64 sent = 0;
+  u64 delivered = 0;
+  u64 dropped = 0;
+  u64 reordered = 0;
+  u64 duplicated = 0;
+  // Datagrams dropped because the channel was full, the same as a full socket buffer.
+  u64 overflowed = 0;
+};
+
+// One direction of a loopback link. Delivery times come from GetMicrosecondTick, so a virtual clock makes the link
+// fully deterministic for a given seed.
+struct LoopbackChannel {
+  static constexpr size_t kCapacity = 512;
+
+  LoopbackConditions conditions;
+  LoopbackChannelStatistics stats;
+
+  // Unordered. The earliest due datagram is found with a scan since the channel is small.
+  LoopbackDatagram* datagrams = nullptr;
+  size_t count = 0;
+
+  u64 next_sequence = 0;
+  u64 random_state = 0;
+
+  std::mutex mutex;
+
+  void Initialize(MemoryArena& arena, u64 seed);
+
+  void Push(const u8* data, size_t size);
+  // Copies out the earliest datagram that is due. Returns its size or kTransportWouldBlock.
+  int Pop(u8* dest, size_t capacity);
+
+ private:
+  float NextRandom();
+  void Enqueue(const u8* data, size_t size);
+};
+
+// In-memory transport that reads from one channel and writes to another.
+struct LoopbackTransport : public Transport {
+  LoopbackChannel* inbound = nullptr;
+  LoopbackChannel* outbound = nullptr;
+  bool closed = false;
+
+  int Receive(u8* data, size_t capacity) override;
+  bool Send(const u8* data, size_t size) override;
+  void Close() override;
+};
+
+// Pair of channels with a transport on each end. The client end is given to a connection and the server end is driven
+// by whatever is standing in for the server.
+struct LoopbackLink {
+  LoopbackChannel to_server;
+  LoopbackChannel to_client;
+
+  LoopbackTransport client;
+  LoopbackTransport server;
+
+  LoopbackLink(MemoryArena& arena, u64 seed);
+
+  // Applies the same conditions in both directions.
+  void SetConditions(const LoopbackConditions& conditions);
+};
+
+}  // namespace zero
+
+#endif
@@ -0,0 +1,272 @@
+#include "NetworkStatistics.h"
+
+#include <stdio.h>
+#include <zero/game/Logger.h>
+#include <zero/game/WorkQueue.h>
+#include <zero/game/net/Connection.h>
+
+namespace zero {
+
+volatile sig_atomic_t g_NetworkStatisticsDumpRequests = 0;
+
+u32 LatencyHistogram::GetPercentile(float percentile) const {
+  if (count == 0) return 0;
+
+  u64 target = (u64)(count * percentile);
+  u64 accumulated = 0;
+
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    accumulated += buckets[i];
+
+    if (accumulated > target) {
+      u32 bound = (2u << i) - 1;
+      return bound < max ? bound : max;
+    }
+  }
+
+  return max;
+}
+
+void NetworkStatistics::GetTotals(u64* inbound_packets, u64* inbound_bytes, u64* outbound_packets,
+                                  u64* outbound_bytes) const {
+  *inbound_packets = *inbound_bytes = *outbound_packets = *outbound_bytes = 0;
+
+  for (size_t i = 0; i < kCoreTypeCount; ++i) {
+    *inbound_packets += inbound_core[i].packets;
+    *inbound_bytes += inbound_core[i].bytes;
+    *outbound_packets += outbound_core[i].packets;
+    *outbound_bytes += outbound_core[i].bytes;
+  }
+
+  for (size_t i = 0; i < kGameTypeCount; ++i) {
+    *inbound_packets += inbound_game[i].packets;
+    *inbound_bytes += inbound_game[i].bytes;
+    *outbound_packets += outbound_game[i].packets;
+    *outbound_bytes += outbound_game[i].bytes;
+  }
+}
+
+void LogNetworkSummary(Connection& connection) {
+  NetworkStatistics& stats = connection.net_stats;
+  ReliableStatistics& reliable = connection.packet_sequencer.stats;
+
+  u64 inbound_packets, inbound_bytes, outbound_packets, outbound_bytes;
+  stats.GetTotals(&inbound_packets, &inbound_bytes, &outbound_packets, &outbound_bytes);
+
+  Tick current_tick = GetCurrentTick();
+  float seconds = TICK_DIFF(current_tick, (Tick)stats.summary_tick) / 100.0f;
+
+  if (seconds <= 0.0f) seconds = 1.0f;
+
+  Log(LogLevel::Info, "Network in: %.1f pkt/s %.2f KiB/s  out: %.1f pkt/s %.2f KiB/s",
+      (inbound_packets - stats.summary_inbound_packets) / seconds,
+      (inbound_bytes - stats.summary_inbound_bytes) / seconds / 1024.0f,
+      (outbound_packets - stats.summary_outbound_packets) / seconds,
+      (outbound_bytes - stats.summary_outbound_bytes) / seconds / 1024.0f);
+
+  Log(LogLevel::Info,
+      "Reliable sent: %llu  resends: %llu  received: %llu  out of order: %llu  duplicates: %llu  ack p50/p90/max: "
+      "%u/%u/%u ticks",
+      (unsigned long long)reliable.messages_sent, (unsigned long long)reliable.resends,
+      (unsigned long long)reliable.messages_received, (unsigned long long)reliable.out_of_order,
+      (unsigned long long)reliable.duplicates, reliable.ack_latency.GetPercentile(0.5f),
+      reliable.ack_latency.GetPercentile(0.9f), reliable.ack_latency.max);
+
+  // Find the game packet types that used the most inbound bandwidth.
+  constexpr size_t kTopCount = 3;
+  size_t top[kTopCount] = {};
+  size_t top_count = 0;
+
+  for (size_t i = 0; i < NetworkStatistics::kGameTypeCount; ++i) {
+    if (stats.inbound_game[i].bytes == 0) continue;
+
+    size_t insert = top_count < kTopCount ? top_count++ : kTopCount;
+
+    while (insert > 0 && stats.inbound_game[top[insert - 1]].bytes < stats.inbound_game[i].bytes) {
+      if (insert < kTopCount) top[insert] = top[insert - 1];
+      --insert;
+    }
+
+    if (insert < kTopCount) top[insert] = i;
+  }
+
+  if (top_count > 0) {
+    char line[256];
+    int length = 0;
+
+    for (size_t i = 0; i < top_count; ++i) {
+      PacketTypeStatistics& type = stats.inbound_game[top[i]];
+
+      length += snprintf(line + length, sizeof(line) - length, "  0x%02X: %llu pkts %.1f KiB", (int)top[i],
+                         (unsigned long long)type.packets, type.bytes / 1024.0f);
+    }
+
+    Log(LogLevel::Info, "Top inbound:%s", line);
+  }
+
+  stats.summary_tick = current_tick;
+  stats.summary_inbound_packets = inbound_packets;
+  stats.summary_inbound_bytes = inbound_bytes;
+  stats.summary_outbound_packets = outbound_packets;
+  stats.summary_outbound_bytes = outbound_bytes;
+}
+
+static void WriteCacheStatistics(FILE* f, const char* name, u64 hits, u64 misses) {
+  u64 total = hits + misses;
+
+  fprintf(f, "%s cache hits: %llu  misses: %llu  hit rate: %.1f%%\n", name, (unsigned long long)hits,
+          (unsigned long long)misses, total > 0 ? hits * 100.0 / total : 0.0);
+}
+
+static void WriteTypeTable(FILE* f, const char* direction, const char* group, PacketTypeStatistics* types,
+                           size_t type_count, HandlerContainer* handlers, size_t handler_count) {
+  for (size_t i = 0; i < type_count; ++i) {
+    PacketTypeStatistics& type = types[i];
+
+    if (type.packets == 0) continue;
+
+    fprintf(f, "%-4s %-4s 0x%02X %12llu %14llu %12llu", direction, group, (int)i, (unsigned long long)type.packets,
+            (unsigned long long)type.bytes, (unsigned long long)type.crypt_us);
+
+    if (handlers && i < handler_count) {
+      fprintf(f, " %12llu %12llu", (unsigned long long)handlers[i].dispatch_count,
+              (unsigned long long)handlers[i].handler_us);
+    }
+
+    fprintf(f, "\n");
+  }
+}
+
+bool WriteNetworkStatistics(Connection& connection, const char* path) {
+  FILE* f = fopen(path, "w");
+
+  if (!f) {
+    Log(LogLevel::Error, "Failed to open network statistics file '%s'.", path);
+    return false;
+  }
+
+  NetworkStatistics& stats = connection.net_stats;
+  ReliableStatistics& reliable = connection.packet_sequencer.stats;
+  PacketDispatcher& dispatcher = connection.dispatcher;
+
+  fprintf(f, "timing: %s\n\n", stats.timing_enabled ? "enabled" : "disabled");
+
+  fprintf(f, "%-4s %-4s %-4s %12s %14s %12s %12s %12s\n", "dir", "kind", "type", "packets", "bytes", "crypt_us",
+          "dispatched", "handler_us");
+
+  WriteTypeTable(f, "in", "core", stats.inbound_core, NetworkStatistics::kCoreTypeCount, dispatcher.core_packets,
+                 ZERO_ARRAY_SIZE(dispatcher.core_packets));
+  WriteTypeTable(f, "in", "game", stats.inbound_game, NetworkStatistics::kGameTypeCount, dispatcher.game_packets,
+                 ZERO_ARRAY_SIZE(dispatcher.game_packets));
+  WriteTypeTable(f, "out", "core", stats.outbound_core, NetworkStatistics::kCoreTypeCount, nullptr, 0);
+  WriteTypeTable(f, "out", "game", stats.outbound_game, NetworkStatistics::kGameTypeCount, nullptr, 0);
+
+  fprintf(f, "\nreliable sent: %llu\n", (unsigned long long)reliable.messages_sent);
+  fprintf(f, "reliable resends: %llu\n", (unsigned long long)reliable.resends);
+  fprintf(f, "reliable received: %llu\n", (unsigned long long)reliable.messages_received);
+  fprintf(f, "reliable out of order: %llu\n", (unsigned long long)reliable.out_of_order);
+  fprintf(f, "reliable duplicates: %llu\n", (unsigned long long)reliable.duplicates);
+
+  LatencyHistogram& latency = reliable.ack_latency;
+
+  fprintf(f, "\nack latency samples: %llu  mean: %.2f  max: %u ticks\n", (unsigned long long)latency.count,
+          latency.count > 0 ? (double)latency.total / latency.count : 0.0, latency.max);
+
+  for (size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+    u32 low = i == 0 ? 0 : (1u << i);
+    u32 high = (2u << i) - 1;
+
+    if (i == LatencyHistogram::kBucketCount - 1) {
+      fprintf(f, "  %5u+      %12llu\n", low, (unsigned long long)latency.buckets[i]);
+    } else {
+      fprintf(f, "  %5u-%-5u %12llu\n", low, high, (unsigned long long)latency.buckets[i]);
+    }
+  }
+
+  SocketStatistics& socket_stats = connection.socket_stats;
+
+  fprintf(f, "\nrecv calls: %llu  datagrams received: %llu\n", (unsigned long long)socket_stats.recv_calls,
+          (unsigned long long)socket_stats.datagrams_received);
+  fprintf(f, "send calls: %llu  datagrams sent: %llu  clustered: %u\n", (unsigned long long)socket_stats.send_calls,
+          (unsigned long long)socket_stats.datagrams_sent, connection.packets_clustered);
+
+  SecuritySolver& security_solver = connection.security_solver;
+  SecuritySolverStatistics solver;
+  u64 expansion_hits, expansion_misses, checksum_hits, checksum_misses;
+
+  {
+    // The solver state is written by the solver thread, so copy it out under the lock.
+    std::lock_guard<std::mutex> guard(security_solver.mutex);
+
+    solver = security_solver.stats;
+    expansion_hits = security_solver.expansion_cache.hits;
+    expansion_misses = security_solver.expansion_cache.misses;
+    checksum_hits = security_solver.checksum_cache.hits;
+    checksum_misses = security_solver.checksum_cache.misses;
+  }
+
+  fprintf(f, "\nsecurity requests: %llu  responses: %llu  failures: %llu  retries: %llu  unmatched: %llu\n",
+          (unsigned long long)solver.requests, (unsigned long long)solver.responses,
+          (unsigned long long)solver.failures, (unsigned long long)solver.retries,
+          (unsigned long long)solver.unmatched);
+  fprintf(f, "security connects: %llu  connect failures: %llu  max in flight: %u\n",
+          (unsigned long long)solver.connects, (unsigned long long)solver.connect_failures, solver.max_in_flight);
+  fprintf(f, "security latency mean: %.2f  max: %.2f ms\n",
+          solver.responses > 0 ? solver.latency_total_us / 1000.0 / solver.responses : 0.0,
+          solver.latency_max_us / 1000.0);
+
+  SecurityChecksumCache& checksums = connection.checksum_cache;
+
+  fprintf(f, "\n");
+  WriteCacheStatistics(f, "solver expansion", expansion_hits, expansion_misses);
+  WriteCacheStatistics(f, "solver checksum", checksum_hits, checksum_misses);
+  WriteCacheStatistics(f, "map checksum", checksums.map_checksums.hits, checksums.map_checksums.misses);
+  WriteCacheStatistics(f, "map crc", checksums.map_crcs.hits, checksums.map_crcs.misses);
+  WriteCacheStatistics(f, "settings checksum", checksums.settings_checksums.hits,
+                       checksums.settings_checksums.misses);
+
+  WorkQueue& work_queue = security_solver.work_queue;
+  WorkQueueStatistics work_stats[WorkQueue::kPriorityCount];
+  u64 posted, completions, completion_wait_total_us, completion_wait_max_us;
+
+  {
+    std::lock_guard<std::mutex> guard(work_queue.mutex);
+
+    for (size_t i = 0; i < WorkQueue::kPriorityCount; ++i) {
+      work_stats[i] = work_queue.stats[i];
+    }
+
+    posted = work_queue.posted;
+    completions = work_queue.completions;
+    completion_wait_total_us = work_queue.completion_wait_total_us;
+    completion_wait_max_us = work_queue.completion_wait_max_us;
+  }
+
+  const char* kPriorityNames[] = {"critical", "normal", "background"};
+  static_assert(ZERO_ARRAY_SIZE(kPriorityNames) == WorkQueue::kPriorityCount);
+
+  fprintf(f, "\nwork queue workers: %zu  running: %zu  posted: %llu\n", work_queue.worker_count,
+          work_queue.running_worker_count, (unsigned long long)posted);
+  fprintf(f, "%-10s %10s %10s %10s %6s %10s %12s %10s %12s\n", "priority", "submitted", "completed", "cancelled",
+          "depth", "max depth", "wait mean us", "wait max", "run mean us");
+
+  for (size_t i = 0; i < WorkQueue::kPriorityCount; ++i) {
+    WorkQueueStatistics& work = work_stats[i];
+
+    fprintf(f, "%-10s %10llu %10llu %10llu %6u %10u %12.1f %10llu %12.1f\n", kPriorityNames[i],
+            (unsigned long long)work.submitted, (unsigned long long)work.completed,
+            (unsigned long long)work.cancelled, work.depth, work.max_depth,
+            work.started > 0 ? work.wait_total_us / (double)work.started : 0.0, (unsigned long long)work.wait_max_us,
+            work.started > 0 ? work.run_total_us / (double)work.started : 0.0);
+  }
+
+  fprintf(f, "completion wait mean: %.1f  max: %llu us\n",
+          completions > 0 ? completion_wait_total_us / (double)completions : 0.0,
+          (unsigned long long)completion_wait_max_us);
+
+  fclose(f);
+
+  return true;
+}
+
+}  // namespace zero
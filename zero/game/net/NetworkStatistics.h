@@ -0,0 +1,142 @@
+#ifndef ZERO_NET_NETWORKSTATISTICS_H_
+#define ZERO_NET_NETWORKSTATISTICS_H_
+
+#include <signal.h>
+#include <zero/Types.h>
+
+#include <chrono>
+
+namespace zero {
+
+// Incremented from a signal handler to request a statistics dump on the next frame. Each bot remembers the last value
+// it handled, so every bot in the process writes its own dump.
+extern volatile sig_atomic_t g_NetworkStatisticsDumpRequests;
+
+// Timing always uses the real clock so it still works while the game clock is virtual.
+inline u64 GetStatisticsMicroseconds() {
+  using micro = std::chrono::duration<u64, std::micro>;
+
+  return std::chrono::duration_cast<micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct PacketTypeStatistics {
+  u64 packets;
+  u64 bytes;
+  // Time spent encrypting or decrypting datagrams that started with this packet type.
+  u64 crypt_us;
+};
+
+// Power of two buckets in ticks. Bucket 0 is [0, 1], bucket 1 is [2, 3], bucket 2 is [4, 7] and so on.
+struct LatencyHistogram {
+  static constexpr size_t kBucketCount = 12;
+
+  u64 buckets[kBucketCount];
+  u64 count;
+  u64 total;
+  u32 max;
+
+  inline void Add(s32 ticks) {
+    if (ticks < 0) ticks = 0;
+
+    size_t bucket = 0;
+    u32 value = (u32)ticks >> 1;
+
+    while (value > 0 && bucket < kBucketCount - 1) {
+      value >>= 1;
+      ++bucket;
+    }
+
+    ++buckets[bucket];
+    ++count;
+    total += ticks;
+
+    if ((u32)ticks > max) max = ticks;
+  }
+
+  // Returns the upper bound in ticks of the bucket that contains the percentile, clamped to the largest sample.
+  u32 GetPercentile(float percentile) const;
+};
+
+struct ReliableStatistics {
+  u64 messages_sent;
+  u64 resends;
+  u64 messages_received;
+  // Messages that arrived before an earlier id was received.
+  u64 out_of_order;
+  // Messages that were already received or processed.
+  u64 duplicates;
+
+  // Ticks between the first send of a message and its ack. Resent messages are excluded since the ack is ambiguous.
+  LatencyHistogram ack_latency;
+};
+
+// Packets are counted at the logical level, so containers such as clusters and reliable messages are counted along
+// with the packets inside of them.
+struct NetworkStatistics {
+  static constexpr size_t kCoreTypeCount = 0x20;
+  static constexpr size_t kGameTypeCount = 0x40;
+
+  PacketTypeStatistics inbound_core[kCoreTypeCount];
+  PacketTypeStatistics inbound_game[kGameTypeCount];
+  PacketTypeStatistics outbound_core[kCoreTypeCount];
+  PacketTypeStatistics outbound_game[kGameTypeCount];
+
+  // Timing requires reading the clock around every packet, so it's only done when someone is reading the results.
+  bool timing_enabled;
+
+  // Totals at the time of the last summary so it can report rates.
+  u64 summary_tick;
+  u64 summary_inbound_packets;
+  u64 summary_inbound_bytes;
+  u64 summary_outbound_packets;
+  u64 summary_outbound_bytes;
+
+  inline static PacketTypeStatistics* GetType(PacketTypeStatistics* core, PacketTypeStatistics* game, const u8* pkt,
+                                              size_t size) {
+    if (pkt[0] == 0x00) {
+      u8 type = size > 1 ? pkt[1] : 0;
+      return core + (type < kCoreTypeCount ? type : 0);
+    }
+
+    return game + (pkt[0] < kGameTypeCount ? pkt[0] : 0);
+  }
+
+  inline PacketTypeStatistics* GetInbound(const u8* pkt, size_t size) {
+    return GetType(inbound_core, inbound_game, pkt, size);
+  }
+
+  inline PacketTypeStatistics* GetOutbound(const u8* pkt, size_t size) {
+    return GetType(outbound_core, outbound_game, pkt, size);
+  }
+
+  inline void RecordInbound(const u8* pkt, size_t size) {
+    if (size == 0) return;
+
+    PacketTypeStatistics* stats = GetInbound(pkt, size);
+
+    ++stats->packets;
+    stats->bytes += size;
+  }
+
+  inline void RecordOutbound(const u8* pkt, size_t size) {
+    if (size == 0) return;
+
+    PacketTypeStatistics* stats = GetOutbound(pkt, size);
+
+    ++stats->packets;
+    stats->bytes += size;
+  }
+
+  void GetTotals(u64* inbound_packets, u64* inbound_bytes, u64* outbound_packets, u64* outbound_bytes) const;
+};
+
+struct Connection;
+
+// Logs totals and rates since the previous summary along with the busiest packet types.
+void LogNetworkSummary(Connection& connection);
+// Writes every counter to a file.
+bool WriteNetworkStatistics(Connection& connection, const char* path);
+
+}  // namespace zero
+
+#endif
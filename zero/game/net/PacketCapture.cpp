@@ -0,0 +1,106 @@
+#include "PacketCapture.h"
+
+#include <string.h>
+#include <zero/game/Logger.h>
+#include <zero/game/Memory.h>
+#include <zero/game/Platform.h>
+
+namespace zero {
+
+constexpr size_t kCaptureHeaderSize = sizeof(u32) * 2;
+constexpr size_t kRecordHeaderSize = sizeof(u32) + sizeof(u16);
+
+bool PacketCaptureWriter::Open(const char* path) {
+  Close();
+
+  file = fopen(path, "wb");
+
+  if (!file) {
+    Log(LogLevel::Error, "Failed to open packet capture file '%s'.", path);
+    return false;
+  }
+
+  u32 header[2] = {kPacketCaptureMagic, kPacketCaptureVersion};
+  fwrite(header, sizeof(header), 1, file);
+
+  packet_count = 0;
+
+  return true;
+}
+
+void PacketCaptureWriter::Write(Tick tick, const u8* data, size_t size) {
+  if (!file || size > 0xFFFF) return;
+
+  u8 header[kRecordHeaderSize];
+  u16 size16 = (u16)size;
+
+  memcpy(header, &tick, sizeof(tick));
+  memcpy(header + sizeof(tick), &size16, sizeof(size16));
+
+  fwrite(header, sizeof(header), 1, file);
+  fwrite(data, 1, size, file);
+
+  ++packet_count;
+}
+
+void PacketCaptureWriter::Close() {
+  if (!file) return;
+
+  fclose(file);
+  file = nullptr;
+}
+
+bool PacketCaptureReader::Open(MemoryArena& arena, const char* path) {
+  data = platform.LoadAssetArena(arena, path, &size);
+  offset = 0;
+
+  if (!data || size < kCaptureHeaderSize) {
+    Log(LogLevel::Error, "Failed to load packet capture file '%s'.", path);
+    return false;
+  }
+
+  u32 header[2];
+  memcpy(header, data, sizeof(header));
+
+  if (header[0] != kPacketCaptureMagic || header[1] != kPacketCaptureVersion) {
+    Log(LogLevel::Error, "Packet capture file '%s' has an unknown format.", path);
+    return false;
+  }
+
+  offset = kCaptureHeaderSize;
+
+  return true;
+}
+
+bool PacketCaptureReader::HasNext() const {
+  if (!data || offset + kRecordHeaderSize > size) return false;
+
+  u16 record_size;
+  memcpy(&record_size, data + offset + sizeof(u32), sizeof(record_size));
+
+  return offset + kRecordHeaderSize + record_size <= size;
+}
+
+Tick PacketCaptureReader::PeekTick() const {
+  Tick tick = 0;
+
+  if (HasNext()) {
+    memcpy(&tick, data + offset, sizeof(tick));
+  }
+
+  return tick;
+}
+
+bool PacketCaptureReader::Next(PacketCaptureRecord* record) {
+  if (!HasNext()) return false;
+
+  memcpy(&record->tick, data + offset, sizeof(record->tick));
+  memcpy(&record->size, data + offset + sizeof(u32), sizeof(record->size));
+  record->data = data + offset + kRecordHeaderSize;
+
+  offset += kRecordHeaderSize + record->size;
+
+  return true;
+}
+
+}  // namespace zero
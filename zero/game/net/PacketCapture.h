@@ -0,0 +1,51 @@
+#ifndef ZERO_NET_PACKETCAPTURE_H_
+#define ZERO_NET_PACKETCAPTURE_H_
+
+#include <stdio.h>
+#include <zero/Types.h>
+#include <zero/game/Clock.h>
+
+namespace zero {
+
+struct MemoryArena;
+
+// A capture file is a header followed by one record for every decrypted inbound packet.
+// Header: u32 magic, u32 version
+// Record: u32 tick, u16 size, u8 data[size]
+constexpr u32 kPacketCaptureMagic = 0x5041435A;  // "ZCAP"
+constexpr u32 kPacketCaptureVersion = 1;
+
+struct PacketCaptureWriter {
+  FILE* file = nullptr;
+  size_t packet_count = 0;
+
+  bool Open(const char* path);
+  void Write(Tick tick, const u8* data, size_t size);
+  void Close();
+
+  inline bool IsOpen() const { return file != nullptr; }
+};
+
+struct PacketCaptureRecord {
+  Tick tick;
+  u16 size;
+  // Points into the reader's buffer. This can be modified while processing.
+  u8* data;
+};
+
+struct PacketCaptureReader {
+  u8* data = nullptr;
+  size_t size = 0;
+  size_t offset = 0;
+
+  // Loads the entire capture into the arena.
+  bool Open(MemoryArena& arena, const char* path);
+
+  bool HasNext() const;
+  Tick PeekTick() const;
+  bool Next(PacketCaptureRecord* record);
+};
+
+}  // namespace zero
+
+#endif
@@ -1,6 +1,7 @@
 #include "PacketDispatcher.h"
 
 #include <assert.h>
+#include <zero/game/net/NetworkStatistics.h>
 
 namespace zero {
 
@@ -21,11 +22,29 @@ void PacketDispatcher::Dispatch(u8* pkt, size_t size) {
 
   assert(type < kPacketMaxId);
 
-  for (size_t i = 0; i < container[type].handler_count; ++i) {
-    PacketHandler* handler = container[type].handlers + i;
+  HandlerContainer& handlers = container[type];
+
+  ++handlers.dispatch_count;
+
+  u64 start_us = timing_enabled ? GetStatisticsMicroseconds() : 0;
+
+  if (container == game_packets) {
+    TypedHandlerContainer& typed = typed_packets[type];
+
+    if (typed.dispatch) {
+      typed.dispatch(typed, pkt, size);
+    }
+  }
+
+  for (size_t i = 0; i < handlers.handler_count; ++i) {
+    PacketHandler* handler = handlers.handlers + i;
 
     handler->callback(handler->user, pkt, size);
   }
+
+  if (timing_enabled) {
+    handlers.handler_us += GetStatisticsMicroseconds() - start_us;
+  }
 }
 
 void PacketDispatcher::Register(ProtocolCore type, PacketCallback callback, void* user) {
@@ -2,8 +2,12 @@
 #define ZERO_NET_PACKETDISPATCHER_H_
 
 #include <zero/Types.h>
+#include <zero/game/net/Packets.h>
 #include <zero/game/net/Protocol.h>
 
+#include <type_traits>
+#include <vector>
+
 namespace zero {
 
 using PacketCallback = void (*)(void* user, u8* pkt, size_t size);
@@ -19,6 +23,37 @@ constexpr size_t kPacketMaxHandlers = 64;
 struct HandlerContainer {
   size_t handler_count = 0;
   PacketHandler handlers[kPacketMaxHandlers];
+
+  u64 dispatch_count = 0;
+  // Total time spent in the handlers. Only measured while timing is enabled.
+  u64 handler_us = 0;
+};
+
+struct TypedPacketHandler {
+  void* user;
+  void (*callback)(void* user, const void* packet);
+};
+
+struct TypedHandlerContainer {
+  // Decodes the packet once and passes it to every handler. Set to the decoder of the subscribed packet type.
+  void (*dispatch)(TypedHandlerContainer& container, u8* pkt, size_t size) = nullptr;
+  std::vector<TypedPacketHandler> handlers;
+};
+
+// Splits a subscriber into the type that it's called on and the decoded packet type that it takes.
+template <typename Method>
+struct PacketSubscriberTraits;
+
+template <typename T, typename P>
+struct PacketSubscriberTraits<void (T::*)(const P&)> {
+  using Subscriber = T;
+  using Packet = P;
+};
+
+template <typename P>
+struct PacketSubscriberTraits<void (*)(void*, const P&)> {
+  using Subscriber = void;
+  using Packet = P;
 };
 
 // TODO: This should probably just get rewritten as a general event dispatcher
@@ -28,10 +63,46 @@ struct HandlerContainer {
 struct PacketDispatcher {
   HandlerContainer core_packets[0x15];
   HandlerContainer game_packets[kPacketMaxId];
+  TypedHandlerContainer typed_packets[kPacketMaxId];
+
+  bool timing_enabled = false;
 
   void Dispatch(u8* pkt, size_t size);
   void Register(ProtocolCore type, PacketCallback callback, void* user = nullptr);
   void Register(ProtocolS2C type, PacketCallback callback, void* user = nullptr);
+
+  // Subscribes a member function or a free function that takes a decoded packet.
+  // Typed subscribers are called before the raw handlers of the same type.
+  // Usage: dispatcher.Subscribe<&PlayerManager::OnPlayerDeath>(this);
+  template <auto Method>
+  void Subscribe(typename PacketSubscriberTraits<decltype(Method)>::Subscriber* subscriber) {
+    using Traits = PacketSubscriberTraits<decltype(Method)>;
+    using Subscriber = typename Traits::Subscriber;
+    using Packet = typename Traits::Packet;
+
+    TypedHandlerContainer& container = typed_packets[(size_t)Packet::kType];
+
+    container.dispatch = DispatchTyped<Packet>;
+    container.handlers.push_back({subscriber, [](void* user, const void* packet) {
+                                    if constexpr (std::is_void_v<Subscriber>) {
+                                      Method(user, *(const Packet*)packet);
+                                    } else {
+                                      (((Subscriber*)user)->*Method)(*(const Packet*)packet);
+                                    }
+                                  }});
+  }
+
+ private:
+  template <typename Packet>
+  static void DispatchTyped(TypedHandlerContainer& container, u8* pkt, size_t size) {
+    Packet packet;
+
+    if (!Packet::Decode(pkt, size, packet)) return;
+
+    for (TypedPacketHandler& handler : container.handlers) {
+      handler.callback(handler.user, &packet);
+    }
+  }
 };
 
 }  // namespace zero
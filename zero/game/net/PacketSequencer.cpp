@@ -8,14 +8,11 @@
 #include <zero/game/Logger.h>
 #include <zero/game/net/Connection.h>
 
-#include <algorithm>
-
 #define DEBUG_SEQUENCER
 
 namespace zero {
 
 constexpr size_t kReliableHeaderSize = 6;
-constexpr u32 kResendDelay = 300;
 
 static inline void SendReliable(Connection& connection, ReliableMessage& mesg) {
   u8 data[kMaxPacketSize];
@@ -30,36 +27,70 @@ static inline void SendReliable(Connection& connection, ReliableMessage& mesg) {
 }
 
 void PacketSequencer::Tick(Connection& connection) {
-  std::make_heap(process_queue, process_queue + process_queue_count);
+  while (true) {
+    ReliableMessage* mesg = &process_queue.Get(process_queue.base);
+
+    if (!mesg->active || mesg->id != process_queue.base) break;
+
+    // Remove it from the window before processing in case processing receives more reliable messages.
+    u8* message = mesg->message;
+    size_t size = mesg->size;
+
+    mesg->active = false;
+    ++process_queue.base;
 
-  while (process_queue_count > 0 && process_queue[0].id == next_reliable_process_id) {
-    // Process
 #ifdef DEBUG_SEQUENCER
-    Log(LogLevel::Jabber, "Processing reliable id %d", process_queue[0].id);
+    Log(LogLevel::Jabber, "Processing reliable id %d", process_queue.base - 1);
 #endif
-    connection.ProcessPacket(process_queue[0].message, process_queue[0].size);
-    std::pop_heap(process_queue, process_queue + process_queue_count--);
-    ++next_reliable_process_id;
+    connection.ProcessPacket(message, size);
+
+    payload_slab.Free(message, size);
   }
 
   u32 current_tick = GetCurrentTick();
 
-  // Resend timed out messages from reliable_sent
-  for (size_t i = 0; i < reliable_sent_count; ++i) {
-    ReliableMessage* mesg = reliable_sent + i;
+  reliable_pacer.Refill(current_tick);
+
+  // Resend timed out messages from reliable_sent. These take priority over messages that haven't been sent yet.
+  for (u32 id = reliable_sent.base; id != next_unsent_id && reliable_pacer.CanSend(); ++id) {
+    ReliableMessage* mesg = &reliable_sent.Get(id);
+
+    if (!mesg->active) continue;
 
-    if (TICK_DIFF(current_tick, mesg->timestamp) >= kResendDelay) {
+    if (TICK_DIFF(current_tick, mesg->timestamp) > (s32)rtt.GetTimeout(mesg->resend_count)) {
 #ifdef DEBUG_SEQUENCER
       Log(LogLevel::Jabber, "******** Resending timed out message with id %d", mesg->id);
 #endif
       SendReliable(connection, *mesg);
+      reliable_pacer.Consume(mesg->size + kReliableHeaderSize);
       mesg->timestamp = current_tick;
+      ++stats.resends;
+
+      if (mesg->resend_count < 0xFF) {
+        ++mesg->resend_count;
+      }
     }
   }
 
+  SendPendingReliable(connection);
   ProcessOutboundAcks(connection);
 }
 
+void PacketSequencer::SendPendingReliable(Connection& connection) {
+  u32 current_tick = GetCurrentTick();
+
+  reliable_pacer.Refill(current_tick);
+
+  while (next_unsent_id != next_reliable_id && reliable_pacer.CanSend()) {
+    ReliableMessage* mesg = &reliable_sent.Get(next_unsent_id++);
+
+    mesg->timestamp = current_tick;
+
+    SendReliable(connection, *mesg);
+    reliable_pacer.Consume(mesg->size + kReliableHeaderSize);
+  }
+}
+
 void PacketSequencer::ProcessOutboundAcks(Connection& connection) {
   constexpr size_t kAckSize = 6;
   // This is the size of the ack (6) + header length (1)
@@ -117,15 +148,29 @@ void PacketSequencer::ProcessOutboundAcks(Connection& connection) {
 void PacketSequencer::SendReliableMessage(Connection& connection, u8* pkt, size_t size) {
   assert(size + kReliableHeaderSize <= kMaxPacketSize);
 
-  ReliableMessage* mesg = reliable_sent + reliable_sent_count++;
-  mesg->id = next_reliable_id++;
-  mesg->size = size;
+  u32 id = next_reliable_id;
+
+  if (!reliable_sent.Contains(id)) {
+    Log(LogLevel::Error, "PacketSequencer: Too many unacknowledged reliable messages.");
+    return;
+  }
+
+  ++next_reliable_id;
+  ++stats.messages_sent;
+
+  ReliableMessage* mesg = &reliable_sent.Get(id);
+  mesg->id = id;
+  mesg->size = (u16)size;
   mesg->timestamp = GetCurrentTick();
+  mesg->active = true;
+  mesg->resend_count = 0;
+  mesg->message = payload_slab.Allocate(perm_arena, size);
   memcpy(mesg->message, pkt, size);
 
   Log(LogLevel::Jabber, "PacketSequencer: Sending reliable type 0x%02X id %d", pkt[0], mesg->id);
 
-  SendReliable(connection, *mesg);
+  // This is sent in order behind anything the pacer is holding back.
+  SendPendingReliable(connection);
 }
 
 void PacketSequencer::OnReliableMessage(Connection& connection, u8* pkt, size_t size) {
@@ -135,30 +180,45 @@ void PacketSequencer::OnReliableMessage(Connection& connection, u8* pkt, size_t
   Log(LogLevel::Jabber, "Got reliable message of id %d", id);
 #endif
 
+  // This was already processed
+  if (id < process_queue.base) {
+    outbound_acks.AddId(id);
+    ++stats.duplicates;
+    return;
+  }
+
+  // Don't acknowledge it if it can't be stored so the server will send it again.
+  if (!process_queue.Contains(id)) {
+    Log(LogLevel::Warning, "PacketSequencer: Dropping reliable message %u that is too far ahead.", id);
+    return;
+  }
+
   outbound_acks.AddId(id);
 
-  // This was already processed
-  if (id < next_reliable_process_id) {
+  ReliableMessage* mesg = &process_queue.Get(id);
+
+  // Don't add it to the process list if it is already there
+  if (mesg->active && mesg->id == id) {
+    ++stats.duplicates;
     return;
   }
 
-  for (size_t i = 0; i < process_queue_count; ++i) {
-    ReliableMessage* mesg = process_queue + i;
+  ++stats.messages_received;
+
+  if (id != process_queue.base) {
+    ReliableMessage& previous = process_queue.Get(id - 1);
 
-    // Don't add it to the process list if it is already there
-    if (mesg->id == id) {
-      return;
+    if (!previous.active || previous.id != id - 1) {
+      ++stats.out_of_order;
     }
   }
 
-  ReliableMessage* mesg = process_queue + process_queue_count++;
-
   mesg->id = id;
-  mesg->size = size - kReliableHeaderSize;
+  mesg->size = (u16)(size - kReliableHeaderSize);
   mesg->timestamp = GetCurrentTick();
+  mesg->active = true;
+  mesg->message = payload_slab.Allocate(perm_arena, mesg->size);
   memcpy(mesg->message, pkt + kReliableHeaderSize, mesg->size);
-
-  std::push_heap(process_queue, process_queue + process_queue_count);
 }
 
 void PacketSequencer::OnReliableAck(Connection& connection, u8* pkt, size_t size) {
@@ -168,48 +228,159 @@ void PacketSequencer::OnReliableAck(Connection& connection, u8* pkt, size_t size
   Log(LogLevel::Jabber, "Received reliable ack with id %d", id);
 #endif
 
-  for (size_t i = 0; i < reliable_sent_count; ++i) {
-    ReliableMessage* mesg = reliable_sent + i;
+  if (!reliable_sent.Contains(id) || id - reliable_sent.base >= next_unsent_id - reliable_sent.base) return;
+
+  ReliableMessage* mesg = &reliable_sent.Get(id);
+
+  if (!mesg->active || mesg->id != id) return;
+
+  // Only use messages that weren't resent as rtt samples since it's unknown which send the ack belongs to.
+  if (mesg->resend_count == 0) {
+    s32 latency = TICK_DIFF(GetCurrentTick(), mesg->timestamp);
+
+    rtt.AddSample((float)latency);
+    stats.ack_latency.Add(latency);
+  }
+
+  mesg->active = false;
+  payload_slab.Free(mesg->message, mesg->size);
 
-    if (mesg->id == id) {
-      // Swap last reliable sent message to this slot and decrease count
-      reliable_sent[i] = reliable_sent[--reliable_sent_count];
 #ifdef DEBUG_SEQUENCER
-      Log(LogLevel::Jabber, "Found reliable ack in sent list.");
+  Log(LogLevel::Jabber, "Found reliable ack in sent list.");
 #endif
-      return;
-    }
+
+  // Slide the window forward past everything that has been acknowledged.
+  while (reliable_sent.base != next_reliable_id && !reliable_sent.Get(reliable_sent.base).active) {
+    ++reliable_sent.base;
+  }
+}
+
+///////////// Round trip estimation
+
+void RttEstimator::AddSample(float rtt) {
+  if (rtt < 0.0f) return;
+
+  if (!has_sample) {
+    srtt = rtt;
+    rttvar = rtt * 0.5f;
+    has_sample = true;
+  } else {
+    float error = srtt - rtt;
+
+    rttvar = rttvar * 0.75f + (error < 0.0f ? -error : error) * 0.25f;
+    srtt = srtt * 0.875f + rtt * 0.125f;
+  }
+
+  float variance = 4.0f * rttvar;
+
+  timeout = srtt + (variance > kClockGranularity ? variance : kClockGranularity);
+
+  if (timeout < kMinTimeout) timeout = kMinTimeout;
+  if (timeout > kMaxTimeout) timeout = kMaxTimeout;
+}
+
+u32 RttEstimator::GetTimeout(u8 resend_count) const {
+  u8 backoff = resend_count < kMaxBackoff ? resend_count : kMaxBackoff;
+  float result = timeout * (float)(1 << backoff);
+
+  if (result > kMaxTimeout) result = kMaxTimeout;
+
+  return (u32)result;
+}
+
+///////////// Send pacing
+
+void TokenBucket::Refill(u32 tick) {
+  s32 elapsed = TICK_DIFF(tick, last_tick);
+
+  if (elapsed <= 0) return;
+
+  last_tick = tick;
+
+  s64 refilled = (s64)tokens + (s64)elapsed * rate;
+
+  tokens = refilled > (s64)capacity ? (s32)capacity : (s32)refilled;
+}
+
+///////////// Reliable window
+
+void ReliableWindow::Initialize(MemoryArena& arena) {
+  base = 0;
+  messages = memory_arena_push_type_count(&arena, ReliableMessage, kCapacity);
+  memset(messages, 0, sizeof(ReliableMessage) * kCapacity);
+}
+
+///////////// Payload slab
+
+u8* PayloadSlab::Allocate(MemoryArena& arena, size_t size) {
+  size_t index = GetClass(size);
+  FreeBlock* block = free_lists[index];
+
+  if (block) {
+    free_lists[index] = block->next;
+    return (u8*)block;
   }
+
+  return arena.Allocate(kClassSizes[index], alignof(FreeBlock));
+}
+
+void PayloadSlab::Free(u8* data, size_t size) {
+  size_t index = GetClass(size);
+  FreeBlock* block = (FreeBlock*)data;
+
+  block->next = free_lists[index];
+  free_lists[index] = block;
 }
 
 ///////////// Small chunks
 
 void PacketSequencer::OnSmallChunkBody(Connection& connection, u8* pkt, size_t size) {
-  small_chunks.Push(perm_arena, pkt + 2, size - 2);
+  if (!small_chunks.Push(perm_arena, pkt + 2, size - 2)) {
+    Log(LogLevel::Warning, "Small chunk transfer is too large at %zu bytes. Discarding transfer.",
+        small_chunks.size + size - 2);
+    small_chunks.Clear();
+  }
 }
 
 void PacketSequencer::OnSmallChunkTail(Connection& connection, u8* pkt, size_t size) {
-  small_chunks.Push(perm_arena, pkt + 2, size - 2);
-
-  ChunkData* current = small_chunks.chunks;
-  assert(current);
+  if (!small_chunks.Push(perm_arena, pkt + 2, size - 2)) {
+    Log(LogLevel::Warning, "Small chunk transfer is too large at %zu bytes. Discarding transfer.",
+        small_chunks.size + size - 2);
+    small_chunks.Clear();
+    return;
+  }
 
-  u8* body_data = nullptr;
-  size_t body_size = small_chunks.Construct(temp_arena, &body_data);
+  u8* body_data = small_chunks.data;
+  size_t body_size = small_chunks.size;
 
   assert(body_data);
 
+  // The buffer is kept for the next transfer, so it's safe to process the body out of it after clearing.
   small_chunks.Clear();
 
-  // Process the full body. The body data will be freed when the temp arena is
-  // freed in the main loop.
   connection.ProcessPacket(body_data, body_size);
 }
 
 ///////////// Huge chunks
 
 void PacketSequencer::OnHugeChunk(Connection& connection, u8* pkt, size_t size) {
-  u32 length = *(u32*)(pkt + 2);
+  if (size < 6) return;
+
+  u32 length;
+  memcpy(&length, pkt + 2, sizeof(length));
+
+  // Size the destination from the total length on the first fragment so nothing needs to be moved later.
+  // Every fragment of a rejected transfer ends up here and is dropped since nothing is ever stored for it.
+  if (huge_chunks.size == 0 && (length == 0 || !huge_chunks.Reserve(perm_arena, length))) {
+    Log(LogLevel::Warning, "Huge chunk total length of %u is invalid. Discarding transfer.", length);
+    return;
+  }
+
+  if (huge_chunks.size + size - 6 > length) {
+    Log(LogLevel::Warning, "Huge chunk overflowed its total length of %u. Discarding transfer.", length);
+    huge_chunks.Clear();
+    return;
+  }
 
   huge_chunks.Push(perm_arena, pkt + 6, size - 6);
 
@@ -218,10 +389,8 @@ void PacketSequencer::OnHugeChunk(Connection& connection, u8* pkt, size_t size)
 #endif
 
   if (huge_chunks.size >= length) {
-    u8* body_data = nullptr;
-    size_t body_size = huge_chunks.Construct(temp_arena, &body_data);
-
-    assert(body_data);
+    u8* body_data = huge_chunks.data;
+    size_t body_size = huge_chunks.size;
 
     huge_chunks.Clear();
 
@@ -242,68 +411,49 @@ void PacketSequencer::OnCancelHugeChunk(Connection& connection, u8* pkt, size_t
 
 ///////////// Chunk store
 
-void ChunkStore::Push(MemoryArena& arena, u8* data, size_t size) {
-  ChunkData* body_data = free;
-
-  // Allocate or pop off free list
-  if (!body_data) {
-    body_data = memory_arena_push_type(&arena, ChunkData);
-  } else {
-    free = free->next;
-  }
-
-  assert(body_data);
-  assert(size <= kMaxPacketSize);
+bool ChunkStore::Reserve(MemoryArena& arena, size_t total_size) {
+  if (total_size <= capacity) return true;
+  if (total_size > kMaxSize) return false;
 
-  memcpy(body_data->data, data, size);
-  body_data->size = size;
-  body_data->next = nullptr;
+  size_t new_capacity = capacity * 2;
 
-  if (chunks == nullptr) {
-    chunks = body_data;
+  if (new_capacity < total_size) {
+    new_capacity = total_size;
   }
 
-  if (end) {
-    end->next = body_data;
+  if (new_capacity > kMaxSize) {
+    new_capacity = kMaxSize;
   }
 
-  end = body_data;
-  this->size += size;
-}
-
-void ChunkStore::Clear() {
-  ChunkData* current = chunks;
+  // The old buffer isn't returned to the arena, so the whole new buffer has to fit in what is left.
+  if (new_capacity > arena.GetRemaining()) return false;
 
-  // Push the full chunk list into the free list
-  while (current) {
-    ChunkData* new_free = current;
-    current = current->next;
+  u8* new_data = arena.Allocate(new_capacity);
 
-    new_free->next = free;
-    free = new_free;
+  // Only small chunks can grow in the middle of a transfer since they don't know the total size up front.
+  if (size > 0) {
+    memcpy(new_data, data, size);
   }
 
-  chunks = nullptr;
-  end = nullptr;
-  size = 0;
+  data = new_data;
+  capacity = new_capacity;
+
+  return true;
 }
 
-size_t ChunkStore::Construct(MemoryArena& arena, u8** data) {
-  *data = nullptr;
+bool ChunkStore::Push(MemoryArena& arena, const u8* data, size_t size) {
+  assert(size <= kMaxPacketSize);
 
-  // Allocate enough space for the body
-  *data = arena.Allocate(size);
-  u8* write_ptr = *data;
+  if (!Reserve(arena, this->size + size)) return false;
 
-  // Loop to write data to the body
-  ChunkData* current = chunks;
-  while (current) {
-    memcpy(write_ptr, current->data, current->size);
-    write_ptr += current->size;
-    current = current->next;
-  }
+  memcpy(this->data + this->size, data, size);
+  this->size += size;
+
+  return true;
+}
 
-  return size;
+void ChunkStore::Clear() {
+  size = 0;
 }
 
 }  // namespace zero
@@ -3,43 +3,86 @@
 
 #include <zero/Types.h>
 #include <zero/game/Memory.h>
+#include <zero/game/net/NetworkStatistics.h>
 
 namespace zero {
 
 struct Connection;
 
+// Size class allocator for reliable message payloads so each message doesn't reserve a full packet.
+// Freed blocks are kept in per-class free lists and reused.
+struct PayloadSlab {
+  static constexpr size_t kClassCount = 5;
+  static constexpr size_t kClassSizes[kClassCount] = {32, 64, 128, 256, kMaxPacketSize};
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  FreeBlock* free_lists[kClassCount] = {};
+
+  u8* Allocate(MemoryArena& arena, size_t size);
+  void Free(u8* data, size_t size);
+
+  inline static size_t GetClass(size_t size) {
+    size_t index = 0;
+
+    while (index < kClassCount - 1 && size > kClassSizes[index]) {
+      ++index;
+    }
+
+    return index;
+  }
+};
+
 struct ReliableMessage {
-  size_t size;
   u32 id;
+  // Tick of the most recent send.
   u32 timestamp;
+  u16 size;
+  bool active;
+  // Number of times this was resent. Used for timeout backoff and to skip ambiguous rtt samples.
+  u8 resend_count;
 
-  u8 message[kMaxPacketSize];
-
-  // Flipped comparison operator for heap
-  bool operator<(const ReliableMessage& other) const { return id > other.id; }
+  u8* message;
 };
 
-struct ChunkData {
-  u8 data[kMaxPacketSize];
-  size_t size;
+// Ring of reliable messages indexed by sequence id. The window covers [base, base + kCapacity) and is allocated once, so
+// a peer can't make it grow. Ids past the end of the window are refused until the base catches up.
+struct ReliableWindow {
+  // Must be a power of 2.
+  static constexpr u32 kCapacity = 4096;
 
-  ChunkData* next;
+  ReliableMessage* messages = nullptr;
+  // Oldest sequence id that is still tracked by the window.
+  u32 base = 0;
+
+  void Initialize(MemoryArena& arena);
+
+  inline bool Contains(u32 id) const { return id - base < kCapacity; }
+  inline ReliableMessage& Get(u32 id) { return messages[id & (kCapacity - 1)]; }
 };
 
+static_assert((ReliableWindow::kCapacity & (ReliableWindow::kCapacity - 1)) == 0,
+              "Reliable window capacity must be a power of 2");
+
+// Reassembles chunked transfers in one contiguous buffer. Fragments are written straight to their final offset so the
+// complete body can be processed in place without another copy.
 struct ChunkStore {
-  // Beginning of chunk data stored as linked list
-  ChunkData* chunks = nullptr;
-  // End of chunk data to make appending faster
-  ChunkData* end = nullptr;
-  // Free list for chunk data
-  ChunkData* free = nullptr;
+  // Transfer sizes come from the server, so anything past this is treated as malformed instead of exhausting the arena.
+  static constexpr size_t kMaxSize = Megabytes(8);
+
+  u8* data = nullptr;
+  size_t capacity = 0;
   // Current size so far
   size_t size = 0;
 
-  void Push(MemoryArena& arena, u8* data, size_t size);
+  // Makes sure the buffer can hold total_size bytes. The buffer is only reallocated when a transfer is larger than any
+  // previous one, so this is normally free after the first map download.
+  // Returns false without allocating if total_size is over kMaxSize or the arena doesn't have room for it.
+  bool Reserve(MemoryArena& arena, size_t total_size);
+  bool Push(MemoryArena& arena, const u8* data, size_t size);
   void Clear();
-
-  size_t Construct(MemoryArena& arena, u8** data);
 };
 
 struct OutboundAckSet {
@@ -53,37 +96,87 @@ struct OutboundAckSet {
   }
 };
 
-constexpr size_t kReliableQueueSize = 256;
+// Smoothed round trip estimate (SRTT/RTTVAR) that determines how long to wait before resending. All values are ticks.
+struct RttEstimator {
+  static constexpr float kMinTimeout = 10.0f;
+  static constexpr float kMaxTimeout = 1000.0f;
+  // Lower bound on the variance term. Samples are whole ticks and acks are only read once per tick, so a steady link
+  // would otherwise drive rttvar to zero and resend every message whose ack arrives exactly on time.
+  static constexpr float kClockGranularity = 4.0f;
+  // Used until the first sample arrives.
+  static constexpr float kInitialTimeout = 300.0f;
+  // Number of doublings a message's timeout can go through after repeated resends.
+  static constexpr u8 kMaxBackoff = 4;
+
+  float srtt = 0.0f;
+  float rttvar = 0.0f;
+  float timeout = kInitialTimeout;
+  bool has_sample = false;
+
+  void AddSample(float rtt);
+
+  // Resend timeout for a message that has already been resent this many times.
+  u32 GetTimeout(u8 resend_count) const;
+};
+
+// Limits the number of bytes sent per tick. Tokens are refilled every tick up to the burst capacity.
+struct TokenBucket {
+  u32 rate;
+  u32 capacity;
+
+  s32 tokens;
+  u32 last_tick = 0;
+
+  TokenBucket(u32 rate, u32 capacity) : rate(rate), capacity(capacity), tokens((s32)capacity) {}
+
+  void Refill(u32 tick);
+
+  // A send is allowed as long as any tokens remain, so a packet larger than the balance can't stall forever. The
+  // balance goes negative and has to be paid back before the next send.
+  inline bool CanSend() const { return tokens > 0; }
+  inline void Consume(size_t size) { tokens -= (s32)size; }
+};
+
 struct PacketSequencer {
   MemoryArena& perm_arena;
   MemoryArena& temp_arena;
 
-  // Next sequence number to process from the server
-  u32 next_reliable_process_id = 0;
   // Next sequence number used by this client
   u32 next_reliable_id = 0;
+  // Messages from here to next_reliable_id are waiting for send tokens and haven't been sent yet.
+  u32 next_unsent_id = 0;
+
+  RttEstimator rtt;
+  ReliableStatistics stats = {};
+  // Paces reliable traffic so large transfers don't saturate the link. Unreliable packets such as position packets
+  // aren't limited.
+  TokenBucket reliable_pacer = TokenBucket(kMaxPacketSize * 2, kMaxPacketSize * 16);
 
-  size_t reliable_sent_count = 0;
-  // The reliable messages that were sent and are waiting to be acknowledged.
-  ReliableMessage reliable_sent[kReliableQueueSize];
+  // The reliable messages that were sent and are waiting to be acknowledged. The base is the oldest unacked id.
+  ReliableWindow reliable_sent;
+  // The reliable messages that were received and are waiting to be processed in order. The base is the next sequence
+  // number to process from the server.
+  ReliableWindow process_queue;
 
-  size_t process_queue_count = 0;
-  // The reliable messages there were received and are waiting to be processed
-  // in order.
-  ReliableMessage process_queue[kReliableQueueSize];
+  PayloadSlab payload_slab;
 
   OutboundAckSet outbound_acks;
 
   ChunkStore small_chunks;
   ChunkStore huge_chunks;
 
-  PacketSequencer(MemoryArena& perm_arena, MemoryArena& temp_arena) : perm_arena(perm_arena), temp_arena(temp_arena) {}
+  PacketSequencer(MemoryArena& perm_arena, MemoryArena& temp_arena) : perm_arena(perm_arena), temp_arena(temp_arena) {
+    reliable_sent.Initialize(perm_arena);
+    process_queue.Initialize(perm_arena);
+  }
 
   void Tick(Connection& connection);
 
   void ProcessOutboundAcks(Connection& connection);
 
   void SendReliableMessage(Connection& connection, u8* pkt, size_t size);
+  // Sends messages that were held back by the pacer.
+  void SendPendingReliable(Connection& connection);
   void OnReliableMessage(Connection& connection, u8* pkt, size_t size);
   void OnReliableAck(Connection& connection, u8* pkt, size_t size);
 
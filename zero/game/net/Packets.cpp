@@ -0,0 +1,103 @@
+#include "Packets.h"
+
+#include <string.h>
+
+namespace zero {
+
+static inline u16 LoadU16(const u8* data) {
+  u16 result;
+  memcpy(&result, data, sizeof(result));
+  return result;
+}
+
+static inline u32 LoadU32(const u8* data) {
+  u32 result;
+  memcpy(&result, data, sizeof(result));
+  return result;
+}
+
+bool LargePositionPacket::Decode(const u8* pkt, size_t size, LargePositionPacket& packet) {
+  if (size < 21) return false;
+
+  packet.direction = pkt[1];
+  packet.timestamp = LoadU16(pkt + 2);
+  packet.x = LoadU16(pkt + 4);
+  packet.vel_y = (s16)LoadU16(pkt + 6);
+  packet.player_id = LoadU16(pkt + 8);
+  packet.vel_x = (s16)LoadU16(pkt + 10);
+  packet.checksum = pkt[12];
+  packet.togglables = pkt[13];
+  packet.ping = pkt[14];
+  packet.y = LoadU16(pkt + 15);
+  packet.bounty = LoadU16(pkt + 17);
+  packet.weapon = LoadU16(pkt + 19);
+
+  packet.size = size;
+  packet.energy = packet.HasEnergy() ? LoadU16(pkt + 21) : 0;
+  packet.s2c_latency = packet.HasLatency() ? LoadU16(pkt + 23) : 0;
+  packet.flag_timer = packet.HasFlagTimer() ? LoadU16(pkt + 25) : 0;
+  packet.items = packet.HasItems() ? LoadU32(pkt + 27) : 0;
+
+  return true;
+}
+
+bool SmallPositionPacket::Decode(const u8* pkt, size_t size, SmallPositionPacket& packet) {
+  if (size < 16) return false;
+
+  packet.direction = pkt[1];
+  packet.timestamp = LoadU16(pkt + 2);
+  packet.x = LoadU16(pkt + 4);
+  packet.ping = pkt[6];
+  packet.bounty = pkt[7];
+  packet.player_id = pkt[8];
+  packet.togglables = pkt[9];
+  packet.vel_y = (s16)LoadU16(pkt + 10);
+  packet.y = LoadU16(pkt + 12);
+  packet.vel_x = (s16)LoadU16(pkt + 14);
+
+  packet.size = size;
+  packet.energy = packet.HasEnergy() ? LoadU16(pkt + 16) : 0;
+  packet.s2c_latency = packet.HasLatency() ? LoadU16(pkt + 18) : 0;
+  packet.flag_timer = packet.HasFlagTimer() ? LoadU16(pkt + 20) : 0;
+  packet.items = packet.HasItems() ? LoadU32(pkt + 22) : 0;
+
+  return true;
+}
+
+bool PlayerDeathPacket::Decode(const u8* pkt, size_t size, PlayerDeathPacket& packet) {
+  if (size < 6) return false;
+
+  packet.green_id = (s8)pkt[1];
+  packet.killer_id = LoadU16(pkt + 2);
+  packet.killed_id = LoadU16(pkt + 4);
+  packet.bounty = size >= 8 ? LoadU16(pkt + 6) : 0;
+  packet.flag_transfer = size >= 10 ? LoadU16(pkt + 8) : 0;
+
+  return true;
+}
+
+void BatchedPositionEntry::Decode(const u8* entry, const BatchedPositionFormat& format, BatchedPositionEntry& out) {
+  u16 pid_togglables = format.id_size == 2 ? LoadU16(entry) : entry[0];
+  const u8* data = entry + format.id_size;
+
+  u16 packed = LoadU16(data);
+  u32 packed_pos = LoadU32(data + 2);
+  u16 packed_velocity = LoadU16(data + 6);
+  s8 multiplier = (s8)data[8];
+
+  u32 x = packed_pos & 0x3FFF;
+  u32 y = (packed_pos >> 0x0E) & 0x3FFF;
+
+  // Sign extend the low 14 bits.
+  s16 vel_y = (s16)((s32)((u32)packed_velocity << 0x12) >> 0x12);
+  s32 vel_x = ((packed_velocity >> 0x0E) + (multiplier * 4)) * 0x10 + (packed_pos >> 0x1C);
+
+  out.player_id = pid_togglables & 0x3FF;
+  out.togglables = format.id_size == 2 ? (u8)(pid_togglables >> 10) : 0;
+  out.direction = (u8)(packed >> 10);
+  out.timestamp = packed & 0x3FF;
+  out.position = Vector2f(x / 16.0f, y / 16.0f);
+  out.velocity = Vector2f(vel_x / 16.0f / 10.0f, vel_y / 16.0f / 10.0f);
+}
+
+}  // namespace zero
@@ -0,0 +1,116 @@
+#ifndef ZERO_NET_PACKETS_H_
+#define ZERO_NET_PACKETS_H_
+
+#include <zero/Math.h>
+#include <zero/Types.h>
+#include <zero/game/net/Protocol.h>
+
+namespace zero {
+
+// Decoded server packets. Each one is decoded once by the dispatcher and the struct is passed to every subscriber.
+// Decode returns false if the packet is too small to contain the fixed fields.
+
+struct LargePositionPacket {
+  static constexpr ProtocolS2C kType = ProtocolS2C::LargePosition;
+
+  u8 direction;
+  u16 timestamp;
+  u16 x;
+  u16 y;
+  s16 vel_x;
+  s16 vel_y;
+  u16 player_id;
+  u8 checksum;
+  u8 togglables;
+  u8 ping;
+  u16 bounty;
+  u16 weapon;
+
+  // Extra position data is only appended when the arena sends it. Check the size before using these.
+  size_t size;
+  u16 energy;
+  u16 s2c_latency;
+  u16 flag_timer;
+  u32 items;
+
+  inline bool HasEnergy() const { return size >= 23; }
+  inline bool HasLatency() const { return size >= 25; }
+  inline bool HasFlagTimer() const { return size >= 27; }
+  inline bool HasItems() const { return size >= 31; }
+
+  static bool Decode(const u8* pkt, size_t size, LargePositionPacket& packet);
+};
+
+struct SmallPositionPacket {
+  static constexpr ProtocolS2C kType = ProtocolS2C::SmallPosition;
+
+  u8 direction;
+  u16 timestamp;
+  u16 x;
+  u16 y;
+  s16 vel_x;
+  s16 vel_y;
+  u16 player_id;
+  u8 togglables;
+  u8 ping;
+  u8 bounty;
+
+  size_t size;
+  u16 energy;
+  u16 s2c_latency;
+  u16 flag_timer;
+  u32 items;
+
+  inline bool HasEnergy() const { return size >= 18; }
+  inline bool HasLatency() const { return size >= 20; }
+  inline bool HasFlagTimer() const { return size >= 22; }
+  inline bool HasItems() const { return size >= 26; }
+
+  static bool Decode(const u8* pkt, size_t size, SmallPositionPacket& packet);
+};
+
+struct PlayerDeathPacket {
+  static constexpr ProtocolS2C kType = ProtocolS2C::PlayerDeath;
+
+  s8 green_id;
+  u16 killer_id;
+  u16 killed_id;
+  u16 bounty;
+  u16 flag_transfer;
+
+  static bool Decode(const u8* pkt, size_t size, PlayerDeathPacket& packet);
+};
+
+// Layout of one entry in a batched position packet. Both types share everything after the player id.
+struct BatchedPositionFormat {
+  size_t entry_size;
+  // Number of bytes that the player id is packed into. The large format packs togglables into the upper 6 bits.
+  size_t id_size;
+};
+
+constexpr BatchedPositionFormat kBatchedSmallPositionFormat = {10, 1};
+constexpr BatchedPositionFormat kBatchedLargePositionFormat = {11, 2};
+
+// Batched position packets aren't decoded by the dispatcher. The handler reads each entry straight out of the packet,
+// checking the player id first so entries for unknown players are skipped without decoding the rest.
+struct BatchedPositionEntry {
+  u16 player_id;
+  // Only sent in the large format.
+  u8 togglables;
+  u8 direction;
+  // Low 10 bits of the server tick.
+  u16 timestamp;
+  Vector2f position;
+  Vector2f velocity;
+
+  static inline u16 GetPlayerId(const u8* entry, const BatchedPositionFormat& format) {
+    u16 pid_togglables = format.id_size == 2 ? (u16)(entry[0] | (entry[1] << 8)) : entry[0];
+    return pid_togglables & 0x3FF;
+  }
+
+  static void Decode(const u8* entry, const BatchedPositionFormat& format, BatchedPositionEntry& out);
+};
+
+}  // namespace zero
+
+#endif
@@ -9,6 +9,13 @@ using SocketType = long long;
 using SocketType = int;
 #endif
 
+// Linux can receive and send multiple datagrams per syscall with recvmmsg and sendmmsg.
+#ifdef __linux__
+#define ZERO_BATCHED_SOCKET_IO 1
+#else
+#define ZERO_BATCHED_SOCKET_IO 0
+#endif
+
 #ifdef _WIN32
 #pragma comment(lib, "ws2_32.lib")
 #endif
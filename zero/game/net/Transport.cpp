@@ -0,0 +1,28 @@
+#include "Transport.h"
+
+namespace zero {
+
+int Transport::ReceiveBatch(DatagramBatch& batch) {
+  batch.Clear();
+
+  while (batch.count < DatagramBatch::kCapacity) {
+    int size = Receive(batch.data[batch.count], kMaxPacketSize);
+
+    if (size == kTransportWouldBlock) break;
+    if (size <= 0) return batch.count > 0 ? (int)batch.count : size;
+
+    batch.sizes[batch.count++] = size;
+  }
+
+  return batch.count > 0 ? (int)batch.count : kTransportWouldBlock;
+}
+
+bool Transport::SendBatch(DatagramBatch& batch) {
+  for (size_t i = 0; i < batch.count; ++i) {
+    if (!Send(batch.data[i], batch.sizes[i])) return false;
+  }
+
+  return true;
+}
+
+}  // namespace zero
@@ -0,0 +1,79 @@
+#ifndef ZERO_NET_TRANSPORT_H_
+#define ZERO_NET_TRANSPORT_H_
+
+#include <zero/Types.h>
+#include <zero/game/Buffer.h>
+#include <zero/game/net/Socket.h>
+
+namespace zero {
+
+// Receive results that aren't datagram sizes.
+constexpr int kTransportWouldBlock = -1;
+constexpr int kTransportError = -2;
+
+// Preallocated datagrams that are filled or drained with one batched transport call.
+struct DatagramBatch {
+  static constexpr size_t kCapacity = 32;
+  // Encryption can append a crc and an escape byte to a full size packet.
+  static constexpr size_t kDatagramSize = kMaxPacketSize + 2;
+
+  u8 data[kCapacity][kDatagramSize];
+  size_t sizes[kCapacity];
+
+  // Next datagram to consume when receiving.
+  size_t read = 0;
+  size_t count = 0;
+
+  inline void Clear() {
+    read = 0;
+    count = 0;
+  }
+};
+
+struct SocketStatistics {
+  u64 recv_calls = 0;
+  u64 send_calls = 0;
+  u64 datagrams_received = 0;
+  u64 datagrams_sent = 0;
+
+  // Socket syscalls that were made between the previous two connection ticks.
+  u32 tick_recv_calls = 0;
+  u32 tick_send_calls = 0;
+
+  u64 tick_start_recv_calls = 0;
+  u64 tick_start_send_calls = 0;
+};
+
+// Moves datagrams between a connection and the server. Everything above this, such as encryption, sequencing and
+// dispatch, is the same for every transport.
+struct Transport {
+  // Points at the owning connection's statistics once it's attached.
+  SocketStatistics* stats = &unattached_stats;
+  SocketStatistics unattached_stats;
+
+  virtual ~Transport() {}
+
+  // Receives one datagram. Returns its size, zero if the transport was closed by the remote end, or one of the
+  // kTransport results.
+  virtual int Receive(u8* data, size_t capacity) = 0;
+  // Clears the batch and fills it with as many waiting datagrams as it can hold. Returns the number received or one
+  // of the kTransport results.
+  virtual int ReceiveBatch(DatagramBatch& batch);
+
+  // Returns false if the transport failed and should be closed.
+  virtual bool Send(const u8* data, size_t size) = 0;
+  virtual bool SendBatch(DatagramBatch& batch);
+
+  virtual void Close() = 0;
+
+  // Socket that becomes readable when a datagram arrives. Transports that can't be waited on return -1.
+  virtual SocketType GetSocket() const { return -1; }
+
+  // Reported to the server during login. The remote address is in network byte order.
+  virtual u32 GetRemoteAddress() const { return 0; }
+  virtual u16 GetLocalPort() const { return 0; }
+};
+
+}  // namespace zero
+
+#endif
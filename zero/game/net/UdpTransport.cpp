@@ -0,0 +1,199 @@
+#include "UdpTransport.h"
+
+#ifdef _WIN32
+#include <WS2tcpip.h>
+#include <Windows.h>
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define WSAEWOULDBLOCK EWOULDBLOCK
+#define closesocket close
+#endif
+
+#include <stdlib.h>
+#include <zero/game/Logger.h>
+
+namespace zero {
+
+inline int GetLastSocketError() {
+#ifdef _WIN32
+  return WSAGetLastError();
+#else
+  return errno;
+#endif
+}
+
+ConnectResult UdpTransport::Open(const char* ip, u16 port) {
+  inet_pton(AF_INET, ip, &this->remote_addr.addr);
+
+  this->remote_addr.port = htons(port);
+  this->remote_addr.family = AF_INET;
+
+  this->fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+  if (this->fd < 0) {
+    return ConnectResult::ErrorSocket;
+  }
+
+  this->SetBlocking(false);
+
+  return ConnectResult::Success;
+}
+
+int UdpTransport::Receive(u8* data, size_t capacity) {
+  sockaddr_in addr = {};
+  socklen_t socklen = sizeof(addr);
+
+  int bytes_recv = recvfrom(fd, (char*)data, (int)capacity, 0, (sockaddr*)&addr, &socklen);
+  ++stats->recv_calls;
+
+  if (bytes_recv > 0) {
+    ++stats->datagrams_received;
+  } else if (bytes_recv < 0) {
+    return GetLastSocketError() == WSAEWOULDBLOCK ? kTransportWouldBlock : kTransportError;
+  }
+
+  return bytes_recv;
+}
+
+int UdpTransport::ReceiveBatch(DatagramBatch& batch) {
+#if ZERO_BATCHED_SOCKET_IO
+  iovec iovecs[DatagramBatch::kCapacity];
+  mmsghdr messages[DatagramBatch::kCapacity] = {};
+
+  for (size_t i = 0; i < DatagramBatch::kCapacity; ++i) {
+    iovecs[i].iov_base = batch.data[i];
+    iovecs[i].iov_len = kMaxPacketSize;
+
+    messages[i].msg_hdr.msg_iov = iovecs + i;
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  batch.Clear();
+
+  int count = recvmmsg(fd, messages, DatagramBatch::kCapacity, MSG_DONTWAIT, nullptr);
+  ++stats->recv_calls;
+
+  if (count < 0) {
+    return GetLastSocketError() == WSAEWOULDBLOCK ? kTransportWouldBlock : kTransportError;
+  }
+
+  for (int i = 0; i < count; ++i) {
+    batch.sizes[i] = messages[i].msg_len;
+  }
+
+  batch.count = count;
+  stats->datagrams_received += count;
+
+  return count;
+#else
+  return Transport::ReceiveBatch(batch);
+#endif
+}
+
+bool UdpTransport::Send(const u8* data, size_t size) {
+  sockaddr_in addr = {};
+
+  addr.sin_family = remote_addr.family;
+  addr.sin_port = remote_addr.port;
+  addr.sin_addr.s_addr = remote_addr.addr;
+
+  int bytes = sendto(this->fd, (const char*)data, (int)size, 0, (sockaddr*)&addr, sizeof(addr));
+  ++stats->send_calls;
+  ++stats->datagrams_sent;
+
+  return bytes > 0;
+}
+
+bool UdpTransport::SendBatch(DatagramBatch& batch) {
+#if ZERO_BATCHED_SOCKET_IO
+  sockaddr_in addr = {};
+
+  addr.sin_family = remote_addr.family;
+  addr.sin_port = remote_addr.port;
+  addr.sin_addr.s_addr = remote_addr.addr;
+
+  iovec iovecs[DatagramBatch::kCapacity];
+  mmsghdr messages[DatagramBatch::kCapacity] = {};
+
+  for (size_t i = 0; i < batch.count; ++i) {
+    iovecs[i].iov_base = batch.data[i];
+    iovecs[i].iov_len = batch.sizes[i];
+
+    messages[i].msg_hdr.msg_name = &addr;
+    messages[i].msg_hdr.msg_namelen = sizeof(addr);
+    messages[i].msg_hdr.msg_iov = iovecs + i;
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  size_t sent = 0;
+
+  // sendmmsg can stop early, so keep going until everything is sent.
+  while (sent < batch.count) {
+    int result = sendmmsg(fd, messages + sent, (unsigned int)(batch.count - sent), 0);
+    ++stats->send_calls;
+
+    if (result <= 0) return false;
+
+    sent += result;
+  }
+
+  stats->datagrams_sent += sent;
+
+  return true;
+#else
+  return Transport::SendBatch(batch);
+#endif
+}
+
+void UdpTransport::Close() {
+  if (fd == -1) return;
+
+  closesocket(this->fd);
+  fd = -1;
+}
+
+u16 UdpTransport::GetLocalPort() const {
+  struct sockaddr_in addr;
+  socklen_t addr_size = sizeof(addr);
+
+  getsockname(fd, (sockaddr*)&addr, &addr_size);
+
+  return htons(addr.sin_port);
+}
+
+void UdpTransport::SetBlocking(bool blocking) {
+#ifdef _WIN32
+  unsigned long mode = blocking ? 0 : 1;
+
+  ioctlsocket(this->fd, FIONBIO, &mode);
+#else
+  int flags = fcntl(this->fd, F_GETFL, 0);
+
+  flags = blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+
+  fcntl(this->fd, F_SETFL, flags);
+#endif
+}
+
+#ifdef _WIN32
+struct NetworkInitializer {
+  NetworkInitializer() {
+    WSADATA wsa;
+
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+      Log(LogLevel::Error, "Error WSAStartup: %d", WSAGetLastError());
+      exit(1);
+    }
+  }
+};
+
+NetworkInitializer _net_init;
+#endif
+
+}  // namespace zero
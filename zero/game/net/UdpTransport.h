@@ -0,0 +1,43 @@
+#ifndef ZERO_NET_UDPTRANSPORT_H_
+#define ZERO_NET_UDPTRANSPORT_H_
+
+#include <zero/game/net/Transport.h>
+
+namespace zero {
+
+enum class ConnectResult { Success, ErrorSocket, ErrorAddrInfo, ErrorConnect };
+
+struct RemoteAddress {
+  long addr;
+  u16 port;
+  u16 family;
+
+  RemoteAddress() : addr(0), port(0), family(0) {}
+};
+
+// Nonblocking UDP socket. Batches use recvmmsg and sendmmsg when they are available.
+struct UdpTransport : public Transport {
+  SocketType fd = -1;
+  RemoteAddress remote_addr;
+
+  ConnectResult Open(const char* ip, u16 port);
+
+  int Receive(u8* data, size_t capacity) override;
+  int ReceiveBatch(DatagramBatch& batch) override;
+
+  bool Send(const u8* data, size_t size) override;
+  bool SendBatch(DatagramBatch& batch) override;
+
+  void Close() override;
+
+  SocketType GetSocket() const override { return fd; }
+  u32 GetRemoteAddress() const override { return (u32)remote_addr.addr; }
+  u16 GetLocalPort() const override;
+
+ private:
+  void SetBlocking(bool blocking);
+};
+
+}  // namespace zero
+
+#endif
@@ -2,10 +2,18 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 #include <zero/game/ArenaSettings.h>
 #include <zero/game/Memory.h>
 #include <zero/game/net/security/MD5.h>
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ZERO_CHECKSUM_SSE2 1
+#else
+#define ZERO_CHECKSUM_SSE2 0
+#endif
+
 namespace zero {
 
 #if 0  // No longer used since the network solver is used, but kept here to
@@ -132,7 +140,7 @@ uint32_t crc32_for_byte(uint32_t r) {
   return r ^ (uint32_t)0xFF000000L;
 }
 
-u32 crc32(const u8* ptr, size_t size) {
+u32 crc32_scalar(const u8* ptr, size_t size) {
   static uint32_t table[0x100];
   u32 crc = 0;
 
@@ -180,7 +188,7 @@ static const uint32_t g_crc32_reflected_table[256] = {
     0x24b4a3a6, 0xbad03605, 0xcdd70693, 0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
     0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d};
 
-u32 crc32_map(const u8* ptr, size_t size) {
+u32 crc32_map_scalar(const u8* ptr, size_t size) {
   u32 crc = 0xFFFFFFFF;
 
   for (size_t i = 0; i < size; ++i) {
@@ -194,6 +202,250 @@ u32 crc32_map(const u8* ptr, size_t size) {
   return crc;
 }
 
+// Slicing-by-8 tables. The first table is the normal reflected crc32 table and each following table advances a byte
+// further, so eight bytes can be folded into the crc with independent lookups.
+struct Crc32Slices {
+  u32 table[8][256];
+};
+
+static constexpr Crc32Slices MakeCrc32Slices() {
+  Crc32Slices slices = {};
+
+  for (u32 i = 0; i < 256; ++i) {
+    u32 crc = i;
+
+    for (int j = 0; j < 8; ++j) {
+      crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+    }
+
+    slices.table[0][i] = crc;
+  }
+
+  for (u32 i = 0; i < 256; ++i) {
+    for (size_t k = 1; k < 8; ++k) {
+      u32 previous = slices.table[k - 1][i];
+
+      slices.table[k][i] = (previous >> 8) ^ slices.table[0][previous & 0xFF];
+    }
+  }
+
+  return slices;
+}
+
+static constexpr Crc32Slices kCrc32Slices = MakeCrc32Slices();
+
+static inline u32 LoadU32(const u8* data) {
+  u32 result;
+  memcpy(&result, data, sizeof(result));
+  return result;
+}
+
+// Updates a raw crc state without the initial or final inversion. Loads are little endian.
+static u32 crc32_update(u32 crc, const u8* ptr, size_t size) {
+  const auto& t = kCrc32Slices.table;
+
+  while (size >= 8) {
+    u32 one = LoadU32(ptr) ^ crc;
+    u32 two = LoadU32(ptr + 4);
+
+    crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^ t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24] ^
+          t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+
+    ptr += 8;
+    size -= 8;
+  }
+
+  while (size--) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *ptr++) & 0xFF];
+  }
+
+  return crc;
+}
+
+u32 crc32(const u8* ptr, size_t size) {
+  return ~crc32_update(0xFFFFFFFF, ptr, size);
+}
+
+u32 crc32_map(const u8* ptr, size_t size) {
+  // Only some tiles are part of the crc, so they are packed into a buffer that is run through the sliced crc. Most of
+  // a map is empty, so runs of zero tiles are skipped without looking at each byte.
+  constexpr size_t kPackedSize = 4096;
+
+  u8 packed[kPackedSize + 16];
+  size_t packed_count = 0;
+  u32 crc = 0xFFFFFFFF;
+  size_t i = 0;
+
+#if ZERO_CHECKSUM_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max_tile = _mm_set1_epi8((char)0xA0);
+  const __m128i safe_tile = _mm_set1_epi8((char)0xAB);
+
+  for (; i + 16 <= size; i += 16) {
+    __m128i tiles = _mm_loadu_si128((const __m128i*)(ptr + i));
+
+    // Keep tiles that are nonzero and either at most 0xA0 or the safe tile.
+    __m128i low = _mm_cmpeq_epi8(_mm_min_epu8(tiles, max_tile), tiles);
+    __m128i keep = _mm_andnot_si128(_mm_cmpeq_epi8(tiles, zero), _mm_or_si128(low, _mm_cmpeq_epi8(tiles, safe_tile)));
+    int mask = _mm_movemask_epi8(keep);
+
+    if (mask == 0) continue;
+
+    if (mask == 0xFFFF) {
+      _mm_storeu_si128((__m128i*)(packed + packed_count), tiles);
+      packed_count += 16;
+    } else {
+      for (size_t j = 0; j < 16; ++j) {
+        if (mask & (1 << j)) {
+          packed[packed_count++] = ptr[i + j];
+        }
+      }
+    }
+
+    if (packed_count >= kPackedSize) {
+      crc = crc32_update(crc, packed, packed_count);
+      packed_count = 0;
+    }
+  }
+#else
+  for (; i + 8 <= size; i += 8) {
+    if (LoadU32(ptr + i) == 0 && LoadU32(ptr + i + 4) == 0) continue;
+
+    for (size_t j = 0; j < 8; ++j) {
+      u8 tile = ptr[i + j];
+
+      if (tile != 0 && (tile < 0xA1 || tile == 0xAB)) {
+        packed[packed_count++] = tile;
+      }
+    }
+
+    if (packed_count >= kPackedSize) {
+      crc = crc32_update(crc, packed, packed_count);
+      packed_count = 0;
+    }
+  }
+#endif
+
+  for (; i < size; ++i) {
+    u8 tile = ptr[i];
+
+    if (tile != 0 && (tile < 0xA1 || tile == 0xAB)) {
+      packed[packed_count++] = tile;
+    }
+  }
+
+  return crc32_update(crc, packed, packed_count);
+}
+
+// Matches Map::GetTileId, including the tile id that is returned outside of the map.
+static inline u8 GetChecksumTile(const u8* tiles, int x, int y) {
+  if (!tiles) return 0;
+  if ((u16)x >= 1024 || (u16)y >= 1024) return 20;
+
+  return tiles[(u16)y * 1024 + (u16)x];
+}
+
+u32 MapChecksumScalar(const u8* tiles, u32 key) {
+  constexpr u32 kTileStart = 1;
+  constexpr u32 kTileEnd = 160;
+  constexpr u32 kTileIdSafe = 171;
+
+  int basekey = key;
+
+  for (int y = basekey % 32; y < 1024; y += 32) {
+    for (int x = basekey % 31; x < 1024; x += 31) {
+      u8 tile = GetChecksumTile(tiles, x, y);
+
+      if (tile == 250) {
+        tile = 0;
+      }
+
+      if ((tile >= kTileStart && tile <= kTileEnd) || tile == kTileIdSafe) {
+        key += basekey ^ tile;
+      }
+    }
+  }
+
+  return key;
+}
+
+u32 MapChecksum(const u8* tiles, u32 key) {
+  int basekey = key;
+  int start_y = basekey % 32;
+  int start_x = basekey % 31;
+
+  // Keys with the high bit set start sampling outside of the map, so leave those to the reference.
+  if (!tiles || start_x < 0 || start_y < 0) {
+    return MapChecksumScalar(tiles, key);
+  }
+
+  // The tile only changes the low byte of basekey ^ tile, so the sum splits into the count of matching tiles times the
+  // high bytes of the key plus the sum of the low bytes. Both can be accumulated in byte lanes.
+  constexpr size_t kRowSamples = 34;
+  constexpr size_t kRowCount = 32;
+
+  alignas(16) u8 samples[kRowSamples * kRowCount + 16];
+  size_t sample_count = 0;
+
+  for (int y = start_y; y < 1024; y += 32) {
+    const u8* row = tiles + y * 1024;
+
+    for (int x = start_x; x < 1024; x += 31) {
+      samples[sample_count++] = row[x];
+    }
+  }
+
+  u8 low_key = (u8)basekey;
+  u32 count = 0;
+  u32 low_sum = 0;
+  size_t i = 0;
+
+#if ZERO_CHECKSUM_SSE2
+  // Zero tiles never match, so padding to the vector width doesn't change anything.
+  memset(samples + sample_count, 0, 16);
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi8(1);
+  const __m128i last_tile = _mm_set1_epi8((char)159);
+  const __m128i safe_tile = _mm_set1_epi8((char)171);
+  const __m128i key_vector = _mm_set1_epi8((char)low_key);
+
+  __m128i sums = zero;
+  __m128i counts = zero;
+
+  for (; i < sample_count; i += 16) {
+    __m128i tiles = _mm_load_si128((const __m128i*)(samples + i));
+
+    // Tiles 1 through 160 are at most 159 after subtracting one, and zero wraps around to 255.
+    __m128i offset = _mm_sub_epi8(tiles, one);
+    __m128i in_range = _mm_cmpeq_epi8(_mm_min_epu8(offset, last_tile), offset);
+    __m128i keep = _mm_or_si128(in_range, _mm_cmpeq_epi8(tiles, safe_tile));
+
+    __m128i low_bytes = _mm_and_si128(_mm_xor_si128(tiles, key_vector), keep);
+
+    sums = _mm_add_epi64(sums, _mm_sad_epu8(low_bytes, zero));
+    // Each lane sees at most 68 samples, so the byte counters can't overflow.
+    counts = _mm_sub_epi8(counts, keep);
+  }
+
+  counts = _mm_sad_epu8(counts, zero);
+
+  count = (u32)_mm_cvtsi128_si32(counts) + (u32)_mm_cvtsi128_si32(_mm_srli_si128(counts, 8));
+  low_sum = (u32)_mm_cvtsi128_si32(sums) + (u32)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+#endif
+
+  for (; i < sample_count; ++i) {
+    u8 tile = samples[i];
+
+    if ((tile >= 1 && tile <= 160) || tile == 171) {
+      ++count;
+      low_sum += (u8)(tile ^ low_key);
+    }
+  }
+
+  return key + count * ((u32)basekey & 0xFFFFFF00) + low_sum;
+}
+
 u32 SettingsChecksum(u32 key, const ArenaSettings& settings) {
   u32* data = (u32*)&settings;
   u32 sum = 0;
@@ -7,8 +7,15 @@ namespace zero {
 
 u8 crc8(const u8* ptr, size_t len);
 u8 crc8_repeat(const u8 value, size_t len);
+// Sliced versions of the checksums. The scalar versions are the original byte at a time loops, kept as references.
 u32 crc32(const u8* ptr, size_t size);
 u32 crc32_map(const u8* ptr, size_t size);
+u32 crc32_scalar(const u8* ptr, size_t size);
+u32 crc32_map_scalar(const u8* ptr, size_t size);
+
+// Checksum of the map tiles that is sent in security packets. Tiles must be the full 1024x1024 grid.
+u32 MapChecksum(const u8* tiles, u32 key);
+u32 MapChecksumScalar(const u8* tiles, u32 key);
 
 struct ArenaSettings;
 u32 SettingsChecksum(u32 key, const ArenaSettings& settings);
@@ -12,6 +12,13 @@
 #include <stdio.h>
 #endif
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ZERO_CRYPT_SSE2 1
+#else
+#define ZERO_CRYPT_SSE2 0
+#endif
+
 #include <zero/game/Clock.h>
 #include <zero/game/Logger.h>
 #include <zero/game/net/security/Checksum.h>
@@ -85,6 +92,65 @@ size_t VieEncrypt::Decrypt(u8* pkt, size_t size) {
     ++i;
   }
 
+#if ZERO_CRYPT_SSE2
+  // Each plaintext word only depends on its own ciphertext word and the previous one, so decryption can be done four
+  // words at a time. The IV is the previous ciphertext word for the first lane.
+  __m128i iv = _mm_cvtsi32_si128((int)IV);
+
+  while (i + 16 <= size) {
+    __m128i cipher = _mm_loadu_si128((const __m128i*)(pkt + i));
+    __m128i stream = _mm_loadu_si128((const __m128i*)(keystream + ksi));
+    __m128i previous = _mm_or_si128(_mm_slli_si128(cipher, 4), iv);
+
+    _mm_storeu_si128((__m128i*)(pkt + i), _mm_xor_si128(_mm_xor_si128(cipher, stream), previous));
+
+    iv = _mm_srli_si128(cipher, 12);
+    i += 16;
+    ksi += 16;
+  }
+
+  IV = (u32)_mm_cvtsi128_si32(iv);
+#endif
+
+  while (i + 4 <= size) {
+    EDX = *(u32*)(pkt + i);
+
+    *(u32*)&pkt[i] = *(u32*)(keystream + ksi) ^ IV ^ EDX;
+
+    IV = EDX;
+    i += 4;
+    ksi += 4;
+  }
+
+  size_t diff = size - i;
+
+  if (diff) {
+    u32 remaining = 0;
+
+    memcpy(&remaining, pkt + i, diff);
+
+    remaining ^= *(u32*)(keystream + ksi) ^ IV;
+    memcpy(pkt + i, &remaining, diff);
+  }
+
+  return size;
+}
+
+size_t VieEncrypt::DecryptReference(u8* pkt, size_t size) {
+  if (!session_key) {
+    return size;
+  }
+
+  u32 ksi = 0, i = 1, IV = session_key, EDX;
+
+  if (*pkt == 0) {
+    if (size <= 2) {
+      return size;
+    }
+
+    ++i;
+  }
+
   while (i + 4 <= size) {
     EDX = *(u32*)(pkt + i);
 
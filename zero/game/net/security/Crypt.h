@@ -47,7 +47,11 @@ struct ContinuumEncrypt {
 
 struct VieEncrypt {
   size_t Encrypt(const u8* pkt, u8* dest, size_t size);
+  // Decrypts four words at a time with SSE2 when available. Encryption chains every word off of the previous output,
+  // so it stays serial.
   size_t Decrypt(u8* pkt, size_t size);
+  // Decrypts with the scalar reference implementation. This must match Decrypt exactly.
+  size_t DecryptReference(u8* pkt, size_t size);
 
   bool Initialize(u32 server_key);
   bool IsValidKey(u32 server_key);
@@ -0,0 +1,57 @@
+#include "SecurityCache.h"
+
+#include <zero/game/Map.h>
+#include <zero/game/net/security/Checksum.h>
+
+namespace zero {
+
+static inline u64 MakeKey(u32 identity, u32 key) {
+  return ((u64)identity << 32) | key;
+}
+
+u32 SecurityChecksumCache::GetMapChecksum(const Map& map, u32 key) {
+  // Nothing can be cached until the tiles match a known map file.
+  if (map.loaded_checksum == 0) return map.GetChecksum(key);
+
+  u64 cache_key = MakeKey(map.loaded_checksum, key);
+  const u32* cached = map_checksums.Find(cache_key);
+
+  if (cached) return *cached;
+
+  u32 checksum = map.GetChecksum(key);
+
+  map_checksums.Insert(cache_key, checksum);
+
+  return checksum;
+}
+
+u32 SecurityChecksumCache::GetMapCrc(const Map& map) {
+  // Security checks can arrive while the map is still downloading. Treat it as empty like the map checksum does.
+  if (!map.tiles) return 0xFFFFFFFF;
+  if (map.loaded_checksum == 0) return crc32_map(map.tiles, 1024 * 1024);
+
+  const u32* cached = map_crcs.Find(map.loaded_checksum);
+
+  if (cached) return *cached;
+
+  u32 crc = crc32_map(map.tiles, 1024 * 1024);
+
+  map_crcs.Insert(map.loaded_checksum, crc);
+
+  return crc;
+}
+
+u32 SecurityChecksumCache::GetSettingsChecksum(const ArenaSettings& settings, u32 settings_crc, u32 key) {
+  u64 cache_key = MakeKey(settings_crc, key);
+  const u32* cached = settings_checksums.Find(cache_key);
+
+  if (cached) return *cached;
+
+  u32 checksum = SettingsChecksum(key, settings);
+
+  settings_checksums.Insert(cache_key, checksum);
+
+  return checksum;
+}
+
+}  // namespace zero
@@ -0,0 +1,88 @@
+#ifndef ZERO_NET_SECURITY_SECURITYCACHE_H_
+#define ZERO_NET_SECURITY_SECURITYCACHE_H_
+
+#include <zero/Types.h>
+
+namespace zero {
+
+// Fixed size cache of security results. Entries are grouped into small sets by key and replaced round robin within
+// their set, so the cache never grows and lookups only look at a few entries.
+template <typename Value, size_t kSets, size_t kWays = 4>
+struct SecurityResultCache {
+  struct Entry {
+    u64 key;
+    Value value;
+    bool valid;
+  };
+
+  Entry entries[kSets * kWays] = {};
+  u8 next_victim[kSets] = {};
+
+  u64 hits = 0;
+  u64 misses = 0;
+
+  const Value* Find(u64 key) {
+    Entry* set = entries + GetSetIndex(key) * kWays;
+
+    for (size_t i = 0; i < kWays; ++i) {
+      if (set[i].valid && set[i].key == key) {
+        ++hits;
+        return &set[i].value;
+      }
+    }
+
+    ++misses;
+    return nullptr;
+  }
+
+  void Insert(u64 key, const Value& value) {
+    size_t set_index = GetSetIndex(key);
+    Entry* set = entries + set_index * kWays;
+    Entry* entry = nullptr;
+
+    for (size_t i = 0; i < kWays; ++i) {
+      if (!set[i].valid || set[i].key == key) {
+        entry = set + i;
+        break;
+      }
+    }
+
+    if (!entry) {
+      entry = set + next_victim[set_index];
+      next_victim[set_index] = (u8)((next_victim[set_index] + 1) % kWays);
+    }
+
+    entry->key = key;
+    entry->value = value;
+    entry->valid = true;
+  }
+
+  inline float GetHitRate() const { return hits + misses > 0 ? hits / (float)(hits + misses) : 0.0f; }
+
+ private:
+  static inline size_t GetSetIndex(u64 key) { return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) % kSets; }
+};
+
+struct ExpandedKey {
+  u32 table[20];
+};
+
+struct ArenaSettings;
+struct Map;
+
+// Caches the checksums that are sent back in security packets. Door and brick tiles are skipped by both map checksums,
+// so the results only depend on the map file, which is identified by the checksum it was loaded with. Settings are
+// identified by their crc so rejoining an arena with the same settings still hits.
+struct SecurityChecksumCache {
+  SecurityResultCache<u32, 64> map_checksums;
+  SecurityResultCache<u32, 4> map_crcs;
+  SecurityResultCache<u32, 64> settings_checksums;
+
+  u32 GetMapChecksum(const Map& map, u32 key);
+  u32 GetMapCrc(const Map& map);
+  u32 GetSettingsChecksum(const ArenaSettings& settings, u32 settings_crc, u32 key);
+};
+
+}  // namespace zero
+
+#endif
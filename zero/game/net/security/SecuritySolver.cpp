@@ -6,12 +6,16 @@
 #ifdef _WIN32
 #include <WS2tcpip.h>
 #include <Windows.h>
+#define SHUT_RDWR SD_BOTH
 #else
 #include <arpa/inet.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/ip.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -19,12 +23,18 @@
 #define closesocket close
 #endif
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 #include <stdio.h>
+#include <zero/game/Clock.h>
 #include <zero/game/Logger.h>
 #include <zero/game/Platform.h>
 #include <zero/game/WorkQueue.h>
 
-#define SECURITY_DEBUG_LOG 1
+#include <chrono>
+#include <new>
 
 namespace zero {
 
@@ -55,6 +65,13 @@ struct ChecksumResponsePacket {
 };
 #pragma pack(pop)
 
+static_assert(sizeof(KeystreamRequestPacket) == sizeof(ChecksumRequestPacket), "Requests must be the same size");
+
+constexpr s64 kConnectTimeoutUs = 1000000;
+// How long the solver thread waits for a response before checking for expired requests.
+constexpr s64 kPollTimeoutUs = 100000;
+constexpr u64 kInitialReconnectDelayUs = 100000;
+
 SecurityNetworkService::SecurityNetworkService(const char* service_ip, u16 service_port) {
   strcpy(this->ip, service_ip);
   this->port = service_port;
@@ -74,15 +91,32 @@ void SetBlocking(SocketType fd, bool blocking) {
 #endif
 }
 
+static bool IsConnectPending() {
+#ifdef _WIN32
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EINPROGRESS;
+#endif
+}
+
+// Returns > 0 if the socket is ready, 0 on timeout and < 0 on error.
+static int WaitForSocket(SocketType socket, bool write, s64 timeout_us) {
+  fd_set set;
+  FD_ZERO(&set);
+  FD_SET(socket, &set);
+
+  timeval timeout;
+  timeout.tv_sec = (long)(timeout_us / 1000000);
+  timeout.tv_usec = (long)(timeout_us % 1000000);
+
+  return select((int)socket + 1, write ? nullptr : &set, write ? &set : nullptr, nullptr, &timeout);
+}
+
 SocketType SecurityNetworkService::Connect() {
   struct addrinfo hints = {0}, *result = nullptr;
 
   SocketType socket = -1;
 
-  if ((socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)) < 0) {
-    return -1;
-  }
-
   hints.ai_family = AF_INET;
   hints.ai_socktype = SOCK_STREAM;
   hints.ai_protocol = IPPROTO_TCP;
@@ -91,215 +125,465 @@ SocketType SecurityNetworkService::Connect() {
   sprintf(str_port, "%d", port);
 
   if (getaddrinfo(this->ip, str_port, &hints, &result) != 0) {
-    closesocket(socket);
     return -1;
   }
 
-  struct addrinfo* ptr = nullptr;
-  for (ptr = result; ptr != nullptr; ptr = ptr->ai_next) {
-    struct sockaddr_in* sockaddr = (struct sockaddr_in*)ptr->ai_addr;
-
-    if (::connect(socket, (struct sockaddr*)sockaddr, sizeof(struct sockaddr_in)) == 0) {
+  // Connect without blocking so an unreachable service doesn't hold up the solver thread for the system timeout.
+  for (struct addrinfo* ptr = result; ptr != nullptr; ptr = ptr->ai_next) {
+    if ((socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)) < 0) {
+      socket = -1;
       break;
     }
-  }
 
-  freeaddrinfo(result);
+    SetBlocking(socket, false);
+
+    bool connected = ::connect(socket, ptr->ai_addr, (int)ptr->ai_addrlen) == 0;
+
+    if (!connected && IsConnectPending() && WaitForSocket(socket, true, kConnectTimeoutUs) > 0) {
+      int error = 0;
+      socklen_t error_size = sizeof(error);
+
+      connected = getsockopt(socket, SOL_SOCKET, SO_ERROR, (char*)&error, &error_size) == 0 && error == 0;
+    }
+
+    if (connected) break;
 
-  if (!ptr) {
     closesocket(socket);
-    return -1;
+    socket = -1;
   }
 
+  freeaddrinfo(result);
+
+  if (socket == -1) return -1;
+
   SetBlocking(socket, true);
 
+  // Requests are tiny and latency sensitive, so don't let them sit in the send buffer.
+  int nodelay = 1;
+  setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&nodelay, sizeof(nodelay));
+
   return socket;
 }
 
-int ProcessRequest(SocketType socket, void* request, int request_size, void* response, int response_size) {
-  if (send(socket, (const char*)request, request_size, 0) != request_size) {
-    return -1;
-  }
+SecuritySolver::SecuritySolver(MemoryArena& arena, WorkQueue& work_queue, const char* service_ip, u16 service_port)
+    : arena(arena), work_queue(work_queue), service(service_ip, service_port) {}
 
-  int total_received = 0;
+SecuritySolver::~SecuritySolver() {
+  {
+    std::lock_guard<std::mutex> guard(mutex);
 
-  while (total_received < response_size) {
-    int bytes_received = recv(socket, (char*)response + total_received, response_size - total_received, 0);
+    running = false;
 
-    if (bytes_received <= 0) {
-      closesocket(socket);
-      break;
+    if (socket != -1) {
+      shutdown(socket, SHUT_RDWR);
     }
+  }
+
+  convar.notify_all();
+
+  if (thread.joinable()) {
+    thread.join();
+  }
 
-    total_received += bytes_received;
+  if (socket != -1) {
+    closesocket(socket);
   }
+}
+
+void SecuritySolver::ExpandKey(u32 key2, SecurityCallback callback) {
+  Log(LogLevel::Jabber, "Submitting ExpandKey: %08X", key2);
+  Submit(SecurityRequestType::Expansion, key2, std::move(callback));
+}
 
-  return total_received;
+void SecuritySolver::GetChecksum(u32 key, SecurityCallback callback) {
+  Log(LogLevel::Jabber, "Submitting Checksum: %08X", key);
+  Submit(SecurityRequestType::Checksum, key, std::move(callback));
 }
 
-void ExpansionWorkRun(Work* work) {
-  SecurityNetworkWork* expansion_work = (SecurityNetworkWork*)work->user;
-  SecurityNetworkService* service = &expansion_work->solver->service;
+void SecuritySolver::Submit(SecurityRequestType type, u32 key, SecurityCallback&& callback) {
+  // Large enough to hold either result.
+  ExpandedKey cached;
+  bool hit = false;
+
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    if (type == SecurityRequestType::Expansion) {
+      const ExpandedKey* expanded = expansion_cache.Find(key);
 
-  Log(LogLevel::Jabber, "ExpansionWorkRun(%08X): Starting", expansion_work->expansion.key2);
+      if (expanded) {
+        cached = *expanded;
+        hit = true;
+      }
+    } else {
+      const u32* checksum = checksum_cache.Find(key);
 
-  SocketType socket = service->Connect();
+      if (checksum) {
+        cached.table[0] = *checksum;
+        hit = true;
+      }
+    }
+  }
 
-  if (socket == -1) {
-    Log(LogLevel::Jabber, "ExpansionWorkRun(%08X): Connect failure", expansion_work->expansion.key2);
+  if (hit) {
+    callback(cached.table);
     return;
   }
 
-  expansion_work->socket = socket;
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    SecurityRequest* request = free;
+
+    if (request) {
+      free = request->next;
+    } else {
+      request = memory_arena_push_type(&arena, SecurityRequest);
+      new (request) SecurityRequest();
+    }
 
-  KeystreamRequestPacket request;
-  request.type = RequestType::Keystream;
-  request.key2 = expansion_work->expansion.key2;
+    request->solver = this;
+    request->type = type;
+    request->key = key;
+    request->callback = std::move(callback);
+    request->submit_us = GetMicrosecondTick();
+    request->send_us = 0;
+    request->sent = false;
+    request->next = nullptr;
+
+    if (requests_tail) {
+      requests_tail->next = request;
+    } else {
+      requests = request;
+    }
 
-  KeystreamResponsePacket response;
+    requests_tail = request;
 
-  Log(LogLevel::Jabber, "ExpansionWorkRun(%08X): ProcessRequest start", expansion_work->expansion.key2);
-  int response_size = ProcessRequest(socket, &request, sizeof(request), &response, sizeof(response));
+    ++stats.requests;
 
-  if (response_size == sizeof(response) && response.type == ResponseType::Keystream) {
-    memcpy(expansion_work->expansion.table, response.table, sizeof(expansion_work->expansion.table));
+    // The thread is only started once something needs the service so offline connections never touch it.
+    if (!running) {
+      running = true;
+      thread = std::thread(&SecuritySolver::Run, this);
+    }
 
-    expansion_work->state = SecurityWorkState::Success;
+    // Write the request right away if the connection is up. Otherwise the solver thread sends it after connecting.
+    if (socket != -1) {
+      SendPendingLocked(request->submit_us);
+    }
   }
 
-  closesocket(socket);
-
-  Log(LogLevel::Jabber, "ExpansionWorkRun(%08X) result: %d", expansion_work->expansion.key2, expansion_work->state);
+  convar.notify_one();
 }
 
-void ExpansionWorkComplete(Work* work) {
-  SecurityNetworkWork* expansion_work = (SecurityNetworkWork*)work->user;
+void SecuritySolver::ClearWork() {
+  std::lock_guard<std::mutex> guard(mutex);
+
+  SecurityRequest* request = requests;
 
-  u32* table = nullptr;
+  while (request) {
+    SecurityRequest* next = request->next;
 
-  if (expansion_work->state == SecurityWorkState::Success) {
-    table = expansion_work->expansion.table;
+    FreeRequestLocked(request);
+    request = next;
   }
 
-  expansion_work->callback(table);
-
-  expansion_work->solver->FreeWork(expansion_work);
+  requests = requests_tail = nullptr;
 }
 
-const WorkDefinition kExpansionDefinition = {ExpansionWorkRun, ExpansionWorkComplete};
+void SecuritySolver::Run() {
+  u64 reconnect_delay_us = 0;
 
-void ChecksumWorkRun(Work* work) {
-  SecurityNetworkWork* checksum_work = (SecurityNetworkWork*)work->user;
-  SecurityNetworkService* service = &checksum_work->solver->service;
+  while (true) {
+    SocketType current = -1;
 
-  Log(LogLevel::Jabber, "ChecksumWorkRun(%08X): Starting", checksum_work->checksum.key);
-  SocketType socket = service->Connect();
+    {
+      std::unique_lock<std::mutex> lock(mutex);
 
-  if (socket == -1) {
-    Log(LogLevel::Jabber, "ChecksumWorkRun(%08X): Connect failure", checksum_work->checksum.key);
-    return;
-  }
+      if (socket == -1) {
+        // Only connect when there is something to send.
+        convar.wait(lock, [this] { return !running || requests != nullptr; });
+      }
 
-  checksum_work->socket = socket;
+      if (!running) break;
 
-  ChecksumRequestPacket request;
-  request.type = RequestType::Checksum;
-  request.key = checksum_work->checksum.key;
+      current = socket;
+    }
 
-  ChecksumResponsePacket response;
+    if (current == -1) {
+      if (ConnectService()) {
+        if (reconnect_delay_us > 0) {
+          Log(LogLevel::Info, "Reconnected to security service.");
+        }
+
+        reconnect_delay_us = 0;
+        continue;
+      }
+
+      if (reconnect_delay_us == 0) {
+        Log(LogLevel::Error, "Failed to connect to security service at %s:%d.", service.ip, (int)service.port);
+        reconnect_delay_us = kInitialReconnectDelayUs;
+      } else {
+        reconnect_delay_us *= 2;
+        if (reconnect_delay_us > kMaxReconnectDelayUs) reconnect_delay_us = kMaxReconnectDelayUs;
+      }
+
+      ExpireRequests(GetMicrosecondTick());
+
+      std::unique_lock<std::mutex> lock(mutex);
+      convar.wait_for(lock, std::chrono::microseconds(reconnect_delay_us), [this] { return !running; });
+      continue;
+    }
 
-  Log(LogLevel::Jabber, "ChecksumWorkRun(%08X): ProcessRequest start", checksum_work->checksum.key);
-  int response_size = ProcessRequest(socket, &request, sizeof(request), &response, sizeof(response));
+    int ready = WaitForSocket(current, false, kPollTimeoutUs);
 
-  if (response_size == sizeof(response) && response.type == ResponseType::Checksum) {
-    checksum_work->checksum.checksum = response.checksum;
-    checksum_work->state = SecurityWorkState::Success;
-  }
+    if (ready > 0 && !ReceiveResponses()) {
+      std::lock_guard<std::mutex> guard(mutex);
+      CloseSocketLocked(true);
+    }
 
-  closesocket(socket);
-  Log(LogLevel::Jabber, "ChecksumWorkRun(%08X) result: %d", checksum_work->checksum.key, checksum_work->state);
+    ExpireRequests(GetMicrosecondTick());
+  }
 }
 
-void ChecksumWorkComplete(Work* work) {
-  SecurityNetworkWork* checksum_work = (SecurityNetworkWork*)work->user;
+bool SecuritySolver::ConnectService() {
+  SocketType new_socket = service.Connect();
 
-  u32* checksum = nullptr;
+  std::lock_guard<std::mutex> guard(mutex);
 
-  if (checksum_work->state == SecurityWorkState::Success) {
-    checksum = &checksum_work->checksum.checksum;
+  if (new_socket == -1) {
+    ++stats.connect_failures;
+    return false;
   }
 
-  checksum_work->callback(checksum);
+  socket = new_socket;
+  responses_on_socket = 0;
+  recv_size = 0;
+
+  ++stats.connects;
+
+  Log(LogLevel::Debug, "Connected to security service at %s:%d.", service.ip, (int)service.port);
 
-  checksum_work->solver->FreeWork(checksum_work);
+  SendPendingLocked(GetMicrosecondTick());
+
+  return true;
 }
 
-const WorkDefinition kChecksumDefinition = {ChecksumWorkRun, ChecksumWorkComplete};
+void SecuritySolver::CloseSocketLocked(bool closed_by_service) {
+  if (socket == -1) return;
+
+  closesocket(socket);
+  socket = -1;
+  recv_size = 0;
+
+  bool lost_requests = false;
 
-SecuritySolver::SecuritySolver(WorkQueue& work_queue, const char* service_ip, u16 service_port)
-    : work_queue(work_queue), service(service_ip, service_port) {
-  memset(work, 0, sizeof(work));
-  for (size_t i = 0; i < ZERO_ARRAY_SIZE(work); ++i) {
-    work[i].state = SecurityWorkState::Idle;
+  // Anything sent on this connection that wasn't answered is sent again on the next one.
+  for (SecurityRequest* request = requests; request; request = request->next) {
+    if (request->sent) {
+      request->sent = false;
+      lost_requests = true;
+      ++stats.retries;
+    }
+  }
+
+  if (closed_by_service && lost_requests && responses_on_socket > 0 && max_in_flight > 1) {
+    Log(LogLevel::Info, "Security service closed the connection after responding. Requests will not be pipelined.");
+    max_in_flight = 1;
   }
+
+  responses_on_socket = 0;
 }
 
-void SecuritySolver::ExpandKey(u32 key2, SecurityCallback callback) {
-  SecurityNetworkWork* work = AllocateWork();
+void SecuritySolver::SendPendingLocked(u64 now) {
+  u32 in_flight = 0;
 
-  work->state = SecurityWorkState::Working;
-  work->type = SecurityRequestType::Expansion;
-  work->expansion.key2 = key2;
-  work->callback = callback;
-  work->solver = this;
+  for (SecurityRequest* request = requests; request; request = request->next) {
+    if (request->sent) ++in_flight;
+  }
 
-  Log(LogLevel::Jabber, "Submitting work_queue ExpandKey: %08X", key2);
-  work_queue.Submit(kExpansionDefinition, work);
-}
+  for (SecurityRequest* request = requests; request && in_flight < max_in_flight; request = request->next) {
+    if (request->sent) continue;
 
-void SecuritySolver::GetChecksum(u32 key, SecurityCallback callback) {
-  SecurityNetworkWork* work = AllocateWork();
+    ChecksumRequestPacket packet;
 
-  work->state = SecurityWorkState::Working;
-  work->type = SecurityRequestType::Checksum;
-  work->checksum.key = key;
-  work->callback = callback;
-  work->solver = this;
+    packet.type = request->type == SecurityRequestType::Expansion ? RequestType::Keystream : RequestType::Checksum;
+    packet.key = request->key;
 
-  Log(LogLevel::Jabber, "Submitting work_queue Checksum: %08X", key);
-  work_queue.Submit(kChecksumDefinition, work);
+    if (send(socket, (const char*)&packet, sizeof(packet), MSG_NOSIGNAL) != sizeof(packet)) {
+      // Only the solver thread closes the socket. Shutting it down wakes the thread up to do that and resend.
+      shutdown(socket, SHUT_RDWR);
+      return;
+    }
+
+    request->sent = true;
+    request->send_us = now;
+
+    if (++in_flight > stats.max_in_flight) {
+      stats.max_in_flight = in_flight;
+    }
+  }
 }
 
-SecurityNetworkWork* SecuritySolver::AllocateWork() {
-  std::lock_guard<std::mutex> guard(mutex);
+bool SecuritySolver::ReceiveResponses() {
+  int bytes_received = recv(socket, (char*)recv_buffer + recv_size, (int)(sizeof(recv_buffer) - recv_size), 0);
+
+  if (bytes_received <= 0) return false;
+
+  recv_size += bytes_received;
 
-  for (size_t i = 0; i < ZERO_ARRAY_SIZE(work); ++i) {
-    if (work[i].state == SecurityWorkState::Idle) {
-      work[i].state = SecurityWorkState::Working;
-      return work + i;
+  while (recv_size > 0) {
+    ResponseType response_type = (ResponseType)recv_buffer[0];
+    SecurityRequestType type;
+    size_t response_size = 0;
+
+    if (response_type == ResponseType::Keystream) {
+      type = SecurityRequestType::Expansion;
+      response_size = sizeof(KeystreamResponsePacket);
+    } else if (response_type == ResponseType::Checksum) {
+      type = SecurityRequestType::Checksum;
+      response_size = sizeof(ChecksumResponsePacket);
+    } else {
+      Log(LogLevel::Error, "Received unknown security service response type %d.", (int)recv_buffer[0]);
+      return false;
+    }
+
+    if (recv_size < response_size) break;
+
+    u32 key;
+    ExpandedKey result;
+
+    memcpy(&key, recv_buffer + 1, sizeof(key));
+    memcpy(result.table, recv_buffer + 5, response_size - 5);
+
+    recv_size -= response_size;
+    memmove(recv_buffer, recv_buffer + response_size, recv_size);
+
+    SecurityRequest* request = nullptr;
+
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+
+      SecurityRequest* prev = nullptr;
+
+      for (request = requests; request; prev = request, request = request->next) {
+        if (request->sent && request->type == type && request->key == key) break;
+      }
+
+      ++responses_on_socket;
+
+      if (type == SecurityRequestType::Expansion) {
+        expansion_cache.Insert(key, result);
+      } else {
+        checksum_cache.Insert(key, result.table[0]);
+      }
+
+      if (request) {
+        if (prev) {
+          prev->next = request->next;
+        } else {
+          requests = request->next;
+        }
+
+        if (requests_tail == request) {
+          requests_tail = prev;
+        }
+
+        u64 latency_us = GetMicrosecondTick() - request->send_us;
+
+        ++stats.responses;
+        stats.latency_total_us += latency_us;
+
+        if (latency_us > stats.latency_max_us) {
+          stats.latency_max_us = latency_us;
+        }
+
+        // A slot opened up, so anything held back by the pipeline limit can go out now.
+        SendPendingLocked(GetMicrosecondTick());
+
+        Log(LogLevel::Jabber, "Security response %08X type %d", key, (int)type);
+        PostResultLocked(request, result.table);
+      } else {
+        ++stats.unmatched;
+      }
     }
   }
 
-  return nullptr;
+  return true;
 }
 
-void SecuritySolver::FreeWork(SecurityNetworkWork* security_work) {
+void SecuritySolver::ExpireRequests(u64 now) {
   std::lock_guard<std::mutex> guard(mutex);
 
-  security_work->state = SecurityWorkState::Idle;
-}
+  SecurityRequest* prev = nullptr;
+  SecurityRequest* request = requests;
+  bool stalled = false;
 
-void SecuritySolver::ClearWork() {
-  std::lock_guard<std::mutex> guard(mutex);
+  while (request) {
+    SecurityRequest* next = request->next;
+
+    if (now - request->submit_us >= kRequestTimeoutUs) {
+      if (prev) {
+        prev->next = next;
+      } else {
+        requests = next;
+      }
+
+      if (requests_tail == request) {
+        requests_tail = prev;
+      }
 
-  for (size_t i = 0; i < ZERO_ARRAY_SIZE(work); ++i) {
-    SecurityNetworkWork* security_work = work + i;
+      ++stats.failures;
 
-    if (security_work->state != SecurityWorkState::Idle) {
-      closesocket(security_work->socket);
-      security_work->state = SecurityWorkState::Idle;
+      Log(LogLevel::Error, "Security service request %08X timed out.", request->key);
+      PostResultLocked(request, nullptr);
+    } else {
+      if (request->sent && now - request->send_us >= kResponseTimeoutUs) {
+        stalled = true;
+      }
+
+      prev = request;
     }
+
+    request = next;
+  }
+
+  if (stalled && socket != -1) {
+    Log(LogLevel::Warning, "Security service stopped responding. Reconnecting.");
+    CloseSocketLocked(false);
+  }
+}
+
+static void SecurityRequestComplete(Work* work) {
+  SecurityRequest* request = (SecurityRequest*)work->user;
+  SecuritySolver* solver = request->solver;
+
+  // Cancelled when the work queue is cleared for an arena change, so the result is no longer wanted.
+  if (!work->cancelled) {
+    request->callback(request->success ? request->result.table : nullptr);
   }
+
+  std::lock_guard<std::mutex> guard(solver->mutex);
+  solver->FreeRequestLocked(request);
+}
+
+void SecuritySolver::PostResultLocked(SecurityRequest* request, const u32* data) {
+  request->success = data != nullptr;
+  request->next = nullptr;
+
+  if (data) {
+    size_t size = request->type == SecurityRequestType::Expansion ? sizeof(request->result.table) : sizeof(u32);
+    memcpy(request->result.table, data, size);
+  }
+
+  // Posted while the lock is held so a ClearWork can't slip in between removing the request and queueing the result.
+  work_queue.Post(SecurityRequestComplete, request);
+}
+
+void SecuritySolver::FreeRequestLocked(SecurityRequest* request) {
+  request->callback = nullptr;
+  request->next = free;
+  free = request;
 }
 
 }  // namespace zero
@@ -2,10 +2,14 @@
 #define ZERO_NET_SECURITY_SECURITYSOLVER_H_
 
 #include <zero/Types.h>
+#include <zero/game/Memory.h>
 #include <zero/game/net/Socket.h>
+#include <zero/game/net/security/SecurityCache.h>
 
+#include <condition_variable>
 #include <functional>
 #include <mutex>
+#include <thread>
 
 namespace zero {
 
@@ -20,55 +24,110 @@ struct SecurityNetworkService {
   SocketType Connect();
 };
 
-enum class SecurityWorkState {
-  Idle,
-  Working,
-  Success,
-  Failure,
-};
+enum class SecurityRequestType : u8 { Expansion, Checksum };
 
-enum class SecurityRequestType { Expansion, Checksum };
-
-struct SecurityNetworkWork {
-  union {
-    struct {
-      u32 key2;
-      u32 table[20];
-    } expansion;
-    struct {
-      u32 key;
-      u32 checksum;
-    } checksum;
-  };
-
-  SocketType socket;
-  SecurityCallback callback;
-  SecurityRequestType type;
-  SecurityWorkState state;
+struct SecurityRequest {
   struct SecuritySolver* solver;
+  SecurityRequestType type;
+  // Key2 for expansion or the checksum key. The service echoes it back, so it identifies the response.
+  u32 key;
+  SecurityCallback callback;
 
-  SecurityNetworkWork() {}
-  ~SecurityNetworkWork() {}
+  u64 submit_us;
+  u64 send_us;
+  bool sent;
+
+  // Filled in by the solver thread before the result is posted to the main thread.
+  ExpandedKey result;
+  bool success;
+
+  SecurityRequest* next;
 };
 
+struct SecuritySolverStatistics {
+  u64 requests = 0;
+  u64 responses = 0;
+  u64 failures = 0;
+  // Requests that were sent again because the connection was lost or stalled before they were answered.
+  u64 retries = 0;
+  // Responses that didn't match any request, usually because the request was cleared.
+  u64 unmatched = 0;
+  u64 connects = 0;
+  u64 connect_failures = 0;
+
+  u64 latency_total_us = 0;
+  u64 latency_max_us = 0;
+  u32 max_in_flight = 0;
+};
+
+// Keeps one connection to the security service open and pipelines requests over it.
+// Requests are written as soon as they are submitted and responses are read on a dedicated thread. The service
+// doesn't send request ids, so responses are matched against the oldest sent request with the same type and key.
+// Results are posted to the work queue so callbacks run on the main thread, or right away when the result is cached.
 struct SecuritySolver {
+  // A sent request that goes this long without a response is treated as a stalled connection and sent again on a new
+  // one. Requests fail once they are older than kRequestTimeoutUs.
+  static constexpr u64 kResponseTimeoutUs = 3000000;
+  static constexpr u64 kRequestTimeoutUs = 8000000;
+  static constexpr u64 kMaxReconnectDelayUs = 2000000;
+  static constexpr u32 kMaxInFlight = 32;
+
+  MemoryArena& arena;
   struct WorkQueue& work_queue;
 
   SecurityNetworkService service;
 
   std::mutex mutex;
+  std::condition_variable convar;
+  std::thread thread;
+  bool running = false;
+
+  SocketType socket = -1;
+  // Services that close the connection after every response only get one request at a time.
+  u32 max_in_flight = kMaxInFlight;
+  u32 in_flight = 0;
+  u32 responses_on_socket = 0;
 
-  SecurityNetworkWork work[16];
+  // Outstanding requests in submit order.
+  SecurityRequest* requests = nullptr;
+  SecurityRequest* requests_tail = nullptr;
+  SecurityRequest* free = nullptr;
 
-  SecuritySolver(struct WorkQueue& work_queue, const char* service_ip, u16 service_port);
+  u8 recv_buffer[256];
+  size_t recv_size = 0;
+
+  SecuritySolverStatistics stats;
+
+  // The service always gives the same result for a key, so repeated requests are answered from here without touching
+  // the network. These live as long as the solver, so they are kept across reconnects.
+  SecurityResultCache<ExpandedKey, 16> expansion_cache;
+  SecurityResultCache<u32, 64> checksum_cache;
+
+  SecuritySolver(MemoryArena& arena, struct WorkQueue& work_queue, const char* service_ip, u16 service_port);
+  ~SecuritySolver();
 
   void ExpandKey(u32 key2, SecurityCallback callback);
   void GetChecksum(u32 key, SecurityCallback callback);
 
-  SecurityNetworkWork* AllocateWork();
-  void FreeWork(SecurityNetworkWork* security_work);
-
+  // Drops all outstanding requests without calling their callbacks. The connection is kept open.
+  // Results that were already posted are dropped by clearing the work queue.
   void ClearWork();
+
+  // Returns a request to the free list once its callback has run.
+  void FreeRequestLocked(SecurityRequest* request);
+
+ private:
+  void Submit(SecurityRequestType type, u32 key, SecurityCallback&& callback);
+
+  void Run();
+
+  bool ConnectService();
+  void CloseSocketLocked(bool closed_by_service);
+  void SendPendingLocked(u64 now);
+  bool ReceiveResponses();
+  void ExpireRequests(u64 now);
+
+  void PostResultLocked(SecurityRequest* request, const u32* data);
 };
 
 }  // namespace zero
@@ -1,3 +1,4 @@
+#include <zero/BotHost.h>
 #include <zero/Utility.h>
 #include <zero/ZeroBot.h>
 #include <zero/game/Buffer.h>
@@ -15,6 +16,7 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -25,16 +27,39 @@
 #endif
 
 zero::ZeroBot* g_Bot = nullptr;
+// Hosted bots are stepped on their own threads, so the handlers below only tell the host to stop. Each thread sends
+// the disconnects for its bots when it sees that, and the memory usage is logged once they have all finished.
+std::atomic<zero::BotHost*> g_Host = nullptr;
+
+// Force disconnect so the bot doesn't stick around in the zone waiting to be timed out.
+// Memory usage isn't logged from here since that allocates and this runs from the signal handler.
+static void DisconnectBot() {
+  if (g_Bot && g_Bot->game) {
+    g_Bot->game->connection.SendDisconnect();
+  }
+}
 
 #ifdef _WIN32
 #include <Windows.h>
 
-// Force disconnect when closing the console so the bot doesn't stick around in the zone waiting to be timed out.
 BOOL WINAPI ConsoleCloserHandler(DWORD dwCtrlType) {
-  if (g_Bot && g_Bot->game) {
-    g_Bot->game->connection.SendDisconnect();
+  zero::BotHost* host = g_Host;
+
+  if (host) {
+    host->Stop();
+
+    // The process is ended as soon as this returns when the console is closing, so wait for the bots to disconnect.
+    if (dwCtrlType != CTRL_C_EVENT && dwCtrlType != CTRL_BREAK_EVENT) {
+      for (int i = 0; i < 50 && g_Host; ++i) {
+        Sleep(100);
+      }
+    }
+
+    return TRUE;
   }
 
+  DisconnectBot();
+
   ExitProcess(0);
   return TRUE;
 }
@@ -43,13 +68,24 @@ BOOL WINAPI ConsoleCloserHandler(DWORD dwCtrlType) {
 #include <signal.h>
 
 static void SignalHandler(int signum) {
-  if (g_Bot && g_Bot->game) {
-    g_Bot->game->connection.SendDisconnect();
+  zero::BotHost* host = g_Host;
+
+  if (host) {
+    host->Stop();
+    // Let a second interrupt end the process if the bots don't stop.
+    signal(SIGINT, SIG_DFL);
+    return;
   }
 
+  DisconnectBot();
+
   exit(0);
 }
 
+static void NetworkStatisticsSignalHandler(int signum) {
+  zero::g_NetworkStatisticsDumpRequests = zero::g_NetworkStatisticsDumpRequests + 1;
+}
+
 #endif
 
 namespace zero {
@@ -153,6 +189,9 @@ static void PrintUsage(std::string_view path) {
       "\t\t\t\tvalues depend on server\n"
       "-l, --loglevel\t\t\toverrides log level\n"
       "\t\t\t\tvalues: j, d, i, w, e\n"
+      "--capture <path>\t\trecords inbound packets to a capture file\n"
+      "--replay <path>\t\t\treplays a capture file offline and reports tick timings\n"
+      "--host <count>\t\t\truns count bots in this process that share map data\n"
 #ifdef GLFW_AVAILABLE
       "--render\t\t\tenables render window\n"
 #endif
@@ -165,12 +204,12 @@ int main(int argc, char* argv[]) {
   SetConsoleCtrlHandler(ConsoleCloserHandler, TRUE);
 #else
   signal(SIGINT, SignalHandler);
+  signal(SIGUSR1, NetworkStatisticsSignalHandler);
 #endif
 
   srand((unsigned int)time(NULL));
 
   zero::ZeroBot bot;
-  g_Bot = &bot;
 
   zero::g_LogPrintLevel = zero::LogLevel::Info;
 
@@ -269,13 +308,6 @@ int main(int argc, char* argv[]) {
       }
     }
 
-    auto owner_str = cfg->GetString("General", "Owner");
-    if (owner_str) {
-      bot.owner = *owner_str;
-    } else {
-      bot.owner = "*unset*";
-    }
-
     auto render_window = cfg->GetString("Debug", "RenderWindow");
     if (render_window) {
       zero::g_Settings.debug_window = strtol(*render_window, nullptr, 10) != 0;
@@ -383,11 +415,43 @@ int main(int argc, char* argv[]) {
   zero::Log(zero::LogLevel::Info, "Attempting to login to '%s:%d' with encryption type '%s'.", server->ipaddr.data(),
             (int)server->port, encrypt_type);
 
+  zero::kServerName = server->name.data();
+
+  size_t host_count = 0;
+
+  auto opt_host_bots = bot.config->GetInt("Host", "Bots");
+  if (opt_host_bots && *opt_host_bots > 0) host_count = *opt_host_bots;
+
+  std::string_view host_override = args->GetValue({"host"});
+  if (!host_override.empty()) {
+    host_count = (size_t)strtol(host_override.data(), nullptr, 10);
+  }
+
+  // Replays always use a single bot.
+  if (host_count > 0 && args->GetValue({"replay"}).empty()) {
+    zero::BotHost host;
+
+    if (!host.Initialize(*bot.config, *args, login_name.data(), login_password.data(), host_count)) {
+      return 1;
+    }
+
+    g_Host = &host;
+    host.Run(*server);
+    g_Host = nullptr;
+
+    return 0;
+  }
+
+  g_Bot = &bot;
+
   if (!bot.Initialize(std::move(args), login_name.data(), login_password.data())) {
     return 1;
   }
 
-  zero::kServerName = server->name.data();
+  std::string_view replay_path = bot.args->GetValue({"replay"});
+  if (!replay_path.empty()) {
+    return bot.Replay(*server, replay_path.data()) ? 0 : 1;
+  }
 
   bot.JoinZone(*server);
   bot.Run();
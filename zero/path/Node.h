@@ -27,9 +27,33 @@ enum NodeFlag {
   // This marks the node as visitable, but it must first be checked if it can currently be occupied.
   // This is used for empty spaces in the map that might be obstructed by surrounding doors.
   NodeFlag_DynamicEmpty = (1 << 6),
+  // Set once the node has been loaded from the shared node tiles.
+  NodeFlag_Loaded = (1 << 7),
 };
 typedef u32 NodeFlags;
 
+struct EdgeSet {
+  u8 set = 0;
+  u8 dynamic = 0;
+
+  inline bool IsSet(size_t index) const { return set & (1 << index); }
+  void Set(size_t index) { set |= (1 << index); }
+  void Erase(size_t index) { set &= ~(1 << index); }
+
+  inline bool DynamicIsSet(size_t index) const { return dynamic & (1 << index); }
+  void DynamicSet(size_t index) { dynamic |= (1 << index); }
+};
+
+// The part of a node that only depends on the map and ship radius. These are built once and shared by every bot that
+// uses the same map and radius.
+struct NodeTile {
+  // Only Traversable, Safety and DynamicEmpty are stored here.
+  u8 flags;
+  u8 weight;
+  EdgeSet edges;
+};
+
+// A node that is all zero bytes is a valid default node, so node storage can come straight from zeroed pages.
 struct Node {
   u32 parent_id;
 
@@ -39,20 +63,41 @@ struct Node {
   u8 flags;
 
  private:
-  // Fixed point weight where every 10 is 1
+  // Fixed point weight where every 10 is 1. It's stored offset by 10 so a zeroed node has a weight of 1.
   u8 weight;
 
  public:
-  Node() : flags(0), parent_id(~0), g(0.0f), f(0.0f), weight(10) {}
+  // Stored with the node because it fits in the padding after the weight.
+  EdgeSet edges;
+
+  Node() : flags(0), parent_id(~0), g(0.0f), f(0.0f), weight(0) {}
+
+  inline NodeTile GetTile() const {
+    constexpr u8 kTileFlags = NodeFlag_Traversable | NodeFlag_Safety | NodeFlag_DynamicEmpty;
+
+    NodeTile tile;
+
+    tile.flags = flags & kTileFlags;
+    tile.weight = weight;
+    tile.edges = edges;
+
+    return tile;
+  }
+
+  inline void LoadTile(const NodeTile& tile) {
+    flags = (flags & ~(NodeFlag_Traversable | NodeFlag_Safety | NodeFlag_DynamicEmpty)) | tile.flags | NodeFlag_Loaded;
+    weight = tile.weight;
+    edges = tile.edges;
+  }
 
-  inline float GetWeight() const { return weight / 10.0f; }
+  inline float GetWeight() const { return (u8)(weight + 10) / 10.0f; }
   inline void SetWeight(float v) {
     u32 calc = (u32)(v * 10.0f);
 
     if (calc <= 255) {
-      weight = (u8)(calc);
+      weight = (u8)(calc - 10);
     } else {
-      weight = 255;
+      weight = (u8)(255 - 10);
     }
   }
 };
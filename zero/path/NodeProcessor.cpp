@@ -1,3 +1,4 @@
+#include <stdlib.h>
 #include <zero/game/Game.h>
 #include <zero/game/Logger.h>
 #include <zero/path/NodeProcessor.h>
@@ -12,6 +13,38 @@ static inline bool IsDynamicTile(const Map& map, u16 world_x, u16 world_y) {
   return tile_id >= kTileIdFirstDoor && tile_id <= (kTileIdLastDoor + 1);
 }
 
+NodeProcessor::NodeProcessor(Game& game) : game_(game), map_(game.connection.map) {
+  nodes_ = (Node*)AllocateZeroedPages(sizeof(Node) * kMaxNodes);
+
+  if (!nodes_) {
+    Log(LogLevel::Error, "Failed to allocate %zu bytes for path nodes.", sizeof(Node) * kMaxNodes);
+    exit(1);
+  }
+}
+
+NodeProcessor::~NodeProcessor() {
+  FreeZeroedPages(nodes_, sizeof(Node) * kMaxNodes);
+}
+
+MemoryFootprint NodeProcessor::GetMemoryFootprint() const {
+  MemoryFootprint footprint;
+
+  footprint.Add(nodes_, sizeof(Node) * kMaxNodes);
+
+  return footprint;
+}
+
+void NodeProcessor::ExportTiles(NodeTile* tiles) const {
+  for (size_t i = 0; i < kMaxNodes; ++i) {
+    NodeTile tile = nodes_[i].GetTile();
+
+    // Skip default tiles so the pages for solid parts of the map are never touched.
+    if (tile.flags == 0 && tile.weight == 0 && tile.edges.set == 0 && tile.edges.dynamic == 0) continue;
+
+    tiles[i] = tile;
+  }
+}
+
 bool NodeProcessor::UpdateDynamicNode(Node* node, float ship_radius, u16 frequency) {
   if (!(node->flags & NodeFlag_DynamicEmpty)) {
     return node->flags & NodeFlag_Traversable;
@@ -19,12 +52,11 @@ bool NodeProcessor::UpdateDynamicNode(Node* node, float ship_radius, u16 frequen
 
   NodePoint node_point = this->GetPoint(node);
   Vector2f node_position((float)node_point.x, (float)node_point.y);
-  size_t node_index = (size_t)node_point.y * 1024 + node_point.x;
   MemoryArena& arena = GetGame().temp_arena;
   const Map& map = GetGame().GetMap();
   MemoryRevert reverter = arena.GetReverter();
 
-  OccupiedRect* rects = memory_arena_push_type_count(&arena, OccupiedRect, 256);
+  OccupiedRect* rects = memory_arena_push_type_count(&arena, OccupiedRect, Map::GetMaxOccupiedRects(ship_radius));
 
   size_t rect_count =
       map.GetAllOccupiedRects(Vector2f((float)node_point.x, (float)node_point.y), ship_radius, frequency, rects, true);
@@ -33,7 +65,7 @@ bool NodeProcessor::UpdateDynamicNode(Node* node, float ship_radius, u16 frequen
   node->flags &= ~(NodeFlag_DynamicEmpty | NodeFlag_Traversable);
 
   EdgeSet new_set = {};
-  edges_[node_index] = new_set;
+  node->edges = new_set;
 
   // If there's only two and the two are offset from each other, then we must be on a diagonal tile and should not
   // proceed.
@@ -97,15 +129,14 @@ bool NodeProcessor::UpdateDynamicNode(Node* node, float ship_radius, u16 frequen
     }
   }
 
-  edges_[node_index] = new_set;
+  node->edges = new_set;
 
   return node->flags & NodeFlag_Traversable;
 }
 
 EdgeSet NodeProcessor::FindEdges(Node* node, float radius) {
   NodePoint point = GetPoint(node);
-  size_t index = (size_t)point.y * 1024 + point.x;
-  EdgeSet edges = this->edges_[index];
+  EdgeSet edges = node->edges;
 
   for (size_t i = 0; i < 8; ++i) {
     // Only check if the tile is dynamic, like doors.
@@ -207,10 +238,14 @@ Node* NodeProcessor::GetNode(NodePoint point) {
     return nullptr;
   }
 
-  std::size_t index = point.y * 1024 + point.x;
+  std::size_t index = GetIndex(point.x, point.y);
   Node* node = &nodes_[index];
 
   if (!(node->flags & NodeFlag_Initialized)) {
+    if (tiles_ && !(node->flags & NodeFlag_Loaded)) {
+      node->LoadTile(tiles_[index]);
+    }
+
     node->parent_id = ~0;
     // Set the node as initialized and clear openset/touched while keeping any other flags set.
     node->flags = NodeFlag_Initialized | (node->flags & ~(NodeFlag_Openset | NodeFlag_Touched));
@@ -3,8 +3,10 @@
 #include <zero/Types.h>
 #include <zero/game/Game.h>
 #include <zero/game/Map.h>
+#include <zero/game/Memory.h>
 #include <zero/path/Node.h>
 
+#include <memory>
 #include <vector>
 
 namespace zero {
@@ -15,18 +17,6 @@ namespace path {
 
 constexpr size_t kMaxNodes = 1024 * 1024;
 
-struct EdgeSet {
-  u8 set = 0;
-  u8 dynamic = 0;
-
-  inline bool IsSet(size_t index) const { return set & (1 << index); }
-  void Set(size_t index) { set |= (1 << index); }
-  void Erase(size_t index) { set &= ~(1 << index); }
-
-  inline bool DynamicIsSet(size_t index) const { return dynamic & (1 << index); }
-  void DynamicSet(size_t index) { dynamic |= (1 << index); }
-};
-
 // All of the coords and indexes stored in this must stay in the same order.
 struct CoordOffset {
   s16 x;
@@ -75,7 +65,12 @@ enum class DoorSolidMethod {
 // Determines the node edges when using A*.
 class NodeProcessor {
  public:
-  NodeProcessor(Game& game) : game_(game), map_(game.connection.map) {}
+  NodeProcessor(Game& game);
+  ~NodeProcessor();
+
+  NodeProcessor(const NodeProcessor& other) = delete;
+  NodeProcessor& operator=(const NodeProcessor& other) = delete;
+
   Game& GetGame() { return game_; }
 
   EdgeSet FindEdges(Node* node, float radius);
@@ -88,18 +83,25 @@ class NodeProcessor {
   // This is not thread-safe.
   bool UpdateDynamicNode(Node* node, float ship_radius, u16 frequency);
 
-  void SetEdgeSet(u16 x, u16 y, EdgeSet set) {
-    size_t index = (size_t)y * 1024 + x;
-    edges_[index] = set;
+  void SetEdgeSet(u16 x, u16 y, EdgeSet set) { nodes_[GetIndex(x, y)].edges = set; }
+
+  // Nodes are stored in 16x16 blocks so each block fills one 4 KiB page. Pages are only backed by memory once a node
+  // in them is written, so the solid and unused parts of the map don't cost anything.
+  static inline size_t GetIndex(u16 x, u16 y) {
+    size_t block = (size_t)(y >> 4) * (1024 / 16) + (x >> 4);
+
+    return (block << 8) | ((size_t)(y & 15) << 4) | (x & 15);
   }
 
   // Calculate the node from the index.
   // This lets the node exist without storing its position so it fits in cache better.
-  inline NodePoint GetPoint(const Node* node) const {
-    size_t index = (node - &nodes_[0]);
+  inline NodePoint GetPoint(const Node* node) const { return GetPoint((size_t)(node - &nodes_[0])); }
+
+  static inline NodePoint GetPoint(size_t index) {
+    size_t block = index >> 8;
 
-    uint16_t world_y = (uint16_t)(index / 1024);
-    uint16_t world_x = (uint16_t)(index % 1024);
+    uint16_t world_y = (uint16_t)((block / (1024 / 16)) * 16 + ((index >> 4) & 15));
+    uint16_t world_x = (uint16_t)((block % (1024 / 16)) * 16 + (index & 15));
 
     return NodePoint(world_x, world_y);
   }
@@ -134,12 +136,20 @@ class NodeProcessor {
     }
   }
 
+  // Nodes are loaded from the tiles the first time they are used, so only the parts of the map that this processor
+  // searches cost it any memory. The tiles are indexed the same as the nodes and are never written to.
+  void SetTiles(std::shared_ptr<const NodeTile[]> tiles) { tiles_ = std::move(tiles); }
+  // Writes out the map data of every node so it can be shared with other processors.
+  void ExportTiles(NodeTile* tiles) const;
+
+  MemoryFootprint GetMemoryFootprint() const;
+
   // This is a list of empty spaces where nearby doors could block us.
   std::vector<NodePoint> dynamic_points;
 
  private:
-  EdgeSet edges_[kMaxNodes];
-  Node nodes_[kMaxNodes];
+  Node* nodes_;
+  std::shared_ptr<const NodeTile[]> tiles_;
   const Map& map_;
   Game& game_;
   DoorSolidMethod door_method_ = DoorSolidMethod::Dynamic;
@@ -313,11 +313,9 @@ static void CalculateTraversables(std::vector<NodePoint>& dynamic_points, const
 }
 
 static void CalculateEdges(const Map& map, NodeProcessor& processor, float ship_radius, Pathfinder::WeightConfig config,
-                           s16 x_start, s16 y_start, s16 x_end, s16 y_end) {
+                           s16 x_start, s16 y_start, s16 x_end, s16 y_end, OccupiedRect* occupied_scratch) {
   u32 frequency = 0xFFFF;
 
-  OccupiedRect* occupied_scratch = (OccupiedRect*)malloc(sizeof(OccupiedRect) * 2048);
-
   for (u16 y = y_start; y < y_end; ++y) {
     for (u16 x = x_start; x < x_end; ++x) {
       if (map.IsSolidEmptyDoors(x, y, frequency)) continue;
@@ -353,38 +351,38 @@ static void CalculateEdges(const Map& map, NodeProcessor& processor, float ship_
       }
     }
   }
-
-  free(occupied_scratch);
 }
 
 void Pathfinder::CreateMapWeights(MemoryArena& temp_arena, const Map& map, WeightConfig config) {
   float ship_radius = config.ship_radius;
 
-  MemoryRevert reverter = temp_arena.GetReverter();
-  OccupiedRect* scratch_rects = memory_arena_push_type_count(&temp_arena, OccupiedRect, 256);
-
   this->config = config;
 
   constexpr size_t kThreadCount = 12;
   std::thread threads[kThreadCount];
   std::vector<NodePoint> dynamic_points[kThreadCount];
 
+  // Each thread gets its own scratch that can hold every rect at this radius. It's used by both passes.
+  MemoryRevert reverter = temp_arena.GetReverter();
+  size_t scratch_count = Map::GetMaxOccupiedRects(ship_radius);
+  OccupiedRect* scratch_rects = memory_arena_push_type_count(&temp_arena, OccupiedRect, scratch_count * kThreadCount);
+
+  s16 per_thread = 1024 / (s16)kThreadCount;
+
   // First loop over tiles and calculate all of the traversables.
   for (size_t i = 0; i < kThreadCount; ++i) {
-    s16 per_thread = 1024 / (s16)kThreadCount;
-
     s16 x_start = (s16)i * per_thread;
     s16 y_start = 0;
     s16 x_end = ((s16)i + 1) * per_thread;
     s16 y_end = 1024;
 
+    // The last thread takes the columns left over from the division.
     if (i == kThreadCount - 1) {
-      s16 remainder = (s16)kThreadCount % 1024;
-      x_end += remainder;
+      x_end = 1024;
     }
 
     threads[i] = std::thread(CalculateTraversables, std::ref(dynamic_points[i]), map, std::ref(*processor_),
-                             ship_radius, x_start, y_start, x_end, y_end, scratch_rects + i * (256 / kThreadCount));
+                             ship_radius, x_start, y_start, x_end, y_end, scratch_rects + i * scratch_count);
   }
 
   // We must wait for all of the traversables to be calculated before we start calculating edges.
@@ -408,20 +406,17 @@ void Pathfinder::CreateMapWeights(MemoryArena& temp_arena, const Map& map, Weigh
 
   // Loop over tiles to calculate the node edges.
   for (size_t i = 0; i < kThreadCount; ++i) {
-    s16 per_thread = 1024 / (s16)kThreadCount;
-
     s16 x_start = (s16)i * per_thread;
     s16 y_start = 0;
     s16 x_end = ((s16)i + 1) * per_thread;
     s16 y_end = 1024;
 
     if (i == kThreadCount - 1) {
-      s16 remainder = (s16)kThreadCount % 1024;
-      x_end += remainder;
+      x_end = 1024;
     }
 
-    threads[i] =
-        std::thread(CalculateEdges, map, std::ref(*processor_), ship_radius, config, x_start, y_start, x_end, y_end);
+    threads[i] = std::thread(CalculateEdges, map, std::ref(*processor_), ship_radius, config, x_start, y_start, x_end,
+                             y_end, scratch_rects + i * scratch_count);
   }
 
   for (size_t i = 0; i < kThreadCount; ++i) {
@@ -6,6 +6,8 @@
 #include <zero/behavior/Behavior.h>
 #include <zero/game/GameEvent.h>
 
+#include <memory>
+
 namespace zero {
 
 struct ZoneController : EventHandler<ZeroBot::JoinRequestEvent>,
@@ -108,4 +110,27 @@ struct ZoneController : EventHandler<ZeroBot::JoinRequestEvent>,
   ZeroBot* bot = nullptr;
 };
 
+// Every bot creates its own instance of each registered controller, so bots that are hosted in the same process don't
+// share controller state.
+struct ZoneControllerRegistration {
+  using CreateFunction = std::unique_ptr<ZoneController> (*)();
+
+  CreateFunction create;
+  ZoneControllerRegistration* next;
+
+  ZoneControllerRegistration(CreateFunction create) : create(create), next(GetHead()) { GetHead() = this; }
+
+  static ZoneControllerRegistration*& GetHead() {
+    static ZoneControllerRegistration* head = nullptr;
+    return head;
+  }
+};
+
+// Declare one of these as a static in the zone's source file to register its controller.
+template <typename T>
+struct RegisterZoneController : ZoneControllerRegistration {
+  RegisterZoneController()
+      : ZoneControllerRegistration([]() -> std::unique_ptr<ZoneController> { return std::make_unique<T>(); }) {}
+};
+
 }  // namespace zero
@@ -72,7 +72,11 @@ struct Devastation {
   }
 };
 
+struct DevastationController;
+
 struct LoadArenaCommand : public CommandExecutor {
+  LoadArenaCommand(DevastationController& controller) : controller(controller) {}
+
   void Execute(CommandSystem& cmd, ZeroBot& bot, const std::string& sender, const std::string& arg) override;
 
   void SendUsage(const std::string& target_player) {
@@ -83,6 +87,8 @@ struct LoadArenaCommand : public CommandExecutor {
   CommandAccessFlags GetAccess() override { return CommandAccess_Private; }
   std::vector<std::string> GetAliases() override { return {"loadarena"}; }
   std::string GetDescription() override { return "Loads a set of behaviors from an arena name."; }
+
+  DevastationController& controller;
 };
 
 struct WarpToCommand : public CommandExecutor {
@@ -134,7 +140,7 @@ struct DevastationController : ZoneController {
   void LoadArenaType(ArenaType arena_type);
 };
 
-static DevastationController controller;
+static RegisterZoneController<DevastationController> controller_registration;
 
 void DevastationController::CreateBehaviors(const char* arena_name) {
   // Create behaviors depending on arena name
@@ -143,7 +149,7 @@ void DevastationController::CreateBehaviors(const char* arena_name) {
   bot->commands->RegisterCommand(std::make_shared<WarpToCommand>());
   bot->commands->SetCommandSecurityLevel("warpto", 10);
 
-  bot->commands->RegisterCommand(std::make_shared<LoadArenaCommand>());
+  bot->commands->RegisterCommand(std::make_shared<LoadArenaCommand>(*this));
   bot->commands->SetCommandSecurityLevel("loadarena", 10);
 
   ArenaType arena_type = GetArenaTypeFromName(arena_name, ArenaType::Public);
@@ -24,7 +24,7 @@ struct GetAttachTargetNode : public behavior::BehaviorNode {
 
       if (player == self) continue;
       if (player->frequency != self->frequency) continue;
-      if (player->enter_delay > 0.0f && player->explode_anim_t >= kLagAttachTime) continue;
+      if (player->enter_delay > 0.0f && pm.player_details[i].explode_anim_t >= kLagAttachTime) continue;
       if (player->position.x == 0.0f && player->position.y == 0.0f) continue;
       if (ignore_rect.Contains(player->position)) continue;
 
@@ -65,6 +65,7 @@ struct GameRoleDecideNode : public BehaviorNode {
     if (!opt_eg) return ExecuteResult::Failure;
 
     GameRole role = GameRole::CollectFlags;
+    u16 self_flags = ctx.bot->game->player_manager.GetDetails(*self).flags;
 
     ExtremeGames* eg = *opt_eg;
 
@@ -82,7 +83,7 @@ struct GameRoleDecideNode : public BehaviorNode {
       if (total_base_flags > 0) {
         role = has_base_control ? GameRole::DefendBase : GameRole::AttackBase;
 
-        if (has_base_control && self->flags > 0) {
+        if (has_base_control && self_flags > 0) {
           role = GameRole::DropFlags;
         }
       }
@@ -92,7 +93,7 @@ struct GameRoleDecideNode : public BehaviorNode {
 
       // We aren't in a base, so decide if we should collect flags, attack enemy base, or defend our base.
 
-      if (self->flags >= kProtectFlagCount) {
+      if (self_flags >= kProtectFlagCount) {
         role = GameRole::DefendBase;
       } else {
         constexpr float kProtectBasePenetrationThreshold = 0.75f;
@@ -319,8 +320,10 @@ struct FindBestEnemyCenterNode : public BehaviorNode {
       if (!ctx.bot->game->radar.InRadarView(player->position)) continue;
       if (game->GetMap().GetTileId(player->position) == kTileIdSafe) continue;
 
+      u16 carried_flags = game->player_manager.player_details[i].flags;
+
       // Skip non-flaggers that are too far away.
-      if (player->flags == 0 &&
+      if (carried_flags == 0 &&
           player->position.DistanceSq(self->position) > nonflagger_distance_req * nonflagger_distance_req) {
         continue;
       }
@@ -333,7 +336,7 @@ struct FindBestEnemyCenterNode : public BehaviorNode {
       float dist_sq = player->position.DistanceSq(self->position);
 
       // Prioritize killing flaggers, but don't ignore people who are nearby that might kill us while we chase flagger.
-      if (player->flags == 0) {
+      if (carried_flags == 0) {
         dist_sq *= nonflagger_multiplier;
       }
 
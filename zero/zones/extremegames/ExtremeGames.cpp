@@ -26,7 +26,7 @@ struct ExtremeGamesController : ZoneController {
   std::unique_ptr<ExtremeGames> eg;
 };
 
-static ExtremeGamesController controller;
+static RegisterZoneController<ExtremeGamesController> controller_registration;
 
 void ExtremeGamesController::CreateBehaviors(const char* arena_name) {
   Log(LogLevel::Info, "Registering eg behaviors.");
@@ -297,11 +297,13 @@ void ExtremeGames::UpdateBaseState(ZeroBot& bot) {
         state.defending_penetration_percent = player_state.position_percent;
       }
 
-      if (player->flags > 0) {
+      u16 carried_flags = pm.GetDetails(*player).flags;
+
+      if (carried_flags > 0) {
         if (control_player) {
-          state.flag_controlling_carried_count += player->flags;
+          state.flag_controlling_carried_count += carried_flags;
         } else {
-          state.flag_attacking_carried_count += player->flags;
+          state.flag_attacking_carried_count += carried_flags;
         }
       }
     }
@@ -23,7 +23,7 @@ struct HockeyZoneController : ZoneController {
   std::unique_ptr<HockeyZone> hz;
 };
 
-static HockeyZoneController controller;
+static RegisterZoneController<HockeyZoneController> controller_registration;
 
 void HockeyZoneController::CreateBehaviors(const char* arena_name) {
   Log(LogLevel::Info, "Registering HockeyZone behaviors.");
@@ -24,7 +24,7 @@ struct HyperspaceController : ZoneController {
   std::unique_ptr<CommandBehavior> command_behavior;
 };
 
-static HyperspaceController controller;
+static RegisterZoneController<HyperspaceController> controller_registration;
 
 class FlagCommand : public CommandExecutor {
  public:
@@ -34,7 +34,7 @@ class FlagCommand : public CommandExecutor {
 
     std::string output = "Not yet implemented.";
 
-    Event::Dispatch(ChatQueueEvent::Private(player->name, output.data()));
+    Event::Dispatch(ChatQueueEvent::Private(bot.game->player_manager.GetName(*player), output.data()));
   }
 
   CommandAccessFlags GetAccess() override { return CommandAccess_Private; }
@@ -43,6 +43,9 @@ class FlagCommand : public CommandExecutor {
 };
 
 class ParseResponseCommand : public CommandExecutor {
+ public:
+  ParseResponseCommand(HyperspaceController& controller) : controller(controller) {}
+
  protected:
   bool CanExecute(ZeroBot& bot, const std::string& sender) {
     auto opt_state = bot.execute_ctx.blackboard.Value<CommandExecuteState>(CommandExecuteState::Key());
@@ -61,10 +64,14 @@ class ParseResponseCommand : public CommandExecutor {
 
     return true;
   }
+
+  HyperspaceController& controller;
 };
 
 class BuyCommand : public ParseResponseCommand {
  public:
+  BuyCommand(HyperspaceController& controller) : ParseResponseCommand(controller) {}
+
   void Execute(CommandSystem& cmd, ZeroBot& bot, const std::string& sender, const std::string& arg) override {
     Player* player = bot.game->player_manager.GetPlayerByName(sender.c_str());
     if (!player) return;
@@ -107,6 +114,8 @@ class BuyCommand : public ParseResponseCommand {
 
 class SellCommand : public ParseResponseCommand {
  public:
+  SellCommand(HyperspaceController& controller) : ParseResponseCommand(controller) {}
+
   void Execute(CommandSystem& cmd, ZeroBot& bot, const std::string& sender, const std::string& arg) override {
     Player* player = bot.game->player_manager.GetPlayerByName(sender.c_str());
     if (!player) return;
@@ -149,6 +158,8 @@ class SellCommand : public ParseResponseCommand {
 
 class ShipItemsCommand : public ParseResponseCommand {
  public:
+  ShipItemsCommand(HyperspaceController& controller) : ParseResponseCommand(controller) {}
+
   void Execute(CommandSystem& cmd, ZeroBot& bot, const std::string& sender, const std::string& arg) override {
     Player* player = bot.game->player_manager.GetPlayerByName(sender.c_str());
     if (!player) return;
@@ -205,9 +216,9 @@ void HyperspaceController::CreateBehaviors(const char* arena_name) {
     SetBehavior("center");
 
     bot->commands->RegisterCommand(std::make_shared<FlagCommand>());
-    bot->commands->RegisterCommand(std::make_shared<ShipItemsCommand>());
-    bot->commands->RegisterCommand(std::make_shared<BuyCommand>());
-    bot->commands->RegisterCommand(std::make_shared<SellCommand>());
+    bot->commands->RegisterCommand(std::make_shared<ShipItemsCommand>(*this));
+    bot->commands->RegisterCommand(std::make_shared<BuyCommand>(*this));
+    bot->commands->RegisterCommand(std::make_shared<SellCommand>(*this));
 
     bot->commands->SetCommandSecurityLevel("flag", 1);
     bot->commands->SetCommandSecurityLevel("shipitems", 1);
@@ -21,7 +21,7 @@ struct LocalController : ZoneController {
   void HandleEvent(const BehaviorChangeEvent& event) override;
 };
 
-static LocalController controller;
+static RegisterZoneController<LocalController> controller_registration;
 
 class SetCommandCommand : public CommandExecutor {
  public:
@@ -30,7 +30,7 @@ class SetCommandCommand : public CommandExecutor {
     if (!player) return;
 
     if (arg.empty()) {
-      Event::Dispatch(ChatQueueEvent::Private(player->name, "Usage: !setcommand lag"));
+      Event::Dispatch(ChatQueueEvent::Private(bot.game->player_manager.GetName(*player), "Usage: !setcommand lag"));
       return;
     }
 
@@ -45,7 +45,7 @@ class SetCommandCommand : public CommandExecutor {
     bot.execute_ctx.blackboard.Set<std::string>(CommandSpamBehavior::CommandKey(), command);
 
     std::string output = "Command set to: " + command;
-    Event::Dispatch(ChatQueueEvent::Private(player->name, output.data()));
+    Event::Dispatch(ChatQueueEvent::Private(bot.game->player_manager.GetName(*player), output.data()));
   }
 
   CommandAccessFlags GetAccess() override { return CommandAccess_Private; }
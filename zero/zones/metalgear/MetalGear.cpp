@@ -16,18 +16,19 @@ struct MetalGearController : ZoneController, public EventHandler<PlayerDeathEven
   void CreateBehaviors(const char* arena_name) override;
 
   void HandleEvent(const PlayerDeathEvent& event) override {
-    auto self = this->bot->game->player_manager.GetSelf();
+    auto& pm = this->bot->game->player_manager;
+    auto self = pm.GetSelf();
 
     if (!self) return;
 
     if (event.player.id == self->id || event.killer.id == self->id) {
-      Log(LogLevel::Info, "%s (%d) killed by %s (%d)", event.player.name, event.bounty, event.killer.name,
-          event.killer.bounty);
+      Log(LogLevel::Info, "%s (%d) killed by %s (%d)", pm.GetName(event.player), event.bounty,
+          pm.GetName(event.killer), event.killer.bounty);
     }
   }
 };
 
-static MetalGearController controller;
+static RegisterZoneController<MetalGearController> controller_registration;
 
 void MetalGearController::CreateBehaviors(const char* arena_name) {
   Log(LogLevel::Info, "Registering mg behaviors.");
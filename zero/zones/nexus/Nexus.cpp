@@ -35,7 +35,7 @@ struct NexusController : ZoneController, EventHandler<ChatEvent> {
   std::unique_ptr<Nexus> nexus;
 };
 
-static NexusController controller;
+static RegisterZoneController<NexusController> controller_registration;
 
 void NexusController::HandleEvent(const ChatEvent& event) {
   std::string sender = event.sender;
@@ -6,22 +6,11 @@
 #include <zero/behavior/BehaviorTree.h>
 #include <zero/game/Game.h>
 #include <zero/game/Logger.h>
-#include <stdexcept>
 #include <variant>
 
 namespace zero {
 namespace nexus {
 
-    struct teamList {
-        Player* player;
-        float distance;
-        bool operator<(const teamList& other) const {
-          return distance < other.distance;  // Sort based on 'distance' in ascending order
-        }
-        teamList(Player* player, float distance) : player(player), distance(distance) {}
-    };
-
-
 //Returns nearest teammate, optionally if factor is included can provide 2nd nearest temmate or 3rd, etc. as int 1 (for 1st closest), 2 for (2nd closest), etc.
   struct NearestTeammateNode : public behavior::BehaviorNode {
     NearestTeammateNode(const char* player_key) : player_key(player_key) {}
@@ -44,16 +33,19 @@ namespace nexus {
    private:
     Player* GetNearestTeammate(Game& game, Player& self, RegionRegistry& region_registry, size_t& player_factor) {
       Player* best_teammate = nullptr;
-      std::vector<teamList> team;
       size_t teamsize = 0;
 
-      for (size_t i = 0; i < game.player_manager.player_count; ++i) {
-        Player* player = game.player_manager.players + i;
+      PlayerQueryFilter filter;
+      filter.frequency = self.frequency;
+
+      // Every teammate is sorted by distance since the checks below can skip any number of the closest ones.
+      size_t nearby_count = game.player_manager.grid.QueryNearest(self.position, PlayerGrid::kMaxPlayers, filter,
+                                                                  nearby_players, ZERO_ARRAY_SIZE(nearby_players));
+
+      for (size_t i = 0; i < nearby_count; ++i) {
+        Player* player = nearby_players[i];
 
         if (player->id == self.id) continue;
-        if (player->ship >= 8) continue;
-        if (player->frequency != self.frequency) continue;
-        if (player->IsRespawning()) continue;
         if (player->position == Vector2f(0, 0)) continue;
         if (!IsSynchronized(game, *player)) continue;
         if (!region_registry.IsConnected(self.position, player->position)) continue;
@@ -61,19 +53,12 @@ namespace nexus {
         bool in_safe = game.connection.map.GetTileId(player->position) == kTileIdSafe;
         if (in_safe) continue;
 
-        float dist_sq = player->position.DistanceSq(self.position);
-        
-        //Insert the player and their distance
-        team.emplace_back(player, dist_sq);
+        // Keep the teammates that pass in distance order at the front of the buffer.
+        nearby_players[teamsize++] = player;
       }
-      
-      teamsize = team.size();
-      
+
       //If no teamsize will return null leading to failed execute result
       if (teamsize >= 1) {
-        // Sort the team based on distance then we can return the desired player based on the provided factor
-        std::sort(team.begin(), team.end());
-
         // Index starts from 0 not 1
         size_t index = player_factor - 1;  //Assuming this sorted correctly and they are in order by distance 
 
@@ -81,9 +66,7 @@ namespace nexus {
           index = teamsize - 1;
         }
         //Try the specified player otherwise return the furthest player (assuming if they specified the 3rd player and they no longer exist you'd get the 2nd player)
-        try {
-          best_teammate = team[index].player;
-        } catch (const std::out_of_range&) { }   
+        best_teammate = nearby_players[index];
       } 
 
       return best_teammate;
@@ -103,6 +86,8 @@ namespace nexus {
 
   size_t player_factor = 1;
   const char* player_key = nullptr;
+
+  Player* nearby_players[PlayerGrid::kMaxPlayers];
 };
 
 }  // namespace nexus
@@ -18,7 +18,7 @@ struct SvsController : ZoneController {
   void CreateBehaviors(const char* arena_name) override;
 };
 
-static SvsController controller;
+static RegisterZoneController<SvsController> controller_registration;
 
 void SvsController::CreateBehaviors(const char* arena_name) {
   Log(LogLevel::Info, "Registering SVS behaviors.");
@@ -44,7 +44,7 @@ static behavior::ExecuteResult FindNearestEnemyFlagger(behavior::ExecuteContext&
     Player* player = game->player_manager.players + i;
 
     if (player->ship >= 8) continue;
-    if (player->flags == 0) continue;
+    if (game->player_manager.player_details[i].flags == 0) continue;
     if (player->frequency == self->frequency) continue;
     if (player->IsRespawning()) continue;
     if (player->position == Vector2f(0, 0)) continue;
@@ -90,7 +90,7 @@ struct TwController : ZoneController, EventHandler<SpawnEvent>, EventHandler<Cha
   s32 scorereset_interval = 0;
 };
 
-static TwController controller;
+static RegisterZoneController<TwController> controller_registration;
 
 void TwController::CreateBehaviors(const char* arena_name) {
   Log(LogLevel::Info, "Registering Trench Wars behaviors.");
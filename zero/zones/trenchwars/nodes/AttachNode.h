@@ -42,7 +42,7 @@ struct BestAttachQueryNode : public behavior::BehaviorNode {
 
       u8 turret_count = 0;
 
-      AttachInfo* child = player->children;
+      AttachInfo* child = pm.player_details[i].children;
       while (child) {
         ++turret_count;
         child = child->next;